@@ -115,6 +115,29 @@ RB_METHOD(audio_bgmPlay)
     return Qnil;
 }
 
+RB_METHOD(audio_bgmCrossfade)
+{
+    RB_UNUSED_PARAM;
+    const char *filename;
+    int duration;
+    int volume = 100;
+    int pitch = 100;
+    VALUE track = Qnil;
+    rb_get_args(argc, argv, "zi|iio", &filename, &duration, &volume, &pitch, &track RB_ARG_END);
+    GUARD_EXC( shState->audio().bgmCrossfade(filename, duration, volume, pitch, MAYBE_NIL_TRACK(track)); )
+    return Qnil;
+}
+
+RB_METHOD(audio_bgmPreload)
+{
+    RB_UNUSED_PARAM;
+    const char *filename;
+    VALUE track = Qnil;
+    rb_get_args(argc, argv, "z|o", &filename, &track RB_ARG_END);
+    GUARD_EXC( shState->audio().bgmPreload(filename, MAYBE_NIL_TRACK(track)); )
+    return Qnil;
+}
+
 RB_METHOD(audio_bgmStop)
 {
     RB_UNUSED_PARAM;
@@ -221,6 +244,8 @@ audioBindingInit()
 	BIND_PLAY_STOP_FADE( bgm );
     _rb_define_module_function(module, "bgm_volume", audio_bgmGetVolume);
     _rb_define_module_function(module, "bgm_set_volume", audio_bgmSetVolume);
+    _rb_define_module_function(module, "bgm_crossfade", audio_bgmCrossfade);
+    _rb_define_module_function(module, "bgm_preload", audio_bgmPreload);
 	BIND_PLAY_STOP_FADE( bgs );
 	BIND_PLAY_STOP_FADE( me  );
 
@@ -31,6 +31,7 @@
 #include "util/boost-hash.h"
 #include "util/exception.h"
 #include "util/encoding.h"
+#include "util/trace.h"
 
 #include "config.h"
 
@@ -48,6 +49,7 @@ extern "C" {
 #if RAPI_FULL >= 190
 #include <ruby/encoding.h>
 #endif
+#include <ruby/debug.h>
 }
 
 #ifdef __WIN32__
@@ -138,6 +140,10 @@ RB_METHOD(mkxpRemovePath);
 RB_METHOD(mkxpFileExists);
 RB_METHOD(mkxpLaunch);
 
+RB_METHOD(mkxpGetTracing);
+RB_METHOD(mkxpSetTracing);
+RB_METHOD(mkxpDumpTrace);
+
 RB_METHOD(mkxpGetJSONSetting);
 RB_METHOD(mkxpSetJSONSetting);
 RB_METHOD(mkxpGetAllJSONSettings);
@@ -151,6 +157,8 @@ RB_METHOD(_kernelCaller);
 RB_METHOD(mkxpStringToUTF8);
 RB_METHOD(mkxpStringToUTF8Bang);
 
+static void traceGCInit();
+
 VALUE json2rb(json5pp::value const &v);
 json5pp::value rb2json(VALUE v);
 
@@ -251,6 +259,11 @@ static void mriBindingInit() {
     _rb_define_module_function(mod, "file_exist?", mkxpFileExists);
     _rb_define_module_function(mod, "launch", mkxpLaunch);
     
+    _rb_define_module_function(mod, "tracing", mkxpGetTracing);
+    _rb_define_module_function(mod, "tracing=", mkxpSetTracing);
+    _rb_define_module_function(mod, "dump_trace", mkxpDumpTrace);
+    traceGCInit();
+    
     _rb_define_module_function(mod, "default_font_family=", mkxpSetDefaultFontFamily);
     
     _rb_define_method(rb_cString, "to_utf8", mkxpStringToUTF8);
@@ -684,6 +697,66 @@ RB_METHOD(mkxpLaunch) {
     return RUBY_Qnil;
 }
 
+RB_METHOD(mkxpGetTracing) {
+    RB_UNUSED_PARAM;
+    
+    return rb_bool_new(Trace::isRecording());
+}
+
+RB_METHOD(mkxpSetTracing) {
+    RB_UNUSED_PARAM;
+    
+    bool value;
+    rb_get_args(argc, argv, "b", &value RB_ARG_END);
+    
+    Trace::setRecording(value);
+    
+    return rb_bool_new(value);
+}
+
+RB_METHOD(mkxpDumpTrace) {
+    RB_UNUSED_PARAM;
+    
+    const char *path;
+    rb_get_args(argc, argv, "z", &path RB_ARG_END);
+    
+    if (!Trace::dump(path))
+        raiseRbExc(Exception(Exception::MKXPError, "Failed to write trace to \"%s\"", path));
+    
+    return RUBY_Qnil;
+}
+
+#ifdef RUBY_INTERNAL_EVENT_GC_ENTER
+/* GC runs on the RGSS thread, one pass at a time */
+static uint64_t gcStart = 0;
+
+static void traceGCHook(VALUE tpval, void *) {
+    rb_event_flag_t flag = rb_tracearg_event_flag(rb_tracearg_from_tracepoint(tpval));
+    
+    if (flag == RUBY_INTERNAL_EVENT_GC_ENTER) {
+        gcStart = Trace::isRecording() ? Trace::now() : 0;
+    }
+    else if (gcStart) {
+        Trace::complete("GC", gcStart);
+        gcStart = 0;
+    }
+}
+#endif
+
+static void traceGCInit() {
+#ifdef RUBY_INTERNAL_EVENT_GC_ENTER
+    static VALUE tracepoint = Qnil;
+    
+    if (!NIL_P(tracepoint))
+        return;
+    
+    tracepoint = rb_tracepoint_new(0, RUBY_INTERNAL_EVENT_GC_ENTER | RUBY_INTERNAL_EVENT_GC_EXIT,
+                                   traceGCHook, 0);
+    rb_gc_register_address(&tracepoint);
+    rb_tracepoint_enable(tracepoint);
+#endif
+}
+
 json5pp::value loadUserSettings() {
     json5pp::value ret;
     VALUE cpath = rb_utf8_str_new_cstr(shState->config().userConfPath.c_str());
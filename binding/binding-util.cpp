@@ -28,6 +28,7 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <string.h>
+#include <vector>
 
 RbData *getRbData() { return static_cast<RbData *>(shState->bindingData()); }
 
@@ -88,6 +89,34 @@ void raiseDisposedAccess(VALUE self) {
   rb_raise(getRbData()->exc[RGSS], "disposed %s", buf);
 }
 
+#if RAPI_FULL > 187
+/* Property wrappers (Color, Rect, ...) are created for every new
+ * Sprite, Window etc., so the constant lookup is only done once */
+VALUE wrapObjectClass(const rb_data_type_t &type, VALUE underKlass) {
+  struct Entry {
+    const rb_data_type_t *type;
+    VALUE underKlass;
+    VALUE klass;
+  };
+
+  static std::vector<Entry> cache;
+
+  for (size_t i = 0; i < cache.size(); ++i)
+    if (cache[i].type == &type && cache[i].underKlass == underKlass)
+      return cache[i].klass;
+
+  VALUE klass = rb_const_get(underKlass, rb_intern(type.wrap_struct_name));
+
+  /* Keeps it alive and in place */
+  rb_gc_register_mark_object(klass);
+
+  Entry entry = {&type, underKlass, klass};
+  cache.push_back(entry);
+
+  return klass;
+}
+#endif
+
 int rb_get_args(int argc, VALUE *argv, const char *format, ...) {
   char c;
   VALUE *arg = argv;
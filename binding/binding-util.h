@@ -30,6 +30,7 @@
 #endif
 
 #include "exception.h"
+#include "bindingslots.h"
 
 #ifdef RUBY_API_VERSION_MAJOR
 #define RAPI_MAJOR RUBY_API_VERSION_MAJOR
@@ -89,14 +90,17 @@ void raiseRbExc(const Exception &exc);
 
 #if RAPI_MAJOR > 1 || RAPI_MINOR <= 9
 #if RAPI_FULL < 270
-#define DEF_TYPE_CUSTOMNAME_AND_FREE(Klass, Name, Free)                        \
+#define DEF_TYPE_CUSTOMNAME_MARK_AND_FREE(Klass, Name, Mark, Free)            \
 rb_data_type_t Klass##Type = {                                               \
-Name, {0, Free, 0, {0, 0}}, 0, 0, DEF_TYPE_FLAGS}
+Name, {Mark, Free, 0, {0, 0}}, 0, 0, DEF_TYPE_FLAGS}
 #else
-#define DEF_TYPE_CUSTOMNAME_AND_FREE(Klass, Name, Free)                        \
-rb_data_type_t Klass##Type = {Name, {0, Free, 0, 0, 0}, 0, 0, DEF_TYPE_FLAGS}
+#define DEF_TYPE_CUSTOMNAME_MARK_AND_FREE(Klass, Name, Mark, Free)            \
+rb_data_type_t Klass##Type = {Name, {Mark, Free, 0, 0, 0}, 0, 0, DEF_TYPE_FLAGS}
 #endif
 
+#define DEF_TYPE_CUSTOMNAME_AND_FREE(Klass, Name, Free)                        \
+DEF_TYPE_CUSTOMNAME_MARK_AND_FREE(Klass, Name, 0, Free)
+
 #define DEF_TYPE_CUSTOMFREE(Klass, Free)                                       \
 DEF_TYPE_CUSTOMNAME_AND_FREE(Klass, #Klass, Free)
 
@@ -104,6 +108,13 @@ DEF_TYPE_CUSTOMNAME_AND_FREE(Klass, #Klass, Free)
 DEF_TYPE_CUSTOMNAME_AND_FREE(Klass, Name, freeInstance<Klass>)
 
 #define DEF_TYPE(Klass) DEF_TYPE_CUSTOMNAME(Klass, #Klass)
+
+/* For classes keeping their property wrappers in BindingSlots */
+#define DEF_SLOTS_TYPE_CUSTOMNAME(Klass, Name)                                 \
+DEF_TYPE_CUSTOMNAME_MARK_AND_FREE(Klass, Name, markBindingSlots<Klass>,      \
+freeInstance<Klass>)
+
+#define DEF_SLOTS_TYPE(Klass) DEF_SLOTS_TYPE_CUSTOMNAME(Klass, #Klass)
 #endif
 
 // Ruby 1.8 helper stuff
@@ -168,6 +179,11 @@ return Data_Wrap_Struct(klass, 0, free, 0);                                \
 
 #define DEF_ALLOCFUNC(type) DEF_ALLOCFUNC_CUSTOMFREE(type, freeInstance<type>)
 
+#define DEF_SLOTS_ALLOCFUNC(type)                                              \
+static VALUE type##Allocate(VALUE klass) {                                   \
+return Data_Wrap_Struct(klass, markBindingSlots<type>, freeInstance<type>, 0); \
+}
+
 #define PRIsVALUE "s"
 
 #endif
@@ -194,6 +210,32 @@ template <class C> static void freeInstance(void *inst) {
     delete static_cast<C *>(inst);
 }
 
+template <class C> static void markBindingSlots(void *inst) {
+    if (!inst)
+        return;
+    
+    const BindingSlots *slots = static_cast<C *>(inst);
+    
+    for (int i = 0; i < BindingSlots::SlotCount; ++i)
+        rb_gc_mark((VALUE)slots->getSlot(i));
+}
+
+/* Unset slots read as nil, and so does every slot of an object
+ * without a C++ counterpart (allocated but never initialized, or
+ * whose initialize_copy failed) */
+static inline VALUE getPropertySlot(const BindingSlots *owner, int slot) {
+    if (!owner)
+        return Qnil;
+    
+    VALUE value = (VALUE)owner->getSlot(slot);
+    
+    return value ? value : Qnil;
+}
+
+static inline void setPropertySlot(BindingSlots *owner, int slot, VALUE value) {
+    owner->setSlot(slot, (uintptr_t)value);
+}
+
 void raiseDisposedAccess(VALUE self);
 
 template <class C> inline C *getPrivateData(VALUE self) {
@@ -227,10 +269,9 @@ getPrivateDataCheck(VALUE self, const char *type)
     }
     void *obj = DATA_PTR(self);
 #else
-    const char *ownname = rb_obj_classname(self);
     if (!rb_typeddata_is_kind_of(self, &type))
-        rb_raise(rb_eTypeError, "Can't convert %s into %s", ownname,
-                 type.wrap_struct_name);
+        rb_raise(rb_eTypeError, "Can't convert %s into %s",
+                 rb_obj_classname(self), type.wrap_struct_name);
     
     void *obj = RTYPEDDATA_DATA(self);
 #endif
@@ -245,6 +286,11 @@ static inline void setPrivateData(VALUE self, void *p) {
 #endif
 }
 
+#if RAPI_FULL > 187
+/* Class of 'type' below 'underKlass', looked up once */
+VALUE wrapObjectClass(const rb_data_type_t &type, VALUE underKlass);
+#endif
+
 inline VALUE
 #if RAPI_FULL > 187
 wrapObject(void *p, const rb_data_type_t &type, VALUE underKlass = rb_cObject)
@@ -253,7 +299,7 @@ wrapObject(void *p, const char *type, VALUE underKlass = rb_cObject)
 #endif
 {
 #if RAPI_FULL > 187
-    VALUE klass = rb_const_get(underKlass, rb_intern(type.wrap_struct_name));
+    VALUE klass = wrapObjectClass(type, underKlass);
 #else
     VALUE klass = rb_const_get(underKlass, rb_intern(type));
 #endif
@@ -278,6 +324,21 @@ inline VALUE wrapProperty(VALUE self, void *prop, const char *iv,
     return propObj;
 }
 
+/* Like wrapProperty, but keeps the wrapper in 'slot' of 'owner' */
+inline VALUE wrapPropertySlot(BindingSlots *owner, int slot, void *prop,
+#if RAPI_FULL > 187
+                              const rb_data_type_t &type,
+#else
+                              const char *type,
+#endif
+                              VALUE underKlass = rb_cObject) {
+    VALUE propObj = wrapObject(prop, type, underKlass);
+    
+    setPropertySlot(owner, slot, propObj);
+    
+    return propObj;
+}
+
 /* Implemented: oSszfibn| */
 int rb_get_args(int argc, VALUE *argv, const char *format, ...);
 
@@ -456,10 +517,10 @@ return self;                                                               \
 // Do not wait for Graphics.update
 // --------------
 #if RAPI_FULL > 187
-#define DEF_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_iv)                  \
+#define DEF_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_slot)                  \
 RB_METHOD(Klass##Get##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
-return rb_iv_get(self, prop_iv);                                           \
+return getPropertySlot(getPrivateData<Klass>(self), prop_slot);            \
 }                                                                            \
 RB_METHOD(Klass##Set##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
@@ -472,14 +533,14 @@ prop = 0;                                                                \
 else                                                                       \
 prop = getPrivateDataCheck<PropKlass>(propObj, PropKlass##Type);         \
 GUARD_EXC(k->set##PropName(prop);)                                         \
-rb_iv_set(self, prop_iv, propObj);                                         \
+setPropertySlot(k, prop_slot, propObj);                                    \
 return propObj;                                                            \
 }
 #else
-#define DEF_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_iv)                  \
+#define DEF_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_slot)                  \
 RB_METHOD(Klass##Get##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
-return rb_iv_get(self, prop_iv);                                           \
+return getPropertySlot(getPrivateData<Klass>(self), prop_slot);            \
 }                                                                            \
 RB_METHOD(Klass##Set##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
@@ -492,18 +553,18 @@ prop = 0;                                                                \
 else                                                                       \
 prop = getPrivateDataCheck<PropKlass>(propObj, #PropKlass);              \
 GUARD_EXC(k->set##PropName(prop);)                                         \
-rb_iv_set(self, prop_iv, propObj);                                         \
+setPropertySlot(k, prop_slot, propObj);                                    \
 return propObj;                                                            \
 }
 #endif
 
 /* Object property which is copied by value, not reference */
 #if RAPI_FULL > 187
-#define DEF_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_iv)                  \
+#define DEF_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_slot)                  \
 RB_METHOD(Klass##Get##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
 checkDisposed<Klass>(self);                                                \
-return rb_iv_get(self, prop_iv);                                           \
+return getPropertySlot(getPrivateData<Klass>(self), prop_slot);            \
 }                                                                            \
 RB_METHOD(Klass##Set##PropName) {                                            \
 rb_check_argc(argc, 1);                                                    \
@@ -515,11 +576,11 @@ GUARD_EXC(k->set##PropName(*prop);)                                        \
 return propObj;                                                            \
 }
 #else
-#define DEF_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_iv)                  \
+#define DEF_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_slot)                  \
 RB_METHOD(Klass##Get##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
 checkDisposed<Klass>(self);                                                \
-return rb_iv_get(self, prop_iv);                                           \
+return getPropertySlot(getPrivateData<Klass>(self), prop_slot);            \
 }                                                                            \
 RB_METHOD(Klass##Set##PropName) {                                            \
 rb_check_argc(argc, 1);                                                    \
@@ -568,10 +629,10 @@ _rb_define_method(klass, prop_name_s "=", Klass##Set##PropName);           \
 // Wait for Graphics.update
 // --------------
 #if RAPI_FULL > 187
-#define DEF_GFX_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_iv)                  \
+#define DEF_GFX_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_slot)                  \
 RB_METHOD(Klass##Get##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
-return rb_iv_get(self, prop_iv);                                           \
+return getPropertySlot(getPrivateData<Klass>(self), prop_slot);            \
 }                                                                            \
 RB_METHOD(Klass##Set##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
@@ -584,21 +645,21 @@ prop = 0;                                                                \
 else                                                                       \
 prop = getPrivateDataCheck<PropKlass>(propObj, PropKlass##Type);         \
 GFX_GUARD_EXC(k->set##PropName(prop);)                                         \
-rb_iv_set(self, prop_iv, propObj);                                         \
+setPropertySlot(k, prop_slot, propObj);                                    \
 return propObj;                                                            \
 }
 #else
-#define DEF_GFX_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_iv)                  \
-DEF_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_iv)
+#define DEF_GFX_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_slot)                  \
+DEF_PROP_OBJ_REF(Klass, PropKlass, PropName, prop_slot)
 #endif
 
 /* Object property which is copied by value, not reference */
 #if RAPI_FULL > 187
-#define DEF_GFX_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_iv)                  \
+#define DEF_GFX_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_slot)                  \
 RB_METHOD(Klass##Get##PropName) {                                            \
 RB_UNUSED_PARAM;                                                           \
 checkDisposed<Klass>(self);                                                \
-return rb_iv_get(self, prop_iv);                                           \
+return getPropertySlot(getPrivateData<Klass>(self), prop_slot);            \
 }                                                                            \
 RB_METHOD(Klass##Set##PropName) {                                            \
 rb_check_argc(argc, 1);                                                    \
@@ -610,8 +671,8 @@ GFX_GUARD_EXC(k->set##PropName(*prop);)                                        \
 return propObj;                                                            \
 }
 #else
-#define DEF_GFX_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_iv)                  \
-DEF_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_iv)
+#define DEF_GFX_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_slot)                  \
+DEF_PROP_OBJ_VAL(Klass, PropKlass, PropName, prop_slot)
 #endif
 
 #define DEF_GFX_PROP(Klass, type, PropName, arg_fun, value_fun)                    \
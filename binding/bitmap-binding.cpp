@@ -27,18 +27,31 @@
 #include "font.h"
 #include "sharedstate.h"
 #include "graphics.h"
+#include "pixelkernels.h"
+#include "colormatrix.h"
 
 #if RAPI_FULL > 187
-DEF_TYPE(Bitmap);
+DEF_SLOTS_TYPE(Bitmap);
 #else
-DEF_ALLOCFUNC(Bitmap);
+DEF_SLOTS_ALLOCFUNC(Bitmap);
 #endif
 
+enum
+{
+    FontSlot = 0,
+    HiresSlot,
+    BitmapSlotEnd
+};
+
+static_assert(BitmapSlotEnd <= BindingSlots::SlotCount, "Too many Bitmap slots");
+
 static const char *objAsStringPtr(VALUE obj) {
     VALUE str = rb_obj_as_string(obj);
     return RSTRING_PTR(str);
 }
 
+/* 'self' must already own 'b', so that the slots
+ * filled here are marked from the start */
 void bitmapInitProps(Bitmap *b, VALUE self) {
     /* Wrap properties */
     VALUE fontKlass = rb_const_get(rb_cObject, rb_intern("Font"));
@@ -48,12 +61,12 @@ void bitmapInitProps(Bitmap *b, VALUE self) {
     Font *font = getPrivateData<Font>(fontObj);
     b->setInitFont(font);
     
-    rb_iv_set(self, "font", fontObj);
+    setPropertySlot(b, FontSlot, fontObj);
 
     // Leave property as default nil if hasHires() is false.
     if (b->hasHires()) {
         b->assumeRubyGC();
-        wrapProperty(self, b->getHires(), "hires", BitmapType);
+        wrapPropertySlot(b, HiresSlot, b->getHires(), BitmapType);
     }
 }
 
@@ -100,7 +113,7 @@ RB_METHOD(bitmapHeight) {
     return INT2FIX(value);
 }
 
-DEF_GFX_PROP_OBJ_REF(Bitmap, Bitmap, Hires, "hires")
+DEF_GFX_PROP_OBJ_REF(Bitmap, Bitmap, Hires, HiresSlot)
 
 RB_METHOD(bitmapRect) {
     RB_UNUSED_PARAM;
@@ -245,6 +258,105 @@ RB_METHOD(bitmapHueChange) {
     return self;
 }
 
+/* One color matrix argument: either an Array of 20 numbers (rows
+ * for R, G, B and A, each with four factors and an offset in 0..255)
+ * or a Hash of adjustments, applied in the order they are given:
+ * hue (degrees), saturation, grayscale, brightness, tint (Color,
+ * its alpha is the strength), invert (true / false) */
+static ColorMatrix colorMatrixArg(VALUE arg) {
+    ColorMatrix mat;
+    
+    if (RB_TYPE_P(arg, T_ARRAY)) {
+        if (RARRAY_LEN(arg) != 20)
+            rb_raise(rb_eArgError, "color matrix needs 20 values (got %ld)",
+                     (long)RARRAY_LEN(arg));
+        
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 4; ++j)
+                mat.m[i][j] = NUM2DBL(rb_ary_entry(arg, i * 5 + j));
+            
+            mat.offset[i] = NUM2DBL(rb_ary_entry(arg, i * 5 + 4)) / 255;
+        }
+        
+        return mat;
+    }
+    
+    Check_Type(arg, T_HASH);
+    
+    VALUE keys = rb_funcall(arg, rb_intern("keys"), 0);
+    
+    for (long i = 0; i < RARRAY_LEN(keys); ++i) {
+        VALUE key = rb_ary_entry(keys, i);
+        VALUE value = rb_hash_aref(arg, key);
+        ID id = SYMBOL_P(key) ? SYM2ID(key) : 0;
+        
+        if (id == rb_intern("hue"))
+            mat = mat.then(ColorMatrix::hue(NUM2DBL(value)));
+        else if (id == rb_intern("saturation"))
+            mat = mat.then(ColorMatrix::saturation(NUM2DBL(value)));
+        else if (id == rb_intern("grayscale"))
+            mat = mat.then(ColorMatrix::grayscale(NUM2DBL(value)));
+        else if (id == rb_intern("brightness"))
+            mat = mat.then(ColorMatrix::brightness(NUM2DBL(value)));
+        else if (id == rb_intern("tint"))
+            mat = mat.then(ColorMatrix::tint(getPrivateDataCheck<Color>(value, ColorType)->norm));
+        else if (id == rb_intern("invert")) {
+            if (RTEST(value))
+                mat = mat.then(ColorMatrix::invert());
+        }
+        else {
+            VALUE str = rb_inspect(key);
+            rb_raise(rb_eArgError, "unknown color adjustment %s", RSTRING_PTR(str));
+        }
+    }
+    
+    return mat;
+}
+
+/* All arguments chained, first to last */
+static ColorMatrix colorMatrixArgs(int argc, VALUE *argv) {
+    if (argc == 0)
+        rb_raise(rb_eArgError, "no color matrix given");
+    
+    ColorMatrix mat;
+    
+    for (int i = 0; i < argc; ++i)
+        mat = mat.then(colorMatrixArg(argv[i]));
+    
+    return mat;
+}
+
+/* Applies any number of color matrices in a single pass,
+ * eg. bitmap.color_matrix!(saturation: 0.3, tint: Color.new(255, 200, 0, 64)) */
+RB_METHOD(bitmapColorMatrix) {
+    Bitmap *b = getPrivateData<Bitmap>(self);
+    
+    ColorMatrix mat = colorMatrixArgs(argc, argv);
+    
+    GFX_GUARD_EXC(b->colorMatrix(mat););
+    
+    return self;
+}
+
+/* The chained arguments as one 20 value Array, to keep around
+ * or to combine further */
+RB_METHOD(bitmapComposeColorMatrix) {
+    RB_UNUSED_PARAM;
+    
+    ColorMatrix mat = colorMatrixArgs(argc, argv);
+    
+    VALUE ret = rb_ary_new();
+    
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j)
+            rb_ary_push(ret, rb_float_new(mat.m[i][j]));
+        
+        rb_ary_push(ret, rb_float_new(mat.offset[i] * 255));
+    }
+    
+    return ret;
+}
+
 RB_METHOD(bitmapDrawText) {
     Bitmap *b = getPrivateData<Bitmap>(self);
     
@@ -309,7 +421,7 @@ RB_METHOD(bitmapTextSize) {
     return wrapObject(rect, RectType);
 }
 
-DEF_GFX_PROP_OBJ_VAL(Bitmap, Font, Font, "font")
+DEF_GFX_PROP_OBJ_VAL(Bitmap, Font, Font, FontSlot)
 
 RB_METHOD(bitmapGradientFillRect) {
     Bitmap *b = getPrivateData<Bitmap>(self);
@@ -371,13 +483,21 @@ RB_METHOD(bitmapClearRect) {
 }
 
 RB_METHOD(bitmapBlur) {
-    RB_UNUSED_PARAM;
-    
     Bitmap *b = getPrivateData<Bitmap>(self);
     
-    GFX_LOCK;
-    b->blur();
-    GFX_UNLOCK;
+    /* Without arguments, the small fixed blur RGSS has */
+    if (argc == 0) {
+        GFX_LOCK;
+        b->blur();
+        GFX_UNLOCK;
+        
+        return Qnil;
+    }
+    
+    int radius, passes = 1;
+    rb_get_args(argc, argv, "i|i", &radius, &passes RB_ARG_END);
+    
+    GFX_GUARD_EXC(b->blur(radius, passes););
     
     return Qnil;
 }
@@ -701,8 +821,8 @@ RB_METHOD(bitmapSnapToBitmap) {
     
     VALUE ret = rb_obj_alloc(rb_class_of(self));
     
-    bitmapInitProps(newbitmap, ret);
     setPrivateData(ret, newbitmap);
+    bitmapInitProps(newbitmap, ret);
     
     return ret;
 }
@@ -715,6 +835,74 @@ RB_METHOD(bitmapGetMaxSize){
     return INT2NUM(Bitmap::maxSize());
 }
 
+static VALUE bitmapBatchYield(VALUE self) {
+    return rb_yield(self);
+}
+
+static VALUE bitmapBatchEnd(VALUE self) {
+    Bitmap *b = getPrivateData<Bitmap>(self);
+    
+    GFX_GUARD_EXC(b->endBatch(););
+    
+    return Qnil;
+}
+
+RB_METHOD(bitmapDrawBatch) {
+    RB_UNUSED_PARAM;
+    
+    rb_check_argc(argc, 0);
+    
+    if (!rb_block_given_p())
+        rb_raise(rb_eArgError, "no block given");
+    
+    Bitmap *b = getPrivateData<Bitmap>(self);
+    
+    GFX_GUARD_EXC(b->beginBatch(););
+    
+#if RAPI_FULL < 270
+    return rb_ensure((VALUE(*)(ANYARGS))bitmapBatchYield, self,
+                     (VALUE(*)(ANYARGS))bitmapBatchEnd, self);
+#else
+    return rb_ensure(bitmapBatchYield, self, bitmapBatchEnd, self);
+#endif
+}
+
+RB_METHOD(bitmapGetPixelKernels){
+    RB_UNUSED_PARAM;
+    
+    rb_check_argc(argc, 0);
+    
+    return rb_str_new_cstr(pixelKernels().name);
+}
+
+RB_METHOD(bitmapBenchmarkPixelKernels){
+    RB_UNUSED_PARAM;
+    
+    VALUE pixelsArg, roundsArg;
+    rb_scan_args(argc, argv, "02", &pixelsArg, &roundsArg);
+    
+    size_t pixels = NIL_P(pixelsArg) ? (1 << 20) : NUM2ULONG(pixelsArg);
+    int rounds = NIL_P(roundsArg) ? 16 : NUM2INT(roundsArg);
+    
+    std::vector<PixelKernelResult> results;
+    GUARD_EXC(results = pixelKernelsBenchmark(pixels, rounds););
+    
+    VALUE ret = rb_ary_new();
+    
+    for (size_t i = 0; i < results.size(); ++i) {
+        VALUE entry = rb_hash_new();
+        
+        rb_hash_aset(entry, ID2SYM(rb_intern("path")), rb_str_new_cstr(results[i].path.c_str()));
+        rb_hash_aset(entry, ID2SYM(rb_intern("kernel")), rb_str_new_cstr(results[i].kernel.c_str()));
+        rb_hash_aset(entry, ID2SYM(rb_intern("exact")), rb_bool_new(results[i].exact));
+        rb_hash_aset(entry, ID2SYM(rb_intern("mpix_per_sec")), rb_float_new(results[i].mpixPerSec));
+        
+        rb_ary_push(ret, entry);
+    }
+    
+    return ret;
+}
+
 RB_METHOD(bitmapInitializeCopy) {
     rb_check_argc(argc, 1);
     VALUE origObj = argv[0];
@@ -727,9 +915,9 @@ RB_METHOD(bitmapInitializeCopy) {
     
     GFX_GUARD_EXC(b = new Bitmap(*orig););
     
+    setPrivateData(self, b);
     bitmapInitProps(b, self);
     b->setFont(orig->getFont());
-    setPrivateData(self, b);
     
     return self;
 }
@@ -760,6 +948,7 @@ void bitmapBindingInit() {
     _rb_define_method(klass, "get_pixel", bitmapGetPixel);
     _rb_define_method(klass, "set_pixel", bitmapSetPixel);
     _rb_define_method(klass, "hue_change", bitmapHueChange);
+    _rb_define_method(klass, "color_matrix!", bitmapColorMatrix);
     _rb_define_method(klass, "draw_text", bitmapDrawText);
     _rb_define_method(klass, "text_size", bitmapTextSize);
     
@@ -769,11 +958,15 @@ void bitmapBindingInit() {
     
     _rb_define_method(klass, "gradient_fill_rect", bitmapGradientFillRect);
     _rb_define_method(klass, "clear_rect", bitmapClearRect);
+    _rb_define_method(klass, "draw_batch", bitmapDrawBatch);
     _rb_define_method(klass, "blur", bitmapBlur);
     _rb_define_method(klass, "radial_blur", bitmapRadialBlur);
     
     _rb_define_method(klass, "mega?", bitmapGetMega);
     rb_define_singleton_method(klass, "max_size", RUBY_METHOD_FUNC(bitmapGetMaxSize), -1);
+    rb_define_singleton_method(klass, "pixel_kernels", RUBY_METHOD_FUNC(bitmapGetPixelKernels), -1);
+    rb_define_singleton_method(klass, "benchmark_pixel_kernels", RUBY_METHOD_FUNC(bitmapBenchmarkPixelKernels), -1);
+    rb_define_singleton_method(klass, "color_matrix", RUBY_METHOD_FUNC(bitmapComposeColorMatrix), -1);
     
     _rb_define_method(klass, "animated?", bitmapGetAnimated);
     _rb_define_method(klass, "playing", bitmapGetPlaying);
@@ -44,11 +44,23 @@ static void collectStrings(VALUE obj, std::vector<std::string> &out) {
 }
 
 #if RAPI_FULL > 187
-DEF_TYPE(Font);
+DEF_SLOTS_TYPE(Font);
 #else
-DEF_ALLOCFUNC(Font);
+DEF_SLOTS_ALLOCFUNC(Font);
 #endif
 
+enum {
+  NameSlot = 0,
+  ColorSlot,
+  OutColorSlot,
+  FontSlotEnd
+};
+
+static_assert(FontSlotEnd <= BindingSlots::SlotCount, "Too many Font slots");
+
+/* Class level defaults stay instance variables of the Font class */
+static ID defaultNameID;
+
 RB_METHOD(fontDoesExist) {
   RB_UNUSED_PARAM;
 
@@ -74,7 +86,7 @@ RB_METHOD(fontInitialize) {
   Font *f;
 
   if (NIL_P(namesObj)) {
-    namesObj = rb_iv_get(rb_obj_class(self), "default_name");
+    namesObj = rb_ivar_get(rb_obj_class(self), defaultNameID);
     f = new Font(0, size);
   } else {
     std::vector<std::string> names;
@@ -86,17 +98,17 @@ RB_METHOD(fontInitialize) {
   /* This is semantically wrong; the new Font object should take
    * a dup'ed object here in case of an array. Ditto for the setters.
    * However the same bug/behavior exists in all RM versions. */
-  rb_iv_set(self, "name", namesObj);
-
   setPrivateData(self, f);
 
+  setPropertySlot(f, NameSlot, namesObj);
+
   /* Wrap property objects */
   f->initDynAttribs();
 
-  wrapProperty(self, &f->getColor(), "color", ColorType);
+  wrapPropertySlot(f, ColorSlot, &f->getColor(), ColorType);
 
   // if (rgssVer >= 3)
-    wrapProperty(self, &f->getOutColor(), "out_color", ColorType);
+    wrapPropertySlot(f, OutColorSlot, &f->getOutColor(), ColorType);
 
   return self;
 }
@@ -112,13 +124,16 @@ RB_METHOD(fontInitializeCopy) {
   Font *f = new Font(*orig);
   setPrivateData(self, f);
 
+  /* Slots aren't copied along with the Font */
+  setPropertySlot(f, NameSlot, getPropertySlot(orig, NameSlot));
+
   /* Wrap property objects */
   f->initDynAttribs();
 
-  wrapProperty(self, &f->getColor(), "color", ColorType);
+  wrapPropertySlot(f, ColorSlot, &f->getColor(), ColorType);
 
   // if (rgssVer >= 3)
-    wrapProperty(self, &f->getOutColor(), "out_color", ColorType);
+    wrapPropertySlot(f, OutColorSlot, &f->getOutColor(), ColorType);
 
   return self;
 }
@@ -126,7 +141,9 @@ RB_METHOD(fontInitializeCopy) {
 RB_METHOD(FontGetName) {
   RB_UNUSED_PARAM;
 
-  return rb_iv_get(self, "name");
+  Font *f = getPrivateData<Font>(self);
+
+  return getPropertySlot(f, NameSlot);
 }
 
 RB_METHOD(FontSetName) {
@@ -138,15 +155,15 @@ RB_METHOD(FontSetName) {
   collectStrings(argv[0], namesObj);
 
   f->setName(namesObj);
-  rb_iv_set(self, "name", argv[0]);
+  setPropertySlot(f, NameSlot, argv[0]);
 
   return argv[0];
 }
 
 template <class C> static void checkDisposed(VALUE) {}
 
-DEF_PROP_OBJ_VAL(Font, Color, Color, "color")
-DEF_PROP_OBJ_VAL(Font, Color, OutColor, "out_color")
+DEF_PROP_OBJ_VAL(Font, Color, Color, ColorSlot)
+DEF_PROP_OBJ_VAL(Font, Color, OutColor, OutColorSlot)
 
 DEF_PROP_I(Font, Size)
 
@@ -195,7 +212,7 @@ RB_METHOD(FontSetDefaultOutColor) {
 RB_METHOD(FontGetDefaultName) {
   RB_UNUSED_PARAM;
 
-  return rb_iv_get(self, "default_name");
+  return rb_ivar_get(self, defaultNameID);
 }
 
 RB_METHOD(FontSetDefaultName) {
@@ -207,7 +224,7 @@ RB_METHOD(FontSetDefaultName) {
   collectStrings(argv[0], namesObj);
 
   Font::setDefaultName(namesObj, shState->fontState());
-  rb_iv_set(self, "default_name", argv[0]);
+  rb_ivar_set(self, defaultNameID, argv[0]);
 
   return argv[0];
 }
@@ -237,6 +254,8 @@ RB_METHOD(FontSetDefaultColor) {
   }
 
 void fontBindingInit() {
+  defaultNameID = rb_intern("default_name");
+
   VALUE klass = rb_define_class("Font", rb_cObject);
 #if RAPI_FULL > 187
   rb_define_alloc_func(klass, classAllocate<&FontType>);
@@ -260,7 +279,7 @@ void fontBindingInit() {
       rb_ary_push(defNamesObj, rb_utf8_str_new_cstr(defNames[i].c_str()));
   }
 
-  rb_iv_set(klass, "default_name", defNamesObj);
+  rb_ivar_set(klass, defaultNameID, defNamesObj);
 
   // if (rgssVer >= 3)
     wrapProperty(klass, &Font::getDefaultOutColor(), "default_out_color",
@@ -21,6 +21,8 @@
 
 #include "config.h"
 #include "graphics.h"
+#include "profiler.h"
+#include "streambuffer.h"
 #include "sharedstate.h"
 #include "binding-util.h"
 #include "binding-types.h"
@@ -30,6 +32,9 @@
 #include <ruby/thread.h>
 #endif
 
+/* Runs the blocks of finished HTTPLite async requests */
+void httpDispatchCompleted();
+
 RB_METHOD(graphicsDelta) {
     RB_UNUSED_PARAM;
     GFX_LOCK;
@@ -51,6 +56,7 @@ RB_METHOD(graphicsUpdate)
 #else
     shState->graphics().update();
 #endif
+    httpDispatchCompleted();
     return Qnil;
 }
 
@@ -63,6 +69,66 @@ RB_METHOD(graphicsAverageFrameRate)
     return ret;
 }
 
+RB_METHOD(graphicsGLStateStats)
+{
+    RB_UNUSED_PARAM;
+    unsigned issued, skipped;
+    GFX_LOCK;
+    shState->graphics().glStateStats(issued, skipped);
+    GFX_UNLOCK;
+    VALUE ret = rb_ary_new();
+    rb_ary_push(ret, UINT2NUM(issued));
+    rb_ary_push(ret, UINT2NUM(skipped));
+    return ret;
+}
+
+RB_METHOD(graphicsVertexStreamStats)
+{
+    RB_UNUSED_PARAM;
+    
+    VALUE ret = rb_hash_new();
+    
+    GFX_LOCK;
+    const StreamBuffer::Stats &st = shState->streamBuffer().stats();
+    
+    rb_hash_aset(ret, ID2SYM(rb_intern("bytes")), ULL2NUM(st.bytes));
+    rb_hash_aset(ret, ID2SYM(rb_intern("uploads")), UINT2NUM(st.uploads));
+    rb_hash_aset(ret, ID2SYM(rb_intern("waits")), UINT2NUM(st.waits));
+    rb_hash_aset(ret, ID2SYM(rb_intern("orphans")), UINT2NUM(st.orphans));
+    rb_hash_aset(ret, ID2SYM(rb_intern("capacity")), LL2NUM(st.capacity));
+    rb_hash_aset(ret, ID2SYM(rb_intern("persistent")), rb_bool_new(st.persistent));
+    GFX_UNLOCK;
+    
+    return ret;
+}
+
+RB_METHOD(graphicsProfileReport)
+{
+    RB_UNUSED_PARAM;
+    
+    VALUE ret = rb_hash_new();
+    
+    GFX_LOCK;
+    const Profiler &profiler = shState->profiler();
+    
+    for (int i = 0; i < Profiler::SectionCount; ++i) {
+        const Profiler::Stats &st = profiler.stats(i);
+        
+        VALUE entry = rb_hash_new();
+        rb_hash_aset(entry, ID2SYM(rb_intern("calls")), rb_float_new(st.calls));
+        rb_hash_aset(entry, ID2SYM(rb_intern("cpu")), rb_float_new(st.cpuMs));
+        rb_hash_aset(entry, ID2SYM(rb_intern("gpu")),
+                     profiler.hasGpuTimer() ? rb_float_new(st.gpuMs) : Qnil);
+        
+        rb_hash_aset(ret, ID2SYM(rb_intern(Profiler::sectionName(i))), entry);
+    }
+    
+    rb_hash_aset(ret, ID2SYM(rb_intern("frame")), rb_float_new(profiler.frameMs()));
+    GFX_UNLOCK;
+    
+    return ret;
+}
+
 RB_METHOD(graphicsFreeze)
 {
     RB_UNUSED_PARAM;
@@ -81,10 +147,48 @@ RB_METHOD(graphicsTransition)
     int duration = 8;
     const char *filename = "";
     int vague = 40;
+    const char *shader = "";
+    
+    rb_get_args(argc, argv, "|iziz", &duration, &filename, &vague, &shader RB_ARG_END);
+    
+    GFX_GUARD_EXC( shState->graphics().transition(duration, filename, vague, shader); )
+    
+    return Qnil;
+}
+
+RB_METHOD(graphicsStartTransition)
+{
+    RB_UNUSED_PARAM;
+    
+    int duration = 8;
+    const char *filename = "";
+    int vague = 40;
+    const char *shader = "";
     
-    rb_get_args(argc, argv, "|izi", &duration, &filename, &vague RB_ARG_END);
+    rb_get_args(argc, argv, "|iziz", &duration, &filename, &vague, &shader RB_ARG_END);
     
-    GFX_GUARD_EXC( shState->graphics().transition(duration, filename, vague); )
+    GFX_GUARD_EXC( shState->graphics().startTransition(duration, filename, vague, shader); )
+    
+    return Qnil;
+}
+
+RB_METHOD(graphicsTransitioning)
+{
+    RB_UNUSED_PARAM;
+    
+    return rb_bool_new(shState->graphics().isTransitioning());
+}
+
+RB_METHOD(graphicsPreloadTransition)
+{
+    RB_UNUSED_PARAM;
+    
+    const char *filename = "";
+    const char *shader = "";
+    
+    rb_get_args(argc, argv, "|zz", &filename, &shader RB_ARG_END);
+    
+    GFX_GUARD_EXC( shState->graphics().preloadTransition(filename, shader); )
     
     return Qnil;
 }
@@ -344,10 +448,16 @@ RB_METHOD(graphicsScreenshot)
 {
     RB_UNUSED_PARAM;
 
-    VALUE filename;
-    rb_scan_args(argc, argv, "1", &filename);
+    VALUE filename, async;
+    rb_scan_args(argc, argv, "11", &filename, &async);
     SafeStringValue(filename);
     
+    /* Only queues the readback, no need to give up the GVL */
+    if (RTEST(async)) {
+        GFX_GUARD_EXC(shState->graphics().screenshot(RSTRING_PTR(filename), true););
+        return Qnil;
+    }
+    
 #if RAPI_MAJOR >= 2
     rb_thread_call_without_gvl([](void* fn) -> void* {
         graphicsScreenshotInternal((const char*)fn);
@@ -359,6 +469,107 @@ RB_METHOD(graphicsScreenshot)
     return Qnil;
 }
 
+RB_METHOD(graphicsStartCapture)
+{
+    RB_UNUSED_PARAM;
+    
+    const char *path;
+    int every = 1;
+    rb_get_args(argc, argv, "z|i", &path, &every RB_ARG_END);
+    
+    GFX_GUARD_EXC(shState->graphics().startCapture(path, every););
+    
+    return Qnil;
+}
+
+RB_METHOD(graphicsStopCapture)
+{
+    RB_UNUSED_PARAM;
+    
+    GFX_GUARD_EXC(shState->graphics().stopCapture(););
+    
+    return Qnil;
+}
+
+RB_METHOD(graphicsCapturing)
+{
+    RB_UNUSED_PARAM;
+    
+    return rb_bool_new(shState->graphics().isCapturing());
+}
+
+RB_METHOD(graphicsCapturePending)
+{
+    RB_UNUSED_PARAM;
+    
+    int pending;
+    GFX_LOCK;
+    pending = shState->graphics().capturesPending();
+    GFX_UNLOCK;
+    
+    return rb_fix_new(pending);
+}
+
+void graphicsFlushCapturesInternal()
+{
+    GFX_GUARD_EXC(shState->graphics().flushCaptures(););
+}
+
+RB_METHOD(graphicsFlushCaptures)
+{
+    RB_UNUSED_PARAM;
+    
+#if RAPI_MAJOR >= 2
+    rb_thread_call_without_gvl([](void*) -> void* {
+        graphicsFlushCapturesInternal();
+        return 0;
+    }, 0, 0, 0);
+#else
+    graphicsFlushCapturesInternal();
+#endif
+    return Qnil;
+}
+
+RB_METHOD(graphicsGetScalerChain)
+{
+    RB_UNUSED_PARAM;
+    
+    GFX_LOCK;
+    std::vector<std::string> chain = shState->graphics().getScalerChain();
+    GFX_UNLOCK;
+    
+    VALUE ret = rb_ary_new();
+    
+    for (size_t i = 0; i < chain.size(); ++i)
+        rb_ary_push(ret, rb_utf8_str_new_cstr(chain[i].c_str()));
+    
+    return ret;
+}
+
+RB_METHOD(graphicsSetScalerChain)
+{
+    RB_UNUSED_PARAM;
+    
+    VALUE stages;
+    rb_scan_args(argc, argv, "1", &stages);
+    
+    std::vector<std::string> chain;
+    
+    if (!NIL_P(stages)) {
+        Check_Type(stages, T_ARRAY);
+        
+        for (long i = 0; i < RARRAY_LEN(stages); ++i) {
+            VALUE stage = rb_ary_entry(stages, i);
+            SafeStringValue(stage);
+            chain.push_back(RSTRING_PTR(stage));
+        }
+    }
+    
+    GFX_GUARD_EXC(shState->graphics().setScalerChain(chain););
+    
+    return stages;
+}
+
 DEF_GRA_PROP_I(FrameRate)
 DEF_GRA_PROP_I(FrameCount)
 DEF_GRA_PROP_I(Brightness)
@@ -372,6 +583,8 @@ DEF_GRA_PROP_I(SmoothScaling)
 DEF_GRA_PROP_B(IntegerScaling)
 DEF_GRA_PROP_B(LastMileScaling)
 DEF_GRA_PROP_B(Threadsafe)
+DEF_GRA_PROP_B(Profiling)
+DEF_GRA_PROP_B(ProfileOverlay)
 
 #define INIT_GRA_PROP_BIND(PropName, prop_name_s) \
 { \
@@ -387,14 +600,24 @@ void graphicsBindingInit()
     _rb_define_module_function(module, "update", graphicsUpdate);
     _rb_define_module_function(module, "freeze", graphicsFreeze);
     _rb_define_module_function(module, "transition", graphicsTransition);
+    _rb_define_module_function(module, "start_transition", graphicsStartTransition);
+    _rb_define_module_function(module, "transitioning?", graphicsTransitioning);
+    _rb_define_module_function(module, "preload_transition", graphicsPreloadTransition);
     _rb_define_module_function(module, "frame_reset", graphicsFrameReset);
     _rb_define_module_function(module, "screenshot", graphicsScreenshot);
+    _rb_define_module_function(module, "start_capture", graphicsStartCapture);
+    _rb_define_module_function(module, "stop_capture", graphicsStopCapture);
+    _rb_define_module_function(module, "capturing?", graphicsCapturing);
+    _rb_define_module_function(module, "capture_pending", graphicsCapturePending);
+    _rb_define_module_function(module, "flush_captures", graphicsFlushCaptures);
     
     _rb_define_module_function(module, "__reset__", graphicsReset);
     
     INIT_GRA_PROP_BIND( FrameRate,  "frame_rate"  );
     INIT_GRA_PROP_BIND( FrameCount, "frame_count" );
     _rb_define_module_function(module, "average_frame_rate", graphicsAverageFrameRate);
+    _rb_define_module_function(module, "gl_state_stats", graphicsGLStateStats);
+    _rb_define_module_function(module, "vertex_stream_stats", graphicsVertexStreamStats);
 
     _rb_define_module_function(module, "width", graphicsWidth);
     _rb_define_module_function(module, "height", graphicsHeight);
@@ -425,5 +648,9 @@ void graphicsBindingInit()
     INIT_GRA_PROP_BIND( SmoothScaling,    "smooth_scaling"     );
     INIT_GRA_PROP_BIND( IntegerScaling,   "integer_scaling"    );
     INIT_GRA_PROP_BIND( LastMileScaling,  "last_mile_scaling"  );
+    INIT_GRA_PROP_BIND( ScalerChain,      "scaler_chain"       );
     INIT_GRA_PROP_BIND( Threadsafe,       "thread_safe"        );
+    INIT_GRA_PROP_BIND( Profiling,        "profiling"          );
+    INIT_GRA_PROP_BIND( ProfileOverlay,   "profile_overlay"    );
+    _rb_define_module_function(module, "profile_report", graphicsProfileReport);
 }
@@ -7,7 +7,7 @@
 
 #include <stdio.h>
 
-#include "util/json5pp.hpp"
+#include "util/jsonsax.h"
 #include "binding-util.h"
 
 #if RAPI_MAJOR >= 2
@@ -16,6 +16,10 @@
 
 #include "net/net.h"
 
+#include <functional>
+#include <math.h>
+#include <string.h>
+
 VALUE stringMap2hash(mkxp_net::StringMap &map) {
     VALUE ret = rb_hash_new();
     for (auto const &item : map) {
@@ -74,18 +78,62 @@ VALUE formResponse(mkxp_net::HTTPResponse &res) {
     return ret;
 }
 
-#if RAPI_MAJOR >= 2
-void* httpGetInternal(void *req) {
-    VALUE ret;
+typedef std::function<mkxp_net::HTTPResponse()> HTTPPerform;
+
+typedef struct {
+    HTTPPerform perform;
+    mkxp_net::HTTPResponse response;
+    bool failed;
+    Exception error;
+} HTTPCall;
+
+/* Runs without the GVL, so it must not touch any Ruby objects */
+void* httpCallInternal(void *data) {
+    HTTPCall *call = (HTTPCall*)data;
     
-    GUARD_EXC(
-              mkxp_net::HTTPResponse res = ((mkxp_net::HTTPRequest*)req)->get();
-              ret = formResponse(res);
-              );
+    try {
+        call->response = call->perform();
+    }
+    catch (const Exception &e) {
+        call->error = e;
+        call->failed = true;
+    }
     
-    return (void*)ret;
+    return 0;
 }
+
+VALUE httpRun(HTTPPerform perform) {
+    Exception error(Exception::MKXPError, "");
+    bool failed;
+    VALUE ret = Qnil;
+    
+    {
+        HTTPCall call {perform, mkxp_net::HTTPResponse(), false, error};
+#if RAPI_MAJOR >= 2
+        rb_thread_call_without_gvl(httpCallInternal, &call, 0, 0);
+#else
+        httpCallInternal(&call);
 #endif
+        failed = call.failed;
+        
+        if (failed)
+            error = call.error;
+        else
+            ret = formResponse(call.response);
+    }
+    
+    if (failed)
+        raiseRbExc(error);
+    
+    return ret;
+}
+
+void applyHeaders(mkxp_net::HTTPRequest &req, VALUE rheaders) {
+    if (rheaders != Qnil) {
+        auto headers = hash2StringMap(rheaders);
+        req.headers().insert(headers.begin(), headers.end());
+    }
+}
 
 RB_METHOD(httpGet) {
     RB_UNUSED_PARAM;
@@ -97,87 +145,185 @@ RB_METHOD(httpGet) {
     bool rd;
     rb_bool_arg(redirect, &rd);
     mkxp_net::HTTPRequest req(RSTRING_PTR(path), rd);
-    if (rheaders != Qnil) {
-        auto headers = hash2StringMap(rheaders);
-        req.headers().insert(headers.begin(), headers.end());
-    }
-#if RAPI_MAJOR >= 2
-    return (VALUE)rb_thread_call_without_gvl(httpGetInternal, &req, 0, 0);
-#else
-    return (VALUE)httpGetInternal(&req);
-#endif
+    applyHeaders(req, rheaders);
+    
+    return httpRun([&]() { return req.get(); });
 }
 
-#if RAPI_MAJOR >= 2
-
-typedef struct {
-    mkxp_net::HTTPRequest *req;
-    mkxp_net::StringMap *postData;
-} httpPostInternalArgs;
+RB_METHOD(httpPost) {
+    RB_UNUSED_PARAM;
+    
+    VALUE path, postDataHash, rheaders, redirect;
+    rb_scan_args(argc, argv, "22", &path, &postDataHash, &rheaders, &redirect);
+    SafeStringValue(path);
+    
+    bool rd;
+    rb_bool_arg(redirect, &rd);
+    mkxp_net::HTTPRequest req(RSTRING_PTR(path), rd);
+    applyHeaders(req, rheaders);
+    
+    mkxp_net::StringMap postData = hash2StringMap(postDataHash);
+    
+    return httpRun([&]() { return req.post(postData); });
+}
 
-void* httpPostInternal(void *args) {
-    VALUE ret;
+RB_METHOD(httpPostBody) {
+    RB_UNUSED_PARAM;
     
-    mkxp_net::HTTPRequest *req = ((httpPostInternalArgs*)args)->req;
-    mkxp_net::StringMap *postData = ((httpPostInternalArgs*)args)->postData;
+    VALUE path, body, ctype, rheaders;
+    rb_scan_args(argc, argv, "31", &path, &body, &ctype, &rheaders);
+    SafeStringValue(path);
+    SafeStringValue(body);
+    SafeStringValue(ctype);
+    
+    mkxp_net::HTTPRequest req(RSTRING_PTR(path));
+    applyHeaders(req, rheaders);
     
-    GUARD_EXC(
-              mkxp_net::HTTPResponse res = req->post(*postData);
-              ret = formResponse(res);
-              );
+    const char *reqbody = RSTRING_PTR(body);
+    const char *reqctype = RSTRING_PTR(ctype);
     
-    return (void*)ret;
+    return httpRun([&]() { return req.post(reqbody, reqctype); });
 }
-#endif
 
-RB_METHOD(httpPost) {
+// HTTPLite.download(url, file[, headers[, redirect]])
+RB_METHOD(httpDownload) {
     RB_UNUSED_PARAM;
     
-    VALUE path, postDataHash, rheaders, redirect;
-    rb_scan_args(argc, argv, "22", &path, &postDataHash, &rheaders, &redirect);
+    VALUE path, file, rheaders, redirect;
+    rb_scan_args(argc, argv, "22", &path, &file, &rheaders, &redirect);
     SafeStringValue(path);
+    SafeStringValue(file);
     
     bool rd;
     rb_bool_arg(redirect, &rd);
     mkxp_net::HTTPRequest req(RSTRING_PTR(path), rd);
-    if (rheaders != Qnil) {
-        auto headers = hash2StringMap(rheaders);
-        req.headers().insert(headers.begin(), headers.end());
-    }
+    applyHeaders(req, rheaders);
     
-    mkxp_net::StringMap postData = hash2StringMap(postDataHash);
-    httpPostInternalArgs args {&req, &postData};
-#if RAPI_MAJOR >= 2
-    return (VALUE)rb_thread_call_without_gvl(httpPostInternal, &args, 0, 0);
+    const char *filePath = RSTRING_PTR(file);
+    
+    return httpRun([&]() { return req.download(filePath); });
+}
+
+/* Handle returned by the *_async functions */
+struct HTTPTaskHandle {
+    mkxp_net::HTTPTaskPtr task;
+};
+
+#if RAPI_FULL > 187
+DEF_TYPE_CUSTOMNAME(HTTPTaskHandle, "Request");
 #else
-    return httpPostInternal(&args);
+DEF_ALLOCFUNC(HTTPTaskHandle);
 #endif
+
+static VALUE requestKlass;
+
+/* Requests with a block, waiting for httpDispatchCompleted() */
+static VALUE pendingRequests;
+static ID callbackID;
+static ID callID;
+
+VALUE wrapTask(mkxp_net::HTTPTaskPtr task) {
+    HTTPTaskHandle *handle = new HTTPTaskHandle;
+    handle->task = task;
+    
+    VALUE obj = rb_obj_alloc(requestKlass);
+    setPrivateData(obj, handle);
+    
+    if (rb_block_given_p()) {
+        rb_ivar_set(obj, callbackID, rb_block_proc());
+        rb_ary_push(pendingRequests, obj);
+    }
+    
+    return obj;
 }
 
-#if RAPI_MAJOR >= 2
-typedef struct {
-    mkxp_net::HTTPRequest *req;
-    const char *body;
-    const char *ctype;
-} httpPostBodyInternalArgs;
+/* Converts a finished task; on failure, returns nil and
+ * stores the message in 'error' */
+VALUE taskResponse(mkxp_net::HTTPTask &task, std::string &error) {
+    try {
+        return formResponse(task.response());
+    }
+    catch (const Exception &e) {
+        error = e.msg.c_str();
+    }
+    
+    return Qnil;
+}
 
-void* httpPostBodyInternal(void *args) {
-    VALUE ret;
+void httpDispatchCompleted() {
+    if (RARRAY_LEN(pendingRequests) == 0)
+        return;
     
-    mkxp_net::HTTPRequest *req = ((httpPostBodyInternalArgs*)args)->req;
-    const char *reqbody = ((httpPostBodyInternalArgs*)args)->body;
-    const char *reqctype = ((httpPostBodyInternalArgs*)args)->ctype;
+    /* Collect the finished ones first, as callbacks
+     * may well start new requests */
+    VALUE finished = rb_ary_new();
     
-    GUARD_EXC(
-              mkxp_net::HTTPResponse res = req->post(reqbody, reqctype);
-              ret = formResponse(res);
-              );
+    for (long i = 0; i < RARRAY_LEN(pendingRequests); ++i) {
+        VALUE obj = rb_ary_entry(pendingRequests, i);
+        HTTPTaskHandle *handle = getPrivateData<HTTPTaskHandle>(obj);
+        
+        if (handle->task->isDone())
+            rb_ary_push(finished, obj);
+    }
     
-    return (void*)ret;
+    for (long i = 0; i < RARRAY_LEN(finished); ++i) {
+        VALUE obj = rb_ary_entry(finished, i);
+        HTTPTaskHandle *handle = getPrivateData<HTTPTaskHandle>(obj);
+        
+        /* Removed one at a time, so a raising callback
+         * doesn't drop the ones after it */
+        rb_ary_delete(pendingRequests, obj);
+        
+        std::string error;
+        VALUE response = taskResponse(*handle->task, error);
+        VALUE errorObj = error.empty() ? Qnil : rb_utf8_str_new_cstr(error.c_str());
+        
+        rb_funcall(rb_ivar_get(obj, callbackID), callID, 2, response, errorObj);
+    }
 }
-#endif
 
-RB_METHOD(httpPostBody) {
+// HTTPLite.get_async(url[, headers[, redirect]]) { |response, error| }
+RB_METHOD(httpGetAsync) {
+    RB_UNUSED_PARAM;
+    
+    VALUE path, rheaders, redirect;
+    rb_scan_args(argc, argv, "12", &path, &rheaders, &redirect);
+    SafeStringValue(path);
+    
+    bool rd;
+    rb_bool_arg(redirect, &rd);
+    mkxp_net::HTTPRequest req(RSTRING_PTR(path), rd);
+    applyHeaders(req, rheaders);
+    
+    mkxp_net::HTTPTaskPtr task;
+    GUARD_EXC( task = req.getAsync(); );
+    
+    return wrapTask(task);
+}
+
+// HTTPLite.post_async(url, data[, headers[, redirect]]) { |response, error| }
+RB_METHOD(httpPostAsync) {
+    RB_UNUSED_PARAM;
+    
+    VALUE path, postDataHash, rheaders, redirect;
+    rb_scan_args(argc, argv, "22", &path, &postDataHash, &rheaders, &redirect);
+    SafeStringValue(path);
+    
+    bool rd;
+    rb_bool_arg(redirect, &rd);
+    mkxp_net::HTTPRequest req(RSTRING_PTR(path), rd);
+    applyHeaders(req, rheaders);
+    
+    mkxp_net::StringMap postData = hash2StringMap(postDataHash);
+    
+    mkxp_net::HTTPTaskPtr task;
+    GUARD_EXC( task = req.postAsync(postData); );
+    
+    return wrapTask(task);
+}
+
+// HTTPLite.post_body_async(url, body, content_type[, headers]) { |response, error| }
+RB_METHOD(httpPostBodyAsync) {
     RB_UNUSED_PARAM;
     
     VALUE path, body, ctype, rheaders;
@@ -186,132 +332,411 @@ RB_METHOD(httpPostBody) {
     SafeStringValue(body);
     SafeStringValue(ctype);
     
-    
     mkxp_net::HTTPRequest req(RSTRING_PTR(path));
-    if (rheaders != Qnil) {
-        auto headers = hash2StringMap(rheaders);
-        req.headers().insert(headers.begin(), headers.end());
-    }
+    applyHeaders(req, rheaders);
+    
+    mkxp_net::HTTPTaskPtr task;
+    GUARD_EXC( task = req.postAsync(std::string(RSTRING_PTR(body), RSTRING_LEN(body)),
+                                    RSTRING_PTR(ctype)); );
+    
+    return wrapTask(task);
+}
+
+// HTTPLite.download_async(url, file[, headers[, redirect]]) { |response, error| }
+RB_METHOD(httpDownloadAsync) {
+    RB_UNUSED_PARAM;
+    
+    VALUE path, file, rheaders, redirect;
+    rb_scan_args(argc, argv, "22", &path, &file, &rheaders, &redirect);
+    SafeStringValue(path);
+    SafeStringValue(file);
+    
+    bool rd;
+    rb_bool_arg(redirect, &rd);
+    mkxp_net::HTTPRequest req(RSTRING_PTR(path), rd);
+    applyHeaders(req, rheaders);
+    
+    mkxp_net::HTTPTaskPtr task;
+    GUARD_EXC( task = req.downloadAsync(RSTRING_PTR(file)); );
+    
+    return wrapTask(task);
+}
+
+// Runs the blocks of finished requests; also done by Graphics.update
+RB_METHOD(httpPoll) {
+    RB_UNUSED_PARAM;
+    
+    httpDispatchCompleted();
+    
+    return Qnil;
+}
+
+RB_METHOD(httpRequestDone) {
+    RB_UNUSED_PARAM;
+    
+    HTTPTaskHandle *handle = getPrivateData<HTTPTaskHandle>(self);
+    
+    return rb_bool_new(handle->task->isDone());
+}
+
+void* httpRequestWaitInternal(void *task) {
+    ((mkxp_net::HTTPTask*)task)->wait();
+    return 0;
+}
+
+RB_METHOD(httpRequestWait) {
+    RB_UNUSED_PARAM;
+    
+    HTTPTaskHandle *handle = getPrivateData<HTTPTaskHandle>(self);
     
-    httpPostBodyInternalArgs args {&req, RSTRING_PTR(body), RSTRING_PTR(ctype)};
 #if RAPI_MAJOR >= 2
-    return (VALUE)rb_thread_call_without_gvl(httpPostBodyInternal, &args, 0, 0);
+    rb_thread_call_without_gvl(httpRequestWaitInternal, handle->task.get(), 0, 0);
 #else
-    return httpPostBodyInternal(&args);
+    httpRequestWaitInternal(handle->task.get());
 #endif
+    
+    std::string error;
+    VALUE response = taskResponse(*handle->task, error);
+    
+    if (!error.empty())
+        raiseRbExc(Exception(Exception::MKXPError, "%s", error.c_str()));
+    
+    return response;
 }
 
-VALUE json2rb(json5pp::value const &v) {
-    if (v.is_null())
-        return Qnil;
+// Returns nil while the request is still running
+RB_METHOD(httpRequestResponse) {
+    RB_UNUSED_PARAM;
     
-    if (v.is_number())
-        return rb_float_new(v.as_number());
+    HTTPTaskHandle *handle = getPrivateData<HTTPTaskHandle>(self);
     
-    if (v.is_string())
-        return rb_utf8_str_new_cstr(v.as_string().c_str());
+    if (!handle->task->isDone())
+        return Qnil;
     
-    if (v.is_boolean())
-        return rb_bool_new(v.as_boolean());
+    return httpRequestWait(0, 0, self);
+}
+
+/* Builds Ruby objects straight from the parser events. Open
+ * containers and pending object keys are kept in a Ruby array,
+ * so the GC can see them while the document is being read */
+struct RubyJSONBuilder {
+    VALUE stack;
+    VALUE result;
+    bool symbolizeKeys;
+    
+    RubyJSONBuilder(bool symbolizeKeys)
+    : stack(rb_ary_new()), result(Qnil), symbolizeKeys(symbolizeKeys) {}
+    
+    void add(VALUE value) {
+        long depth = RARRAY_LEN(stack);
+        
+        if (depth == 0) {
+            result = value;
+            return;
+        }
+        
+        VALUE top = rb_ary_entry(stack, depth - 1);
+        
+        if (RB_TYPE_P(top, RUBY_T_ARRAY)) {
+            rb_ary_push(top, value);
+            return;
+        }
+        
+        /* Anything else on top is the key of the enclosing Hash */
+        rb_ary_pop(stack);
+        rb_hash_aset(rb_ary_entry(stack, depth - 2), top, value);
+    }
     
-    if (v.is_integer())
-        return LL2NUM(v.as_integer());
+    void null() { add(Qnil); }
+    void boolean(bool value) { add(rb_bool_new(value)); }
+    void number(double value) { add(rb_float_new(value)); }
+    void string(const char *str, size_t len) { add(rb_utf8_str_new(str, len)); }
     
-    if (v.is_array()) {
-        auto &a = v.as_array();
-        VALUE ret = rb_ary_new();
-        for (auto item : a) {
-            rb_ary_push(ret, json2rb(item));
-        }
-        return ret;
+    void key(const char *str, size_t len) {
+        VALUE key = rb_utf8_str_new(str, len);
+        
+        if (symbolizeKeys)
+            key = rb_str_intern(key);
+        else
+            rb_obj_freeze(key);
+        
+        rb_ary_push(stack, key);
     }
     
-    if (v.is_object()) {
-        auto &o = v.as_object();
-        VALUE ret = rb_hash_new();
-        for (auto const &pair : o) {
-            rb_hash_aset(ret, rb_utf8_str_new_cstr(pair.first.c_str()), json2rb(pair.second));
-        }
-        return ret;
+    void startArray() {
+        VALUE ary = rb_ary_new();
+        add(ary);
+        rb_ary_push(stack, ary);
     }
     
-    // This should be unreachable
-    return Qnil;
-}
+    void startObject() {
+        VALUE hash = rb_hash_new();
+        add(hash);
+        rb_ary_push(stack, hash);
+    }
+    
+    void endArray() { rb_ary_pop(stack); }
+    void endObject() { rb_ary_pop(stack); }
+};
+
+static ID keysID;
 
-json5pp::value rb2json(VALUE v) {
-    if (v == Qnil)
-        return json5pp::value(nullptr);
+/* Writes Ruby objects as JSON into one growing buffer. Output
+ * matches the previous json5pp based version: two space indents
+ * when pretty, string keys only */
+/* Builds straight into a Ruby string. Anything in here may raise
+ * (a bad key, a Hash subclass overriding #keys, out of memory), so
+ * the writer holds nothing a longjmp would leak */
+struct RubyJSONWriter {
+    enum { MaxDepth = 512 };
+    
+    VALUE out;
+    bool pretty;
+    
+    RubyJSONWriter(bool pretty) : pretty(pretty) {
+        out = rb_utf8_str_new(0, 0);
+    }
     
-    if (RB_TYPE_P(v, RUBY_T_FLOAT))
-        return json5pp::value(RFLOAT_VALUE(v));
+    void put(const char *str, long len) {
+        rb_str_cat(out, str, len);
+    }
     
-    if (RB_TYPE_P(v, RUBY_T_STRING))
-        return json5pp::value(RSTRING_PTR(v));
+    void put(const char *str) {
+        put(str, strlen(str));
+    }
     
-    if (v == Qtrue || v == Qfalse)
-        return json5pp::value(RTEST(v));
+    void put(char ch) {
+        put(&ch, 1);
+    }
+    
+    void newline(int depth) {
+        if (!pretty)
+            return;
+        
+        put('\n');
+        for (int i = 0; i < depth; ++i)
+            put("  ", 2);
+    }
     
-    if (RB_TYPE_P(v, RUBY_T_FIXNUM))
-        return json5pp::value(NUM2DBL(v));
+    void string(const char *str, long len) {
+        static const char hex[] = "0123456789abcdef";
+        
+        put('"');
+        
+        /* Copy plain runs in one go */
+        const char *run = str;
+        
+        for (long i = 0; i < len; ++i) {
+            const unsigned char ch = str[i];
+            const char *esc = 0;
+            
+            switch (ch) {
+                case '"':  esc = "\\\""; break;
+                case '\\': esc = "\\\\"; break;
+                case '\b': esc = "\\b"; break;
+                case '\f': esc = "\\f"; break;
+                case '\n': esc = "\\n"; break;
+                case '\r': esc = "\\r"; break;
+                case '\t': esc = "\\t"; break;
+                default:
+                    if (ch >= ' ')
+                        continue;
+            }
+            
+            put(run, str + i - run);
+            run = str + i + 1;
+            
+            if (esc) {
+                put(esc);
+            } else {
+                put("\\u00", 3);
+                put(hex[ch >> 4]);
+                put(hex[ch & 0xf]);
+            }
+        }
+        
+        put(run, str + len - run);
+        put('"');
+    }
     
-    if (RB_TYPE_P(v, RUBY_T_ARRAY)) {
-        json5pp::value ret_value = json5pp::array({});
-        auto &ret = ret_value.as_array();
-        for (int i = 0; i < RARRAY_LEN(v); i++) {
-            ret.push_back(rb2json(rb_ary_entry(v, i)));
+    void number(double value) {
+        if (isnan(value)) {
+            put("NaN");
+            return;
+        }
+        
+        if (isinf(value)) {
+            put((value > 0) ? "Infinity" : "-Infinity");
+            return;
+        }
+        
+        /* Shortest representation that reads back the same */
+        char buf[32];
+        for (int precision = 15; precision <= 17; ++precision) {
+            snprintf(buf, sizeof(buf), "%.*g", precision, value);
+            
+            if (strtod(buf, 0) == value)
+                break;
         }
-        return ret_value;
+        
+        put(buf);
+        
+        if (!strpbrk(buf, ".e"))
+            put(".0", 2);
     }
     
-    if (RTEST(rb_funcall(v, rb_intern("is_a?"), 1, rb_cHash))) {
-        json5pp::value ret_value = json5pp::object({});
-        auto &ret = ret_value.as_object();
+    void key(VALUE key) {
+        if (SYMBOL_P(key)) {
+            const char *name = rb_id2name(SYM2ID(key));
+            string(name, strlen(name));
+            return;
+        }
         
+        SafeStringValue(key);
+        string(RSTRING_PTR(key), RSTRING_LEN(key));
+    }
+    
+    void write(VALUE v, int depth) {
+        if (depth > MaxDepth)
+            rb_raise(getRbData()->exc[MKXP], "Nesting too deep for JSON (circular reference?)");
         
-        VALUE keys = rb_funcall(v, rb_intern("keys"), 0);
+        switch (rb_type(v)) {
+            case RUBY_T_NIL:
+                put("null", 4);
+                return;
+                
+            case RUBY_T_TRUE:
+                put("true", 4);
+                return;
+                
+            case RUBY_T_FALSE:
+                put("false", 5);
+                return;
+                
+            case RUBY_T_FIXNUM: {
+                char buf[32];
+                snprintf(buf, sizeof(buf), "%ld", FIX2LONG(v));
+                put(buf);
+                return;
+            }
+                
+            case RUBY_T_BIGNUM: {
+                VALUE str = rb_big2str(v, 10);
+                put(RSTRING_PTR(str), RSTRING_LEN(str));
+                return;
+            }
+                
+            case RUBY_T_FLOAT:
+                number(RFLOAT_VALUE(v));
+                return;
+                
+            case RUBY_T_STRING:
+                string(RSTRING_PTR(v), RSTRING_LEN(v));
+                return;
+                
+            case RUBY_T_ARRAY: {
+                if (RARRAY_LEN(v) == 0) {
+                    put("[]", 2);
+                    return;
+                }
+                
+                put('[');
+                for (long i = 0; i < RARRAY_LEN(v); ++i) {
+                    if (i > 0)
+                        put(',');
+                    
+                    newline(depth + 1);
+                    write(rb_ary_entry(v, i), depth + 1);
+                }
+                newline(depth);
+                put(']');
+                return;
+            }
+                
+            default:
+                break;
+        }
         
-        for (int i = 0; i < RARRAY_LEN(keys); i++) {
-            VALUE key = rb_ary_entry(keys, i); SafeStringValue(key);
-            VALUE val = rb_hash_aref(v, key);
-            ret.emplace(RSTRING_PTR(key), rb2json(val));
+        if (RTEST(rb_obj_is_kind_of(v, rb_cHash))) {
+            VALUE keys = rb_funcall(v, keysID, 0);
+            
+            if (RARRAY_LEN(keys) == 0) {
+                put("{}", 2);
+                return;
+            }
+            
+            put('{');
+            for (long i = 0; i < RARRAY_LEN(keys); ++i) {
+                VALUE k = rb_ary_entry(keys, i);
+                
+                if (i > 0)
+                    put(',');
+                
+                newline(depth + 1);
+                key(k);
+                put(pretty ? ": " : ":");
+                write(rb_hash_aref(v, k), depth + 1);
+            }
+            newline(depth);
+            put('}');
+            return;
         }
         
-        return ret_value;
+        VALUE desc = rb_inspect(v);
+        rb_raise(getRbData()->exc[MKXP], "Invalid value for JSON: %s", RSTRING_PTR(desc));
     }
+};
+
+/* Accepts either a plain boolean or an options hash */
+static bool jsonOption(VALUE opts, const char *name, bool def) {
+    if (NIL_P(opts))
+        return def;
     
-    raiseRbExc(Exception(Exception::MKXPError, "Invalid value for JSON: %s", RSTRING_PTR(rb_inspect(v))));
+    if (!RB_TYPE_P(opts, RUBY_T_HASH))
+        return RTEST(opts);
     
-    // This should be unreachable
-    return json5pp::value(0);
+    VALUE value = rb_hash_aref(opts, ID2SYM(rb_intern(name)));
+    
+    return NIL_P(value) ? def : RTEST(value);
 }
 
+// HTTPLite::JSON.parse(json[, symbolize_names: false])
 RB_METHOD(httpJsonParse) {
     RB_UNUSED_PARAM;
     
-    VALUE jsonv;
-    rb_scan_args(argc, argv, "1", &jsonv);
+    VALUE jsonv, opts;
+    rb_scan_args(argc, argv, "11", &jsonv, &opts);
     SafeStringValue(jsonv);
     
-    json5pp::value v;
+    RubyJSONBuilder builder(jsonOption(opts, "symbolize_names", false));
+    Exception error(Exception::MKXPError, "");
+    bool failed = false;
+    
     try {
-        v = json5pp::parse5(RSTRING_PTR(jsonv));
+        jsonSaxParse(RSTRING_PTR(jsonv), RSTRING_LEN(jsonv), builder);
     }
     catch (const std::exception &e) {
-        raiseRbExc(Exception(Exception::MKXPError, "Failed to parse JSON: %s", e.what()));
+        error = Exception(Exception::MKXPError, "Failed to parse JSON: %s", e.what());
+        failed = true;
     }
     
-    return json2rb(v);
+    if (failed)
+        raiseRbExc(error);
+    
+    return builder.result;
 }
 
+// HTTPLite::JSON.stringify(obj[, pretty: true])
 RB_METHOD(httpJsonStringify) {
     RB_UNUSED_PARAM;
     
-    VALUE obj;
-    rb_scan_args(argc, argv, "1", &obj);
+    VALUE obj, opts;
+    rb_scan_args(argc, argv, "11", &obj, &opts);
+    
+    RubyJSONWriter writer(jsonOption(opts, "pretty", true));
+    writer.write(obj, 0);
     
-    json5pp::value v = rb2json(obj);
-    return rb_utf8_str_new_cstr(v.stringify5(json5pp::rule::space_indent<>()).c_str());
+    return writer.out;
 }
 
 void httpBindingInit() {
@@ -319,6 +744,32 @@ void httpBindingInit() {
     _rb_define_module_function(mNet, "get", httpGet);
     _rb_define_module_function(mNet, "post", httpPost);
     _rb_define_module_function(mNet, "post_body", httpPostBody);
+    _rb_define_module_function(mNet, "download", httpDownload);
+    
+    _rb_define_module_function(mNet, "get_async", httpGetAsync);
+    _rb_define_module_function(mNet, "post_async", httpPostAsync);
+    _rb_define_module_function(mNet, "post_body_async", httpPostBodyAsync);
+    _rb_define_module_function(mNet, "download_async", httpDownloadAsync);
+    _rb_define_module_function(mNet, "poll", httpPoll);
+    
+    callbackID = rb_intern("callback");
+    callID = rb_intern("call");
+    
+    pendingRequests = rb_ary_new();
+    rb_gc_register_address(&pendingRequests);
+    
+    requestKlass = rb_define_class_under(mNet, "Request", rb_cObject);
+#if RAPI_FULL > 187
+    rb_define_alloc_func(requestKlass, classAllocate<&HTTPTaskHandleType>);
+#else
+    rb_define_alloc_func(requestKlass, HTTPTaskHandleAllocate);
+#endif
+    rb_undef_method(rb_singleton_class(requestKlass), "new");
+    _rb_define_method(requestKlass, "done?", httpRequestDone);
+    _rb_define_method(requestKlass, "wait", httpRequestWait);
+    _rb_define_method(requestKlass, "response", httpRequestResponse);
+    
+    keysID = rb_intern("keys");
     
     VALUE mNetJSON = rb_define_module_under(mNet, "JSON");
     _rb_define_module_function(mNetJSON, "stringify", httpJsonStringify);
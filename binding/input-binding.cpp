@@ -172,6 +172,40 @@ RB_METHOD(inputRepeatTime) {
     return rb_float_new(shState->input().repeatTime(num));
 }
 
+RB_METHOD(inputPressTime) {
+    RB_UNUSED_PARAM;
+    
+    rb_check_argc(argc, 1);
+    
+    VALUE button;
+    rb_scan_args(argc, argv, "1", &button);
+    
+    int num = getButtonArg(&button);
+    
+    double t;
+    if (!shState->input().pressTime(num, t))
+        return Qnil;
+    
+    return rb_float_new(t);
+}
+
+RB_METHOD(inputPressLatency) {
+    RB_UNUSED_PARAM;
+    
+    rb_check_argc(argc, 1);
+    
+    VALUE button;
+    rb_scan_args(argc, argv, "1", &button);
+    
+    int num = getButtonArg(&button);
+    
+    double t;
+    if (!shState->input().pressLatency(num, t))
+        return Qnil;
+    
+    return rb_float_new(t);
+}
+
 RB_METHOD(inputPressEx) {
     RB_UNUSED_PARAM;
     
@@ -538,6 +572,20 @@ RB_METHOD(inputQuit)
 	return rb_bool_new(shState->input().hasQuit());
 }
 
+RB_METHOD(inputRecording)
+{
+	RB_UNUSED_PARAM;
+
+	return rb_bool_new(shState->input().isRecording());
+}
+
+RB_METHOD(inputReplaying)
+{
+	RB_UNUSED_PARAM;
+
+	return rb_bool_new(shState->input().isReplaying());
+}
+
 struct {
     const char *str;
     Input::ButtonCode val;
@@ -583,6 +631,8 @@ void inputBindingInit() {
     _rb_define_module_function(module, "release?", inputRelease);
     _rb_define_module_function(module, "count", inputCount);
     _rb_define_module_function(module, "time?", inputRepeatTime);
+    _rb_define_module_function(module, "press_time", inputPressTime);
+    _rb_define_module_function(module, "latency", inputPressLatency);
     _rb_define_module_function(module, "pressex?", inputPressEx);
     _rb_define_module_function(module, "triggerex?", inputTriggerEx);
     _rb_define_module_function(module, "repeatex?", inputRepeatEx);
@@ -624,6 +674,8 @@ void inputBindingInit() {
     _rb_define_module_function(module, "clipboard=", inputSetClipboard);
 
 	_rb_define_module_function(module, "quit?", inputQuit);
+	_rb_define_module_function(module, "recording?", inputRecording);
+	_rb_define_module_function(module, "replaying?", inputReplaying);
     
     if (rgssVer >= 3) {
         VALUE symHash = rb_hash_new();
@@ -31,152 +31,155 @@
 #define _T_INTEGER 3
 #define _T_BOOL 4
 
+/* Everything a call needs, resolved once in initialize */
+struct MiniFFI {
+    void *library;
+    MINIFFI_FUNC function;
+    
+    int nimports;
+    uint8_t imports[MINIFFI_MAX_ARGS];
+    uint8_t exports;
+    
+    /* Release the GVL for the duration of the call, so other
+     * Ruby threads can run. Not worth it for short calls */
+    bool blocking;
+    
+    MiniFFI()
+    : library(0), function(0), nimports(0), exports(_T_VOID), blocking(true) {}
+    
+    ~MiniFFI() {
+        if (library)
+            SDL_UnloadObject(library);
+    }
+};
+
 #if RAPI_FULL > 187
-DEF_TYPE_CUSTOMFREE(MiniFFI, SDL_UnloadObject);
+DEF_TYPE(MiniFFI);
 #else
-DEF_ALLOCFUNC_CUSTOMFREE(MiniFFI, SDL_UnloadObject);
+DEF_ALLOCFUNC(MiniFFI);
 #endif
 
+static ID blockingID;
+
 static void *MiniFFI_GetFunctionHandle(void *libhandle, const char *func) {
     if (!libhandle)
         return 0;
     return SDL_LoadFunction(libhandle, func);
 }
 
-// MiniFFI.new(library, function[, imports[, exports]])
+/* Returns -1 for unknown type characters */
+static int MiniFFI_ParseType(char c) {
+    switch (c) {
+        case 'V':
+        case 'v':
+            return _T_VOID;
+            
+        case 'N':
+        case 'n':
+        case 'L':
+        case 'l':
+            return _T_NUMBER;
+            
+        case 'P':
+        case 'p':
+            return _T_POINTER;
+            
+        case 'I':
+        case 'i':
+            return _T_INTEGER;
+            
+        case 'B':
+        case 'b':
+            return _T_BOOL;
+    }
+    
+    return -1;
+}
+
+static void MiniFFI_AddImport(MiniFFI *ffi, char c) {
+    int type = MiniFFI_ParseType(c);
+    
+    /* Unknown and void parameters are skipped */
+    if (type <= _T_VOID)
+        return;
+    
+    if (ffi->nimports == MINIFFI_MAX_ARGS)
+        rb_raise(rb_eRuntimeError, "too many parameters: more than %ld\n",
+                 MINIFFI_MAX_ARGS);
+    
+    ffi->imports[ffi->nimports++] = type;
+}
+
+// MiniFFI.new(library, function[, imports[, exports]][, blocking: false])
 // Yields itself in blocks
 
 RB_METHOD(MiniFFI_initialize) {
     VALUE libname, func, imports, exports;
+    VALUE opts = Qnil;
+    
+    /* Trailing options hash; neither imports nor exports can be one */
+    if (argc > 2 && RB_TYPE_P(argv[argc-1], RUBY_T_HASH))
+        opts = argv[--argc];
+    
     rb_scan_args(argc, argv, "22", &libname, &func, &imports, &exports);
     SafeStringValue(libname);
     SafeStringValue(func);
+    
+    MiniFFI *ffi = new MiniFFI();
+    setPrivateData(self, ffi);
+    
 #ifdef __APPLE__
-    void *hlib = SDL_LoadObject(mkxp_fs::normalizePath(RSTRING_PTR(libname), 1, 1).c_str());
+    ffi->library = SDL_LoadObject(mkxp_fs::normalizePath(RSTRING_PTR(libname), 1, 1).c_str());
 #else
-    void *hlib = SDL_LoadObject(RSTRING_PTR(libname));
+    ffi->library = SDL_LoadObject(RSTRING_PTR(libname));
 #endif
-    setPrivateData(self, hlib);
-    void *hfunc = MiniFFI_GetFunctionHandle(hlib, RSTRING_PTR(func));
+    void *hfunc = MiniFFI_GetFunctionHandle(ffi->library, RSTRING_PTR(func));
 #ifdef __WIN32__
-    if (hlib && !hfunc) {
+    if (ffi->library && !hfunc) {
         VALUE func_a = rb_str_new3(func);
         func_a = rb_str_cat(func_a, "A", 1);
-        hfunc = SDL_LoadFunction(hlib, RSTRING_PTR(func_a));
+        hfunc = SDL_LoadFunction(ffi->library, RSTRING_PTR(func_a));
     }
 #endif
     if (!hfunc)
         rb_raise(rb_eRuntimeError, "%s", SDL_GetError());
     
-    rb_iv_set(self, "_func", MVAL2RB((mffi_value)hfunc));
+    ffi->function = (MINIFFI_FUNC)hfunc;
+    
     rb_iv_set(self, "_funcname", func);
     rb_iv_set(self, "_libname", libname);
     
-    VALUE ary_imports = rb_ary_new();
-    VALUE *entry;
     switch (TYPE(imports)) {
         case T_NIL:
             break;
         case T_ARRAY:
-            entry = RARRAY_PTR(imports);
             for (int i = 0; i < RARRAY_LEN(imports); i++) {
-                SafeStringValue(entry[i]);
-                switch (*(char *)RSTRING_PTR(entry[i])) {
-                    case 'N':
-                    case 'n':
-                    case 'L':
-                    case 'l':
-                        rb_ary_push(ary_imports, INT2FIX(_T_NUMBER));
-                        break;
-                        
-                    case 'P':
-                    case 'p':
-                        rb_ary_push(ary_imports, INT2FIX(_T_POINTER));
-                        break;
-                        
-                    case 'I':
-                    case 'i':
-                        rb_ary_push(ary_imports, INT2FIX(_T_INTEGER));
-                        break;
-                        
-                    case 'B':
-                    case 'b':
-                        rb_ary_push(ary_imports, INT2FIX(_T_BOOL));
-                        break;
-                }
+                VALUE entry = rb_ary_entry(imports, i);
+                SafeStringValue(entry);
+                MiniFFI_AddImport(ffi, *RSTRING_PTR(entry));
             }
             break;
         default:
             SafeStringValue(imports);
             const char *s = RSTRING_PTR(imports);
-            for (int i = 0; i < RSTRING_LEN(imports); i++) {
-                switch (*s++) {
-                    case 'N':
-                    case 'n':
-                    case 'L':
-                    case 'l':
-                        rb_ary_push(ary_imports, INT2FIX(_T_NUMBER));
-                        break;
-                        
-                    case 'P':
-                    case 'p':
-                        rb_ary_push(ary_imports, INT2FIX(_T_POINTER));
-                        break;
-                        
-                    case 'I':
-                    case 'i':
-                        rb_ary_push(ary_imports, INT2FIX(_T_INTEGER));
-                        break;
-                        
-                    case 'B':
-                    case 'b':
-                        rb_ary_push(ary_imports, INT2FIX(_T_BOOL));
-                        break;
-                }
-            }
+            for (int i = 0; i < RSTRING_LEN(imports); i++)
+                MiniFFI_AddImport(ffi, s[i]);
             break;
     }
     
-    if (MINIFFI_MAX_ARGS < RARRAY_LEN(ary_imports))
-        rb_raise(rb_eRuntimeError, "too many parameters: %ld/%ld\n",
-                 RARRAY_LEN(ary_imports), MINIFFI_MAX_ARGS);
-    
-    rb_iv_set(self, "_imports", ary_imports);
-    int ex;
-    if (NIL_P(exports)) {
-        ex = _T_VOID;
-    } else {
+    if (!NIL_P(exports)) {
         SafeStringValue(exports);
-        switch (*RSTRING_PTR(exports)) {
-            case 'V':
-            case 'v':
-                ex = _T_VOID;
-                break;
-                
-            case 'N':
-            case 'n':
-            case 'L':
-            case 'l':
-                ex = _T_NUMBER;
-                break;
-                
-            case 'P':
-            case 'p':
-                ex = _T_POINTER;
-                break;
-                
-            case 'I':
-            case 'i':
-                ex = _T_INTEGER;
-                break;
-                
-            case 'B':
-            case 'b':
-                ex = _T_BOOL;
-                break;
-        }
+        int ex = MiniFFI_ParseType(*RSTRING_PTR(exports));
+        ffi->exports = (ex < 0) ? _T_VOID : ex;
+    }
+    
+    if (!NIL_P(opts)) {
+        VALUE blocking = rb_hash_aref(opts, ID2SYM(blockingID));
+        
+        if (!NIL_P(blocking))
+            ffi->blocking = RTEST(blocking);
     }
-    rb_iv_set(self, "_exports", INT2FIX(ex));
+    
     if (rb_block_given_p())
         rb_yield(self);
     return Qnil;
@@ -198,21 +201,16 @@ void* miniffi_call_cb(void *args) {
 RB_METHOD(MiniFFI_call) {
     MiniFFIFuncArgs param;
 #define params param.params
-    VALUE func = rb_iv_get(self, "_func");
-    VALUE own_imports = rb_iv_get(self, "_imports");
-    VALUE own_exports = rb_iv_get(self, "_exports");
-    MINIFFI_FUNC ApiFunction = (MINIFFI_FUNC)RB2MVAL(func);
-    VALUE args;
-    int items = rb_scan_args(argc, argv, "0*", &args);
-    int nimport = RARRAY_LEN(own_imports);
-    if (items != nimport)
+    MiniFFI *ffi = getPrivateData<MiniFFI>(self);
+    int nimport = ffi->nimports;
+    if (argc != nimport)
         rb_raise(rb_eRuntimeError,
-                 "wrong number of parameters: expected %d, got %d", nimport, items);
+                 "wrong number of parameters: expected %d, got %d", nimport, argc);
     
     for (int i = 0; i < nimport; i++) {
-        VALUE str = rb_ary_entry(args, i);
+        VALUE str = argv[i];
         mffi_value lParam = 0;
-        switch (FIX2INT(rb_ary_entry(own_imports, i))) {
+        switch (ffi->imports[i]) {
             case _T_POINTER:
                 if (NIL_P(str)) {
                     lParam = 0;
@@ -226,29 +224,31 @@ RB_METHOD(MiniFFI_call) {
                 break;
                 
             case _T_BOOL:
-                rb_bool_arg(rb_ary_entry(args, i), (bool*)&lParam);
+                rb_bool_arg(argv[i], (bool*)&lParam);
                 break;
                 
             case _T_INTEGER:
 #if INTPTR_MAX == INT64_MAX
-                lParam = RB2MVAL(rb_ary_entry(args, i)) & UINT32_MAX;
+                lParam = RB2MVAL(argv[i]) & UINT32_MAX;
                 break;
 #endif
             case _T_NUMBER:
             default:
-                lParam = RB2MVAL(rb_ary_entry(args, i));
+                lParam = RB2MVAL(argv[i]);
                 break;
         }
         params[i] = lParam;
     }
+    mffi_value ret;
 #if RAPI_MAJOR >= 2
-    MFFICallCBArgs cb_args {ApiFunction, &param, nimport};
-    mffi_value ret = (mffi_value)rb_thread_call_without_gvl(miniffi_call_cb, &cb_args, 0, 0);
-#else
-    mffi_value ret = miniffi_call_intern(ApiFunction, &param, nimport);
+    if (ffi->blocking) {
+        MFFICallCBArgs cb_args {ffi->function, &param, nimport};
+        ret = (mffi_value)rb_thread_call_without_gvl(miniffi_call_cb, &cb_args, 0, 0);
+    } else
 #endif
+    ret = miniffi_call_intern(ffi->function, &param, nimport);
     
-    switch (FIX2INT(own_exports)) {
+    switch (ffi->exports) {
         case _T_NUMBER:
         case _T_INTEGER:
             return MVAL2RB(ret);
@@ -265,7 +265,24 @@ RB_METHOD(MiniFFI_call) {
     }
 }
 
+RB_METHOD(MiniFFI_getBlocking) {
+    RB_UNUSED_PARAM;
+    
+    return rb_bool_new(getPrivateData<MiniFFI>(self)->blocking);
+}
+
+RB_METHOD(MiniFFI_setBlocking) {
+    bool blocking;
+    rb_get_args(argc, argv, "b", &blocking RB_ARG_END);
+    
+    getPrivateData<MiniFFI>(self)->blocking = blocking;
+    
+    return rb_bool_new(blocking);
+}
+
 void MiniFFIBindingInit() {
+    blockingID = rb_intern("blocking");
+    
     VALUE cMiniFFI = rb_define_class("MiniFFI", rb_cObject);
 #if RAPI_FULL > 187
     rb_define_alloc_func(cMiniFFI, classAllocate<&MiniFFIType>);
@@ -275,6 +292,8 @@ void MiniFFIBindingInit() {
     _rb_define_method(cMiniFFI, "initialize", MiniFFI_initialize);
     _rb_define_method(cMiniFFI, "call", MiniFFI_call);
     rb_define_alias(cMiniFFI, "Call", "call");
+    _rb_define_method(cMiniFFI, "blocking", MiniFFI_getBlocking);
+    _rb_define_method(cMiniFFI, "blocking=", MiniFFI_setBlocking);
     
     rb_define_const(rb_cObject, "Win32API", cMiniFFI);
 }
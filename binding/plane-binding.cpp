@@ -26,29 +26,36 @@
 #include "viewportelement-binding.h"
 
 #if RAPI_FULL > 187
-DEF_TYPE(Plane);
+DEF_SLOTS_TYPE(Plane);
 #else
-DEF_ALLOCFUNC(Plane);
+DEF_SLOTS_ALLOCFUNC(Plane);
 #endif
 
+enum {
+  BitmapSlot = ViewportElementSlotEnd,
+  ColorSlot,
+  ToneSlot,
+  PlaneSlotEnd
+};
+
+static_assert(PlaneSlotEnd <= BindingSlots::SlotCount, "Too many Plane slots");
+
 RB_METHOD(planeInitialize) {
   Plane *p = viewportElementInitialize<Plane>(argc, argv, self);
 
-  setPrivateData(self, p);
-
     GFX_LOCK;
   p->initDynAttribs();
 
-  wrapProperty(self, &p->getColor(), "color", ColorType);
-  wrapProperty(self, &p->getTone(), "tone", ToneType);
+  wrapPropertySlot(p, ColorSlot, &p->getColor(), ColorType);
+  wrapPropertySlot(p, ToneSlot, &p->getTone(), ToneType);
     GFX_UNLOCK;
 
   return self;
 }
 
-DEF_GFX_PROP_OBJ_REF(Plane, Bitmap, Bitmap, "bitmap")
-DEF_GFX_PROP_OBJ_VAL(Plane, Color, Color, "color")
-DEF_GFX_PROP_OBJ_VAL(Plane, Tone, Tone, "tone")
+DEF_GFX_PROP_OBJ_REF(Plane, Bitmap, Bitmap, BitmapSlot)
+DEF_GFX_PROP_OBJ_VAL(Plane, Color, Color, ColorSlot)
+DEF_GFX_PROP_OBJ_VAL(Plane, Tone, Tone, ToneSlot)
 
 DEF_GFX_PROP_I(Plane, OX)
 DEF_GFX_PROP_I(Plane, OY)
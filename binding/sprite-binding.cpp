@@ -28,34 +28,51 @@
 #include "sprite.h"
 #include "viewportelement-binding.h"
 
+#include <string.h>
+#include <vector>
+
 #if RAPI_FULL > 187
-DEF_TYPE(Sprite);
+DEF_SLOTS_TYPE(Sprite);
 #else
-DEF_ALLOCFUNC(Sprite);
+DEF_SLOTS_ALLOCFUNC(Sprite);
 #endif
 
+enum
+{
+    BitmapSlot = ViewportElementSlotEnd,
+    PatternSlot,
+    SrcRectSlot,
+    ColorSlot,
+    ToneSlot,
+    /* The Sprite object itself, for Viewport#pick */
+    SelfSlot,
+    SpriteSlotEnd
+};
+
+static_assert(SpriteSlotEnd <= BindingSlots::SlotCount, "Too many Sprite slots");
+
 RB_METHOD(spriteInitialize) {
     GFX_LOCK;
     Sprite *s = viewportElementInitialize<Sprite>(argc, argv, self);
     
-    setPrivateData(self, s);
-    
     /* Wrap property objects */
     s->initDynAttribs();
     
-    wrapProperty(self, &s->getSrcRect(), "src_rect", RectType);
-    wrapProperty(self, &s->getColor(), "color", ColorType);
-    wrapProperty(self, &s->getTone(), "tone", ToneType);
+    wrapPropertySlot(s, SrcRectSlot, &s->getSrcRect(), RectType);
+    wrapPropertySlot(s, ColorSlot, &s->getColor(), ColorType);
+    wrapPropertySlot(s, ToneSlot, &s->getTone(), ToneType);
+    
+    setPropertySlot(s, SelfSlot, self);
     
     GFX_UNLOCK;
     return self;
 }
 
-DEF_GFX_PROP_OBJ_REF(Sprite, Bitmap, Bitmap, "bitmap")
-DEF_GFX_PROP_OBJ_REF(Sprite, Bitmap, Pattern, "pattern")
-DEF_GFX_PROP_OBJ_VAL(Sprite, Rect, SrcRect, "src_rect")
-DEF_GFX_PROP_OBJ_VAL(Sprite, Color, Color, "color")
-DEF_GFX_PROP_OBJ_VAL(Sprite, Tone, Tone, "tone")
+DEF_GFX_PROP_OBJ_REF(Sprite, Bitmap, Bitmap, BitmapSlot)
+DEF_GFX_PROP_OBJ_REF(Sprite, Bitmap, Pattern, PatternSlot)
+DEF_GFX_PROP_OBJ_VAL(Sprite, Rect, SrcRect, SrcRectSlot)
+DEF_GFX_PROP_OBJ_VAL(Sprite, Color, Color, ColorSlot)
+DEF_GFX_PROP_OBJ_VAL(Sprite, Tone, Tone, ToneSlot)
 
 DEF_GFX_PROP_I(Sprite, X)
 DEF_GFX_PROP_I(Sprite, Y)
@@ -106,7 +123,189 @@ RB_METHOD(spriteHeight) {
     return rb_fix_new(value);
 }
 
+RB_METHOD(spriteHitTest) {
+    Sprite *s = getPrivateData<Sprite>(self);
+    
+    int x, y, alphaThreshold = 1;
+    rb_get_args(argc, argv, "ii|i", &x, &y, &alphaThreshold RB_ARG_END);
+    
+    bool result = false;
+    GFX_GUARD_EXC(result = s->hitTest(x, y, alphaThreshold););
+    
+    return rb_bool_new(result);
+}
+
+VALUE spriteObject(Sprite *s) {
+    return getPropertySlot(s, SelfSlot);
+}
+
+/* Plain value properties that can be set in bulk through
+ * Sprite#set and Sprite.batch_update */
+struct SpriteValueProp {
+    const char *name;
+    ID id;
+    void (*set)(Sprite *s, double value);
+};
+
+#define SPRITE_INT_PROP(name, Prop) \
+{ name, 0, [](Sprite *s, double v) { s->set##Prop((int)v); } }
+
+#define SPRITE_FLOAT_PROP(name, Prop) \
+{ name, 0, [](Sprite *s, double v) { s->set##Prop((float)v); } }
+
+#define SPRITE_BOOL_PROP(name, Prop) \
+{ name, 0, [](Sprite *s, double v) { s->set##Prop(v != 0); } }
+
+static SpriteValueProp spriteValueProps[] = {
+    SPRITE_INT_PROP("x", X),
+    SPRITE_INT_PROP("y", Y),
+    SPRITE_INT_PROP("z", Z),
+    SPRITE_INT_PROP("ox", OX),
+    SPRITE_INT_PROP("oy", OY),
+    SPRITE_FLOAT_PROP("zoom_x", ZoomX),
+    SPRITE_FLOAT_PROP("zoom_y", ZoomY),
+    SPRITE_FLOAT_PROP("angle", Angle),
+    SPRITE_INT_PROP("opacity", Opacity),
+    SPRITE_INT_PROP("blend_type", BlendType),
+    SPRITE_INT_PROP("bush_depth", BushDepth),
+    SPRITE_INT_PROP("bush_opacity", BushOpacity),
+    SPRITE_BOOL_PROP("visible", Visible),
+    SPRITE_BOOL_PROP("mirror", Mirror),
+    SPRITE_INT_PROP("wave_amp", WaveAmp),
+    SPRITE_INT_PROP("wave_length", WaveLength),
+    SPRITE_INT_PROP("wave_speed", WaveSpeed),
+    SPRITE_FLOAT_PROP("wave_phase", WavePhase),
+};
+
+static const int spriteValuePropCount =
+    sizeof(spriteValueProps) / sizeof(spriteValueProps[0]);
+
+static ID keysID;
+
+static int findValueProp(VALUE key) {
+    if (SYMBOL_P(key)) {
+        ID id = SYM2ID(key);
+        
+        for (int i = 0; i < spriteValuePropCount; ++i)
+            if (spriteValueProps[i].id == id)
+                return i;
+    }
+    
+    VALUE str = rb_inspect(key);
+    rb_raise(rb_eArgError, "unknown Sprite property %s", RSTRING_PTR(str));
+    
+    return -1;
+}
+
+/* Booleans are stored as 0 / 1 */
+static double propArgValue(VALUE arg, int argPos) {
+    if (arg == Qtrue)
+        return 1;
+    
+    if (arg == Qfalse || NIL_P(arg))
+        return 0;
+    
+    double value;
+    rb_float_arg(arg, &value, argPos);
+    
+    return value;
+}
+
+struct SpritePropValue {
+    int prop;
+    double value;
+};
+
+/* Sets any number of value properties in one call,
+ * eg. sprite.set(x: 10, y: 20, opacity: 128) */
+RB_METHOD(spriteSet) {
+    VALUE hash;
+    rb_get_args(argc, argv, "o", &hash RB_ARG_END);
+    
+    Check_Type(hash, T_HASH);
+    
+    Sprite *s = getPrivateData<Sprite>(self);
+    
+    /* Convert everything up front so nothing raises
+     * while properties are being applied */
+    VALUE keys = rb_funcall(hash, keysID, 0);
+    std::vector<SpritePropValue> values(RARRAY_LEN(keys));
+    
+    for (long i = 0; i < RARRAY_LEN(keys); ++i) {
+        VALUE key = rb_ary_entry(keys, i);
+        
+        values[i].prop = findValueProp(key);
+        values[i].value = propArgValue(rb_hash_aref(hash, key), (int)i);
+    }
+    
+    GFX_GUARD_EXC(
+        SceneReorderBatch batch;
+        
+        for (size_t i = 0; i < values.size(); ++i)
+            spriteValueProps[values[i].prop].set(s, values[i].value);
+    )
+    
+    return self;
+}
+
+/* Applies packed property values to many sprites in one call.
+ * 'layout' is an array of property names, 'packed' a string of
+ * native floats (Array#pack("f*")) holding layout.size values
+ * per sprite, in order. Z / Y reordering happens once at the end */
+RB_METHOD(spriteBatchUpdate) {
+    RB_UNUSED_PARAM;
+    
+    VALUE spritesObj, packedObj, layoutObj;
+    rb_get_args(argc, argv, "ooo", &spritesObj, &packedObj, &layoutObj RB_ARG_END);
+    
+    Check_Type(spritesObj, T_ARRAY);
+    Check_Type(packedObj, T_STRING);
+    Check_Type(layoutObj, T_ARRAY);
+    
+    const long count = RARRAY_LEN(spritesObj);
+    const long stride = RARRAY_LEN(layoutObj);
+    
+    if (count == 0 || stride == 0)
+        return spritesObj;
+    
+    if (RSTRING_LEN(packedObj) < (long)(count * stride * sizeof(float)))
+        rb_raise(rb_eArgError, "packed data too short: %ld floats needed",
+                 count * stride);
+    
+    std::vector<int> props(stride);
+    
+    for (long i = 0; i < stride; ++i)
+        props[i] = findValueProp(rb_ary_entry(layoutObj, i));
+    
+    std::vector<Sprite *> sprites(count);
+    
+    for (long i = 0; i < count; ++i)
+        sprites[i] = getPrivateDataCheck<Sprite>(rb_ary_entry(spritesObj, i), SpriteType);
+    
+    const char *packed = RSTRING_PTR(packedObj);
+    
+    GFX_GUARD_EXC(
+        SceneReorderBatch batch;
+        
+        for (long i = 0; i < count; ++i) {
+            for (long j = 0; j < stride; ++j) {
+                float value;
+                memcpy(&value, packed + (i * stride + j) * sizeof(float), sizeof(float));
+                
+                spriteValueProps[props[j]].set(sprites[i], value);
+            }
+        }
+    )
+    
+    return spritesObj;
+}
+
 void spriteBindingInit() {
+    keysID = rb_intern("keys");
+    
+    for (int i = 0; i < spriteValuePropCount; ++i)
+        spriteValueProps[i].id = rb_intern(spriteValueProps[i].name);
+    
     VALUE klass = rb_define_class("Sprite", rb_cObject);
 #if RAPI_FULL > 187
     rb_define_alloc_func(klass, classAllocate<&SpriteType>);
@@ -119,6 +318,9 @@ void spriteBindingInit() {
     viewportElementBindingInit<Sprite>(klass);
     
     _rb_define_method(klass, "initialize", spriteInitialize);
+    _rb_define_method(klass, "set", spriteSet);
+    
+    rb_define_class_method(klass, "batch_update", spriteBatchUpdate);
     
     INIT_PROP_BIND(Sprite, Bitmap, "bitmap");
     INIT_PROP_BIND(Sprite, SrcRect, "src_rect");
@@ -138,6 +340,7 @@ void spriteBindingInit() {
     
     _rb_define_method(klass, "width", spriteWidth);
     _rb_define_method(klass, "height", spriteHeight);
+    _rb_define_method(klass, "hit?", spriteHitTest);
     
     INIT_PROP_BIND(Sprite, BushOpacity, "bush_opacity");
     
@@ -34,6 +34,9 @@ DEF_TYPE_CUSTOMFREE(TilemapAutotiles, RUBY_TYPED_NEVER_FREE);
 #define TilemapAutotilesType "TilemapAutotiles"
 #endif
 
+static ID autotilesArrayID;
+static ID autotilesTilemapID;
+
 RB_METHOD(tilemapAutotilesSet) {
     Tilemap::Autotiles *a = getPrivateData<Tilemap::Autotiles>(self);
     
@@ -47,7 +50,7 @@ RB_METHOD(tilemapAutotilesSet) {
     GFX_LOCK;
     a->set(i, bitmap);
     
-    VALUE ary = rb_iv_get(self, "array");
+    VALUE ary = rb_ivar_get(self, autotilesArrayID);
     rb_ary_store(ary, i, bitmapObj);
     GFX_UNLOCK;
     return self;
@@ -60,17 +63,32 @@ RB_METHOD(tilemapAutotilesGet) {
     if (i < 0 || i > 6)
         return Qnil;
     
-    VALUE ary = rb_iv_get(self, "array");
+    VALUE ary = rb_ivar_get(self, autotilesArrayID);
     
     return rb_ary_entry(ary, i);
 }
 
 #if RAPI_FULL > 187
-DEF_TYPE(Tilemap);
+DEF_SLOTS_TYPE(Tilemap);
 #else
-DEF_ALLOCFUNC(Tilemap);
+DEF_SLOTS_ALLOCFUNC(Tilemap);
 #endif
 
+enum
+{
+    ViewportSlot = 0,
+    AutotilesSlot,
+    TilesetSlot,
+    MapDataSlot,
+    FlashDataSlot,
+    PrioritiesSlot,
+    ColorSlot,
+    ToneSlot,
+    TilemapSlotEnd
+};
+
+static_assert(TilemapSlotEnd <= BindingSlots::SlotCount, "Too many Tilemap slots");
+
 RB_METHOD(tilemapInitialize) {
     Tilemap *t;
     
@@ -87,28 +105,27 @@ RB_METHOD(tilemapInitialize) {
     /* Construct object */
     t = new Tilemap(viewport);
     
-    rb_iv_set(self, "viewport", viewportObj);
-    
     setPrivateData(self, t);
     
-    t->initDynAttribs();
+    setPropertySlot(t, ViewportSlot, viewportObj);
     
-    wrapProperty(self, &t->getAutotiles(), "autotiles", TilemapAutotilesType);
+    t->initDynAttribs();
     
-    wrapProperty(self, &t->getColor(), "color", ColorType);
-    wrapProperty(self, &t->getTone(), "tone", ToneType);
+    VALUE autotilesObj = wrapPropertySlot(t, AutotilesSlot, &t->getAutotiles(),
+                                          TilemapAutotilesType);
     
-    VALUE autotilesObj = rb_iv_get(self, "autotiles");
+    wrapPropertySlot(t, ColorSlot, &t->getColor(), ColorType);
+    wrapPropertySlot(t, ToneSlot, &t->getTone(), ToneType);
     
     VALUE ary = rb_ary_new2(7);
     for (int i = 0; i < 7; ++i)
         rb_ary_push(ary, Qnil);
     
-    rb_iv_set(autotilesObj, "array", ary);
+    rb_ivar_set(autotilesObj, autotilesArrayID, ary);
     
     /* Circular reference so both objects are always
      * alive at the same time */
-    rb_iv_set(autotilesObj, "tilemap", self);
+    rb_ivar_set(autotilesObj, autotilesTilemapID, self);
     
     GFX_UNLOCK;
     return self;
@@ -117,9 +134,11 @@ RB_METHOD(tilemapInitialize) {
 RB_METHOD(tilemapGetAutotiles) {
     RB_UNUSED_PARAM;
     
+    Tilemap *t = getPrivateData<Tilemap>(self);
+    
     checkDisposed<Tilemap>(self);
     
-    return rb_iv_get(self, "autotiles");
+    return getPropertySlot(t, AutotilesSlot);
 }
 
 RB_METHOD(tilemapUpdate) {
@@ -137,18 +156,20 @@ RB_METHOD(tilemapUpdate) {
 RB_METHOD(tilemapGetViewport) {
     RB_UNUSED_PARAM;
     
+    Tilemap *t = getPrivateData<Tilemap>(self);
+    
     checkDisposed<Tilemap>(self);
     
-    return rb_iv_get(self, "viewport");
+    return getPropertySlot(t, ViewportSlot);
 }
 
-DEF_GFX_PROP_OBJ_REF(Tilemap, Bitmap, Tileset, "tileset")
-DEF_GFX_PROP_OBJ_REF(Tilemap, Table, MapData, "map_data")
-DEF_GFX_PROP_OBJ_REF(Tilemap, Table, FlashData, "flash_data")
-DEF_GFX_PROP_OBJ_REF(Tilemap, Table, Priorities, "priorities")
+DEF_GFX_PROP_OBJ_REF(Tilemap, Bitmap, Tileset, TilesetSlot)
+DEF_GFX_PROP_OBJ_REF(Tilemap, Table, MapData, MapDataSlot)
+DEF_GFX_PROP_OBJ_REF(Tilemap, Table, FlashData, FlashDataSlot)
+DEF_GFX_PROP_OBJ_REF(Tilemap, Table, Priorities, PrioritiesSlot)
 
-DEF_GFX_PROP_OBJ_VAL(Tilemap, Color, Color, "color")
-DEF_GFX_PROP_OBJ_VAL(Tilemap, Tone, Tone, "tone")
+DEF_GFX_PROP_OBJ_VAL(Tilemap, Color, Color, ColorSlot)
+DEF_GFX_PROP_OBJ_VAL(Tilemap, Tone, Tone, ToneSlot)
 
 DEF_GFX_PROP_B(Tilemap, Visible)
 
@@ -159,6 +180,9 @@ DEF_GFX_PROP_I(Tilemap, Opacity)
 DEF_GFX_PROP_I(Tilemap, BlendType)
 
 void tilemapBindingInit() {
+    autotilesArrayID = rb_intern("array");
+    autotilesTilemapID = rb_intern("tilemap");
+    
     VALUE klass = rb_define_class("TilemapAutotiles", rb_cObject);
 #if RAPI_FULL > 187
     rb_define_alloc_func(klass, classAllocate<&TilemapAutotilesType>);
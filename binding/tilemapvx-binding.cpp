@@ -30,14 +30,29 @@
 #include "disposable-binding.h"
 
 #if RAPI_FULL > 187
-DEF_TYPE_CUSTOMNAME(TilemapVX, "Tilemap");
+DEF_SLOTS_TYPE_CUSTOMNAME(TilemapVX, "Tilemap");
 
 DEF_TYPE_CUSTOMFREE(BitmapArray, RUBY_TYPED_NEVER_FREE);
 #else
-DEF_ALLOCFUNC(TilemapVX);
+DEF_SLOTS_ALLOCFUNC(TilemapVX);
 #define BitmapArrayType "BitmapArray"
 #endif
 
+enum
+{
+    ViewportSlot = 0,
+    BitmapArraySlot,
+    MapDataSlot,
+    FlashDataSlot,
+    FlagsSlot,
+    TilemapVXSlotEnd
+};
+
+static_assert(TilemapVXSlotEnd <= BindingSlots::SlotCount, "Too many Tilemap slots");
+
+static ID bitmapsArrayID;
+static ID bitmapsTilemapID;
+
 RB_METHOD(tilemapVXInitialize) {
     TilemapVX *t;
     
@@ -56,22 +71,21 @@ RB_METHOD(tilemapVXInitialize) {
     
     setPrivateData(self, t);
     
-    rb_iv_set(self, "viewport", viewportObj);
-    
-    wrapProperty(self, &t->getBitmapArray(), "bitmap_array", BitmapArrayType,
-                 rb_const_get(rb_cObject, rb_intern("Tilemap")));
+    setPropertySlot(t, ViewportSlot, viewportObj);
     
-    VALUE autotilesObj = rb_iv_get(self, "bitmap_array");
+    VALUE autotilesObj = wrapPropertySlot(t, BitmapArraySlot, &t->getBitmapArray(),
+                                          BitmapArrayType,
+                                          rb_const_get(rb_cObject, rb_intern("Tilemap")));
     
     VALUE ary = rb_ary_new2(9);
     for (int i = 0; i < 9; ++i)
         rb_ary_push(ary, Qnil);
     
-    rb_iv_set(autotilesObj, "array", ary);
+    rb_ivar_set(autotilesObj, bitmapsArrayID, ary);
     
     /* Circular reference so both objects are always
      * alive at the same time */
-    rb_iv_set(autotilesObj, "tilemap", self);
+    rb_ivar_set(autotilesObj, bitmapsTilemapID, self);
     
     GFX_UNLOCK;
     return self;
@@ -80,9 +94,11 @@ RB_METHOD(tilemapVXInitialize) {
 RB_METHOD(tilemapVXGetBitmapArray) {
     RB_UNUSED_PARAM;
     
+    TilemapVX *t = getPrivateData<TilemapVX>(self);
+    
     checkDisposed<TilemapVX>(self);
     
-    return rb_iv_get(self, "bitmap_array");
+    return getPropertySlot(t, BitmapArraySlot);
 }
 
 RB_METHOD(tilemapVXUpdate) {
@@ -95,10 +111,10 @@ RB_METHOD(tilemapVXUpdate) {
     return Qnil;
 }
 
-DEF_GFX_PROP_OBJ_REF(TilemapVX, Viewport, Viewport, "viewport")
-DEF_GFX_PROP_OBJ_REF(TilemapVX, Table, MapData, "map_data")
-DEF_GFX_PROP_OBJ_REF(TilemapVX, Table, FlashData, "flash_data")
-DEF_GFX_PROP_OBJ_REF(TilemapVX, Table, Flags, "flags")
+DEF_GFX_PROP_OBJ_REF(TilemapVX, Viewport, Viewport, ViewportSlot)
+DEF_GFX_PROP_OBJ_REF(TilemapVX, Table, MapData, MapDataSlot)
+DEF_GFX_PROP_OBJ_REF(TilemapVX, Table, FlashData, FlashDataSlot)
+DEF_GFX_PROP_OBJ_REF(TilemapVX, Table, Flags, FlagsSlot)
 
 DEF_GFX_PROP_B(TilemapVX, Visible)
 
@@ -118,7 +134,7 @@ RB_METHOD(tilemapVXBitmapsSet) {
     GFX_LOCK;
     a->set(i, bitmap);
     
-    VALUE ary = rb_iv_get(self, "array");
+    VALUE ary = rb_ivar_get(self, bitmapsArrayID);
     rb_ary_store(ary, i, bitmapObj);
     GFX_UNLOCK;
     return self;
@@ -131,12 +147,15 @@ RB_METHOD(tilemapVXBitmapsGet) {
     if (i < 0 || i > 8)
         return Qnil;
     
-    VALUE ary = rb_iv_get(self, "array");
+    VALUE ary = rb_ivar_get(self, bitmapsArrayID);
     
     return rb_ary_entry(ary, i);
 }
 
 void tilemapVXBindingInit() {
+    bitmapsArrayID = rb_intern("array");
+    bitmapsTilemapID = rb_intern("tilemap");
+    
     VALUE klass = rb_define_class("Tilemap", rb_cObject);
 #if RAPI_FULL > 187
     rb_define_alloc_func(klass, classAllocate<&TilemapVXType>);
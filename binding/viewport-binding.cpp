@@ -27,12 +27,24 @@
 #include "sharedstate.h"
 #include "viewport.h"
 
+VALUE spriteObject(Sprite *s);
+
 #if RAPI_FULL > 187
-DEF_TYPE(Viewport);
+DEF_SLOTS_TYPE(Viewport);
 #else
-DEF_ALLOCFUNC(Viewport);
+DEF_SLOTS_ALLOCFUNC(Viewport);
 #endif
 
+enum
+{
+    RectSlot,
+    ColorSlot,
+    ToneSlot,
+    ViewportSlotEnd
+};
+
+static_assert(ViewportSlotEnd <= BindingSlots::SlotCount, "Too many Viewport slots");
+
 RB_METHOD(viewportInitialize) {
     Viewport *v;
     
@@ -64,21 +76,50 @@ RB_METHOD(viewportInitialize) {
     /* Wrap property objects */
     v->initDynAttribs();
     
-    wrapProperty(self, &v->getRect(), "rect", RectType);
-    wrapProperty(self, &v->getColor(), "color", ColorType);
-    wrapProperty(self, &v->getTone(), "tone", ToneType);
+    wrapPropertySlot(v, RectSlot, &v->getRect(), RectType);
+    wrapPropertySlot(v, ColorSlot, &v->getColor(), ColorType);
+    wrapPropertySlot(v, ToneSlot, &v->getTone(), ToneType);
     
     GFX_UNLOCK;
     return self;
 }
 
-DEF_GFX_PROP_OBJ_VAL(Viewport, Rect, Rect, "rect")
-DEF_GFX_PROP_OBJ_VAL(Viewport, Color, Color, "color")
-DEF_GFX_PROP_OBJ_VAL(Viewport, Tone, Tone, "tone")
+DEF_GFX_PROP_OBJ_VAL(Viewport, Rect, Rect, RectSlot)
+DEF_GFX_PROP_OBJ_VAL(Viewport, Color, Color, ColorSlot)
+DEF_GFX_PROP_OBJ_VAL(Viewport, Tone, Tone, ToneSlot)
 
 DEF_GFX_PROP_I(Viewport, OX)
 DEF_GFX_PROP_I(Viewport, OY)
 
+DEF_GFX_PROP_B(Viewport, Cache)
+
+RB_METHOD(viewportCacheStats) {
+    RB_UNUSED_PARAM;
+    
+    Viewport *v = getPrivateData<Viewport>(self);
+    
+    unsigned int hits = 0, misses = 0;
+    GUARD_EXC(v->getCacheStats(hits, misses);)
+    
+    VALUE ret = rb_ary_new();
+    rb_ary_push(ret, UINT2NUM(hits));
+    rb_ary_push(ret, UINT2NUM(misses));
+    
+    return ret;
+}
+
+RB_METHOD(viewportPick) {
+    Viewport *v = getPrivateData<Viewport>(self);
+    
+    int x, y, alphaThreshold = 1;
+    rb_get_args(argc, argv, "ii|i", &x, &y, &alphaThreshold RB_ARG_END);
+    
+    Sprite *sprite = 0;
+    GFX_GUARD_EXC(sprite = v->pick(x, y, alphaThreshold););
+    
+    return sprite ? spriteObject(sprite) : Qnil;
+}
+
 void viewportBindingInit() {
     VALUE klass = rb_define_class("Viewport", rb_cObject);
 #if RAPI_FULL > 187
@@ -98,4 +139,8 @@ void viewportBindingInit() {
     INIT_PROP_BIND(Viewport, OY, "oy");
     INIT_PROP_BIND(Viewport, Color, "color");
     INIT_PROP_BIND(Viewport, Tone, "tone");
+    INIT_PROP_BIND(Viewport, Cache, "cache");
+    
+    _rb_define_method(klass, "cache_stats", viewportCacheStats);
+    _rb_define_method(klass, "pick", viewportPick);
 }
@@ -31,6 +31,14 @@
 #include "sceneelement-binding.h"
 #include "disposable-binding.h"
 
+/* BindingSlots index shared by all viewport elements,
+ * class specific property slots follow after it */
+enum
+{
+	ViewportSlot = 0,
+	ViewportElementSlotEnd
+};
+
 template<class C>
 RB_METHOD(viewportElementGetViewport)
 {
@@ -38,7 +46,7 @@ RB_METHOD(viewportElementGetViewport)
 
 	checkDisposed<C>(self);
 
-	return rb_iv_get(self, "viewport");
+	return getPropertySlot(getPrivateData<C>(self), ViewportSlot);
 }
 
 template<class C>
@@ -46,7 +54,7 @@ RB_METHOD(viewportElementSetViewport)
 {
 	RB_UNUSED_PARAM;
 
-	ViewportElement *ve = getPrivateData<C>(self);
+	C *ve = getPrivateData<C>(self);
 
 	VALUE viewportObj = Qnil;
 	Viewport *viewport = 0;
@@ -58,7 +66,7 @@ RB_METHOD(viewportElementSetViewport)
 
 	GFX_GUARD_EXC( ve->setViewport(viewport); );
 
-	rb_iv_set(self, "viewport", viewportObj);
+	setPropertySlot(ve, ViewportSlot, viewportObj);
 
 	return viewportObj;
 }
@@ -81,10 +89,10 @@ viewportElementInitialize(int argc, VALUE *argv, VALUE self)
     GFX_LOCK;
 	/* Construct object */
 	C *ve = new C(viewport);
+	setPrivateData(self, ve);
 
-    
 	/* Set property objects */
-	rb_iv_set(self, "viewport", viewportObj);
+	setPropertySlot(ve, ViewportSlot, viewportObj);
     GFX_UNLOCK;
 	return ve;
 }
@@ -25,20 +25,28 @@
 #include "window.h"
 
 #if RAPI_FULL > 187
-DEF_TYPE(Window);
+DEF_SLOTS_TYPE(Window);
 #else
-DEF_ALLOCFUNC(Window);
+DEF_SLOTS_ALLOCFUNC(Window);
 #endif
 
+enum
+{
+    WindowskinSlot = ViewportElementSlotEnd,
+    ContentsSlot,
+    CursorRectSlot,
+    WindowSlotEnd
+};
+
+static_assert(WindowSlotEnd <= BindingSlots::SlotCount, "Too many Window slots");
+
 RB_METHOD(windowInitialize) {
     GFX_LOCK;
     Window *w = viewportElementInitialize<Window>(argc, argv, self);
     
-    setPrivateData(self, w);
-    
     w->initDynAttribs();
     
-    wrapProperty(self, &w->getCursorRect(), "cursor_rect", RectType);
+    wrapPropertySlot(w, CursorRectSlot, &w->getCursorRect(), RectType);
     
     GFX_UNLOCK;
     return self;
@@ -54,9 +62,9 @@ RB_METHOD(windowUpdate) {
     return Qnil;
 }
 
-DEF_GFX_PROP_OBJ_REF(Window, Bitmap, Windowskin, "windowskin")
-DEF_GFX_PROP_OBJ_REF(Window, Bitmap, Contents, "contents")
-DEF_GFX_PROP_OBJ_VAL(Window, Rect, CursorRect, "cursor_rect")
+DEF_GFX_PROP_OBJ_REF(Window, Bitmap, Windowskin, WindowskinSlot)
+DEF_GFX_PROP_OBJ_REF(Window, Bitmap, Contents, ContentsSlot)
+DEF_GFX_PROP_OBJ_VAL(Window, Rect, CursorRect, CursorRectSlot)
 
 DEF_GFX_PROP_B(Window, Stretch)
 DEF_GFX_PROP_B(Window, Active)
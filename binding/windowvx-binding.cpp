@@ -28,11 +28,21 @@
 #include "graphics.h"
 
 #if RAPI_FULL > 187
-DEF_TYPE_CUSTOMNAME(WindowVX, "Window");
+DEF_SLOTS_TYPE_CUSTOMNAME(WindowVX, "Window");
 #else
-DEF_ALLOCFUNC(WindowVX);
+DEF_SLOTS_ALLOCFUNC(WindowVX);
 #endif
 
+enum {
+  WindowskinSlot = ViewportElementSlotEnd,
+  ContentsSlot,
+  CursorRectSlot,
+  ToneSlot,
+  WindowVXSlotEnd
+};
+
+static_assert(WindowVXSlotEnd <= BindingSlots::SlotCount, "Too many Window slots");
+
 void bitmapInitProps(Bitmap *b, VALUE self);
 
 RB_METHOD(windowVXInitialize) {
@@ -47,23 +57,22 @@ RB_METHOD(windowVXInitialize) {
       rb_get_args(argc, argv, "iiii", &x, &y, &width, &height RB_ARG_END);
 
     w = new WindowVX(x, y, width, height);
+    setPrivateData(self, w);
   } else {
     w = viewportElementInitialize<WindowVX>(argc, argv, self);
   }
 
-  setPrivateData(self, w);
-
   w->initDynAttribs();
 
-  wrapProperty(self, &w->getCursorRect(), "cursor_rect", RectType);
+  wrapPropertySlot(w, CursorRectSlot, &w->getCursorRect(), RectType);
 
   if (rgssVer >= 3)
-    wrapProperty(self, &w->getTone(), "tone", ToneType);
+    wrapPropertySlot(w, ToneSlot, &w->getTone(), ToneType);
 
   Bitmap *contents = new Bitmap(1, 1);
   VALUE contentsObj = wrapObject(contents, BitmapType);
   bitmapInitProps(contents, contentsObj);
-  rb_iv_set(self, "contents", contentsObj);
+  setPropertySlot(w, ContentsSlot, contentsObj);
 
     GFX_UNLOCK;
   return self;
@@ -110,11 +119,11 @@ RB_METHOD(windowVXIsClosed) {
   return rb_bool_new(w->isClosed());
 }
 
-DEF_GFX_PROP_OBJ_REF(WindowVX, Bitmap, Windowskin, "windowskin")
-DEF_GFX_PROP_OBJ_REF(WindowVX, Bitmap, Contents, "contents")
+DEF_GFX_PROP_OBJ_REF(WindowVX, Bitmap, Windowskin, WindowskinSlot)
+DEF_GFX_PROP_OBJ_REF(WindowVX, Bitmap, Contents, ContentsSlot)
 
-DEF_GFX_PROP_OBJ_VAL(WindowVX, Rect, CursorRect, "cursor_rect")
-DEF_GFX_PROP_OBJ_VAL(WindowVX, Tone, Tone, "tone")
+DEF_GFX_PROP_OBJ_VAL(WindowVX, Rect, CursorRect, CursorRectSlot)
+DEF_GFX_PROP_OBJ_VAL(WindowVX, Tone, Tone, ToneSlot)
 
 DEF_GFX_PROP_I(WindowVX, X)
 DEF_GFX_PROP_I(WindowVX, Y)
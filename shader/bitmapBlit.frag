@@ -4,16 +4,28 @@
 uniform sampler2D source;
 uniform sampler2D destination;
 
+#ifdef BLT_BATCH
+/* Many blits in one draw; each quad carries its
+ * opacity and maps to the destination itself */
+varying vec2 v_dstCoord;
+varying lowp float v_opacity;
+#else
 uniform vec4 subRect;
 
 uniform lowp float opacity;
+#endif
 
 varying vec2 v_texCoord;
 
 void main()
 {
 	vec2 coor = v_texCoord;
+#ifdef BLT_BATCH
+	vec2 dstCoor = v_dstCoord;
+	lowp float opacity = v_opacity;
+#else
 	vec2 dstCoor = (coor - subRect.xy) * subRect.zw;
+#endif
 
 	vec4 srcFrag = texture2D(source, coor);
 	vec4 dstFrag = texture2D(destination, dstCoor);
@@ -0,0 +1,26 @@
+
+uniform mat4 projMat;
+
+uniform vec2 texSizeInv;
+uniform vec2 translation;
+
+/* Size of the destination snapshot, which holds the
+ * target's pixels at the same positions */
+uniform vec2 dstSizeInv;
+
+attribute vec2 position;
+attribute vec2 texCoord;
+attribute lowp vec4 color;
+
+varying vec2 v_texCoord;
+varying vec2 v_dstCoord;
+varying lowp float v_opacity;
+
+void main()
+{
+	gl_Position = projMat * vec4(position + translation, 0, 1);
+
+	v_texCoord = texCoord * texSizeInv;
+	v_dstCoord = position * dstSizeInv;
+	v_opacity = color.a;
+}
@@ -0,0 +1,15 @@
+
+uniform sampler2D texture;
+
+/* See ColorMatrix; applied to non premultiplied color */
+uniform mat4 colorMat;
+uniform vec4 colorOffset;
+
+varying vec2 v_texCoord;
+
+void main()
+{
+	vec4 frag = texture2D(texture, v_texCoord);
+
+	gl_FragColor = clamp(colorMat * frag + colorOffset, 0.0, 1.0);
+}
@@ -0,0 +1,35 @@
+// One axis of a separable Gaussian blur. Each tap past the center
+// samples between two texels, so the kernel reaches out
+// 2 * (BLUR_TAPS - 1) texels to either side. Unused taps weigh 0.
+
+#ifdef GLSLES
+	precision highp float;
+#endif
+
+#define BLUR_TAPS 8
+
+uniform sampler2D texture;
+uniform vec2 texSizeInv;
+
+/* (1, 0) for horizontal, (0, 1) for vertical */
+uniform vec2 direction;
+uniform float weights[BLUR_TAPS];
+uniform float offsets[BLUR_TAPS];
+
+varying vec2 v_texCoord;
+
+void main()
+{
+	vec2 texel = direction * texSizeInv;
+	vec4 frag = texture2D(texture, v_texCoord) * weights[0];
+
+	for (int i = 1; i < BLUR_TAPS; ++i)
+	{
+		vec2 offset = texel * offsets[i];
+
+		frag += texture2D(texture, v_texCoord + offset) * weights[i];
+		frag += texture2D(texture, v_texCoord - offset) * weights[i];
+	}
+
+	gl_FragColor = frag;
+}
@@ -0,0 +1,58 @@
+// Rotational blur: averages 'divisions' copies of the texture
+// rotated around its center, spread evenly over the angle. Copies
+// are mirrored at the edges (but not the corners) so that rotation
+// doesn't pull in empty space. Color is weighted by alpha, like the
+// additive blending this replaces.
+
+#ifdef GLSLES
+	precision highp float;
+#endif
+
+#define MAX_DIVISIONS 100
+
+uniform sampler2D texture;
+uniform vec2 texSizeInv;
+
+/* In radians */
+uniform float baseAngle;
+uniform float angleStep;
+uniform int divisions;
+
+varying vec2 v_texCoord;
+
+void main()
+{
+	vec2 size = 1.0 / texSizeInv;
+	vec2 center = size / 2.0;
+	vec2 pos = v_texCoord * size - center;
+
+	vec4 sum = vec4(0.0);
+
+	for (int i = 0; i < MAX_DIVISIONS; ++i)
+	{
+		if (i >= divisions)
+			break;
+
+		float angle = baseAngle + float(i) * angleStep;
+		float c = cos(angle);
+		float s = sin(angle);
+
+		vec2 src = vec2(c * pos.x - s * pos.y, s * pos.x + c * pos.y) + center;
+
+		/* One reflection per axis, only ever along one axis */
+		vec2 outside = vec2(lessThan(src, vec2(0.0))) + vec2(greaterThan(src, size));
+
+		if (outside.x + outside.y > 1.0)
+			continue;
+
+		src = size - abs(size - abs(src));
+
+		if (any(lessThan(src, vec2(0.0))))
+			continue;
+
+		vec4 frag = texture2D(texture, src * texSizeInv);
+		sum += vec4(frag.rgb * frag.a, frag.a);
+	}
+
+	gl_FragColor = sum / float(divisions);
+}
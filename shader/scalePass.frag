@@ -0,0 +1,73 @@
+// One axis of the Lanczos3 / Bicubic screen scalers, so that a
+// full 2D scale takes 6 + 6 (or 4 + 4) texture reads per pixel
+// instead of 36 (or 16). Define SCALE_LANCZOS3 or SCALE_BICUBIC.
+// The kernels follow lanczos3.frag and bicubic.frag.
+
+#ifdef GLSLES
+	precision highp float;
+#endif
+
+uniform sampler2D texture;
+uniform vec2 sourceSize;
+uniform vec2 texSizeInv;
+uniform vec2 direction;
+varying vec2 v_texCoord;
+
+#ifdef SCALE_BICUBIC
+uniform vec2 bc;
+#endif
+
+#ifdef SCALE_LANCZOS3
+float lanczos3(float x)
+{
+	x = max(abs(x), 0.00001);
+	float val = x * 3.141592654;
+	return sin(val) * sin(val / 3.0) / (val * val);
+}
+#endif
+
+void main()
+{
+	vec2 pixel = v_texCoord * sourceSize + 0.5;
+	float frac = dot(fract(pixel), direction);
+
+	/* Snap to texel centers along the filtered axis only,
+	 * the other one already lines up with the source */
+	vec2 snapped = floor(pixel) * texSizeInv - texSizeInv / 2.0;
+	vec2 base = mix(v_texCoord, snapped, direction);
+	vec2 onePixel = texSizeInv * direction;
+
+#ifdef SCALE_LANCZOS3
+	vec4 colour = vec4(0);
+	float sum = 0.0;
+
+	for (int i = -2; i <= 3; i++)
+	{
+		float w = lanczos3(float(i) - frac);
+		colour += texture2D(texture, base + float(i) * onePixel) * w;
+		sum += w;
+	}
+
+	gl_FragColor = colour / sum;
+#endif
+
+#ifdef SCALE_BICUBIC
+	float frac2 = frac * frac;
+	float frac3 = frac * frac2;
+
+	vec4 p0 = texture2D(texture, base - onePixel);
+	vec4 p1 = texture2D(texture, base);
+	vec4 p2 = texture2D(texture, base + onePixel);
+	vec4 p3 = texture2D(texture, base + 2.0 * onePixel);
+
+	float w0 = (-bc.x / 6.0 - bc.y) * frac3 + (0.5 * bc.x + 2.0 * bc.y) * frac2
+	         + (-0.5 * bc.x - bc.y) * frac + bc.x / 6.0;
+	float w1 = (-1.5 * bc.x - bc.y + 2.0) * frac3 + (2.0 * bc.x + bc.y - 3.0) * frac2
+	         + (-bc.x / 3.0 + 1.0);
+	float w2 = (1.5 * bc.x + bc.y - 2.0) * frac3 + (-2.5 * bc.x - 2.0 * bc.y + 3.0) * frac2
+	         + (0.5 * bc.x + bc.y) * frac + bc.x / 6.0;
+	float w3 = (bc.x / 6.0 + bc.y) * frac3 - bc.y * frac2;
+
+	gl_FragColor = p0 * w0 + p1 * w1 + p2 * w2 + p3 * w3;
+#endif
+}
@@ -1,23 +1,35 @@
 
+/* Effects are selected at compile time (see SpriteShader::Variant):
+ * SPRITE_PATTERN, SPRITE_PATTERN_BLEND (0 normal, 1 add, 2 sub),
+ * SPRITE_TONE, SPRITE_COLOR, SPRITE_BUSH and SPRITE_INVERT */
+
 uniform sampler2D texture;
 
+uniform lowp float opacity;
+
+#ifdef SPRITE_TONE
 uniform lowp vec4 tone;
+#endif
 
-uniform lowp float opacity;
+#ifdef SPRITE_COLOR
 uniform lowp vec4 color;
+#endif
 
+#ifdef SPRITE_BUSH
 uniform float bushDepth;
 uniform lowp float bushOpacity;
+#endif
 
+#ifdef SPRITE_PATTERN
 uniform sampler2D pattern;
-uniform int patternBlendType;
 uniform lowp float patternOpacity;
-uniform bool renderPattern;
-
-uniform bool invert;
+#endif
 
 varying vec2 v_texCoord;
+
+#ifdef SPRITE_PATTERN
 varying vec2 v_patCoord;
+#endif
 
 const vec3 lumaF = vec3(.299, .587, .114);
 const vec2 repeat = vec2(1, 1);
@@ -69,41 +81,45 @@ void main()
 	/* Sample source color */
 	vec4 frag = texture2D(texture, v_texCoord);
     
+#ifdef SPRITE_PATTERN
     /* Apply pattern */
-    if (renderPattern) {
-        vec4 pattfrag = texture2D(pattern, mod(v_patCoord, repeat));
-        if (patternBlendType == 1) {
-            frag.rgb =  blendAdd(frag.rgb, pattfrag.rgb, pattfrag.a * patternOpacity);
-        }
-        else if (patternBlendType == 2) {
-            frag.rgb = blendSubtract(frag.rgb, pattfrag.rgb, pattfrag.a * patternOpacity);
-        }
-        else {
-            frag.rgb = blendNormal(frag.rgb, pattfrag.rgb, pattfrag.a * patternOpacity);
-        }
-    }
+    vec4 pattfrag = texture2D(pattern, mod(v_patCoord, repeat));
+#if SPRITE_PATTERN_BLEND == 1
+    frag.rgb = blendAdd(frag.rgb, pattfrag.rgb, pattfrag.a * patternOpacity);
+#elif SPRITE_PATTERN_BLEND == 2
+    frag.rgb = blendSubtract(frag.rgb, pattfrag.rgb, pattfrag.a * patternOpacity);
+#else
+    frag.rgb = blendNormal(frag.rgb, pattfrag.rgb, pattfrag.a * patternOpacity);
+#endif
+#endif
 	
+#ifdef SPRITE_TONE
 	/* Apply gray */
 	float luma = dot(frag.rgb, lumaF);
 	frag.rgb = mix(frag.rgb, vec3(luma), tone.w);
 	
 	/* Apply tone */
 	frag.rgb += tone.rgb;
+#endif
 
 	/* Apply opacity */
 	frag.a *= opacity;
 	
+#ifdef SPRITE_COLOR
 	/* Apply color */
 	frag.rgb = mix(frag.rgb, color.rgb, color.a);
+#endif
     
+#ifdef SPRITE_INVERT
     /* Apply color inversion */
-    if (invert) {
-        frag.rgb = vec3(1.0 - frag.r, 1.0 - frag.g, 1.0 - frag.b);
-    }
+    frag.rgb = vec3(1.0 - frag.r, 1.0 - frag.g, 1.0 - frag.b);
+#endif
 
+#ifdef SPRITE_BUSH
 	/* Apply bush alpha by mathematical if */
 	lowp float underBush = float(v_texCoord.y < bushDepth);
 	frag.a *= clamp(bushOpacity + underBush, 0.0, 1.0);
+#endif
 	
 	gl_FragColor = frag;
 }
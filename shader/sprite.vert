@@ -4,17 +4,22 @@ uniform mat4 projMat;
 uniform mat4 spriteMat;
 
 uniform vec2 texSizeInv;
+
+#ifdef SPRITE_PATTERN
 uniform vec2 patternSizeInv;
 uniform vec2 patternScroll;
 uniform vec2 patternZoom;
-uniform bool renderPattern;
 uniform bool patternTile;
+#endif
 
 attribute vec2 position;
 attribute vec2 texCoord;
 
 varying vec2 v_texCoord;
+
+#ifdef SPRITE_PATTERN
 varying vec2 v_patCoord;
+#endif
 
 void main()
 {
@@ -22,14 +27,14 @@ void main()
     
     v_texCoord = texCoord * texSizeInv;
     
-    if (renderPattern) {
-        if (patternTile) {
-            vec2 scroll = patternScroll * (patternSizeInv / texSizeInv);
-            v_patCoord = (texCoord * (patternSizeInv / patternZoom)) - (scroll * patternSizeInv);
-        }
-        else {
-            vec2 scroll = patternScroll * (patternSizeInv / texSizeInv);
-            v_patCoord = (texCoord * (texSizeInv / patternZoom)) - (scroll * texSizeInv);
-        }
+#ifdef SPRITE_PATTERN
+    if (patternTile) {
+        vec2 scroll = patternScroll * (patternSizeInv / texSizeInv);
+        v_patCoord = (texCoord * (patternSizeInv / patternZoom)) - (scroll * patternSizeInv);
+    }
+    else {
+        vec2 scroll = patternScroll * (patternSizeInv / texSizeInv);
+        v_patCoord = (texCoord * (texSizeInv / patternZoom)) - (scroll * texSizeInv);
     }
+#endif
 }
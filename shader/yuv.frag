@@ -0,0 +1,20 @@
+
+uniform sampler2D texY;
+uniform sampler2D texU;
+uniform sampler2D texV;
+
+varying vec2 v_texCoord;
+
+/* Theora Y'CbCr (BT.601, studio range) -> R'G'B' */
+void main()
+{
+	float y = (texture2D(texY, v_texCoord).r - (16.0 / 255.0)) * (255.0 / 219.0);
+	float u = (texture2D(texU, v_texCoord).r - (128.0 / 255.0)) * (255.0 / 224.0);
+	float v = (texture2D(texV, v_texCoord).r - (128.0 / 255.0)) * (255.0 / 224.0);
+
+	vec3 rgb = vec3(y + 1.402 * v,
+	                y - 0.344136 * u - 0.714136 * v,
+	                y + 1.772 * u);
+
+	gl_FragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+}
@@ -27,6 +27,16 @@
 
 #include <SDL_audio.h>
 #include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ALUTIL_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ALUTIL_NEON
+#endif
 
 namespace AL
 {
@@ -250,6 +260,64 @@ inline ALenum chooseALFormat(int sampleSize, int channelCount)
 	return 0;
 }
 
+/* Converts 'count' float samples in [-1, 1] to signed 16 bit,
+ * clamping out of range values */
+inline void convertF32ToS16(int16_t *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+
+#if defined(ALUTIL_SSE2)
+	const __m128 lo = _mm_set1_ps(-1.0f);
+	const __m128 hi = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(32767.0f);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128 a = _mm_loadu_ps(src + i);
+		__m128 b = _mm_loadu_ps(src + i + 4);
+
+		a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(a, lo), hi), scale);
+		b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(b, lo), hi), scale);
+
+		const __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+		_mm_storeu_si128((__m128i*) (dst + i), packed);
+	}
+#elif defined(ALUTIL_NEON)
+	const float32x4_t lo = vdupq_n_f32(-1.0f);
+	const float32x4_t hi = vdupq_n_f32(1.0f);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		float32x4_t a = vld1q_f32(src + i);
+		float32x4_t b = vld1q_f32(src + i + 4);
+
+		/* vmaxq keeps NaN, so map it to -1 like the scalar tail */
+		a = vbslq_f32(vceqq_f32(a, a), a, lo);
+		b = vbslq_f32(vceqq_f32(b, b), b, lo);
+
+		a = vmulq_n_f32(vminq_f32(vmaxq_f32(a, lo), hi), 32767.0f);
+		b = vmulq_n_f32(vminq_f32(vmaxq_f32(b, lo), hi), 32767.0f);
+
+		const int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)),
+		                                      vqmovn_s32(vcvtq_s32_f32(b)));
+		vst1q_s16(dst + i, packed);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		float val = src[i];
+
+		/* Also catches NaN */
+		if (!(val >= -1.0f))
+			val = -1.0f;
+		else if (val > 1.0f)
+			val = 1.0f;
+
+		dst[i] = (int16_t) (val * 32767.0f);
+	}
+}
+
 #define AUDIO_SLEEP 10
 #define STREAM_BUF_SIZE 32768
 #define GLOBAL_VOLUME 0.8f
@@ -30,11 +30,14 @@
 #include "fluid-fun.h"
 #include "sdl-util.h"
 #include "debugwriter.h"
+#include "trace.h"
 
 #include <SDL_mutex.h>
 #include <SDL_thread.h>
 #include <SDL_timer.h>
 
+#include <algorithm>
+
 ALStream::ALStream(LoopMode loopMode,
 		           const std::string &threadId)
 	: looped(loopMode == Looped),
@@ -42,7 +45,9 @@ ALStream::ALStream(LoopMode loopMode,
 	  source(0),
 	  thread(0),
 	  preemptPause(false),
-      pitch(1.0f)
+      pitch(1.0f),
+	  srcOps(&opsSlots[0]),
+	  queuePreBuf(false)
 {
 	alSrc = AL::Source::gen();
 
@@ -53,6 +58,11 @@ ALStream::ALStream(LoopMode loopMode,
 	for (int i = 0; i < STREAM_BUFS; ++i)
 		alBuf[i] = AL::Buffer::gen();
 
+	preloaded.source = 0;
+	preloaded.ops = &opsSlots[1];
+	preloaded.primed = false;
+	preloaded.buf = AL::Buffer::gen();
+
 	pauseMut = SDL_CreateMutex();
 
 	threadName = std::string("al_stream (") + threadId + ")";
@@ -68,6 +78,9 @@ ALStream::~ALStream()
 	for (int i = 0; i < STREAM_BUFS; ++i)
 		AL::Buffer::del(alBuf[i]);
 
+	discardPreloaded();
+	AL::Buffer::del(preloaded.buf);
+
 	SDL_DestroyMutex(pauseMut);
 }
 
@@ -106,6 +119,36 @@ void ALStream::open(const std::string &filename)
 	state = Stopped;
 }
 
+void ALStream::preload(const std::string &filename)
+{
+	if (preloaded.source && preloaded.filename == filename)
+		return;
+
+	discardPreloaded();
+
+	preloaded.source = createSource(filename, *preloaded.ops);
+
+	if (!preloaded.source)
+		return;
+
+	preloaded.filename = filename;
+
+	/* Decode the first buffer right away, unless the last
+	 * primed one is still being played back */
+	if (preBufQueued)
+		return;
+
+	preloaded.source->seekToOffset(0);
+
+	ALDataSource::Status status = preloaded.source->fillBuffer(preloaded.buf);
+
+	/* Very short streams are left to the regular path */
+	if (status == ALDataSource::NoError)
+		preloaded.primed = true;
+	else
+		preloaded.source->seekToOffset(0);
+}
+
 void ALStream::stop()
 {
 	checkStopped();
@@ -197,6 +240,15 @@ float ALStream::queryOffset()
 void ALStream::closeSource()
 {
 	delete source;
+	source = 0;
+}
+
+void ALStream::discardPreloaded()
+{
+	delete preloaded.source;
+	preloaded.source = 0;
+	preloaded.primed = false;
+	preloaded.filename.clear();
 }
 
 struct ALStreamOpenHandler : FileSystem::OpenHandler
@@ -255,23 +307,19 @@ struct ALStreamOpenHandler : FileSystem::OpenHandler
 	}
 };
 
-void ALStream::openSource(const std::string &filename)
+ALDataSource *ALStream::createSource(const std::string &filename, SDL_RWops &ops)
 {
-	ALStreamOpenHandler handler(srcOps, looped);
+	ALStreamOpenHandler handler(ops, looped);
 	shState->fileSystem().openRead(handler, filename.c_str());
-	source = handler.source;
-	needsRewind.clear();
 
 	// Try fallback mode, e.g. for handling S32->F32 sample format conversion
-	if (!source)
+	if (!handler.source)
 	{
 		handler.fallbackMode = 1;
 		shState->fileSystem().openRead(handler, filename.c_str());
-		source = handler.source;
-		needsRewind.clear();
 	}
 
-	if (!source)
+	if (!handler.source)
 	{
 		char buf[512];
 		snprintf(buf, sizeof(buf), "Unable to decode audio stream: %s: %s",
@@ -279,6 +327,31 @@ void ALStream::openSource(const std::string &filename)
 
 		Debug() << buf;
 	}
+
+	return handler.source;
+}
+
+void ALStream::openSource(const std::string &filename)
+{
+	needsRewind.clear();
+	queuePreBuf = false;
+
+	if (preloaded.source && preloaded.filename == filename)
+	{
+		/* Take over the preloaded source along with its ops slot */
+		source = preloaded.source;
+		queuePreBuf = preloaded.primed;
+
+		std::swap(srcOps, preloaded.ops);
+
+		preloaded.source = 0;
+		preloaded.primed = false;
+		preloaded.filename.clear();
+
+		return;
+	}
+
+	source = createSource(filename, *srcOps);
 }
 
 void ALStream::stopStream()
@@ -297,6 +370,13 @@ void ALStream::stopStream()
 	 * seeing the term request */
 	AL::Source::stop(alSrc);
 
+	/* Release the primed buffer so it can be refilled */
+	if (preBufQueued)
+	{
+		AL::Source::clearQueue(alSrc);
+		preBufQueued.clear();
+	}
+
 	procFrames = 0;
 }
 
@@ -309,6 +389,15 @@ void ALStream::startStream(float offset)
 	sourceExhausted.clear();
 	threadTermReq.clear();
 
+	/* The primed buffer only holds the very start of the stream.
+	 * Mark it busy before the thread even starts, so a concurrent
+	 * preload can't overwrite it */
+	if (offset > 0)
+		queuePreBuf = false;
+
+	if (queuePreBuf)
+		preBufQueued.set();
+
 	startOffset = offset;
 	procFrames = offset * source->sampleRate();
 
@@ -370,6 +459,8 @@ void ALStream::checkStopped()
 /* thread func */
 void ALStream::streamData()
 {
+	Trace::setThreadName(threadName.c_str());
+
 	/* Fill up queue */
 	bool firstBuffer = true;
 	ALDataSource::Status status;
@@ -377,8 +468,22 @@ void ALStream::streamData()
 	if (threadTermReq)
 		return;
 
-	//if (needsRewind)
+	if (queuePreBuf)
+	{
+		/* The source already sits right past the primed
+		 * buffer, so start with that instead of seeking */
+		queuePreBuf = false;
+
+		AL::Source::queueBuffer(alSrc, preloaded.buf);
+		resumeStream();
+
+		firstBuffer = false;
+		streamInited.set();
+	}
+	else
+	{
 		source->seekToOffset(startOffset);
+	}
 
 	for (int i = 0; i < STREAM_BUFS; ++i)
 	{
@@ -387,7 +492,10 @@ void ALStream::streamData()
 
 		AL::Buffer::ID buf = alBuf[i];
 
-		status = source->fillBuffer(buf);
+		{
+			TRACE_SCOPE("audio refill");
+			status = source->fillBuffer(buf);
+		}
 
 		if (status == ALDataSource::Error)
 			return;
@@ -450,10 +558,21 @@ void ALStream::streamData()
 					procFrames += ((size / (bits / 8)) / chan);
 			}
 
+			/* The primed buffer is only played once, then
+			 * handed back for the next preload */
+			if (buf == preloaded.buf)
+			{
+				preBufQueued.clear();
+				continue;
+			}
+
 			if (sourceExhausted)
 				continue;
 
-			status = source->fillBuffer(buf);
+			{
+				TRACE_SCOPE("audio refill");
+				status = source->fillBuffer(buf);
+			}
 
 			if (status == ALDataSource::Error)
 			{
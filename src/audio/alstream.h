@@ -74,7 +74,30 @@ struct ALStream
 	uint64_t procFrames;
 	AL::Buffer::ID lastBuf;
 
-	SDL_RWops srcOps;
+	/* The data sources keep referencing the ops they were
+	 * opened from, so the current and the preloaded source
+	 * each get their own slot, swapped on handover */
+	SDL_RWops opsSlots[2];
+	SDL_RWops *srcOps;
+
+	/* A source opened (and its first buffer decoded) ahead
+	 * of time, taken over by the next 'open()' of the same
+	 * file so that switching tracks skips all decoder setup */
+	struct
+	{
+		ALDataSource *source;
+		SDL_RWops *ops;
+		std::string filename;
+
+		/* 'buf' holds the decoded start of the stream */
+		bool primed;
+		AL::Buffer::ID buf;
+	} preloaded;
+
+	/* Set while the primed buffer sits in the source
+	 * queue and may not be written to */
+	AtomicFlag preBufQueued;
+	bool queuePreBuf;
 
 	struct
 	{
@@ -94,6 +117,7 @@ struct ALStream
 
 	void close();
 	void open(const std::string &filename);
+	void preload(const std::string &filename);
 	void stop();
 	void play(float offset = 0);
 	void pause();
@@ -107,6 +131,8 @@ struct ALStream
 private:
 	void closeSource();
 	void openSource(const std::string &filename);
+	ALDataSource *createSource(const std::string &filename, SDL_RWops &ops);
+	void discardPreloaded();
 
 	void stopStream();
 	void startStream(float offset);
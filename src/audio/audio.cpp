@@ -22,6 +22,7 @@
 #include "audio.h"
 
 #include "audiostream.h"
+#include "trace.h"
 #include "debugwriter.h"
 #include "soundemitter.h"
 #include "sharedstate.h"
@@ -33,6 +34,7 @@
 #include <string>
 #include <vector>
 
+#include <SDL_mutex.h>
 #include <SDL_thread.h>
 #include <SDL_timer.h>
 
@@ -42,6 +44,23 @@ struct AudioPrivate
 		int global_sfx_volume;
     
     std::vector<AudioStream*> bgmTracks;
+
+	/* One standby stream per BGM track. Crossfades and
+	 * preloaded switches start the new file here and then
+	 * swap it with the track, leaving the old stream to
+	 * fade out in the background */
+	std::vector<AudioStream*> bgmSpares;
+
+	/* Per track, spares that were still fading out a previous
+	 * track when their slot was needed again. They're left to
+	 * finish and then reused as spares */
+	std::vector<std::vector<AudioStream*> > bgmRetired;
+
+	/* Guards the 'bgmTracks', 'bgmSpares' and 'bgmRetired'
+	 * slots against switchTrack swapping them while the
+	 * MeWatch thread walks them */
+	SDL_mutex *tracksMut;
+
 	AudioStream bgs;
 	AudioStream me;
 
@@ -84,8 +103,13 @@ struct AudioPrivate
         for (int i = 0; i < rtData.config.BGM.trackCount; i++) {
             std::string id = std::string("bgm" + std::to_string(i));
             bgmTracks.push_back(new AudioStream(ALStream::Looped, id.c_str()));
+            bgmSpares.push_back(new AudioStream(ALStream::Looped, (id + "_spare").c_str()));
         }
-        
+
+		bgmRetired.resize(bgmTracks.size());
+
+		tracksMut = SDL_CreateMutex();
+
 		meWatch.state = MeNotPlaying;
 		meWatch.thread = createSDLThread
 			<AudioPrivate, &AudioPrivate::meWatchFun>(this, "audio_mewatch");
@@ -97,6 +121,9 @@ struct AudioPrivate
 		SDL_WaitThread(meWatch.thread, 0);
         for (auto track : bgmTracks)
             delete track;
+        for (auto spare : allSpares())
+            delete spare;
+		SDL_DestroyMutex(tracksMut);
 	}
     
     AudioStream *getTrackByIndex(int index) {
@@ -107,8 +134,116 @@ struct AudioPrivate
         return bgmTracks[index];
     }
 
+    AudioStream *getSpareByIndex(int index) {
+        getTrackByIndex(index);
+        return bgmSpares[index < 0 ? 0 : index];
+    }
+
+	static bool isBusy(AudioStream *stream)
+	{
+		stream->lockStream();
+		bool busy = stream->fade.active
+		        ||  stream->stream.queryState() == ALStream::Playing;
+		stream->unlockStream();
+
+		return busy;
+	}
+
+	/* Returns the spare of track 'index', first swapping it
+	 * for an idle one if it's still fading out an earlier track */
+	AudioStream *getIdleSpare(int index)
+	{
+		AudioStream *spare = getSpareByIndex(index);
+
+		if (index < 0)
+			index = 0;
+
+		if (!isBusy(spare))
+			return spare;
+
+		std::vector<AudioStream*> &retired = bgmRetired[index];
+		AudioStream *idle = 0;
+
+		SDL_LockMutex(tracksMut);
+
+		for (size_t i = 0; i < retired.size(); ++i)
+		{
+			if (isBusy(retired[i]))
+				continue;
+
+			idle = retired[i];
+			retired[i] = spare;
+			break;
+		}
+
+		if (!idle)
+		{
+			std::string id = "bgm" + std::to_string(index)
+			               + "_spare" + std::to_string(retired.size() + 1);
+			idle = new AudioStream(ALStream::Looped, id.c_str());
+			retired.push_back(spare);
+		}
+
+		bgmSpares[index] = idle;
+
+		SDL_UnlockMutex(tracksMut);
+
+		return idle;
+	}
+
+	/* Every BGM stream that isn't a current track */
+	std::vector<AudioStream*> allSpares()
+	{
+		std::vector<AudioStream*> spares(bgmSpares);
+
+		for (auto &retired : bgmRetired)
+			spares.insert(spares.end(), retired.begin(), retired.end());
+
+		return spares;
+	}
+
+	/* Plays 'filename' on the spare stream of track 'index' and
+	 * makes it the new track, while the previous stream fades out
+	 * over 'duration' ms (or stops right away if it's 0). A spare
+	 * still fading out from an earlier switch is left to finish */
+	void switchTrack(int index, const char *filename,
+	                 int volume, int pitch, int duration)
+	{
+		AudioStream *cur = getTrackByIndex(index);
+		AudioStream *next = getIdleSpare(index);
+
+		if (index < 0)
+			index = 0;
+
+		next->stop();
+
+		cur->lockStream();
+		next->lockStream();
+
+		next->extPaused = cur->extPaused;
+		next->setVolume(AudioStream::BaseRatio, cur->getVolume(AudioStream::BaseRatio));
+		next->setVolume(AudioStream::External, cur->getVolume(AudioStream::External));
+
+		next->unlockStream();
+		cur->unlockStream();
+
+		next->play(filename, volume, pitch, 0, duration);
+
+		if (duration > 0)
+			cur->fadeOut(duration);
+		else
+			cur->stop();
+
+		SDL_LockMutex(tracksMut);
+		bgmTracks[index] = next;
+		bgmSpares[index] = cur;
+		SDL_UnlockMutex(tracksMut);
+	}
+
 	void meWatchFun()
 	{
+		Trace::setThreadName("audio_mewatch");
+
 		const float fadeOutStep = 1.f / (200  / AUDIO_SLEEP);
 		const float fadeInStep  = 1.f / (1000 / AUDIO_SLEEP);
 
@@ -119,6 +254,8 @@ struct AudioPrivate
 			if (meWatch.termReq)
 				return;
 
+			SDL_LockMutex(tracksMut);
+
 			switch (meWatch.state)
 			{
 			case MeNotPlaying:
@@ -130,6 +267,8 @@ struct AudioPrivate
 					/* ME playing detected. -> FadeOutBGM */
                     for (auto track : bgmTracks)
                         track->extPaused = true;
+                    for (auto spare : allSpares())
+                        spare->extPaused = true;
                     
 					meWatch.state = BgmFadingOut;
 				}
@@ -184,6 +323,28 @@ struct AudioPrivate
                     track->unlockStream();
                     
                 }
+
+                /* Spares still fading out an old track are ducked
+                 * along with the BGM. They're stopped rather than
+                 * paused, since there's nothing to resume afterwards */
+                for (auto spare : allSpares()) {
+                    spare->lockStream();
+
+                    if (spare->stream.queryState() == ALStream::Playing) {
+                        float vol = spare->getVolume(AudioStream::External) - fadeOutStep;
+
+                        if (vol < 0 || shouldBreak) {
+                            spare->setVolume(AudioStream::External, 0);
+                            spare->stream.stop();
+                        }
+                        else {
+                            spare->setVolume(AudioStream::External, vol);
+                        }
+                    }
+
+                    spare->unlockStream();
+                }
+
                 if (shouldBreak) {
                     meWatch.state = MePlaying;
                     me.unlockStream();
@@ -225,6 +386,13 @@ struct AudioPrivate
                         
                         track->unlockStream();
                     }
+
+                    for (auto spare : allSpares()) {
+                        spare->lockStream();
+                        spare->extPaused = false;
+                        spare->setVolume(AudioStream::External, 1.0f);
+                        spare->unlockStream();
+                    }
 				}
 
                 me.unlockStream();
@@ -256,6 +424,8 @@ struct AudioPrivate
 					/* ME started playing midway BGM fade in. -> FadeOutBGM */
                     for (auto track : bgmTracks)
                         track->extPaused = true;
+                    for (auto spare : allSpares())
+                        spare->extPaused = true;
 					meWatch.state = BgmFadingOut;
 					me.unlockStream();
                     for (auto track : bgmTracks)
@@ -285,6 +455,8 @@ struct AudioPrivate
 			}
 			}
 
+			SDL_UnlockMutex(tracksMut);
+
 			SDL_Delay(AUDIO_SLEEP);
 		}
 	}
@@ -312,7 +484,56 @@ void Audio::bgmPlay(const char *filename,
         track = 0;
     }
 
-	p->getTrackByIndex(track)->play(filename, (volume * p->global_bgm_volume) / 100, pitch, pos);
+	AudioStream *stream = p->getTrackByIndex(track);
+	int vol = (volume * p->global_bgm_volume) / 100;
+
+	/* Switch over to a preloaded file without waiting on the decoder */
+	if (pos == 0 && stream->current.filename != filename
+	&&  p->getSpareByIndex(track)->isPreloaded(filename))
+	{
+		p->switchTrack(track, filename, vol, pitch, 0);
+		return;
+	}
+
+	stream->play(filename, vol, pitch, pos);
+}
+
+void Audio::bgmCrossfade(const char *filename,
+                         int duration,
+                         int volume,
+                         int pitch,
+                         int track)
+{
+	if (track == -127) {
+		for (int i = 1; i < (int)p->bgmTracks.size(); i++)
+			p->bgmTracks[i]->stop();
+
+		track = 0;
+	}
+
+	AudioStream *stream = p->getTrackByIndex(track);
+	int vol = (volume * p->global_bgm_volume) / 100;
+
+	stream->lockStream();
+	bool playing = (stream->stream.queryState() == ALStream::Playing);
+	stream->unlockStream();
+
+	/* Nothing to fade from, or fading into the same file */
+	if (duration <= 0 || !playing || stream->current.filename == filename)
+	{
+		bgmPlay(filename, volume, pitch, 0, track);
+		return;
+	}
+
+	p->switchTrack(track, filename, vol, pitch, duration);
+}
+
+void Audio::bgmPreload(const char *filename, int track)
+{
+	if (track == -127)
+		track = 0;
+
+	p->getIdleSpare(track)->preload(filename);
 }
 
 void Audio::bgmStop(int track)
@@ -320,11 +541,16 @@ void Audio::bgmStop(int track)
     if (track == -127) {
         for (auto track : p->bgmTracks)
             track->stop();
+        for (auto spare : p->allSpares())
+            spare->stop();
         
         return;
     }
     
     p->getTrackByIndex(track)->stop();
+    p->getSpareByIndex(track)->stop();
+    for (auto spare : p->bgmRetired[track < 0 ? 0 : track])
+        spare->stop();
 }
 
 void Audio::bgmFade(int time, int track)
@@ -434,6 +660,8 @@ void Audio::reset()
     for (auto track : p->bgmTracks) {
     	track->stop();
     }
+    for (auto spare : p->allSpares())
+        spare->stop();
 
 	p->bgs.stop();
 	p->me.stop();
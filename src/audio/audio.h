@@ -49,6 +49,12 @@ public:
 	void bgmFade(int time, int track = -127);
     int bgmGetVolume(int track = -127);
     void bgmSetVolume(int volume = 100, int track = -127);
+	void bgmCrossfade(const char *filename,
+	                  int duration,
+	                  int volume = 100,
+	                  int pitch = 100,
+	                  int track = -127);
+	void bgmPreload(const char *filename, int track = -127);
 
 	void bgsPlay(const char *filename,
 	             int volume = 100,
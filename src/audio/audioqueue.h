@@ -0,0 +1,101 @@
+/*
+** audioqueue.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef AUDIOQUEUE_H
+#define AUDIOQUEUE_H
+
+#include "al-util.h"
+#include "sdl-util.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A decoded packet of interleaved float samples waiting in an
+ * SPSCRing. 'Packet' needs 'channels', 'freq', 'frames' and
+ * 'samples' members, like THEORAPLAY_AudioPacket. 'offset'
+ * counts the frames already taken from it */
+template<typename Packet>
+struct AudioQueueItem
+{
+	const Packet *audio;
+	int offset;
+};
+
+/* Consumer side: converts queued packets into 'buffer', which holds
+ * 'bufferSize' samples. A buffer only ever holds whole frames of a
+ * single format, so filling stops at the first packet whose channel
+ * count or rate differs; 'channels' and 'sampleRate' receive the
+ * format of what was written (0 if nothing was). Packets are handed
+ * to 'freePacket' once fully consumed. Returns the sample count */
+template<typename Packet, unsigned capacity, typename FreeFunc>
+size_t drainAudioQueue(SPSCRing<AudioQueueItem<Packet>, capacity> &queue,
+                       int16_t *buffer, size_t bufferSize,
+                       int &channels, int &sampleRate,
+                       FreeFunc freePacket)
+{
+	size_t filled = 0;
+	AudioQueueItem<Packet> *item;
+
+	channels = sampleRate = 0;
+
+	while (filled < bufferSize && (item = queue.front()))
+	{
+		const Packet *packet = item->audio;
+
+		/* An empty packet would otherwise block the queue */
+		if (packet->frames <= 0)
+		{
+			freePacket(packet);
+			queue.pop();
+			continue;
+		}
+
+		if (!channels)
+		{
+			channels = packet->channels;
+			sampleRate = packet->freq;
+		}
+		else if (packet->channels != channels || packet->freq != sampleRate)
+		{
+			break;
+		}
+
+		const size_t room = (bufferSize - filled) / channels * channels;
+		const size_t avail = (size_t) (packet->frames - item->offset) * channels;
+		const size_t count = std::min(room, avail);
+
+		if (!count)
+			break;
+
+		convertF32ToS16(buffer + filled, packet->samples + item->offset * channels, count);
+		item->offset += count / channels;
+		filled += count;
+
+		if (item->offset >= packet->frames)
+		{
+			freePacket(packet);
+			queue.pop();
+		}
+	}
+
+	return filled;
+}
+
+#endif // AUDIOQUEUE_H
@@ -23,6 +23,7 @@
 
 #include "util.h"
 #include "exception.h"
+#include "trace.h"
 
 #include <SDL_mutex.h>
 #include <SDL_thread.h>
@@ -44,6 +45,7 @@ AudioStream::AudioStream(ALStream::LoopMode loopMode,
 	fade.threadName = std::string("audio_fadeout (") + threadId + ")";
 
 	fadeIn.thread = 0;
+	fadeIn.duration = 1000;
 	fadeIn.threadName = std::string("audio_fadein (") + threadId + ")";
 
 	streamMut = SDL_CreateMutex();
@@ -76,7 +78,8 @@ AudioStream::~AudioStream()
 void AudioStream::play(const std::string &filename,
                        int volume,
                        int pitch,
-                       float offset)
+                       float offset,
+                       int fadeInDuration)
 {
 	finiFadeOutInt();
 
@@ -143,10 +146,15 @@ void AudioStream::play(const std::string &filename,
 	setVolume(Base, _volume);
 	stream.setPitch(_pitch);
 
-	if (offset > 0)
+	if (fadeInDuration > 0)
 	{
 		setVolume(FadeIn, 0);
-		startFadeIn();
+		startFadeIn(fadeInDuration);
+	}
+	else if (offset > 0)
+	{
+		setVolume(FadeIn, 0);
+		startFadeIn(1000);
 	}
 
 	current.filename = filename;
@@ -161,6 +169,26 @@ void AudioStream::play(const std::string &filename,
 	unlockStream();
 }
 
+void AudioStream::preload(const std::string &filename)
+{
+	lockStream();
+
+	/* Nothing to gain if it's already open */
+	if (filename != current.filename || stream.queryState() == ALStream::Closed)
+		stream.preload(filename);
+
+	unlockStream();
+}
+
+bool AudioStream::isPreloaded(const std::string &filename)
+{
+	lockStream();
+	bool result = stream.preloaded.source && stream.preloaded.filename == filename;
+	unlockStream();
+
+	return result;
+}
+
 void AudioStream::stop()
 {
 	finiFadeOutInt();
@@ -285,7 +313,7 @@ void AudioStream::finiFadeOutInt()
 	}
 }
 
-void AudioStream::startFadeIn()
+void AudioStream::startFadeIn(uint32_t duration)
 {
 	/* Previous fadein should always be terminated in play() */
 	assert(!fadeIn.thread);
@@ -293,6 +321,7 @@ void AudioStream::startFadeIn()
 	fadeIn.rqFini.clear();
 	fadeIn.rqTerm.clear();
 	fadeIn.startTicks = SDL_GetTicks();
+	fadeIn.duration = duration;
 
 	fadeIn.thread = createSDLThread
 		<AudioStream, &AudioStream::fadeInThread>(this, fadeIn.threadName);
@@ -300,6 +329,8 @@ void AudioStream::startFadeIn()
 
 void AudioStream::fadeOutThread()
 {
+	Trace::setThreadName(fade.threadName.c_str());
+
 	while (true)
 	{
 		/* Just immediately terminate on request */
@@ -338,6 +369,8 @@ void AudioStream::fadeOutThread()
 
 void AudioStream::fadeInThread()
 {
+	Trace::setThreadName(fadeIn.threadName.c_str());
+
 	while (true)
 	{
 		if (fadeIn.rqTerm)
@@ -345,9 +378,8 @@ void AudioStream::fadeInThread()
 
 		lockStream();
 
-		/* Fade in duration is always 1 second */
 		uint32_t cur = SDL_GetTicks() - fadeIn.startTicks;
-		float prog = cur / 1000.0f;
+		float prog = cur / (float) fadeIn.duration;
 
 		ALStream::State state = stream.queryState();
 
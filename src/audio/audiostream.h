@@ -118,16 +118,24 @@ struct AudioStream
 		std::string threadName;
 
 		uint32_t startTicks;
+
+		/* In ms */
+		uint32_t duration;
 	} fadeIn;
 
 	AudioStream(ALStream::LoopMode loopMode,
 	            const std::string &threadId);
 	~AudioStream();
 
+	/* A non-zero 'fadeInDuration' (in ms) fades the stream in
+	 * from silence, as used for crossfades */
 	void play(const std::string &filename,
 	          int volume,
 	          int pitch,
-	          float offset = 0);
+	          float offset = 0,
+	          int fadeInDuration = 0);
+	void preload(const std::string &filename);
+	bool isPreloaded(const std::string &filename);
 	void stop();
 	void fadeOut(int duration);
 	void seek(float offset);
@@ -148,7 +156,7 @@ private:
 	void updateVolume();
 
 	void finiFadeOutInt();
-	void startFadeIn();
+	void startFadeIn(uint32_t duration);
 
 	void fadeOutThread();
 	void fadeInThread();
@@ -600,6 +600,16 @@ struct MidiSource : ALDataSource, MidiReadHandler
 	/* Absolute delta at which we received the LOOP_MARKER CC event */
 	uint32_t loopDelta;
 
+	/* Deltas and frames played since the last reset, used to
+	 * find the frame position of the loop marker */
+	uint64_t playedDeltas;
+	uint64_t playedFrames;
+
+	/* Frame position of the loop marker, known once
+	 * playback passed it for the first time */
+	uint32_t loopFrames;
+	bool loopFramesKnown;
+
 	/* Deltas per beat */
 	uint16_t dpb;
 
@@ -617,6 +627,11 @@ struct MidiSource : ALDataSource, MidiReadHandler
 	           bool looped)
 	    : freq(SYNTH_SAMPLERATE),
 	      looped(looped),
+	      loopDelta(0),
+	      playedDeltas(0),
+	      playedFrames(0),
+	      loopFrames(0),
+	      loopFramesKnown(false),
 	      dpb(480),
 	      pitchShift(0),
 	      genDeltasCarry(0),
@@ -796,6 +811,7 @@ struct MidiSource : ALDataSource, MidiReadHandler
 			tracks[i].scheduleEvent(looped);
 
 		size_t remTicks = BUF_TICKS;
+		bool seam = false;
 
 		/* Iterate until all ticks that fit into the buffer
 		 * have been rendered */
@@ -807,6 +823,13 @@ struct MidiSource : ALDataSource, MidiReadHandler
 			{
 				Track &track = tracks[i];
 
+				/* The longest track's final event marks the loop end.
+				 * Once it fires we cut the buffer, so the seam lands
+				 * on a buffer boundary (to the tick) */
+				if (i == longestI && track.valid && track.remDeltas <= 0
+				    && track.wrapAroundFlag)
+					seam = true;
+
 				/* We have to loop and ensure that the final scheduled
 				 * event lies in the future, as multiple events might
 				 * have to be activated at once */
@@ -833,6 +856,9 @@ struct MidiSource : ALDataSource, MidiReadHandler
 				}
 			}
 
+			if (seam)
+				break;
+
 			size_t nextEvent = (size_t) -1;
 			bool allInvalid = true;
 
@@ -861,6 +887,14 @@ struct MidiSource : ALDataSource, MidiReadHandler
 			if (genTicks == 0)
 				continue;
 
+			/* The loop marker is an event itself, so rendering
+			 * is always split right at it */
+			if (!loopFramesKnown && playedDeltas >= loopDelta)
+			{
+				loopFrames = playedFrames;
+				loopFramesKnown = true;
+			}
+
 			renderTicks(genTicks, BUF_TICKS - remTicks);
 			remTicks -= genTicks;
 
@@ -874,14 +908,23 @@ struct MidiSource : ALDataSource, MidiReadHandler
 			for (size_t i = 0; i < tracks.size(); ++i)
 				if (tracks[i].valid)
 					tracks[i].remDeltas -= intDeltas;
+
+			playedDeltas += intDeltas;
+			playedFrames += genTicks * TICK_FRAMES;
 		}
 
+		size_t renderedTicks = BUF_TICKS - remTicks;
+
 		/* Fill AL buffer */
-		AL::Buffer::uploadData(buf, AL_FORMAT_STEREO16, synthBuf, sizeof(synthBuf), freq);
+		AL::Buffer::uploadData(buf, AL_FORMAT_STEREO16, synthBuf,
+		                       renderedTicks * TICK_FRAMES * 2 * sizeof(int16_t), freq);
 
 		if (tracks[longestI].atEnd)
 			return EndOfStream;
 
+		if (seam)
+			return WrapAround;
+
 		return NoError;
 	}
 
@@ -898,6 +941,7 @@ struct MidiSource : ALDataSource, MidiReadHandler
 
 		/* Reset runtime variables */
 		genDeltasCarry = 0;
+		playedDeltas = playedFrames = 0;
 		updatePlaybackSpeed(DEFAULT_BPM);
 
 		/* Reset tracks */
@@ -905,7 +949,10 @@ struct MidiSource : ALDataSource, MidiReadHandler
 			tracks[i].reset();
 	}
 
-	uint32_t loopStartFrames() { return 0; }
+	uint32_t loopStartFrames()
+	{
+		return loopFramesKnown ? loopFrames : 0;
+	}
 
 	bool setPitch(float value)
 	{
@@ -23,6 +23,65 @@
 #include "exception.h"
 
 #include <SDL_sound.h>
+#include <SDL_endian.h>
+
+#include <string.h>
+#include <algorithm>
+
+static bool findWaveLoop(SDL_RWops &ops, uint32_t &start, uint32_t &end)
+{
+	char id[4];
+
+	if (SDL_RWread(&ops, id, 1, 4) < 4 || memcmp(id, "RIFF", 4))
+		return false;
+
+	SDL_ReadLE32(&ops);
+
+	if (SDL_RWread(&ops, id, 1, 4) < 4 || memcmp(id, "WAVE", 4))
+		return false;
+
+	while (SDL_RWread(&ops, id, 1, 4) == 4)
+	{
+		uint32_t size = SDL_ReadLE32(&ops);
+		Sint64 next = SDL_RWtell(&ops) + size + (size & 1);
+
+		if (!memcmp(id, "smpl", 4) && size >= 36 + 24)
+		{
+			/* Skip to 'numSampleLoops' */
+			SDL_RWseek(&ops, 28, RW_SEEK_CUR);
+			uint32_t loopCount = SDL_ReadLE32(&ops);
+
+			/* Skip 'samplerData' and the loop's cue point ID and type */
+			SDL_RWseek(&ops, 4 + 8, RW_SEEK_CUR);
+			start = SDL_ReadLE32(&ops);
+			end = SDL_ReadLE32(&ops);
+
+			if (loopCount == 0 || end < start)
+				return false;
+
+			/* The end sample is inclusive */
+			end += 1;
+
+			return true;
+		}
+
+		if (SDL_RWseek(&ops, next, RW_SEEK_SET) < 0)
+			return false;
+	}
+
+	return false;
+}
+
+/* Extracts the first loop from a RIFF/WAVE 'smpl' chunk, which is
+ * where wave editors store their loop points. Returns false if there
+ * is none. Leaves 'ops' positioned at the start of the stream. */
+static bool readWaveLoop(SDL_RWops &ops, uint32_t &start, uint32_t &end)
+{
+	bool found = findWaveLoop(ops, start, end);
+	SDL_RWseek(&ops, 0, RW_SEEK_SET);
+
+	return found;
+}
 
 struct SDLSoundSource : ALDataSource
 {
@@ -34,14 +93,34 @@ struct SDLSoundSource : ALDataSource
 	ALenum alFormat;
 	ALsizei alFreq;
 
+	uint32_t frameSize;
+	uint32_t currentFrame;
+
+	/* Decoded frames to drop before handing out data again,
+	 * used to land exactly on frames that Sound_Seek's
+	 * millisecond resolution can't address */
+	uint32_t skipFrames;
+
+	struct
+	{
+		uint32_t start;
+		uint32_t end;
+		bool valid;
+	} loop;
+
 	SDLSoundSource(SDL_RWops &ops,
 	               const char *extension,
 	               uint32_t maxBufSize,
 	               bool looped,
 	               int fallbackMode)
 	    : srcOps(ops),
-	      looped(looped)
+	      looped(looped),
+	      currentFrame(0),
+	      skipFrames(0)
 	{
+		loop.start = loop.end = 0;
+		loop.valid = looped && readWaveLoop(srcOps, loop.start, loop.end);
+
 		if (fallbackMode == 0)
 		{
 			sample = Sound_NewSample(&srcOps, extension, 0, maxBufSize);
@@ -91,6 +170,8 @@ struct SDLSoundSource : ALDataSource
 
 		alFormat = chooseALFormat(sampleSize, sample->actual.channels);
 		alFreq = sample->actual.rate;
+
+		frameSize = sampleSize * sample->actual.channels;
 	}
 
 	~SDLSoundSource()
@@ -99,7 +180,8 @@ struct SDLSoundSource : ALDataSource
 		Sound_FreeSample(sample);
 	}
 
-	Status fillBuffer(AL::Buffer::ID alBuffer)
+	/* Returns the number of decoded bytes, or -1 on error */
+	int32_t decode()
 	{
 		uint32_t decoded = Sound_Decode(sample);
 
@@ -110,19 +192,60 @@ struct SDLSoundSource : ALDataSource
 
 			/* Give up */
 			if (sample->flags & SOUND_SAMPLEFLAG_EAGAIN)
-				return ALDataSource::Error;
+				return -1;
 		}
 
 		if (sample->flags & SOUND_SAMPLEFLAG_ERROR)
-			return ALDataSource::Error;
+			return -1;
+
+		return decoded;
+	}
+
+	Status fillBuffer(AL::Buffer::ID alBuffer)
+	{
+		uint8_t *data;
+		int32_t decoded;
+
+		/* Drop frames left over from the last seek */
+		while (true)
+		{
+			decoded = decode();
+
+			if (decoded < 0)
+				return ALDataSource::Error;
+
+			data = static_cast<uint8_t*>(sample->buffer);
+
+			uint32_t skip = std::min<uint32_t>(skipFrames, decoded / frameSize);
+			skipFrames -= skip;
+			currentFrame += skip;
+			data += skip * frameSize;
+			decoded -= skip * frameSize;
+
+			if (skipFrames == 0 || (sample->flags & SOUND_SAMPLEFLAG_EOF))
+				break;
+		}
 
-		AL::Buffer::uploadData(alBuffer, alFormat, sample->buffer, decoded, alFreq);
+		uint32_t frames = decoded / frameSize;
+		bool seam = false;
 
-		if (sample->flags & SOUND_SAMPLEFLAG_EOF)
+		/* Cut the buffer off exactly at the loop end */
+		if (loop.valid && currentFrame + frames >= loop.end)
+		{
+			frames = (loop.end > currentFrame) ? loop.end - currentFrame : 0;
+			decoded = frames * frameSize;
+			seam = true;
+		}
+
+		currentFrame += frames;
+
+		AL::Buffer::uploadData(alBuffer, alFormat, data, decoded, alFreq);
+
+		if (seam || (sample->flags & SOUND_SAMPLEFLAG_EOF))
 		{
 			if (looped)
 			{
-				Sound_Rewind(sample);
+				seekToLoopStart();
 				return ALDataSource::WrapAround;
 			}
 			else
@@ -139,18 +262,49 @@ struct SDLSoundSource : ALDataSource
 		return sample->actual.rate;
 	}
 
-	void seekToOffset(float seconds)
+	void seekToFrame(uint32_t frame)
 	{
-		if (seconds <= 0)
+		uint32_t ms = (uint64_t) frame * 1000 / alFreq;
+
+		/* Fall back to decoding from the start if the
+		 * decoder can't seek */
+		if (frame == 0 || !Sound_Seek(sample, ms))
+		{
 			Sound_Rewind(sample);
+			currentFrame = 0;
+		}
 		else
-			Sound_Seek(sample, static_cast<uint32_t>(seconds * 1000));
+		{
+			currentFrame = (uint64_t) ms * alFreq / 1000;
+		}
+
+		skipFrames = (frame > currentFrame) ? frame - currentFrame : 0;
+	}
+
+	void seekToLoopStart()
+	{
+		seekToFrame(loop.valid ? loop.start : 0);
+	}
+
+	void seekToOffset(float seconds)
+	{
+		if (seconds <= 0)
+		{
+			seekToFrame(0);
+			return;
+		}
+
+		uint32_t frame = seconds * alFreq;
+
+		if (loop.valid && frame >= loop.end)
+			frame = loop.start + (frame - loop.start) % (loop.end - loop.start);
+
+		seekToFrame(frame);
 	}
 
 	uint32_t loopStartFrames()
 	{
-		/* Loops from the beginning of the file */
-		return 0;
+		return loop.valid ? loop.start : 0;
 	}
 
 	bool setPitch(float)
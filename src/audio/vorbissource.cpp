@@ -111,11 +111,13 @@ struct VorbisSource : ALDataSource
 
 		loop.requested = looped;
 		loop.valid = false;
-		loop.start = loop.length = 0;
+		loop.start = loop.length = loop.end = 0;
 
 		if (!loop.requested)
 			return;
 
+		uint32_t loopEndTag = 0;
+
 		/* Try to extract loop info */
 		for (int i = 0; i < vf.vc->comments; ++i)
 		{
@@ -138,11 +140,29 @@ struct VorbisSource : ALDataSource
 			if (!strcmp(comment, "LOOPLENGTH"))
 				loop.length = strtol(sep+1, 0, 10);
 
+			if (!strcmp(comment, "LOOPEND"))
+				loopEndTag = strtol(sep+1, 0, 10);
+
 			*sep = '=';
 		}
 
+		/* Some tools write LOOPEND instead of LOOPLENGTH,
+		 * and a lone LOOPSTART means looping until EOF */
+		ogg_int64_t totalFrames = ov_pcm_total(&vf, -1);
+
+		if (!loop.length && loopEndTag > loop.start)
+			loop.length = loopEndTag - loop.start;
+
+		if (!loop.length && loop.start && totalFrames > loop.start)
+			loop.length = totalFrames - loop.start;
+
+		/* Clamp loops reaching past the end of the stream, otherwise
+		 * we'd hit EOF and wrap to the wrong position */
+		if (totalFrames > 0 && loop.start + loop.length > totalFrames)
+			loop.length = (loop.start < totalFrames) ? totalFrames - loop.start : 0;
+
 		loop.end = loop.start + loop.length;
-		loop.valid = (loop.start && loop.length);
+		loop.valid = (loop.length > 0);
 	}
 
 	~VorbisSource()
@@ -162,16 +182,31 @@ struct VorbisSource : ALDataSource
 		{
 			ov_raw_seek(&vf, 0);
 			currentFrame = 0;
+
+			return;
 		}
 
 		currentFrame = seconds * info.rate;
 
-		if (loop.valid && currentFrame > loop.end)
-			currentFrame = loop.start;
+		/* Offsets past the loop end map back into the loop
+		 * body instead of snapping to its start */
+		if (loop.valid && currentFrame >= loop.end)
+			currentFrame = loop.start + (currentFrame - loop.start) % loop.length;
 
 		/* If seeking fails, just seek back to start */
 		if (ov_pcm_seek(&vf, currentFrame) != 0)
+		{
 			ov_raw_seek(&vf, 0);
+			currentFrame = 0;
+		}
+	}
+
+	/* Seek to the frame right after the loop seam */
+	bool seekToLoopStart()
+	{
+		currentFrame = loop.valid ? loop.start : 0;
+
+		return ov_pcm_seek(&vf, currentFrame) == 0;
 	}
 
 	Status fillBuffer(AL::Buffer::ID alBuffer)
@@ -186,17 +221,21 @@ struct VorbisSource : ALDataSource
 
 		bool readAgain = false;
 
-		if (loop.valid)
+		while (canRead > 16)
 		{
-			int tilLoopEnd = loop.end * info.frameSize;
+			int readLen = canRead;
 
-			canRead = std::min(availBuf, tilLoopEnd);
-		}
+			/* Never read past the loop end, so the seam lands
+			 * exactly on a buffer boundary */
+			if (loop.valid && currentFrame < loop.end)
+			{
+				int tilLoopEnd = (loop.end - currentFrame) * info.frameSize;
+
+				readLen = std::min(readLen, tilLoopEnd);
+			}
 
-		while (canRead > 16)
-		{
 			long res = ov_read(&vf, static_cast<char*>(bufPtr),
-			                   canRead, 0, sizeof(int16_t), 1, 0);
+			                   readLen, 0, sizeof(int16_t), 1, 0);
 
 			if (res < 0)
 			{
@@ -212,7 +251,9 @@ struct VorbisSource : ALDataSource
 				if (loop.requested)
 				{
 					retStatus = ALDataSource::WrapAround;
-					seekToOffset(0);
+
+					if (!seekToLoopStart())
+						seekToOffset(0);
 				}
 				else
 				{
@@ -251,8 +292,7 @@ struct VorbisSource : ALDataSource
 				retStatus = ALDataSource::WrapAround;
 
 				/* Seek to loop start */
-				currentFrame = loop.start;
-				if (ov_pcm_seek(&vf, currentFrame) != 0)
+				if (!seekToLoopStart())
 					retStatus = ALDataSource::Error;
 
 				break;
@@ -131,6 +131,7 @@ void Config::read(int argc, char *argv[]) {
         {"debugMode", false},
         {"displayFPS", false},
         {"printFPS", false},
+        {"enableTracing", false},
         {"winResizable", true},
         {"fullscreen", false},
         {"fixedAspectRatio", true},
@@ -140,6 +141,7 @@ void Config::read(int argc, char *argv[]) {
         {"bitmapSmoothScalingDown", 0},
         {"smoothScalingMipmaps", false},
         {"bicubicSharpness", 100},
+        {"scalerChain", json::array({})},
 #ifdef MKXPZ_SSL
         {"xbrzScalingFactor", 1.},
 #endif
@@ -154,6 +156,9 @@ void Config::read(int argc, char *argv[]) {
         {"fixedFramerate", 0},
         {"frameSkip", false},
         {"syncToRefreshrate", false},
+        {"fixedTimestep", false},
+        {"inputRecord", ""},
+        {"inputReplay", ""},
         {"solidFonts", json::array({})},
 #if defined(__APPLE__) && defined(__aarch64__)
         {"preferMetalRenderer", true},
@@ -169,6 +174,7 @@ void Config::read(int argc, char *argv[]) {
         {"integerScalingActive", false},
         {"integerScalingLastMile", true},
         {"maxTextureSize", 0},
+        {"viewportCache", false},
         {"gameFolder", ".."},
         {"anyAltToggleFS", false},
         {"enableReset", true},
@@ -185,6 +191,7 @@ void Config::read(int argc, char *argv[]) {
         {"BGMTrackCount", 1},
         {"customScript", ""},
         {"pathCache", true},
+        {"shaderCache", true},
         {"useScriptNames", true},
         {"preloadScript", json::array({})},
         {"RTP", json::array({})},
@@ -244,6 +251,7 @@ try { exp } catch (...) {}
     SET_STRINGOPT(execName, execName);
     SET_OPT(allowSymlinks, boolean);
     SET_OPT(pathCache, boolean);
+    SET_OPT(shaderCache, boolean);
     SET_OPT_CUSTOMKEY(jit.enabled, JITEnable, boolean);
     SET_OPT_CUSTOMKEY(jit.verboseLevel, JITVerboseLevel, integer);
     SET_OPT_CUSTOMKEY(jit.maxCache, JITMaxCache, integer);
@@ -270,6 +278,7 @@ try { exp } catch (...) {}
     SET_OPT(debugMode, boolean);
     SET_OPT(displayFPS, boolean);
     SET_OPT(printFPS, boolean);
+    SET_OPT(enableTracing, boolean);
     SET_OPT(fullscreen, boolean);
     SET_OPT(fixedAspectRatio, boolean);
     SET_OPT(smoothScaling, integer);
@@ -278,6 +287,7 @@ try { exp } catch (...) {}
     SET_OPT(bitmapSmoothScalingDown, integer);
     SET_OPT(smoothScalingMipmaps, boolean);
     SET_OPT(bicubicSharpness, integer);
+    fillStringVec(opts["scalerChain"], scalerChain);
 #ifdef MKXPZ_SSL
     SET_OPT(xbrzScalingFactor, integer);
 #endif
@@ -291,6 +301,9 @@ try { exp } catch (...) {}
     SET_OPT(fixedFramerate, integer);
     SET_OPT(frameSkip, boolean);
     SET_OPT(syncToRefreshrate, boolean);
+    SET_OPT(fixedTimestep, boolean);
+    SET_STRINGOPT(inputRecord, inputRecord);
+    SET_STRINGOPT(inputReplay, inputReplay);
     fillStringVec(opts["solidFonts"], solidFonts);
     for (std::string & solidFont : solidFonts)
         std::transform(solidFont.begin(), solidFont.end(), solidFont.begin(),
@@ -303,6 +316,7 @@ try { exp } catch (...) {}
     SET_OPT_CUSTOMKEY(integerScaling.active, integerScalingActive, boolean);
     SET_OPT_CUSTOMKEY(integerScaling.lastMileScaling, integerScalingLastMile, boolean);
     SET_OPT(maxTextureSize, integer);
+    SET_OPT(viewportCache, boolean);
     SET_OPT(anyAltToggleFS, boolean);
     SET_OPT(enableReset, boolean);
     SET_OPT(enableSettings, boolean);
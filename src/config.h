@@ -39,6 +39,7 @@ struct Config {
     bool preferMetalRenderer;
     bool displayFPS;
     bool printFPS;
+    bool enableTracing;
     
     bool winResizable;
     bool fullscreen;
@@ -49,6 +50,7 @@ struct Config {
     int bitmapSmoothScalingDown;
     bool smoothScalingMipmaps;
     int bicubicSharpness;
+    std::vector<std::string> scalerChain;
 #ifdef MKXPZ_SSL
     double xbrzScalingFactor;
 #endif
@@ -65,12 +67,17 @@ struct Config {
     int fixedFramerate;
     bool frameSkip;
     bool syncToRefreshrate;
+    bool fixedTimestep;
+    
+    std::string inputRecord;
+    std::string inputReplay;
     
     std::vector<std::string> solidFonts;
     
     bool subImageFix;
     bool enableBlitting;
     int maxTextureSize;
+    bool viewportCache;
     
     struct {
         bool active;
@@ -85,6 +92,7 @@ struct Config {
     bool enableSettings;
     bool allowSymlinks;
     bool pathCache;
+    bool shaderCache;
     
     std::string dataPathOrg;
     std::string dataPathApp;
@@ -39,7 +39,10 @@
 #include "sharedstate.h"
 #include "glstate.h"
 #include "texpool.h"
+#include "profiler.h"
 #include "shader.h"
+#include "pixelkernels.h"
+#include "colormatrix.h"
 #include "filesystem.h"
 #include "font.h"
 #include "eventthread.h"
@@ -52,7 +55,11 @@
 #include "sigslot/signal.hpp"
 
 #include <math.h>
+#ifndef M_PI
+# define M_PI 3.14159265358979323846
+#endif
 #include <algorithm>
+#include <atomic>
 
 extern "C" {
 #include "libnsgif/libnsgif.h"
@@ -81,6 +88,14 @@ throw Exception(Exception::MKXPError, \
 
 #define OUTLINE_SIZE 1
 
+/* Limits of Bitmap::blur(radius, passes) */
+#define BLUR_MAX_RADIUS 256
+#define BLUR_MAX_PASSES 8
+
+/* Upper bound for the cells of a hit testing alpha mask;
+ * bigger textures get one cell per 2x2, 4x4... texels */
+#define ALPHA_MASK_CELLS (256 * 256)
+
 /* Normalize (= ensure width and
  * height are positive) */
 static IntRect normalizedRect(const IntRect &rect)
@@ -151,6 +166,11 @@ static void gif_bitmap_modified(void *bitmap)
 
 // --------------------
 
+/* Shared by all bitmaps, so a content stamp is never handed out
+ * twice; not even to a new bitmap that ends up at the address of a
+ * disposed one */
+static std::atomic<uint64_t> nextContentStamp(1);
+
 struct BitmapPrivate
 {
     Bitmap *self;
@@ -243,13 +263,51 @@ struct BitmapPrivate
     Bitmap *selfLores;
     bool assumingRubyGC;
     
+    /* Drawn from nextContentStamp on creation
+     * and again on every modification */
+    uint64_t modStamp;
+    
+    /* Blits / fills recorded between Bitmap::beginBatch()
+     * and endBatch(); fills have no source */
+    struct BatchCommand
+    {
+        const Bitmap *source;
+        IntRect sourceRect;
+        IntRect destRect;
+        Vec4 color;
+        bool smooth;
+    };
+    
+    std::vector<BatchCommand> batch;
+    int batchDepth;
+    ColorQuadArray batchQuads;
+    
+    /* Coarse copy of the alpha channel for hit testing. Each cell
+     * holds the highest alpha of the (1 << shift) wide square of
+     * texels it covers. Read back on first use after a change */
+    struct
+    {
+        std::vector<uint8_t> cells;
+        int w, h;
+        int shift;
+        
+        /* Size of the texture it was read from */
+        int texW, texH;
+        
+        uint64_t stamp;
+        unsigned frame;
+        bool valid;
+    } alphaMask;
+    
     BitmapPrivate(Bitmap *self)
     : self(self),
     megaSurface(0),
     selfHires(0),
     selfLores(0),
     surface(0),
-    assumingRubyGC(false)
+    assumingRubyGC(false),
+    modStamp(nextContentStamp++),
+    batchDepth(0)
     {
         format = SDL_AllocFormat(SDL_PIXELFORMAT_ABGR8888);
         
@@ -265,12 +323,15 @@ struct BitmapPrivate
         
         prepareCon = shState->prepareDraw.connect(&BitmapPrivate::prepare, this);
         
+        alphaMask.valid = false;
+        
         font = &shState->defaultFont();
         pixman_region_init(&tainted);
     }
     
     ~BitmapPrivate()
     {
+        dropBatch();
         prepareCon.disconnect();
         SDL_FreeFormat(format);
         pixman_region_fini(&tainted);
@@ -399,12 +460,64 @@ struct BitmapPrivate
         glState.scissorTest.pop();
     }
     
+    void recordBlit(const Bitmap &source, const IntRect &sourceRect,
+                    const IntRect &destRect, int opacity, bool smooth)
+    {
+        BatchCommand cmd;
+        cmd.source = &source;
+        cmd.sourceRect = sourceRect;
+        cmd.destRect = destRect;
+        cmd.color = Vec4(1, 1, 1, opacity / 255.0f);
+        cmd.smooth = smooth;
+        
+        pushBatch(cmd);
+    }
+    
+    void recordFill(const IntRect &rect, const Vec4 &color)
+    {
+        BatchCommand cmd;
+        cmd.source = 0;
+        cmd.destRect = normalizedRect(rect);
+        cmd.color = color;
+        cmd.smooth = false;
+        
+        pushBatch(cmd);
+    }
+    
+    void pushBatch(const BatchCommand &cmd);
+    void dropBatch();
+    void flushBatch();
+    size_t batchGroupEnd(size_t first, IntRect &bounds) const;
+    
     static void ensureFormat(SDL_Surface *&surf, Uint32 format)
     {
         if (surf->format->format == format)
             return;
         
-        SDL_Surface *surfConv = SDL_ConvertSurfaceFormat(surf, format, 0);
+        SDL_Surface *surfConv;
+        
+        /* What TTF renders into; only differs in channel order */
+        if (format == SDL_PIXELFORMAT_ABGR8888 &&
+            surf->format->format == SDL_PIXELFORMAT_ARGB8888 &&
+            !SDL_MUSTLOCK(surf))
+        {
+            surfConv = SDL_CreateRGBSurfaceWithFormat(0, surf->w, surf->h, 32, format);
+            
+            if (surfConv)
+            {
+                SDL_BlendMode mode;
+                SDL_GetSurfaceBlendMode(surf, &mode);
+                SDL_SetSurfaceBlendMode(surfConv, mode);
+                
+                pixelSwizzleRect(surfConv->pixels, surfConv->pitch,
+                                 surf->pixels, surf->pitch, surf->w, surf->h);
+            }
+        }
+        else
+        {
+            surfConv = SDL_ConvertSurfaceFormat(surf, format, 0);
+        }
+        
         SDL_FreeSurface(surf);
         surf = surfConv;
     }
@@ -417,10 +530,230 @@ struct BitmapPrivate
             surface = 0;
         }
         
+        alphaMask.valid = false;
+        
+        modStamp = nextContentStamp++;
         self->modified();
     }
+    
+    void buildAlphaMask()
+    {
+        /* Sprites draw the high-res texture if there is one */
+        TEXFBO &tex = selfHires ? selfHires->getGLTypes() : getGLTypes();
+        
+        int shift = 0;
+        while (((tex.width + (1 << shift) - 1) >> shift) *
+               ((tex.height + (1 << shift) - 1) >> shift) > ALPHA_MASK_CELLS)
+            ++shift;
+        
+        alphaMask.shift = shift;
+        alphaMask.w = (tex.width + (1 << shift) - 1) >> shift;
+        alphaMask.h = (tex.height + (1 << shift) - 1) >> shift;
+        alphaMask.texW = tex.width;
+        alphaMask.texH = tex.height;
+        alphaMask.cells.assign(alphaMask.w * alphaMask.h, 0);
+        
+        const uint8_t *pixels;
+        int pitch;
+        std::vector<uint8_t> readback;
+        
+        /* Reuse the getPixel() copy if it's current */
+        if (surface && &tex == &gl)
+        {
+            pixels = static_cast<const uint8_t*>(surface->pixels);
+            pitch = surface->pitch;
+        }
+        else
+        {
+            readback.resize((size_t) tex.width * tex.height * 4);
+            pitch = tex.width * 4;
+            
+            FBO::bind(tex.fbo);
+            ::gl.ReadPixels(0, 0, tex.width, tex.height, GL_RGBA, GL_UNSIGNED_BYTE, &readback[0]);
+            
+            pixels = &readback[0];
+        }
+        
+        for (int y = 0; y < tex.height; ++y)
+        {
+            const uint8_t *row = pixels + y * pitch;
+            uint8_t *cells = &alphaMask.cells[(y >> shift) * alphaMask.w];
+            
+            for (int x = 0; x < tex.width; ++x)
+            {
+                uint8_t &cell = cells[x >> shift];
+                cell = std::max(cell, row[x * 4 + 3]);
+            }
+        }
+        
+        alphaMask.stamp = self->contentStamp();
+        alphaMask.frame = self->animationFrame();
+        alphaMask.valid = true;
+    }
 };
 
+/* Only one bitmap holds recorded batch commands at a time: anything
+ * else done to any bitmap submits them first, so no operation ever
+ * sees contents that are missing recorded draws */
+static BitmapPrivate *pendingBatch = 0;
+
+void BitmapPrivate::pushBatch(const BatchCommand &cmd)
+{
+    if (pendingBatch != this)
+    {
+        Bitmap::flushPendingBatch();
+        pendingBatch = this;
+    }
+    
+    batch.push_back(cmd);
+}
+
+void BitmapPrivate::dropBatch()
+{
+    batch.clear();
+    
+    if (pendingBatch == this)
+        pendingBatch = 0;
+}
+
+size_t BitmapPrivate::batchGroupEnd(size_t first, IntRect &bounds) const
+{
+    /* A group goes out in one draw, so its blits all blend against
+     * the target as it was before the group. A blit overlapping an
+     * earlier one has to start a new group; fills just replace */
+    const BatchCommand &head = batch[first];
+    
+    pixman_region16_t covered;
+    pixman_region_init(&covered);
+    
+    int x1 = gl.width, y1 = gl.height, x2 = 0, y2 = 0;
+    size_t i = first;
+    
+    for (; i < batch.size(); ++i)
+    {
+        const BatchCommand &cmd = batch[i];
+        
+        if (cmd.source != head.source || cmd.smooth != head.smooth)
+            break;
+        
+        const IntRect r = normalizedRect(cmd.destRect);
+        
+        if (head.source)
+        {
+            pixman_box16_t box;
+            box.x1 = r.x;
+            box.y1 = r.y;
+            box.x2 = r.x + r.w;
+            box.y2 = r.y + r.h;
+            
+            if (pixman_region_contains_rectangle(&covered, &box) != PIXMAN_REGION_OUT)
+                break;
+            
+            pixman_region_union_rect(&covered, &covered, r.x, r.y, r.w, r.h);
+        }
+        
+        x1 = std::min(x1, r.x);
+        y1 = std::min(y1, r.y);
+        x2 = std::max(x2, r.x + r.w);
+        y2 = std::max(y2, r.y + r.h);
+    }
+    
+    pixman_region_fini(&covered);
+    
+    x1 = clamp(x1, 0, gl.width);
+    y1 = clamp(y1, 0, gl.height);
+    x2 = clamp(x2, x1, gl.width);
+    y2 = clamp(y2, y1, gl.height);
+    bounds = IntRect(x1, y1, x2 - x1, y2 - y1);
+    
+    return i;
+}
+
+void BitmapPrivate::flushBatch()
+{
+    if (pendingBatch == this)
+        pendingBatch = 0;
+    
+    if (batch.empty())
+        return;
+    
+    /* All quads go out in one upload */
+    batchQuads.resize(batch.size());
+    
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        Vertex *vert = &batchQuads.vertices[i*4];
+        Quad::setTexPosRect(vert, batch[i].sourceRect, batch[i].destRect);
+        Quad::setColor(vert, batch[i].color);
+    }
+    
+    batchQuads.commit();
+    
+    glState.blend.pushSet(false);
+    
+    size_t first = 0;
+    
+    while (first < batch.size())
+    {
+        IntRect bounds;
+        const size_t end = batchGroupEnd(first, bounds);
+        const BatchCommand &head = batch[first];
+        
+        if (!head.source)
+        {
+            SimpleColorShader &shader = shState->shaders().simpleColor;
+            shader.bind();
+            shader.setTranslation(Vec2i());
+            
+            bindFBO();
+            pushSetViewport(shader);
+            
+            batchQuads.draw(first, end - first);
+            
+            popViewport();
+        }
+        else
+        {
+            /* The blend equation needs the destination pixels; copy
+             * the touched area to the same place in a scratch texture */
+            TEXFBO &gpTex = shState->gpTexFBO(gl.width, gl.height);
+            
+            GLMeta::blitBegin(gpTex);
+            GLMeta::blitSource(gl);
+            GLMeta::blitRectangle(bounds, Vec2i(bounds.x, bounds.y));
+            GLMeta::blitEnd();
+            
+            BltBatchShader &shader = shState->shaders().bltBatch;
+            shader.bind();
+            const_cast<Bitmap*>(head.source)->bindTex(shader, false);
+            shader.setSource();
+            shader.setDestination(gpTex.tex);
+            shader.setDestSize(Vec2i(gpTex.width, gpTex.height));
+            shader.setTranslation(Vec2i());
+            
+            bindFBO();
+            pushSetViewport(shader);
+            
+            if (head.smooth)
+                TEX::setSmooth(true);
+            
+            batchQuads.draw(first, end - first);
+            
+            if (head.smooth)
+                TEX::setSmooth(false);
+            
+            popViewport();
+        }
+        
+        first = end;
+    }
+    
+    glState.blend.pop();
+    
+    batch.clear();
+    onModified();
+}
+
 struct BitmapOpenHandler : FileSystem::OpenHandler
 {
     // Non-GIF
@@ -664,7 +997,7 @@ Bitmap::Bitmap(void *pixeldata, int width, int height)
         throw Exception(Exception::SDLError, "Error creating Bitmap: %s",
                         SDL_GetError());
     
-    memcpy(surface->pixels, pixeldata, width*height*(p->format->BitsPerPixel/8));
+    pixelCopyRect(surface->pixels, surface->pitch, pixeldata, width*4, width, height);
     
     if (surface->w > glState.caps.maxTexSize || surface->h > glState.caps.maxTexSize)
     {
@@ -702,6 +1035,7 @@ Bitmap::Bitmap(void *pixeldata, int width, int height)
 Bitmap::Bitmap(const Bitmap &other, int frame)
 {
     other.guardDisposed();
+    flushPendingBatch();
     other.ensureNonMega();
     if (frame > -2) other.ensureAnimated();
     
@@ -922,6 +1256,8 @@ void Bitmap::blt(int x, int y,
                  const Bitmap &source, const IntRect &rect,
                  int opacity)
 {
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapBlt);
+    
     if (source.isDisposed())
         return;
     
@@ -1010,6 +1346,8 @@ void Bitmap::stretchBlt(IntRect destRect,
                         int opacity, bool smooth)
 {
     guardDisposed();
+    
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapStretchBlt);
 
     // Don't need this, right? This function is fine with megasurfaces it seems
     //GUARD_MEGA;
@@ -1049,6 +1387,16 @@ void Bitmap::stretchBlt(IntRect destRect,
     if(shrinkRects(sourceRect.y, sourceRect.h, source.height(), destRect.y, destRect.h, height()))
         return;
     
+    if (p->batchDepth > 0 && !p->animation.enabled && &source != this &&
+        !source.isMega() && !source.isAnimated())
+    {
+        p->recordBlit(source, sourceRect, destRect, opacity, smooth);
+        p->addTaintedArea(destRect);
+        return;
+    }
+    
+    flushPendingBatch();
+    
     SDL_Surface *srcSurf = source.megaSurface();
     SDL_Surface *blitTemp = 0;
     bool touchesTaintedArea = p->touchesTaintedArea(destRect);
@@ -1112,8 +1460,12 @@ void Bitmap::stretchBlt(IntRect destRect,
                         throw Exception(Exception::SDLError, "Error creating temporary surface for blitting: %s",
                                         SDL_GetError());
                     
-                    SDL_Rect tmpRect = {0, 0, blitTemp->w, blitTemp->h};
-                    error = SDL_LowerBlit(srcSurf, &srcRect, blitTemp, &tmpRect);
+                    /* Same format on both sides, so this is a plain copy */
+                    const uint8_t *srcPixels = (const uint8_t*) srcSurf->pixels
+                                             + srcRect.y * srcSurf->pitch + srcRect.x * 4;
+                    pixelCopyRect(blitTemp->pixels, blitTemp->pitch,
+                                  srcPixels, srcSurf->pitch, srcRect.w, srcRect.h);
+                    error = 0;
                 }
                 
                 if (error)
@@ -1307,7 +1659,15 @@ void Bitmap::fillRect(const IntRect &rect, const Vec4 &color)
         p->selfHires->fillRect(IntRect(destX, destY, destWidth, destHeight), color);
     }
 
-    p->fillRect(rect, color);
+    if (p->batchDepth > 0)
+    {
+        p->recordFill(rect, color);
+    }
+    else
+    {
+        flushPendingBatch();
+        p->fillRect(rect, color);
+    }
     
     if (color.w == 0)
     /* Clear op */
@@ -1316,7 +1676,8 @@ void Bitmap::fillRect(const IntRect &rect, const Vec4 &color)
     /* Fill op */
         p->addTaintedArea(rect);
     
-    p->onModified();
+    if (p->batchDepth == 0)
+        p->onModified();
 }
 
 void Bitmap::gradientFillRect(int x, int y,
@@ -1332,6 +1693,7 @@ void Bitmap::gradientFillRect(const IntRect &rect,
                               bool vertical)
 {
     guardDisposed();
+    flushPendingBatch();
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -1403,14 +1765,99 @@ void Bitmap::clearRect(const IntRect &rect)
         p->selfHires->clearRect(IntRect(destX, destY, destWidth, destHeight));
     }
 
+    if (p->batchDepth > 0)
+    {
+        p->recordFill(rect, Vec4());
+        return;
+    }
+    
+    flushPendingBatch();
     p->fillRect(rect, Vec4());
     
     p->onModified();
 }
 
+/* Draws all of 'src' stretched over 'dst' with the bound shader;
+ * blending is up to the caller */
+static void filterPass(ShaderBase &shader,
+                     const TEXFBO &src, const Vec2i &srcSize,
+                     const TEXFBO &dst, const Vec2i &dstSize,
+                     bool smooth = false)
+{
+    FBO::bind(dst.fbo);
+    glState.viewport.pushSet(IntRect(Vec2i(), dstSize));
+    shader.applyViewportProj();
+    shader.setTexSize(srcSize);
+    
+    TEX::bind(src.tex);
+    TEX::setSmooth(smooth);
+    
+    Quad &quad = shState->gpQuad();
+    quad.setTexPosRect(FloatRect(0, 0, srcSize.x, srcSize.y),
+                       FloatRect(0, 0, dstSize.x, dstSize.y));
+    quad.draw();
+    
+    TEX::setSmooth(false);
+    glState.viewport.pop();
+}
+
+/* Runs the bound shader over all of 'tex' in place: renders into a
+ * pooled scratch target and copies the result back, so 'tex' stays
+ * the same texture for everything holding on to it */
+static void filterInPlace(ShaderBase &shader, TEXFBO &tex, bool smooth = false)
+{
+    const Vec2i size(tex.width, tex.height);
+    TEXFBO scratch = shState->texPool().request(size.x, size.y);
+    
+    glState.blend.pushSet(false);
+    filterPass(shader, tex, size, scratch, size, smooth);
+    glState.blend.pop();
+    
+    GLMeta::blitBegin(tex);
+    GLMeta::blitSource(scratch);
+    GLMeta::blitRectangle(IntRect(Vec2i(), size), Vec2i());
+    GLMeta::blitEnd();
+    
+    shState->texPool().release(scratch);
+}
+
+/* Gaussian with sigma = radius / 3, cut off at the radius, folded
+ * into taps that sample between two texels (see gaussBlur.frag) */
+static void gaussKernel(float radius,
+                        float weights[GaussBlurShader::Taps],
+                        float offsets[GaussBlurShader::Taps])
+{
+    const int reach = std::min((int) ceilf(radius), 2 * (GaussBlurShader::Taps - 1));
+    const float sigma = std::max(radius / 3, 0.5f);
+    
+    float g[2 * GaussBlurShader::Taps];
+    float total = 0;
+    
+    for (int k = 0; k < 2 * GaussBlurShader::Taps; ++k)
+    {
+        g[k] = (k <= reach) ? expf(-(k * k) / (2 * sigma * sigma)) : 0;
+        total += (k == 0) ? g[k] : 2 * g[k];
+    }
+    
+    weights[0] = g[0] / total;
+    offsets[0] = 0;
+    
+    for (int i = 1; i < GaussBlurShader::Taps; ++i)
+    {
+        const int k = 2 * i - 1;
+        const float w = g[k] + g[k+1];
+        
+        weights[i] = w / total;
+        offsets[i] = (w > 0) ? (k * g[k] + (k+1) * g[k+1]) / w : 0;
+    }
+}
+
 void Bitmap::blur()
 {
     guardDisposed();
+    flushPendingBatch();
+    
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapBlur);
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -1460,103 +1907,136 @@ void Bitmap::blur()
     p->onModified();
 }
 
-void Bitmap::radialBlur(int angle, int divisions)
+void Bitmap::blur(int radius, int passes)
 {
     guardDisposed();
+    flushPendingBatch();
+    
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapBlur);
     
     GUARD_MEGA;
     GUARD_ANIMATED;
     
     if (hasHires()) {
-        p->selfHires->radialBlur(angle, divisions);
+        p->selfHires->blur(radius * p->selfHires->width() / width(), passes);
         return;
     }
-
-    angle     = clamp<int>(angle, 0, 359);
-    divisions = clamp<int>(divisions, 2, 100);
-    
-    const int _width = width();
-    const int _height = height();
     
-    float angleStep = (float) angle / (divisions-1);
-    float opacity   = 1.0f / divisions;
-    float baseAngle = -((float) angle / 2);
+    radius = clamp<int>(radius, 0, BLUR_MAX_RADIUS);
+    passes = clamp<int>(passes, 1, BLUR_MAX_PASSES);
     
-    ColorQuadArray qArray;
-    qArray.resize(5);
+    if (radius == 0)
+        return;
     
-    std::vector<Vertex> &vert = qArray.vertices;
+    /* Halve the resolution until the kernel fits into the shader;
+     * downsampling and the filtered upsampling blur a little too */
+    const int kernelReach = 2 * (GaussBlurShader::Taps - 1);
+    std::vector<Vec2i> sizes(1, Vec2i(width(), height()));
+    float levelRadius = radius;
     
-    int i = 0;
+    while (levelRadius > kernelReach &&
+           sizes.back().x >= 4 && sizes.back().y >= 4)
+    {
+        const Vec2i &prev = sizes.back();
+        sizes.push_back(Vec2i((prev.x + 1) / 2, (prev.y + 1) / 2));
+        levelRadius /= 2;
+    }
     
-    /* Center */
-    FloatRect texRect(0, 0, _width, _height);
-    FloatRect posRect(0, 0, _width, _height);
+    const int levels = sizes.size() - 1;
     
-    i += Quad::setTexPosRect(&vert[i*4], texRect, posRect);
+    /* levels[0] is the bitmap itself */
+    std::vector<TEXFBO> targets(sizes.size());
+    targets[0] = p->gl;
     
-    /* Upper */
-    posRect = FloatRect(0, 0, _width, -_height);
+    for (int i = 1; i <= levels; ++i)
+        targets[i] = shState->texPool().request(sizes[i].x, sizes[i].y);
     
-    i += Quad::setTexPosRect(&vert[i*4], texRect, posRect);
+    TEXFBO scratch = shState->texPool().request(sizes[levels].x, sizes[levels].y);
     
-    /* Lower */
-    posRect = FloatRect(0, _height*2, _width, -_height);
+    glState.blend.pushSet(false);
     
-    i += Quad::setTexPosRect(&vert[i*4], texRect, posRect);
+    SimpleShader &simple = shState->shaders().simple;
+    simple.bind();
+    simple.setTranslation(Vec2i());
     
-    /* Left */
-    posRect = FloatRect(0, 0, -_width, _height);
+    for (int i = 1; i <= levels; ++i)
+        filterPass(simple, targets[i-1], sizes[i-1], targets[i], sizes[i], true);
     
-    i += Quad::setTexPosRect(&vert[i*4], texRect, posRect);
+    float weights[GaussBlurShader::Taps];
+    float offsets[GaussBlurShader::Taps];
+    gaussKernel(levelRadius, weights, offsets);
     
-    /* Right */
-    posRect = FloatRect(_width*2, 0, -_width, _height);
+    GaussBlurShader &gauss = shState->shaders().gaussBlur;
+    gauss.bind();
+    gauss.setTranslation(Vec2i());
+    gauss.setKernel(weights, offsets);
     
-    i += Quad::setTexPosRect(&vert[i*4], texRect, posRect);
+    const Vec2i &size = sizes[levels];
     
-    for (int i = 0; i < 4*5; ++i)
-        vert[i].color = Vec4(1, 1, 1, opacity);
+    /* The kernel folds pairs of texels into one tap between them,
+     * which takes bilinear sampling to read both */
+    for (int i = 0; i < passes; ++i)
+    {
+        gauss.setDirection(Vec2(1, 0));
+        filterPass(gauss, targets[levels], size, scratch, size, true);
+        
+        gauss.setDirection(Vec2(0, 1));
+        filterPass(gauss, scratch, size, targets[levels], size, true);
+    }
     
-    qArray.commit();
+    simple.bind();
     
-    TEXFBO newTex = shState->texPool().request(_width, _height);
+    for (int i = levels; i > 0; --i)
+        filterPass(simple, targets[i], sizes[i], targets[i-1], sizes[i-1], true);
     
-    FBO::bind(newTex.fbo);
+    glState.blend.pop();
     
-    glState.clearColor.pushSet(Vec4());
-    FBO::clear();
+    shState->texPool().release(scratch);
     
-    Transform trans;
-    trans.setOrigin(Vec2(_width / 2.0f, _height / 2.0f));
-    trans.setPosition(Vec2(_width / 2.0f, _height / 2.0f));
+    for (int i = 1; i <= levels; ++i)
+        shState->texPool().release(targets[i]);
     
-    glState.blendMode.pushSet(BlendAddition);
+    /* Blurring spreads the visible parts */
+    if (pixman_region_not_empty(&p->tainted))
+        p->addTaintedArea(rect());
     
-    SimpleMatrixShader &shader = shState->shaders().simpleMatrix;
-    shader.bind();
+    p->onModified();
+}
+
+void Bitmap::radialBlur(int angle, int divisions)
+{
+    guardDisposed();
+    flushPendingBatch();
     
-    p->bindTexture(shader, false);
-    TEX::setSmooth(true);
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapBlur);
     
-    p->pushSetViewport(shader);
+    GUARD_MEGA;
+    GUARD_ANIMATED;
     
-    for (int i = 0; i < divisions; ++i)
-    {
-        trans.setRotation(baseAngle + i*angleStep);
-        shader.setMatrix(trans.getMatrix());
-        qArray.draw();
+    if (hasHires()) {
+        p->selfHires->radialBlur(angle, divisions);
+        return;
     }
+
+    angle     = clamp<int>(angle, 0, 359);
+    divisions = clamp<int>(divisions, 2, RadialBlurShader::MaxDivisions);
     
-    p->popViewport();
+    const float angleStep = (float) angle / (divisions-1);
+    const float baseAngle = -((float) angle / 2);
+    const float toRad = (float) M_PI / 180;
     
-    TEX::setSmooth(false);
+    /* All divisions in a single pass instead of one
+     * blended draw over the whole bitmap per division */
+    RadialBlurShader &shader = shState->shaders().radialBlur;
+    shader.bind();
+    shader.setTranslation(Vec2i());
+    shader.setAngles(baseAngle * toRad, angleStep * toRad);
+    shader.setDivisions(divisions);
     
-    glState.blendMode.pop();
-    glState.clearColor.pop();
+    filterInPlace(shader, p->gl, true);
     
-    shState->texPool().release(p->gl);
-    p->gl = newTex;
+    if (pixman_region_not_empty(&p->tainted))
+        p->addTaintedArea(rect());
     
     p->onModified();
 }
@@ -1564,6 +2044,7 @@ void Bitmap::radialBlur(int angle, int divisions)
 void Bitmap::clear()
 {
     guardDisposed();
+    flushPendingBatch();
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -1596,6 +2077,7 @@ static uint32_t &getPixelAt(SDL_Surface *surf, SDL_PixelFormat *form, int x, int
 Color Bitmap::getPixel(int x, int y) const
 {
     guardDisposed();
+    flushPendingBatch();
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -1667,9 +2149,33 @@ Color Bitmap::getPixel(int x, int y) const
                  (pixel >> p->format->Ashift) & 0xFF);
 }
 
+int Bitmap::hitAlpha(int x, int y) const
+{
+    guardDisposed();
+    flushPendingBatch();
+    
+    GUARD_MEGA;
+    
+    if (x < 0 || y < 0 || x >= width() || y >= height())
+        return 0;
+    
+    if (!p->alphaMask.valid || p->alphaMask.stamp != contentStamp()
+        || p->alphaMask.frame != animationFrame())
+        p->buildAlphaMask();
+    
+    /* Map to the texture the mask was read from */
+    x = x * p->alphaMask.texW / width();
+    y = y * p->alphaMask.texH / height();
+    
+    const int shift = p->alphaMask.shift;
+    
+    return p->alphaMask.cells[(y >> shift) * p->alphaMask.w + (x >> shift)];
+}
+
 void Bitmap::setPixel(int x, int y, const Color &color)
 {
     guardDisposed();
+    flushPendingBatch();
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -1722,14 +2228,15 @@ bool Bitmap::getRaw(void *output, int output_size)
     if (output_size != width()*height()*4) return false;
     
     guardDisposed();
+    flushPendingBatch();
     
     if (hasHires()) {
         Debug() << "GAME BUG: Game is calling getRaw on low-res Bitmap; you may want to patch the game to improve graphics quality.";
     }
 
     if (!p->animation.enabled && (p->surface || p->megaSurface)) {
-        void *src = (p->megaSurface) ? p->megaSurface->pixels : p->surface->pixels;
-        memcpy(output, src, output_size);
+        SDL_Surface *src = (p->megaSurface) ? p->megaSurface : p->surface;
+        pixelCopyRect(output, width()*4, src->pixels, src->pitch, width(), height());
     }
     else {
         FBO::bind(getGLTypes().fbo);
@@ -1741,8 +2248,7 @@ bool Bitmap::getRaw(void *output, int output_size)
 void Bitmap::replaceRaw(void *pixel_data, int size)
 {
     guardDisposed();
-    
-    GUARD_MEGA;
+    flushPendingBatch();
     
     if (hasHires()) {
         Debug() << "GAME BUG: Game is calling replaceRaw on low-res Bitmap; you may want to patch the game to improve graphics quality.";
@@ -1755,6 +2261,12 @@ void Bitmap::replaceRaw(void *pixel_data, int size)
     if (size != w*h*4)
         throw Exception(Exception::MKXPError, "Replacement bitmap data is not large enough (given %i bytes, need %i)", size, requiredsize);
     
+    if (p->megaSurface) {
+        pixelCopyRect(p->megaSurface->pixels, p->megaSurface->pitch, pixel_data, w*4, w, h);
+        p->onModified();
+        return;
+    }
+    
     TEX::bind(getGLTypes().tex);
     TEX::uploadImage(w, h, pixel_data, GL_RGBA);
     
@@ -1765,6 +2277,7 @@ void Bitmap::replaceRaw(void *pixel_data, int size)
 void Bitmap::saveToFile(const char *filename)
 {
     guardDisposed();
+    flushPendingBatch();
     
     if (hasHires()) {
         Debug() << "GAME BUG: Game is calling saveToFile on low-res Bitmap; you may want to patch the game to improve graphics quality.";
@@ -1825,6 +2338,9 @@ void Bitmap::saveToFile(const char *filename)
 void Bitmap::hueChange(int hue)
 {
     guardDisposed();
+    flushPendingBatch();
+    
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapHueChange);
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -1837,31 +2353,49 @@ void Bitmap::hueChange(int hue)
     if ((hue % 360) == 0)
         return;
     
-    TEXFBO newTex = shState->texPool().request(width(), height());
-    
-    FloatRect texRect(rect());
-    
-    Quad &quad = shState->gpQuad();
-    quad.setTexPosRect(texRect, texRect);
-    quad.setColor(Vec4(1, 1, 1, 1));
-    
     HueShader &shader = shState->shaders().hue;
     shader.bind();
+    shader.setTranslation(Vec2i());
     /* Shader expects normalized value */
     shader.setHueAdjust(wrapRange(hue, 0, 359) / 360.0f);
     
-    FBO::bind(newTex.fbo);
-    p->pushSetViewport(shader);
-    p->bindTexture(shader, false);
+    filterInPlace(shader, p->gl);
     
-    p->blitQuad(quad);
+    p->onModified();
+}
+
+void Bitmap::colorMatrix(const ColorMatrix &mat)
+{
+    guardDisposed();
+    flushPendingBatch();
     
-    p->popViewport();
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapColorMatrix);
+    
+    GUARD_MEGA;
+    GUARD_ANIMATED;
+    
+    if (hasHires()) {
+        p->selfHires->colorMatrix(mat);
+        return;
+    }
+    
+    if (mat.isIdentity())
+        return;
+    
+    float glMat[16];
+    mat.toGL(glMat);
+    
+    ColorMatrixShader &shader = shState->shaders().colorMatrix;
+    shader.bind();
+    shader.setTranslation(Vec2i());
+    shader.setMatrix(glMat);
+    shader.setOffset(Vec4(mat.offset[0], mat.offset[1], mat.offset[2], mat.offset[3]));
     
-    TEX::unbind();
+    filterInPlace(shader, p->gl);
     
-    shState->texPool().release(p->gl);
-    p->gl = newTex;
+    /* Transparent pixels might not stay that way */
+    if (mat.touchesAlpha())
+        p->addTaintedArea(rect());
     
     p->onModified();
 }
@@ -1888,14 +2422,18 @@ static std::string fixupString(const char *str)
     return s;
 }
 
+static uint32_t *surfaceRow(SDL_Surface *surf, int y)
+{
+    return (uint32_t*) ((uint8_t*) surf->pixels + y*surf->pitch);
+}
+
 static void applyShadow(SDL_Surface *&in, const SDL_PixelFormat &fm, const SDL_Color &c)
 {
     SDL_Surface *out = SDL_CreateRGBSurface
     (0, in->w+1, in->h+1, fm.BitsPerPixel, fm.Rmask, fm.Gmask, fm.Bmask, fm.Amask);
     
-    float fr = c.r / 255.0f;
-    float fg = c.g / 255.0f;
-    float fb = c.b / 255.0f;
+    const uint32_t color = c.r | c.g << 8 | c.b << 16;
+    const PixelKernels &kernels = pixelKernels();
     
     /* We allocate an output surface one pixel wider and higher than the input,
      * (implicitly) blit a copy of the input with RGB values set to black into
@@ -1903,72 +2441,32 @@ static void applyShadow(SDL_Surface *&in, const SDL_PixelFormat &fm, const SDL_C
      * (0,0) using the bitmap blit equation (see shader/bitmapBlit.frag) */
     
     for (int y = 0; y < in->h+1; ++y)
-        for (int x = 0; x < in->w+1; ++x)
+    {
+        uint32_t *outRow = surfaceRow(out, y);
+        
+        /* src: input row, shd: shadow row (offset by one) */
+        const uint32_t *src = (y < in->h) ? surfaceRow(in, y) : 0;
+        const uint32_t *shd = (y > 0) ? surfaceRow(in, y-1) : 0;
+        
+        if (!shd)
         {
-            /* src: input pixel, shd: shadow pixel */
-            uint32_t src = 0, shd = 0;
-            
-            /* Output pixel location */
-            uint32_t *outP = ((uint32_t*) ((uint8_t*) out->pixels + y*out->pitch)) + x;
-            
-            if (y < in->h && x < in->w)
-                src = ((uint32_t*) ((uint8_t*) in->pixels + y*in->pitch))[x];
-            
-            if (y > 0 && x > 0)
-                shd = ((uint32_t*) ((uint8_t*) in->pixels + (y-1)*in->pitch))[x-1];
-            
-            /* Set shadow pixel RGB values to 0 (black) */
-            shd &= fm.Amask;
-            
-            if (x == 0 || y == 0)
-            {
-                *outP = src;
-                continue;
-            }
-            
-            if (x == in->w || y == in->h)
-            {
-                *outP = shd;
-                continue;
-            }
-            
-            /* Input and shadow alpha values */
-            uint8_t srcA, shdA;
-            srcA = (src & fm.Amask) >> fm.Ashift;
-            shdA = (shd & fm.Amask) >> fm.Ashift;
-            
-            if (srcA == 255 || shdA == 0)
-            {
-                *outP = src;
-                continue;
-            }
-            
-            if (srcA == 0 && shdA == 0)
-            {
-                *outP = 0;
-                continue;
-            }
-            
-            float fSrcA = srcA / 255.0f;
-            float fShdA = shdA / 255.0f;
-            
-            /* Because opacity == 1, co1 == fSrcA */
-            float co2 = fShdA * (1.0f - fSrcA);
-            /* Result alpha */
-            float fa = fSrcA + co2;
-            /* Temp value to simplify arithmetic below */
-            float co3 = fSrcA / fa;
-            
-            /* Result colors */
-            uint8_t r, g, b, a;
-            
-            r = clamp<float>(fr * co3, 0, 1) * 255.0f;
-            g = clamp<float>(fg * co3, 0, 1) * 255.0f;
-            b = clamp<float>(fb * co3, 0, 1) * 255.0f;
-            a = clamp<float>(fa, 0, 1) * 255.0f;
-            
-            *outP = SDL_MapRGBA(&fm, r, g, b, a);
+            memcpy(outRow, src, in->w*4);
+            outRow[in->w] = 0;
+            continue;
+        }
+        
+        if (!src)
+        {
+            outRow[0] = 0;
+            for (int x = 1; x < in->w+1; ++x)
+                outRow[x] = shd[x-1] & fm.Amask;
+            continue;
         }
+        
+        outRow[0] = src[0];
+        kernels.shadow(outRow+1, src+1, shd, in->w-1, color);
+        outRow[in->w] = shd[in->w-1] & fm.Amask;
+    }
     
     /* Store new surface in the input pointer */
     SDL_FreeSurface(in);
@@ -1978,6 +2476,9 @@ static void applyShadow(SDL_Surface *&in, const SDL_PixelFormat &fm, const SDL_C
 void Bitmap::drawText(const IntRect &rect, const char *str, int align)
 {
     guardDisposed();
+    flushPendingBatch();
+    
+    Profiler::Scope profile(shState->profiler(), Profiler::BitmapDrawText);
     
     GUARD_MEGA;
     GUARD_ANIMATED;
@@ -2054,10 +2555,12 @@ void Bitmap::drawText(const IntRect &rect, const char *str, int align)
             outline = TTF_RenderUTF8_Blended(font, str, co);
         
         p->ensureFormat(outline, SDL_PIXELFORMAT_ABGR8888);
-        SDL_Rect outRect = {scaledOutlineSize, scaledOutlineSize, txtSurf->w, txtSurf->h};
         
-        SDL_SetSurfaceBlendMode(txtSurf, SDL_BLENDMODE_BLEND);
-        SDL_BlitSurface(txtSurf, NULL, outline, &outRect);
+        /* Blend the text over the outline, offset by the outline size */
+        int blendW = std::min(txtSurf->w, outline->w - scaledOutlineSize);
+        int blendH = std::min(txtSurf->h, outline->h - scaledOutlineSize);
+        pixelBlendRect(surfaceRow(outline, scaledOutlineSize) + scaledOutlineSize, outline->pitch,
+                       txtSurf->pixels, txtSurf->pitch, blendW, blendH);
         SDL_FreeSurface(txtSurf);
         txtSurf = outline;
         /* reset outline to 0 */
@@ -2353,6 +2856,7 @@ int Bitmap::currentFrameI() const
 int Bitmap::addFrame(Bitmap &source, int position)
 {
     guardDisposed();
+    flushPendingBatch();
     
     GUARD_MEGA;
     
@@ -2560,6 +3064,26 @@ void Bitmap::bindTex(ShaderBase &shader, bool substituteLoresSize)
     p->bindTexture(shader, substituteLoresSize);
 }
 
+uint64_t Bitmap::contentStamp() const
+{
+    /* Every modification of either one draws a stamp larger
+     * than all before, so the newer one identifies the pair */
+    if (p->selfHires)
+        return std::max(p->modStamp, p->selfHires->p->modStamp);
+    
+    return p->modStamp;
+}
+
+unsigned Bitmap::animationFrame() const
+{
+    return p->animation.enabled ? p->animation.currentFrameI() : 0;
+}
+
+void Bitmap::markModified()
+{
+    p->onModified();
+}
+
 void Bitmap::taintArea(const IntRect &rect)
 {
     if (hasHires()) {
@@ -2575,6 +3099,28 @@ void Bitmap::taintArea(const IntRect &rect)
     p->addTaintedArea(rect);
 }
 
+void Bitmap::beginBatch()
+{
+    guardDisposed();
+    
+    ++p->batchDepth;
+}
+
+void Bitmap::endBatch()
+{
+    if (isDisposed() || p->batchDepth == 0)
+        return;
+    
+    if (--p->batchDepth == 0)
+        p->flushBatch();
+}
+
+void Bitmap::flushPendingBatch()
+{
+    if (pendingBatch)
+        pendingBatch->flushBatch();
+}
+
 int Bitmap::maxSize(){
     return glState.caps.maxTexSize;
 }
@@ -2586,6 +3132,10 @@ void Bitmap::assumeRubyGC()
 
 void Bitmap::releaseResources()
 {
+    /* The recorded batch may read from this bitmap */
+    if (pendingBatch != p)
+        flushPendingBatch();
+    
     if (p->selfHires && !p->assumingRubyGC) {
         delete p->selfHires;
     }
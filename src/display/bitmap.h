@@ -23,19 +23,23 @@
 #define BITMAP_H
 
 #include "disposable.h"
+#include "bindingslots.h"
 #include "etc-internal.h"
 #include "etc.h"
 
 #include "sigslot/signal.hpp"
 
+#include <stdint.h>
+
 class Font;
 class ShaderBase;
+struct ColorMatrix;
 struct TEXFBO;
 struct SDL_Surface;
 
 struct BitmapPrivate;
 // FIXME make this class use proper RGSS classes again
-class Bitmap : public Disposable
+class Bitmap : public Disposable, public BindingSlots
 {
 public:
 	Bitmap(const char *filename);
@@ -88,11 +92,29 @@ public:
 	void clearRect(const IntRect &rect);
 
 	void blur();
+	/* Gaussian blur of 'radius' pixels, 'passes' times over;
+	 * wide radii are blurred at a reduced resolution */
+	void blur(int radius, int passes = 1);
 	void radialBlur(int angle, int divisions);
 
 	void clear();
 
+	/* Between these, blits and fills are recorded instead of drawn
+	 * right away, and submitted in as few draws as possible on the
+	 * outermost endBatch(). Any other operation on any bitmap (or
+	 * a screen update) submits them early, so results are the same
+	 * as without batching. Calls nest */
+	void beginBatch();
+	void endBatch();
+
 	Color getPixel(int x, int y) const;
+
+	/* Alpha at (x, y) for hit testing, 0 outside of the bitmap.
+	 * Comes from a coarse copy of the alpha channel (exact for
+	 * bitmaps up to 256x256, otherwise the highest alpha of the
+	 * surrounding 2x2, 4x4... block) that is only read back after
+	 * the contents changed, so it is cheap to call repeatedly */
+	int hitAlpha(int x, int y) const;
 	void setPixel(int x, int y, const Color &color);
     
     bool getRaw(void *output, int output_size);
@@ -101,6 +123,10 @@ public:
 
 	void hueChange(int hue);
 
+	/* Applies 'mat' to every pixel in one pass. Like hueChange(),
+	 * works in place on the existing texture */
+	void colorMatrix(const ColorMatrix &mat);
+
 	enum TextAlign
 	{
 		Left = 0,
@@ -160,13 +186,30 @@ public:
 	 * texture size uniform in shader */
 	void bindTex(ShaderBase &shader, bool substituteLoresSize = true);
 
+	/* Changes on every modification, and is unique among all
+	 * bitmaps ever created, so it also tells a bitmap apart from
+	 * one that took a disposed bitmap's place in memory */
+	uint64_t contentStamp() const;
+
+	/* The animation frame currently shown, 0 if not animated */
+	unsigned animationFrame() const;
+
 	/* Adds 'rect' to tainted area */
 	void taintArea(const IntRect &rect);
 
+	/* For code that draws into the backing texture directly:
+	 * drops cached CPU side copies, advances contentStamp()
+	 * and emits 'modified'. Use this rather than emitting
+	 * 'modified' by hand */
+	void markModified();
+
 	sigslot::signal<> modified;
 
 	static int maxSize();
 
+	/* Submits the recorded batch, if there is one */
+	static void flushPendingBatch();
+
     void assumeRubyGC();
 
 private:
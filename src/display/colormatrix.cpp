@@ -0,0 +1,174 @@
+/*
+** colormatrix.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "colormatrix.h"
+
+#include <math.h>
+
+/* Same weights as gray.frag */
+static const float lumaR = 0.299f;
+static const float lumaG = 0.587f;
+static const float lumaB = 0.114f;
+
+ColorMatrix::ColorMatrix()
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+			m[i][j] = (i == j) ? 1 : 0;
+
+		offset[i] = 0;
+	}
+}
+
+ColorMatrix ColorMatrix::then(const ColorMatrix &next) const
+{
+	ColorMatrix result;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			float sum = 0;
+
+			for (int k = 0; k < 4; ++k)
+				sum += next.m[i][k] * m[k][j];
+
+			result.m[i][j] = sum;
+		}
+
+		float off = next.offset[i];
+
+		for (int k = 0; k < 4; ++k)
+			off += next.m[i][k] * offset[k];
+
+		result.offset[i] = off;
+	}
+
+	return result;
+}
+
+bool ColorMatrix::isIdentity() const
+{
+	const ColorMatrix identity;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+			if (m[i][j] != identity.m[i][j])
+				return false;
+
+		if (offset[i] != 0)
+			return false;
+	}
+
+	return true;
+}
+
+bool ColorMatrix::touchesAlpha() const
+{
+	return m[3][0] != 0 || m[3][1] != 0 || m[3][2] != 0 ||
+	       m[3][3] != 1 || offset[3] != 0;
+}
+
+void ColorMatrix::toGL(float out[16]) const
+{
+	for (int i = 0; i < 4; ++i)
+		for (int j = 0; j < 4; ++j)
+			out[j*4+i] = m[i][j];
+}
+
+ColorMatrix ColorMatrix::hue(float degrees)
+{
+	const float angle = degrees * 3.141592654f / 180.0f;
+	const float c = cosf(angle);
+	const float s = sinf(angle);
+
+	ColorMatrix result;
+
+	result.m[0][0] = 0.213f + c * 0.787f - s * 0.213f;
+	result.m[0][1] = 0.715f - c * 0.715f - s * 0.715f;
+	result.m[0][2] = 0.072f - c * 0.072f + s * 0.928f;
+
+	result.m[1][0] = 0.213f - c * 0.213f + s * 0.143f;
+	result.m[1][1] = 0.715f + c * 0.285f + s * 0.140f;
+	result.m[1][2] = 0.072f - c * 0.072f - s * 0.283f;
+
+	result.m[2][0] = 0.213f - c * 0.213f - s * 0.787f;
+	result.m[2][1] = 0.715f - c * 0.715f + s * 0.715f;
+	result.m[2][2] = 0.072f + c * 0.928f + s * 0.072f;
+
+	return result;
+}
+
+ColorMatrix ColorMatrix::saturation(float amount)
+{
+	const float luma[] = { lumaR, lumaG, lumaB };
+
+	ColorMatrix result;
+
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			result.m[i][j] = luma[j] * (1 - amount) + ((i == j) ? amount : 0);
+
+	return result;
+}
+
+ColorMatrix ColorMatrix::grayscale(float amount)
+{
+	return saturation(1 - amount);
+}
+
+ColorMatrix ColorMatrix::brightness(float factor)
+{
+	ColorMatrix result;
+
+	for (int i = 0; i < 3; ++i)
+		result.m[i][i] = factor;
+
+	return result;
+}
+
+ColorMatrix ColorMatrix::tint(const Vec4 &color)
+{
+	const float rgb[] = { color.x, color.y, color.z };
+
+	ColorMatrix result;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		result.m[i][i] = 1 - color.w;
+		result.offset[i] = rgb[i] * color.w;
+	}
+
+	return result;
+}
+
+ColorMatrix ColorMatrix::invert()
+{
+	ColorMatrix result;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		result.m[i][i] = -1;
+		result.offset[i] = 1;
+	}
+
+	return result;
+}
@@ -0,0 +1,67 @@
+/*
+** colormatrix.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COLORMATRIX_H
+#define COLORMATRIX_H
+
+#include "etc-internal.h"
+
+/* Affine transform of a non premultiplied RGBA color in 0..1:
+ * out = m * in + offset, clamped. Chaining any number of them with
+ * then() still takes a single pass in Bitmap::colorMatrix() */
+struct ColorMatrix
+{
+	/* Row major, rows produce R, G, B and A */
+	float m[4][4];
+	float offset[4];
+
+	/* Identity */
+	ColorMatrix();
+
+	/* This transform followed by 'next' */
+	ColorMatrix then(const ColorMatrix &next) const;
+
+	bool isIdentity() const;
+
+	/* Whether it can change alpha */
+	bool touchesAlpha() const;
+
+	/* Column major 4x4, as GL expects it */
+	void toGL(float out[16]) const;
+
+	/* Rotates hue around the luma axis, like CSS hue-rotate()
+	 * (unlike Bitmap::hueChange(), which rotates HSV hue) */
+	static ColorMatrix hue(float degrees);
+
+	/* 0 is gray, 1 leaves colors as they are */
+	static ColorMatrix saturation(float amount);
+
+	/* 1 is full gray; same luma as Tone gray */
+	static ColorMatrix grayscale(float amount);
+
+	/* Multiplies RGB */
+	static ColorMatrix brightness(float factor);
+
+	/* Mixes RGB towards 'color' by its alpha, like Sprite color */
+	static ColorMatrix tint(const Vec4 &color);
+
+	static ColorMatrix invert();
+};
+
+#endif // COLORMATRIX_H
@@ -24,6 +24,7 @@
 
 #include "etc.h"
 #include "util.h"
+#include "bindingslots.h"
 
 #include <vector>
 #include <string>
@@ -61,7 +62,7 @@ private:
 
 struct FontPrivate;
 
-class Font
+class Font : public BindingSlots
 {
 public:
 	static bool doesExist(const char *name);
@@ -0,0 +1,533 @@
+/*
+** framecapture.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "framecapture.h"
+
+#include "debugwriter.h"
+#include "sdl-util.h"
+#include "trace.h"
+
+#include <SDL_image.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+
+/* Encoded frames allowed to pile up before
+ * the capturing thread is made to wait */
+#define CAPTURE_MAX_QUEUED 8
+
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+
+static std::string extensionOf(const std::string &path)
+{
+	size_t dot = path.rfind('.');
+	size_t slash = path.find_last_of("/\\");
+
+	if (dot == std::string::npos || (slash != std::string::npos && slash > dot))
+		return std::string();
+
+	std::string ext = path.substr(dot + 1);
+
+	for (size_t i = 0; i < ext.size(); ++i)
+		ext[i] = tolower(ext[i]);
+
+	return ext;
+}
+
+static bool isVideoPath(const std::string &path)
+{
+	return extensionOf(path) == "y4m";
+}
+
+/* Expands a "%d" / "%0Nd" counter in 'pattern', or appends
+ * "_NNNNN" to the file name if there is none */
+static std::string sequencePath(const std::string &pattern, int index)
+{
+	size_t pct = pattern.find('%');
+
+	if (pct != std::string::npos)
+	{
+		size_t i = pct + 1;
+		int width = 0;
+
+		while (i < pattern.size() && isdigit(pattern[i]))
+			width = width * 10 + (pattern[i++] - '0');
+
+		if (i < pattern.size() && pattern[i] == 'd')
+		{
+			char num[32];
+			snprintf(num, sizeof(num), "%0*d", width, index);
+
+			return pattern.substr(0, pct) + num + pattern.substr(i + 1);
+		}
+	}
+
+	char num[32];
+	snprintf(num, sizeof(num), "_%05d", index);
+
+	std::string ext = extensionOf(pattern);
+
+	if (ext.empty())
+		return pattern + num;
+
+	size_t dot = pattern.size() - ext.size() - 1;
+
+	return pattern.substr(0, dot) + num + pattern.substr(dot);
+}
+
+FrameCapture::FrameCapture()
+    : nextSerial(0),
+      async(gl.pixel_buffer && gl.fence_sync),
+      recording(false),
+      recordInterval(1),
+      recordFps(60),
+      recordTick(0),
+      recordIndex(0),
+      encoding(0),
+      stopWorker(false),
+      video(0),
+      videoWidth(0),
+      videoHeight(0)
+{
+	for (int i = 0; i < SlotCount; ++i)
+	{
+		slots[i].pbo = PackBO::ID(0);
+		slots[i].fence = 0;
+		slots[i].size = 0;
+		slots[i].serial = 0;
+	}
+
+	mutex = SDL_CreateMutex();
+	jobCond = SDL_CreateCond();
+	doneCond = SDL_CreateCond();
+
+	worker = createSDLThread
+		<FrameCapture, &FrameCapture::workerLoop>(this, "capture");
+}
+
+FrameCapture::~FrameCapture()
+{
+	stopRecording();
+	finishAll();
+
+	SDL_LockMutex(mutex);
+	stopWorker = true;
+	SDL_CondSignal(jobCond);
+	SDL_UnlockMutex(mutex);
+
+	SDL_WaitThread(worker, 0);
+
+	for (int i = 0; i < SlotCount; ++i)
+		if (slots[i].pbo != PackBO::ID(0))
+			PackBO::del(slots[i].pbo);
+
+	SDL_DestroyCond(doneCond);
+	SDL_DestroyCond(jobCond);
+	SDL_DestroyMutex(mutex);
+}
+
+void FrameCapture::capture(const TEXFBO &src, int width, int height,
+                           const std::string &path)
+{
+	Job job;
+	job.kind = Image;
+	job.width = width;
+	job.height = height;
+	job.fps = 0;
+	job.path = path;
+
+	readback(src, job);
+}
+
+void FrameCapture::startRecording(const std::string &path, int interval, int fps)
+{
+	stopRecording();
+
+	recording = true;
+	recordPath = path;
+	recordInterval = std::max(interval, 1);
+	recordFps = std::max(fps, 1);
+	recordTick = 0;
+	recordIndex = 0;
+}
+
+void FrameCapture::stopRecording()
+{
+	if (!recording)
+		return;
+
+	recording = false;
+
+	if (!isVideoPath(recordPath))
+		return;
+
+	/* The stream may only be closed after its last frame */
+	finishAll();
+
+	Job job;
+	job.kind = VideoEnd;
+	job.width = job.height = job.fps = 0;
+	job.path = recordPath;
+
+	submit(job);
+}
+
+void FrameCapture::onFrame(const TEXFBO &src, int width, int height)
+{
+	if (!recording)
+		return;
+
+	if (recordTick++ % recordInterval != 0)
+		return;
+
+	Job job;
+	job.width = width;
+	job.height = height;
+	job.fps = recordFps;
+
+	if (isVideoPath(recordPath))
+	{
+		job.kind = VideoFrame;
+		job.path = recordPath;
+	}
+	else
+	{
+		job.kind = Image;
+		job.path = sequencePath(recordPath, recordIndex++);
+	}
+
+	readback(src, job);
+}
+
+void FrameCapture::poll()
+{
+	/* Strictly in issue order so video frames stay in sequence */
+	while (Slot *slot = oldestSlot())
+		if (!finishSlot(*slot, false))
+			break;
+}
+
+void FrameCapture::flush()
+{
+	finishAll();
+
+	SDL_LockMutex(mutex);
+
+	while (!queue.empty() || encoding > 0)
+		SDL_CondWait(doneCond, mutex);
+
+	SDL_UnlockMutex(mutex);
+}
+
+int FrameCapture::pending() const
+{
+	int inFlight = 0;
+
+	for (int i = 0; i < SlotCount; ++i)
+		if (slots[i].fence)
+			inFlight++;
+
+	SDL_LockMutex(mutex);
+	inFlight += queue.size() + encoding;
+	SDL_UnlockMutex(mutex);
+
+	return inFlight;
+}
+
+void FrameCapture::readback(const TEXFBO &src, Job &job)
+{
+	TRACE_SCOPE("capture readback");
+
+	const size_t size = job.width * job.height * 4;
+
+	FBO::bind(src.fbo);
+
+	if (!async)
+	{
+		job.pixels.resize(size);
+		gl.ReadPixels(0, 0, job.width, job.height, GL_RGBA, GL_UNSIGNED_BYTE, &job.pixels[0]);
+		submit(job);
+
+		return;
+	}
+
+	Slot *slot = 0;
+
+	for (int i = 0; i < SlotCount && !slot; ++i)
+		if (!slots[i].fence)
+			slot = &slots[i];
+
+	/* Capturing faster than the GPU delivers; fall back
+	 * to waiting on the oldest readback */
+	if (!slot)
+	{
+		slot = oldestSlot();
+		finishSlot(*slot, true);
+	}
+
+	if (slot->pbo == PackBO::ID(0))
+		slot->pbo = PackBO::gen();
+
+	PackBO::bind(slot->pbo);
+
+	if (slot->size < size)
+	{
+		PackBO::allocEmpty(size, GL_STREAM_READ);
+		slot->size = size;
+	}
+
+	/* With a bound pack buffer, the pointer is an offset into it */
+	gl.ReadPixels(0, 0, job.width, job.height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+	PackBO::unbind();
+
+	slot->fence = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->serial = nextSerial++;
+	slot->job = std::move(job);
+}
+
+bool FrameCapture::finishSlot(Slot &slot, bool wait)
+{
+	if (!slot.fence)
+		return false;
+
+	GLenum status;
+
+	if (wait)
+	{
+		do
+			status = gl.ClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+		while (status == GL_TIMEOUT_EXPIRED);
+	}
+	else
+	{
+		status = gl.ClientWaitSync(slot.fence, 0, 0);
+
+		if (status == GL_TIMEOUT_EXPIRED)
+			return false;
+	}
+
+	gl.DeleteSync(slot.fence);
+	slot.fence = 0;
+
+	Job &job = slot.job;
+
+	if (status == GL_WAIT_FAILED)
+	{
+		Debug() << "Frame capture: waiting for readback of" << job.path << "failed";
+		return true;
+	}
+
+	const size_t size = job.width * job.height * 4;
+
+	PackBO::bind(slot.pbo);
+
+	void *src = gl.MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+	if (src)
+	{
+		job.pixels.resize(size);
+		memcpy(&job.pixels[0], src, size);
+		gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	PackBO::unbind();
+
+	if (src)
+		submit(job);
+	else
+		Debug() << "Frame capture: mapping readback of" << job.path << "failed";
+
+	return true;
+}
+
+FrameCapture::Slot *FrameCapture::oldestSlot()
+{
+	Slot *oldest = 0;
+
+	for (int i = 0; i < SlotCount; ++i)
+		if (slots[i].fence && (!oldest || slots[i].serial < oldest->serial))
+			oldest = &slots[i];
+
+	return oldest;
+}
+
+void FrameCapture::finishAll()
+{
+	while (Slot *slot = oldestSlot())
+		finishSlot(*slot, true);
+}
+
+void FrameCapture::submit(Job &job)
+{
+	SDL_LockMutex(mutex);
+
+	while (queue.size() >= CAPTURE_MAX_QUEUED)
+		SDL_CondWait(doneCond, mutex);
+
+	queue.push_back(std::move(job));
+	SDL_CondSignal(jobCond);
+
+	SDL_UnlockMutex(mutex);
+}
+
+void FrameCapture::workerLoop()
+{
+	Trace::setThreadName("capture");
+
+	SDL_LockMutex(mutex);
+
+	while (true)
+	{
+		while (queue.empty() && !stopWorker)
+			SDL_CondWait(jobCond, mutex);
+
+		if (queue.empty())
+			break;
+
+		Job job = std::move(queue.front());
+		queue.pop_front();
+		encoding++;
+
+		SDL_UnlockMutex(mutex);
+
+		encode(job);
+
+		SDL_LockMutex(mutex);
+
+		encoding--;
+		SDL_CondBroadcast(doneCond);
+	}
+
+	SDL_UnlockMutex(mutex);
+
+	if (video)
+		fclose(video);
+}
+
+void FrameCapture::encode(Job &job)
+{
+	TRACE_SCOPE("encode", job.path.c_str());
+
+	switch (job.kind)
+	{
+	case Image :
+		writeImage(job);
+		break;
+
+	case VideoFrame :
+		writeVideoFrame(job);
+		break;
+
+	case VideoEnd :
+		if (video && videoPath == job.path)
+		{
+			fclose(video);
+			video = 0;
+		}
+		break;
+	}
+}
+
+void FrameCapture::writeImage(const Job &job)
+{
+	SDL_Surface *surf =
+		SDL_CreateRGBSurfaceWithFormatFrom((void*) &job.pixels[0], job.width, job.height,
+		                                   32, job.width * 4, SDL_PIXELFORMAT_ABGR8888);
+
+	if (!surf)
+	{
+		Debug() << "Frame capture:" << SDL_GetError();
+		return;
+	}
+
+	const std::string ext = extensionOf(job.path);
+	int rc;
+
+	if (ext == "png")
+		rc = IMG_SavePNG(surf, job.path.c_str());
+	else if (ext == "jpg" || ext == "jpeg")
+		rc = IMG_SaveJPG(surf, job.path.c_str(), 90);
+	else
+		rc = SDL_SaveBMP(surf, job.path.c_str());
+
+	if (rc)
+		Debug() << "Frame capture: failed to write" << job.path << ":" << SDL_GetError();
+
+	SDL_FreeSurface(surf);
+}
+
+void FrameCapture::writeVideoFrame(const Job &job)
+{
+	if (video && videoPath != job.path)
+	{
+		fclose(video);
+		video = 0;
+	}
+
+	if (!video)
+	{
+		video = fopen(job.path.c_str(), "wb");
+
+		if (!video)
+		{
+			Debug() << "Frame capture: failed to open" << job.path;
+			return;
+		}
+
+		videoPath = job.path;
+		videoWidth = job.width;
+		videoHeight = job.height;
+
+		fprintf(video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n",
+		        videoWidth, videoHeight, job.fps);
+	}
+
+	/* A stream can't change its dimensions midway */
+	if (job.width != videoWidth || job.height != videoHeight)
+		return;
+
+	const size_t count = job.width * job.height;
+	std::vector<uint8_t> planes(count * 3);
+
+	uint8_t *y = &planes[0];
+	uint8_t *u = y + count;
+	uint8_t *v = u + count;
+
+	const uint8_t *px = &job.pixels[0];
+
+	/* BT.601, limited range */
+	for (size_t i = 0; i < count; ++i, px += 4)
+	{
+		const int r = px[0], g = px[1], b = px[2];
+
+		y[i] = (( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16;
+		u[i] = ((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128;
+		v[i] = ((112 * r -  94 * g -  18 * b + 128) >> 8) + 128;
+	}
+
+	fputs("FRAME\n", video);
+
+	if (fwrite(&planes[0], 1, planes.size(), video) != planes.size())
+		Debug() << "Frame capture: failed to write to" << videoPath;
+}
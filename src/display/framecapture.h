@@ -0,0 +1,139 @@
+/*
+** framecapture.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include "gl-util.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdio.h>
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+/* Reads back rendered frames without stalling the GL pipeline and
+ * encodes them on a worker thread. Where pixel pack buffers and
+ * fence syncs are available, a readback only queues a copy into a
+ * PBO; the pixels are fetched on a later frame once the fence has
+ * signaled. Otherwise the readback is synchronous, but encoding
+ * still happens off the RGSS thread.
+ *
+ * Output format follows the file extension: .png, .jpg/.jpeg, .bmp
+ * for images, .y4m for a YUV4MPEG2 (4:4:4) video stream */
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	/* Queues one image of 'src' to be written to 'path' */
+	void capture(const TEXFBO &src, int width, int height,
+	             const std::string &path);
+
+	/* Continuous capture of every 'interval'th frame. For image
+	 * formats, 'path' may contain a "%d" / "%05d" style counter,
+	 * otherwise one is appended to the file name. 'fps' is only
+	 * written into video stream headers */
+	void startRecording(const std::string &path, int interval, int fps);
+	void stopRecording();
+	bool isRecording() const { return recording; }
+
+	/* Call once per presented frame with the finished screen */
+	void onFrame(const TEXFBO &src, int width, int height);
+
+	/* Hands finished readbacks to the encoder; never blocks */
+	void poll();
+
+	/* Blocks until every queued frame has been written */
+	void flush();
+
+	/* Frames read back or encoded but not yet written */
+	int pending() const;
+
+private:
+	enum { SlotCount = 3 };
+
+	enum Kind
+	{
+		Image,
+		VideoFrame,
+		VideoEnd
+	};
+
+	struct Job
+	{
+		Kind kind;
+		int width, height;
+		int fps;
+		std::string path;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct Slot
+	{
+		PackBO::ID pbo;
+		_GLsync fence;
+		size_t size;
+		uint64_t serial;
+		Job job;
+	};
+
+	void readback(const TEXFBO &src, Job &job);
+	bool finishSlot(Slot &slot, bool wait);
+	Slot *oldestSlot();
+	void finishAll();
+	void submit(Job &job);
+
+	void workerLoop();
+	void encode(Job &job);
+	void writeImage(const Job &job);
+	void writeVideoFrame(const Job &job);
+
+	Slot slots[SlotCount];
+	uint64_t nextSerial;
+	bool async;
+
+	bool recording;
+	std::string recordPath;
+	int recordInterval;
+	int recordFps;
+	int recordTick;
+	int recordIndex;
+
+	/* Shared with the worker */
+	std::deque<Job> queue;
+	int encoding;
+	bool stopWorker;
+	SDL_mutex *mutex;
+	SDL_cond *jobCond;
+	SDL_cond *doneCond;
+	SDL_Thread *worker;
+
+	/* Worker only */
+	FILE *video;
+	std::string videoPath;
+	int videoWidth, videoHeight;
+};
+
+#endif // FRAMECAPTURE_H
@@ -97,6 +97,7 @@ void initGLFunctions()
     
     /* Assume single digit */
     int glMajor = *ver - '0';
+    int glMinor = (ver[1] == '.') ? ver[2] - '0' : 0;
     
     if (glMajor < 2)
 #ifndef GLES2_HEADER
@@ -177,6 +178,68 @@ void initGLFunctions()
         GL_VAO_FUN;
     }
     
+    /* Buffer mapping entrypoints, only useful together
+     * with pixel unpack buffers (GL 2.1 / GLES 3.0) */
+    if (glMajor >= 3 || (!gles && HAVE_EXT(ARB_map_buffer_range)
+                         && HAVE_EXT(ARB_pixel_buffer_object)))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+        GL_MAP_BUFFER_FUN;
+    }
+    
+    /* Buffer storage entrypoints (GL 4.4 / GLES ext) */
+    if (!gles && (glMajor > 4 || (glMajor == 4 && glMinor >= 4)
+                  || HAVE_EXT(ARB_buffer_storage)))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+        GL_BUFFER_STORAGE_FUN;
+    }
+    else if (gles && HAVE_EXT(EXT_buffer_storage))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX "EXT"
+        GL_BUFFER_STORAGE_FUN;
+    }
+    
+    /* Program binary entrypoints (GL 4.1 / GLES 3.0) */
+    if ((gles && glMajor >= 3) || HAVE_EXT(ARB_get_program_binary))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+        GL_PROGRAM_BINARY_FUN;
+    }
+    else if (HAVE_EXT(OES_get_program_binary))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX "OES"
+        GL_PROGRAM_BINARY_FUN;
+    }
+    
+    /* Timer query entrypoints (GL 3.3 / GLES ext) */
+    if (!gles && (glMajor >= 4 || (glMajor == 3 && glMinor >= 3) || HAVE_EXT(ARB_timer_query)))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+        GL_TIMER_QUERY_FUN;
+    }
+    else if (gles && HAVE_EXT(EXT_disjoint_timer_query))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX "EXT"
+        GL_TIMER_QUERY_FUN;
+    }
+    
+    /* Sync object entrypoints (GL 3.2 / GLES 3.0) */
+    if ((gles && glMajor >= 3) || glMajor >= 4 || (glMajor == 3 && glMinor >= 2)
+        || HAVE_EXT(ARB_sync))
+    {
+#undef EXT_SUFFIX
+#define EXT_SUFFIX ""
+        GL_SYNC_FUN;
+    }
+    
     /* Debug callback entrypoints */
     if (HAVE_EXT(KHR_debug))
     {
@@ -204,4 +267,26 @@ void initGLFunctions()
     
     if (!gles || glMajor >= 3 || HAVE_EXT(OES_texture_npot))
         gl.npot_repeat = true;
+    
+    if (gl.MapBufferRange && gl.UnmapBuffer)
+        gl.pixel_buffer = true;
+    
+    if (gl.GenQueries && gl.GetQueryObjectui64v)
+        gl.timer_query = true;
+    
+    if (gl.FenceSync && gl.ClientWaitSync && gl.DeleteSync)
+        gl.fence_sync = true;
+    
+    /* Persistent mappings are only safe to write with fences */
+    if (gl.BufferStorage && gl.pixel_buffer && gl.fence_sync)
+        gl.buffer_storage = true;
+    
+    /* Drivers may expose the entrypoints without
+     * supporting a single binary format */
+    if (gl.GetProgramBinary && gl.ProgramBinary)
+    {
+        GLint formats = 0;
+        gl.GetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        gl.program_binary = formats > 0;
+    }
 }
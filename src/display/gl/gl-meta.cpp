@@ -27,9 +27,16 @@
 #include "config.h"
 #include "etc.h"
 
+namespace TEX
+{
+	GLuint boundUnits[MaxUnits];
+	unsigned activeUnit;
+}
+
 namespace FBO
 {
 	ID boundFramebufferID;
+	ID boundReadFramebufferID;
 }
 
 namespace GLMeta
@@ -74,29 +81,55 @@ void subRectImageEnd()
 
 #define HAVE_NATIVE_VAO gl.GenVertexArrays
 
-static void vaoBindRes(VAO &vao)
+/* Shadow of the native VAO binding. Unbinding is deferred until
+ * another VAO is needed, so consecutive draws from the same VAO
+ * (the common case for Quad/QuadArray) don't touch the driver */
+static GLuint boundVAO = 0;
+
+/* 'ibo' is the element buffer recorded in 'vao' */
+static void nativeVAOBind(GLuint vao, GLuint ibo)
 {
-	VBO::bind(vao.vbo);
-	IBO::bind(vao.ibo);
+	if (!GLShadowStats::check(boundVAO != vao))
+		return;
+
+	boundVAO = vao;
+	gl.BindVertexArray(vao);
+
+	/* The element buffer binding is part of the VAO */
+	IBO::setBound(ibo);
+}
 
+static void vaoSetPointers(VAO &vao, bool enable)
+{
 	for (size_t i = 0; i < vao.attrCount; ++i)
 	{
 		const VertexAttribute &va = vao.attr[i];
+		const char *offset = (const char*) va.offset + vao.base;
+
+		if (enable)
+			gl.EnableVertexAttribArray(va.index);
 
-		gl.EnableVertexAttribArray(va.index);
-		gl.VertexAttribPointer(va.index, va.size, va.type, GL_FALSE, vao.vertSize, va.offset);
+		gl.VertexAttribPointer(va.index, va.size, va.type, GL_FALSE, vao.vertSize, offset);
 	}
 }
 
+static void vaoBindRes(VAO &vao)
+{
+	VBO::bind(vao.vbo);
+	IBO::bind(vao.ibo);
+
+	vaoSetPointers(vao, true);
+}
+
 void vaoInit(VAO &vao, bool keepBound)
 {
 	if (HAVE_NATIVE_VAO)
 	{
 		gl.GenVertexArrays(1, &vao.nativeVAO);
-		gl.BindVertexArray(vao.nativeVAO);
+		nativeVAOBind(vao.nativeVAO, 0);
 		vaoBindRes(vao);
 		if (!keepBound)
-			gl.BindVertexArray(0);
+			vaoReset();
 	}
 	else
 	{
@@ -111,13 +144,22 @@ void vaoInit(VAO &vao, bool keepBound)
 void vaoFini(VAO &vao)
 {
 	if (HAVE_NATIVE_VAO)
+	{
+		/* Deleting the bound VAO reverts to 0 */
+		if (boundVAO == vao.nativeVAO)
+		{
+			boundVAO = 0;
+			IBO::setBound(GL_BINDING_UNKNOWN);
+		}
+
 		gl.DeleteVertexArrays(1, &vao.nativeVAO);
+	}
 }
 
 void vaoBind(VAO &vao)
 {
 	if (HAVE_NATIVE_VAO)
-		gl.BindVertexArray(vao.nativeVAO);
+		nativeVAOBind(vao.nativeVAO, vao.ibo.gl);
 	else
 		vaoBindRes(vao);
 }
@@ -126,7 +168,8 @@ void vaoUnbind(VAO &vao)
 {
 	if (HAVE_NATIVE_VAO)
 	{
-		gl.BindVertexArray(0);
+		/* Left bound until the next vaoBind()/vaoReset() */
+		GLShadowStats::skipped++;
 	}
 	else
 	{
@@ -138,6 +181,28 @@ void vaoUnbind(VAO &vao)
 	}
 }
 
+void vaoRebase(VAO &vao, GLintptr base)
+{
+	vao.base = base;
+
+	if (HAVE_NATIVE_VAO)
+	{
+		nativeVAOBind(vao.nativeVAO, vao.ibo.gl);
+		VBO::bind(vao.vbo);
+		vaoSetPointers(vao, false);
+	}
+	else
+	{
+		vaoBindRes(vao);
+	}
+}
+
+void vaoReset()
+{
+	if (HAVE_NATIVE_VAO)
+		nativeVAOBind(0, GL_BINDING_UNKNOWN);
+}
+
 #define HAVE_NATIVE_BLIT (gl.BlitFramebuffer && shState->config().smoothScaling <= Bilinear && shState->config().smoothScalingDown <= Bilinear)
 
 int blitScaleIsSpecial(TEXFBO &target, bool targetPreferHires, const IntRect &targetRect, TEXFBO &source, const IntRect &sourceRect)
@@ -196,8 +261,7 @@ static void _blitBegin(FBO::ID fbo, const Vec2i &size, int scaleIsSpecial)
 {
 	if (HAVE_NATIVE_BLIT)
 	{
-		FBO::boundFramebufferID = fbo;
-		gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo.gl);
+		FBO::bindDraw(fbo);
 	}
 	else
 	{
@@ -304,7 +368,7 @@ void blitSource(TEXFBO &source, int scaleIsSpecial)
 
 	if (HAVE_NATIVE_BLIT)
 	{
-		gl.BindFramebuffer(GL_READ_FRAMEBUFFER, source.fbo.gl);
+		FBO::bindRead(source.fbo);
 	}
 	else
 	{
@@ -332,6 +396,7 @@ void blitSource(TEXFBO &source, int scaleIsSpecial)
 			XbrzShader &shader = shState->shaders().xbrz;
 			shader.bind();
 			shader.setTexSize(Vec2i(blitSrcWidthHires, blitSrcHeightHires));
+			shader.setTargetScale(Vec2((float)(shState->config().xbrzScalingFactor), (float)(shState->config().xbrzScalingFactor)));
 		}
 
 			break;
@@ -381,13 +446,6 @@ void blitRectangle(const IntRect &src, const IntRect &dst, bool smooth)
 	}
 	else
 	{
-#ifdef MKXPZ_SSL
-		if (shState->config().smoothScaling == xBRZ)
-		{
-			XbrzShader &shader = shState->shaders().xbrz;
-			shader.setTargetScale(Vec2((float)(shState->config().xbrzScalingFactor), (float)(shState->config().xbrzScalingFactor)));
-		}
-#endif
 		if (smooth)
 			TEX::setSmooth(true);
 
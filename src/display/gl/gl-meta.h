@@ -47,6 +47,10 @@ struct VAO
 	VBO::ID vbo;
 	IBO::ID ibo;
 
+	/* Byte offset of the first vertex in 'vbo',
+	 * change through vaoRebase() */
+	GLintptr base;
+
 	/* Don't touch */
 	GLuint nativeVAO;
 };
@@ -57,6 +61,7 @@ inline void vaoFillInVertexData(VAO &vao)
 	vao.attr      = VertexTraits<VertexType>::attr;
 	vao.attrCount = VertexTraits<VertexType>::attrCount;
 	vao.vertSize  = sizeof(VertexType);
+	vao.base      = 0;
 }
 
 void vaoInit(VAO &vao, bool keepBound = false);
@@ -64,6 +69,14 @@ void vaoFini(VAO &vao);
 void vaoBind(VAO &vao);
 void vaoUnbind(VAO &vao);
 
+/* Binds 'vao' with its attributes pointing 'base' bytes into
+ * its vertex buffer (for buffers shared between many draws) */
+void vaoRebase(VAO &vao, GLintptr base);
+
+/* Actually unbinds any VAO left bound by vaoUnbind(); required
+ * before touching GL_ELEMENT_ARRAY_BUFFER outside of a VAO */
+void vaoReset();
+
 /* EXT_framebuffer_blit */
 int blitScaleIsSpecial(TEXFBO &target, bool targetPreferHires, const IntRect &targetRect, TEXFBO &source, const IntRect &sourceRect);
 int smoothScalingMethod(int scaleIsSpecial);
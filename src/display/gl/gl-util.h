@@ -23,6 +23,7 @@
 #define GLUTIL_H
 
 #include "gl-fun.h"
+#include "glstate.h"
 #include "etc-internal.h"
 #include "sharedstate.h"
 #include "config.h"
@@ -55,6 +56,12 @@ namespace TEX
 {
 	DEF_GL_ID
 
+	/* Shadow of the active unit and of the GL_TEXTURE_2D
+	 * binding of each unit that shaders sample from */
+	enum { MaxUnits = 4 };
+	extern GLuint boundUnits[MaxUnits];
+	extern unsigned activeUnit;
+
 	inline ID gen()
 	{
 		ID id;
@@ -65,14 +72,48 @@ namespace TEX
 
 	static inline void del(ID id)
 	{
+		/* Deleting a bound texture reverts its units to 0 */
+		for (size_t i = 0; i < MaxUnits; ++i)
+			if (boundUnits[i] == id.gl)
+				boundUnits[i] = 0;
+
 		gl.DeleteTextures(1, &id.gl);
 	}
 
+	static inline void setActiveUnit(unsigned unit)
+	{
+		if (!GLShadowStats::check(activeUnit == unit))
+			return;
+
+		activeUnit = unit;
+		gl.ActiveTexture(GL_TEXTURE0 + unit);
+	}
+
 	static inline void bind(ID id)
 	{
+		if (!GLShadowStats::check(boundUnits[activeUnit] != id.gl))
+			return;
+
+		boundUnits[activeUnit] = id.gl;
 		gl.BindTexture(GL_TEXTURE_2D, id.gl);
 	}
 
+	/* Binds 'id' to another unit, leaving unit 0 active */
+	static inline void bindUnit(unsigned unit, ID id)
+	{
+		assert(unit < MaxUnits);
+
+		if (boundUnits[unit] == id.gl)
+		{
+			GLShadowStats::skipped++;
+			return;
+		}
+
+		setActiveUnit(unit);
+		bind(id);
+		setActiveUnit(0);
+	}
+
 	static inline void unbind()
 	{
 		bind(ID(0));
@@ -117,7 +158,9 @@ namespace FBO
 {
 	DEF_GL_ID
 
+	/* Shadow of the draw / read framebuffer bindings */
 	extern ID boundFramebufferID;
+	extern ID boundReadFramebufferID;
 
 	inline ID gen()
 	{
@@ -129,15 +172,43 @@ namespace FBO
 
 	static inline void del(ID id)
 	{
+		if (boundFramebufferID == id)
+			boundFramebufferID = ID(0);
+		if (boundReadFramebufferID == id)
+			boundReadFramebufferID = ID(0);
+
 		gl.DeleteFramebuffers(1, &id.gl);
 	}
 
 	static inline void bind(ID id)
 	{
+		if (!GLShadowStats::check(boundFramebufferID != id || boundReadFramebufferID != id))
+			return;
+
 		boundFramebufferID = id;
+		boundReadFramebufferID = id;
 		gl.BindFramebuffer(GL_FRAMEBUFFER, id.gl);
 	}
 
+	/* Separate targets, only with GL_FBO_BLIT_FUN */
+	static inline void bindDraw(ID id)
+	{
+		if (!GLShadowStats::check(boundFramebufferID != id))
+			return;
+
+		boundFramebufferID = id;
+		gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, id.gl);
+	}
+
+	static inline void bindRead(ID id)
+	{
+		if (!GLShadowStats::check(boundReadFramebufferID != id))
+			return;
+
+		boundReadFramebufferID = id;
+		gl.BindFramebuffer(GL_READ_FRAMEBUFFER, id.gl);
+	}
+
 	static inline void unbind()
 	{
 		bind(ID(0));
@@ -154,11 +225,17 @@ namespace FBO
 	}
 }
 
+/* Marks a binding whose driver state is not known */
+#define GL_BINDING_UNKNOWN ((GLuint) -1)
+
 template<GLenum target>
 struct GenericBO
 {
 	DEF_GL_ID
 
+	/* Shadow of the binding of 'target' */
+	static GLuint bound;
+
 	static inline ID gen()
 	{
 		ID id;
@@ -169,14 +246,28 @@ struct GenericBO
 
 	static inline void del(ID id)
 	{
+		if (bound == id.gl)
+			bound = 0;
+
 		gl.DeleteBuffers(1, &id.gl);
 	}
 
 	static inline void bind(ID id)
 	{
+		if (!GLShadowStats::check(bound != id.gl))
+			return;
+
+		bound = id.gl;
 		gl.BindBuffer(target, id.gl);
 	}
 
+	/* The driver changed the binding behind our back
+	 * (eg. GL_ELEMENT_ARRAY_BUFFER is vertex array state) */
+	static inline void setBound(GLuint id)
+	{
+		bound = id;
+	}
+
 	static inline void unbind()
 	{
 		bind(ID(0));
@@ -198,12 +289,21 @@ struct GenericBO
 	}
 };
 
+template<GLenum target>
+GLuint GenericBO<target>::bound = 0;
+
 /* Vertex Buffer Object */
 typedef struct GenericBO<GL_ARRAY_BUFFER> VBO;
 
 /* Index Buffer Object */
 typedef struct GenericBO<GL_ELEMENT_ARRAY_BUFFER> IBO;
 
+/* Pixel Unpack Buffer Object (only if gl.pixel_buffer) */
+typedef struct GenericBO<GL_PIXEL_UNPACK_BUFFER> PBO;
+
+/* Pixel Pack Buffer Object (only if gl.pixel_buffer) */
+typedef struct GenericBO<GL_PIXEL_PACK_BUFFER> PackBO;
+
 #undef DEF_GL_ID
 
 /* Convenience struct wrapping a framebuffer
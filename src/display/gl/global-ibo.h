@@ -23,6 +23,7 @@
 #define GLOBALIBO_H
 
 #include "gl-util.h"
+#include "gl-meta.h"
 
 #include <vector>
 #include <limits>
@@ -66,6 +67,9 @@ struct GlobalIBO
 				buffer.push_back(i * 4 + indTemp[j]);
 		}
 
+		/* Don't clobber the element buffer of a bound VAO */
+		GLMeta::vaoReset();
+
 		IBO::bind(ibo);
 		IBO::uploadData(buffer.size() * sizeof(index_t), dataPtr(buffer));
 		IBO::unbind();
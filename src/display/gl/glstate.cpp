@@ -29,6 +29,17 @@
 
 #include <SDL_rect.h>
 
+unsigned GLShadowStats::issued = 0;
+unsigned GLShadowStats::skipped = 0;
+unsigned GLShadowStats::frameIssued = 0;
+unsigned GLShadowStats::frameSkipped = 0;
+
+void GLShadowStats::endFrame() {
+  frameIssued = issued;
+  frameSkipped = skipped;
+  issued = skipped = 0;
+}
+
 static void applyBool(GLenum state, bool mode) {
   mode ? gl.Enable(state) : gl.Disable(state);
 }
@@ -29,6 +29,32 @@
 
 struct Config;
 
+/* Bookkeeping of the shadow state (GLState, gl-util.h bindings and
+ * shader uniforms): driver calls actually issued vs. the ones dropped
+ * because the value was already current */
+struct GLShadowStats
+{
+	static unsigned issued;
+	static unsigned skipped;
+
+	/* Totals of the last finished frame */
+	static unsigned frameIssued;
+	static unsigned frameSkipped;
+
+	/* Counts one call; returns whether it has to reach the driver */
+	static inline bool check(bool changed)
+	{
+		if (changed)
+			issued++;
+		else
+			skipped++;
+
+		return changed;
+	}
+
+	static void endFrame();
+};
+
 template<typename T>
 struct GLProperty
 {
@@ -48,7 +74,7 @@ struct GLProperty
 	const T &get()    { return current; }
 	void set(const T &value)
 	{
-		if (value == current)
+		if (!GLShadowStats::check(!(value == current)))
 			return;
 
 		init(value);
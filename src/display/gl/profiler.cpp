@@ -0,0 +1,320 @@
+/*
+** profiler.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "profiler.h"
+
+#include <SDL_timer.h>
+
+#include <string.h>
+
+/* Frames averaged into one published report */
+#define PROFILER_WINDOW 30
+
+static const char *sectionNames[] =
+{
+	"other",
+	"sprite",
+	"plane",
+	"tilemap",
+	"tilemap_vx",
+	"window",
+	"window_vx",
+	"viewport",
+	"bitmap_blt",
+	"bitmap_stretch_blt",
+	"bitmap_blur",
+	"bitmap_hue_change",
+	"bitmap_color_matrix",
+	"bitmap_draw_text",
+	"screen",
+	"present",
+	"script"
+};
+
+static_assert(sizeof(sectionNames) / sizeof(sectionNames[0]) == Profiler::SectionCount,
+              "Profiler section names out of sync");
+
+static bool hasGpuTime(int section)
+{
+	return section != Profiler::Present && section != Profiler::Script;
+}
+
+Profiler::Profiler()
+    : enabled(false),
+      intervalStart(0),
+      frameStart(0),
+      cpuFrames(0),
+      gpuFrames(0),
+      avgFrameMs(0),
+      publishCount(0)
+{
+	memset(cpuTicks, 0, sizeof(cpuTicks));
+	memset(gpuNs, 0, sizeof(gpuNs));
+	memset(calls, 0, sizeof(calls));
+}
+
+Profiler::~Profiler()
+{
+	releaseQueries();
+}
+
+void Profiler::setEnabled(bool value)
+{
+	if (enabled == value)
+		return;
+
+	if (!value)
+	{
+		if (!stack.empty())
+			stopInterval();
+
+		stack.clear();
+		releaseQueries();
+	}
+
+	enabled = value;
+
+	memset(cpuTicks, 0, sizeof(cpuTicks));
+	memset(gpuNs, 0, sizeof(gpuNs));
+	memset(calls, 0, sizeof(calls));
+	cpuFrames = gpuFrames = 0;
+
+	frameStart = SDL_GetPerformanceCounter();
+}
+
+bool Profiler::hasGpuTimer() const
+{
+	return gl.timer_query;
+}
+
+static bool isBitmapOp(int section)
+{
+	return section >= Profiler::BitmapBlt && section <= Profiler::BitmapDrawText;
+}
+
+bool Profiler::begin(Section section)
+{
+	if (!stack.empty())
+	{
+		/* Bitmap ops built on top of other ops (blt on stretchBlt,
+		 * the hires counterpart etc.) are charged to the outermost
+		 * one, otherwise it would always show up as free */
+		if (isBitmapOp(stack.back()) && isBitmapOp(section))
+			return false;
+
+		stopInterval();
+	}
+
+	stack.push_back(section);
+	calls[section]++;
+
+	startInterval();
+
+	return true;
+}
+
+void Profiler::end()
+{
+	/* The profiler might have been switched
+	 * off and on again inside of a scope */
+	if (stack.empty())
+		return;
+
+	stopInterval();
+	stack.pop_back();
+
+	if (!stack.empty())
+		startInterval();
+}
+
+void Profiler::startInterval()
+{
+	intervalStart = SDL_GetPerformanceCounter();
+
+	if (!gl.timer_query || !hasGpuTime(stack.back()))
+		return;
+
+	Query query;
+	query.section = stack.back();
+
+	if (freeQueries.empty())
+	{
+		gl.GenQueries(1, &query.id);
+	}
+	else
+	{
+		query.id = freeQueries.back();
+		freeQueries.pop_back();
+	}
+
+	gl.BeginQuery(GL_TIME_ELAPSED, query.id);
+	current.push_back(query);
+}
+
+void Profiler::stopInterval()
+{
+	cpuTicks[stack.back()] += SDL_GetPerformanceCounter() - intervalStart;
+
+	if (gl.timer_query && hasGpuTime(stack.back()))
+		gl.EndQuery(GL_TIME_ELAPSED);
+}
+
+bool Profiler::isAvailable(const Frame &frame) const
+{
+	for (size_t i = frame.queries.size(); i-- > 0;)
+	{
+		GLuint available = 0;
+		gl.GetQueryObjectuiv(frame.queries[i].id, GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available)
+			return false;
+	}
+
+	return true;
+}
+
+void Profiler::collect()
+{
+	if (inFlight.empty())
+		return;
+
+	/* Reading the flag also clears it. A disjoint
+	 * operation invalidates every query in flight */
+	GLint disjoint = 0;
+	if (gl.glsles)
+		gl.GetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+	if (disjoint)
+		for (size_t i = 0; i < inFlight.size(); ++i)
+			inFlight[i].disjoint = true;
+
+	/* Frames finish in order. Stop at the first one the GPU
+	 * is still working on and look again next frame, rather
+	 * than waiting for it with GL_QUERY_RESULT */
+	while (!inFlight.empty() && isAvailable(inFlight.front()))
+	{
+		Frame &frame = inFlight.front();
+
+		for (size_t i = 0; i < frame.queries.size(); ++i)
+		{
+			uint64_t ns = 0;
+			gl.GetQueryObjectui64v(frame.queries[i].id, GL_QUERY_RESULT, &ns);
+
+			if (!frame.disjoint)
+				gpuNs[frame.queries[i].section] += ns;
+
+			freeQueries.push_back(frame.queries[i].id);
+		}
+
+		if (!frame.disjoint)
+			gpuFrames++;
+
+		inFlight.pop_front();
+	}
+}
+
+void Profiler::releaseQueries()
+{
+	for (size_t i = 0; i < inFlight.size(); ++i)
+		for (size_t j = 0; j < inFlight[i].queries.size(); ++j)
+			freeQueries.push_back(inFlight[i].queries[j].id);
+
+	for (size_t i = 0; i < current.size(); ++i)
+		freeQueries.push_back(current[i].id);
+
+	inFlight.clear();
+	current.clear();
+
+	if (!freeQueries.empty())
+		gl.DeleteQueries(freeQueries.size(), &freeQueries[0]);
+
+	freeQueries.clear();
+}
+
+void Profiler::endFrame()
+{
+	if (!enabled)
+		return;
+
+	uint64_t now = SDL_GetPerformanceCounter();
+	uint64_t frameTicks = now - frameStart;
+	frameStart = now;
+
+	/* Whatever wasn't claimed by a section belongs to the script */
+	uint64_t claimed = 0;
+	for (int i = 0; i < SectionCount; ++i)
+		if (i != Script)
+			claimed += cpuTicks[i];
+
+	if (frameTicks > claimed)
+		cpuTicks[Script] += frameTicks - claimed;
+
+	calls[Script]++;
+
+	if (!current.empty())
+	{
+		inFlight.push_back(Frame());
+		inFlight.back().queries.swap(current);
+		inFlight.back().disjoint = false;
+	}
+
+	collect();
+
+	if (++cpuFrames < PROFILER_WINDOW)
+		return;
+
+	const double msPerTick = 1000.0 / SDL_GetPerformanceFrequency();
+	double frameSum = 0;
+
+	for (int i = 0; i < SectionCount; ++i)
+	{
+		Stats &s = published[i];
+		s.cpuMs = cpuTicks[i] * msPerTick / cpuFrames;
+		s.calls = (double) calls[i] / cpuFrames;
+
+		if (gpuFrames > 0)
+			s.gpuMs = gpuNs[i] / 1000000.0 / gpuFrames;
+
+		frameSum += s.cpuMs;
+	}
+
+	avgFrameMs = frameSum;
+
+	memset(cpuTicks, 0, sizeof(cpuTicks));
+	memset(calls, 0, sizeof(calls));
+	cpuFrames = 0;
+
+	if (gpuFrames > 0)
+	{
+		memset(gpuNs, 0, sizeof(gpuNs));
+		gpuFrames = 0;
+	}
+
+	publishCount++;
+}
+
+const Profiler::Stats &Profiler::stats(int section) const
+{
+	return published[section];
+}
+
+const char *Profiler::sectionName(int section)
+{
+	return sectionNames[section];
+}
@@ -0,0 +1,175 @@
+/*
+** profiler.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "gl-fun.h"
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+/* Opt-in frame profiler. Sections nest; time is always attributed
+ * to the innermost open section only (a Viewport's figure excludes
+ * the sprites inside it). GPU time comes from GL_TIME_ELAPSED queries
+ * that are polled and only read back once the GPU has finished them,
+ * so GPU figures lag behind the CPU ones by a few frames */
+class Profiler
+{
+public:
+	enum Section
+	{
+		Other = 0,
+
+		/* Scene elements */
+		Sprite,
+		Plane,
+		Tilemap,
+		TilemapVX,
+		Window,
+		WindowVX,
+		Viewport,
+
+		/* Bitmap operations */
+		BitmapBlt,
+		BitmapStretchBlt,
+		BitmapBlur,
+		BitmapHueChange,
+		BitmapColorMatrix,
+		BitmapDrawText,
+
+		/* Screen effects, scaling and the final blit */
+		Screen,
+
+		/* Buffer swap and frame limiter wait (CPU only) */
+		Present,
+
+		/* Everything not covered above, ie. mostly
+		 * Ruby code between Graphics.update calls */
+		Script,
+
+		SectionCount
+	};
+
+	struct Stats
+	{
+		/* Per frame averages */
+		double cpuMs;
+		double gpuMs;
+		double calls;
+
+		Stats() : cpuMs(0), gpuMs(0), calls(0) {}
+	};
+
+	struct Scope
+	{
+		Scope(Profiler &profiler, Section section)
+		    : profiler(profiler),
+		      active(profiler.isEnabled() && profiler.begin(section))
+		{}
+
+		~Scope()
+		{
+			close();
+		}
+
+		/* Ends the section before the scope does */
+		void close()
+		{
+			if (active)
+				profiler.end();
+
+			active = false;
+		}
+
+	private:
+		Profiler &profiler;
+		bool active;
+	};
+
+	Profiler();
+	~Profiler();
+
+	void setEnabled(bool value);
+	bool isEnabled() const { return enabled; }
+
+	/* Whether GPU times are available at all */
+	bool hasGpuTimer() const;
+
+	/* Returns false if the section was folded into the
+	 * enclosing one, in which case end() must not be called */
+	bool begin(Section section);
+	void end();
+
+	/* Called once per Graphics.update, closes the frame that
+	 * started with the previous call */
+	void endFrame();
+
+	/* Averages over the last completed window of frames */
+	const Stats &stats(int section) const;
+	double frameMs() const { return avgFrameMs; }
+
+	/* Increments every time new averages are published */
+	unsigned generation() const { return publishCount; }
+
+	static const char *sectionName(int section);
+
+private:
+	struct Query
+	{
+		GLuint id;
+		uint8_t section;
+	};
+
+	/* The queries issued during one frame */
+	struct Frame
+	{
+		std::vector<Query> queries;
+		bool disjoint;
+	};
+
+	void startInterval();
+	void stopInterval();
+
+	bool isAvailable(const Frame &frame) const;
+	void collect();
+	void releaseQueries();
+
+	bool enabled;
+
+	std::vector<uint8_t> stack;
+	uint64_t intervalStart;
+	uint64_t frameStart;
+
+	uint64_t cpuTicks[SectionCount];
+	uint64_t gpuNs[SectionCount];
+	unsigned calls[SectionCount];
+	unsigned cpuFrames, gpuFrames;
+
+	std::vector<Query> current;
+	std::deque<Frame> inFlight;
+	std::vector<GLuint> freeQueries;
+
+	Stats published[SectionCount];
+	double avgFrameMs;
+	unsigned publishCount;
+};
+
+#endif // PROFILER_H
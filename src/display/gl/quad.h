@@ -28,14 +28,13 @@
 #include "gl-util.h"
 #include "gl-meta.h"
 #include "sharedstate.h"
-#include "global-ibo.h"
+#include "streambuffer.h"
 #include "shader.h"
 
 struct Quad
 {
 	Vertex vert[4];
-	VBO::ID vbo;
-	GLMeta::VAO vao;
+	StreamRange range;
 	bool vboDirty;
 
 	template<typename V>
@@ -75,33 +74,11 @@ struct Quad
 	}
 
 	Quad()
-	    : vbo(VBO::gen()),
-	      vboDirty(true)
+	    : vboDirty(true)
 	{
-		GLMeta::vaoFillInVertexData<Vertex>(vao);
-		vao.vbo = vbo;
-		vao.ibo = shState->globalIBO().ibo;
-
-		GLMeta::vaoInit(vao, true);
-		VBO::allocEmpty(sizeof(Vertex[4]), GL_DYNAMIC_DRAW);
-		GLMeta::vaoUnbind(vao);
-
 		setColor(Vec4(1, 1, 1, 1));
 	}
 
-	~Quad()
-	{
-		GLMeta::vaoFini(vao);
-		VBO::del(vbo);
-	}
-
-	void updateBuffer()
-	{
-		VBO::bind(vbo);
-		VBO::uploadSubData(0, sizeof(Vertex[4]), vert);
-		VBO::unbind();
-	}
-
 	void setPosRect(const FloatRect &r)
 	{
 		setPosRect(vert, r);
@@ -130,15 +107,17 @@ struct Quad
 
 	void draw()
 	{
-		if (vboDirty)
+		StreamBuffer &stream = shState->streamBuffer();
+
+		/* Unchanged quads keep drawing from their old
+		 * range until the stream wraps over it */
+		if (vboDirty || !stream.isValid(range))
 		{
-			updateBuffer();
+			range = stream.upload(vert, 1);
 			vboDirty = false;
 		}
 
-		GLMeta::vaoBind(vao);
-		gl.DrawElements(GL_TRIANGLES, 6, _GL_INDEX_TYPE, 0);
-		GLMeta::vaoUnbind(vao);
+		stream.draw<Vertex>(range, 0, 1);
 	}
 };
 
@@ -26,41 +26,25 @@
 #include "gl-util.h"
 #include "gl-meta.h"
 #include "sharedstate.h"
-#include "global-ibo.h"
+#include "streambuffer.h"
 #include "shader.h"
 
 #include <vector>
-#include <stdint.h>
 
 template<class VertexType>
 struct QuadArray
 {
 	std::vector<VertexType> vertices;
 
-	VBO::ID vbo;
-	GLMeta::VAO vao;
+	StreamRange range;
+	bool dirty;
 
 	size_t quadCount;
-	GLsizeiptr vboSize;
 
 	QuadArray()
-	    : quadCount(0),
-	      vboSize(-1)
-	{
-		vbo = VBO::gen();
-
-		GLMeta::vaoFillInVertexData<VertexType>(vao);
-		vao.vbo = vbo;
-		vao.ibo = shState->globalIBO().ibo;
-
-		GLMeta::vaoInit(vao);
-	}
-
-	~QuadArray()
-	{
-		GLMeta::vaoFini(vao);
-		VBO::del(vbo);
-	}
+	    : dirty(true),
+	      quadCount(0)
+	{}
 
 	void resize(size_t size)
 	{
@@ -75,39 +59,27 @@ struct QuadArray
 	}
 
 	/* This needs to be called after the final 'append()' call
-	 * and previous to the first 'draw()' call. */
+	 * and previous to the first 'draw()' call. The vertices are
+	 * streamed lazily on the next draw */
 	void commit()
 	{
-		VBO::bind(vbo);
-
-		GLsizeiptr size = vertices.size() * sizeof(VertexType);
-
-		if (size > vboSize)
-		{
-			/* New data exceeds already allocated size.
-			 * Reallocate VBO. */
-			VBO::uploadData(size, dataPtr(vertices), GL_DYNAMIC_DRAW);
-			vboSize = size;
-
-			shState->ensureQuadIBO(quadCount);
-		}
-		else
-		{
-			/* New data fits in allocated size */
-			VBO::uploadSubData(0, size, dataPtr(vertices));
-		}
-
-		VBO::unbind();
+		dirty = true;
 	}
 
 	void draw(size_t offset, size_t count)
 	{
-		GLMeta::vaoBind(vao);
+		if (quadCount == 0)
+			return;
+
+		StreamBuffer &stream = shState->streamBuffer();
 
-		const char *_offset = (const char*) 0 + offset * 6 * sizeof(index_t);
-		gl.DrawElements(GL_TRIANGLES, count * 6, _GL_INDEX_TYPE, _offset);
+		if (dirty || !stream.isValid(range))
+		{
+			range = stream.upload(dataPtr(vertices), quadCount);
+			dirty = false;
+		}
 
-		GLMeta::vaoUnbind(vao);
+		stream.draw<VertexType>(range, offset, count);
 	}
 
 	void draw()
@@ -22,11 +22,25 @@
 #include "scene.h"
 #include "sharedstate.h"
 
+#include <algorithm>
+#include <vector>
+
+/* Nesting depth of SceneReorderBatch, and the scenes
+ * waiting to be sorted once it drops back to zero */
+static int reorderBatchDepth = 0;
+static std::vector<Scene*> reorderPendingScenes;
+
 Scene::Scene()
+    : reorderPending(false)
 {}
 
 Scene::~Scene()
 {
+	if (reorderPending)
+		reorderPendingScenes.erase(std::remove(reorderPendingScenes.begin(),
+		                                       reorderPendingScenes.end(), this),
+		                           reorderPendingScenes.end());
+
 	/* Ensure elements don't unlink from a destructed Scene */
 	IntruListLink<SceneElement> *iter;
 
@@ -74,10 +88,42 @@ void Scene::insertAfter(SceneElement &element, SceneElement &after)
 
 void Scene::reinsert(SceneElement &element)
 {
+	if (reorderBatchDepth > 0)
+	{
+		if (!reorderPending)
+		{
+			reorderPending = true;
+			reorderPendingScenes.push_back(this);
+		}
+
+		return;
+	}
+
 	elements.remove(element.link);
 	insert(element);
 }
 
+void Scene::sortElements()
+{
+	std::vector<SceneElement*> sorted;
+	sorted.reserve(elements.getSize());
+
+	IntruListLink<SceneElement> *iter;
+
+	for (iter = elements.begin(); iter != elements.end(); iter = iter->next)
+		sorted.push_back(iter->data);
+
+	/* Creation stamps are unique, so the order is total */
+	std::sort(sorted.begin(), sorted.end(),
+	          [](const SceneElement *a, const SceneElement *b) { return *a < *b; });
+
+	for (size_t i = 0; i < sorted.size(); ++i)
+		elements.remove(sorted[i]->link);
+
+	for (size_t i = 0; i < sorted.size(); ++i)
+		elements.append(sorted[i]->link);
+}
+
 void Scene::notifyGeometryChange()
 {
 	IntruListLink<SceneElement> *iter;
@@ -88,16 +134,41 @@ void Scene::notifyGeometryChange()
 	}
 }
 
+bool Scene::addElementSignatures(CacheSignature &sig) const
+{
+	const IntruListLink<SceneElement> *iter;
+
+	for (iter = elements.begin(); iter != elements.end(); iter = iter->next)
+	{
+		const SceneElement *e = iter->data;
+
+		if (!e->visible)
+			continue;
+
+		/* Not the address, which a new element may reuse */
+		sig.add(e->creationStamp);
+
+		if (!e->addCacheSignature(sig))
+			return false;
+	}
+
+	return true;
+}
+
 void Scene::composite()
 {
 	IntruListLink<SceneElement> *iter;
+	Profiler &profiler = shState->profiler();
 
 	for (iter = elements.begin(); iter != elements.end(); iter = iter->next)
 	{
 		SceneElement *e = iter->data;
 
-		if (e->visible)
-			e->draw();
+		if (!e->visible)
+			continue;
+
+		Profiler::Scope scope(profiler, e->profileSection());
+		e->draw();
 	}
 }
 
@@ -195,6 +266,27 @@ void SceneElement::setSpriteY(int value)
 	scene->reinsert(*this);
 }
 
+SceneReorderBatch::SceneReorderBatch()
+{
+	++reorderBatchDepth;
+}
+
+SceneReorderBatch::~SceneReorderBatch()
+{
+	if (--reorderBatchDepth > 0)
+		return;
+
+	for (size_t i = 0; i < reorderPendingScenes.size(); ++i)
+	{
+		Scene *scene = reorderPendingScenes[i];
+
+		scene->reorderPending = false;
+		scene->sortElements();
+	}
+
+	reorderPendingScenes.clear();
+}
+
 void SceneElement::unlink()
 {
 	if (scene)
@@ -26,6 +26,10 @@
 #include "intrulist.h"
 #include "etc.h"
 #include "etc-internal.h"
+#include "profiler.h"
+
+#include <stdint.h>
+#include <stddef.h>
 
 class SceneElement;
 class Viewport;
@@ -34,6 +38,31 @@ class Window;
 struct ScanRow;
 struct TilemapPrivate;
 
+/* Running FNV-1a hash over everything that influences how a
+ * scene element renders; two equal signatures mean the element
+ * would produce the same pixels. Only feed it plain values
+ * without padding bytes */
+struct CacheSignature
+{
+	uint64_t hash;
+
+	CacheSignature()
+	    : hash(14695981039346656037ULL)
+	{}
+
+	template<typename T>
+	void add(const T &value)
+	{
+		const uint8_t *bytes = reinterpret_cast<const uint8_t*>(&value);
+
+		for (size_t i = 0; i < sizeof(T); ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+};
+
 class Scene
 {
 public:
@@ -66,13 +95,24 @@ protected:
 	void insertAfter(SceneElement &element, SceneElement &after);
 	void reinsert(SceneElement &element);
 
+	/* Restores draw order after deferred reinserts */
+	void sortElements();
+
 	/* Notify all elements that geometry has changed */
 	void notifyGeometryChange();
 
+	/* Adds the signatures of all visible elements in draw order;
+	 * returns false as soon as one of them can't be cached */
+	bool addElementSignatures(CacheSignature &sig) const;
+
 	IntruList<SceneElement> elements;
 	Geometry geometry;
 
+	/* Order changed while a SceneReorderBatch was active */
+	bool reorderPending;
+
 	friend class SceneElement;
+	friend class SceneReorderBatch;
 	friend class Window;
 	friend class WindowVX;
 	friend struct ZLayer;
@@ -115,6 +155,14 @@ protected:
 	// FIXME: This should be a signal
 	virtual void onGeometryChange(const Scene::Geometry &) {}
 
+	/* Profiler section this element's draw time is booked under */
+	virtual Profiler::Section profileSection() const { return Profiler::Other; }
+
+	/* Adds this element's render state to 'sig' and returns true,
+	 * or returns false if its output can't be cached (because it
+	 * animates on its own, or blends with what's below it) */
+	virtual bool addCacheSignature(CacheSignature &) const { return false; }
+
 	/* Compares two elements in terms of their display priority;
 	 * elements with lower priority are drawn earlier */
 	bool operator<(const SceneElement &o) const;
@@ -146,6 +194,17 @@ private:
 	int spriteY;
 };
 
+/* While one of these is alive, changes to Z and sprite Y only
+ * mark their scene, which is then sorted once when the outermost
+ * batch ends instead of reinserting the element every time.
+ * Draw order is undefined until then */
+class SceneReorderBatch
+{
+public:
+	SceneReorderBatch();
+	~SceneReorderBatch();
+};
+
 #define ABOUT_TO_ACCESS_NOOP \
 	void aboutToAccess() const {}
 
@@ -25,6 +25,10 @@
 #include "sharedstate.h"
 #include "glstate.h"
 #include "exception.h"
+#include "debugwriter.h"
+#include "shadercache.h"
+
+#include <SDL_timer.h>
 
 #include <assert.h>
 #include <string.h>
@@ -34,6 +38,7 @@
 #include "common.h.xxd"
 #include "sprite.frag.xxd"
 #include "hue.frag.xxd"
+#include "yuv.frag.xxd"
 #include "trans.frag.xxd"
 #include "transSimple.frag.xxd"
 #include "bitmapBlit.frag.xxd"
@@ -48,6 +53,7 @@
 #include "flashMap.frag.xxd"
 #include "bicubic.frag.xxd"
 #include "lanczos3.frag.xxd"
+#include "scalePass.frag.xxd"
 #ifdef MKXPZ_SSL
 #include "xbrz.frag.xxd"
 #endif
@@ -60,25 +66,34 @@
 #include "simpleMatrix.vert.xxd"
 #include "blurH.vert.xxd"
 #include "blurV.vert.xxd"
+#include "gaussBlur.frag.xxd"
+#include "radialBlur.frag.xxd"
+#include "colorMatrix.frag.xxd"
 #include "tilemapvx.vert.xxd"
+#include "blitBatch.vert.xxd"
 #endif
 
 #ifdef MKXPZ_BUILD_XCODE
 #include "filesystem/filesystem.h"
-#define INIT_SHADER(vert, frag, name) \
+#define INIT_SHADER_DEFS(vert, frag, name, defines) \
 { \
     std::string v = mkxp_fs::contentsOfAssetAsString("Shaders/" #vert, "vert"); \
     std::string f = mkxp_fs::contentsOfAssetAsString("Shaders/" #frag, "frag"); \
-    Shader::init((const unsigned char*)v.c_str(), v.length(), (const unsigned char*)f.c_str(), f.length(), #vert, #frag, #name); \
+    Shader::init((const unsigned char*)v.c_str(), v.length(), (const unsigned char*)f.c_str(), f.length(), #vert, #frag, #name, defines); \
 }
 #else
-#define INIT_SHADER(vert, frag, name) \
+#define INIT_SHADER_DEFS(vert, frag, name, defines) \
 { \
 	Shader::init(___shader_##vert##_vert, ___shader_##vert##_vert_len, ___shader_##frag##_frag, ___shader_##frag##_frag_len, \
-	#vert, #frag, #name); \
+	#vert, #frag, #name, defines); \
 }
 #endif
 
+#define INIT_SHADER(vert, frag, name) INIT_SHADER_DEFS(vert, frag, name, 0)
+
+/* Higher locations are passed through without shadowing */
+#define MAX_SHADOWED_UNIFORMS 64
+
 #define GET_U(name) u_##name = gl.GetUniformLocation(program, #name)
 
 #ifdef MKXPZ_BUILD_XCODE
@@ -107,33 +122,75 @@ static void printProgramLog(GLuint program)
 	std::clog << "Program log:\n" << log;
 }
 
+/* Shared by all programs; only touched from the GL thread */
+static ShaderCache programCache;
+static bool programCacheChecked = false;
+
+/* Time spent compiling/linking so far, reported in debug mode */
+static double totalLinkMs = 0;
+
 Shader::Shader()
+    : vertShader(0),
+      fragShader(0),
+      program(0)
 {
 #ifdef MKXPZ_BUILD_XCODE
     if (Shader::shaderCommon.empty())
         Shader::shaderCommon = mkxp_fs::contentsOfAssetAsString("Shaders/common", "h");
 #endif
-	vertShader = gl.CreateShader(GL_VERTEX_SHADER);
-	fragShader = gl.CreateShader(GL_FRAGMENT_SHADER);
-
-	program = gl.CreateProgram();
 }
 
 Shader::~Shader()
 {
-	gl.DeleteProgram(program);
-	gl.DeleteShader(vertShader);
-	gl.DeleteShader(fragShader);
+	release();
+}
+
+void Shader::release()
+{
+	if (program)
+		gl.DeleteProgram(program);
+	if (vertShader)
+		gl.DeleteShader(vertShader);
+	if (fragShader)
+		gl.DeleteShader(fragShader);
+
+	program = vertShader = fragShader = 0;
+	uniformValues.clear();
+}
+
+static void logLinkTime(const char *programName, Uint64 start, bool cached)
+{
+	const double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+	totalLinkMs += ms;
+
+	if (shState->config().debugMode)
+		Debug() << "Shader:" << programName << (cached ? "loaded from cache in" : "compiled in")
+		        << ms << "ms," << totalLinkMs << "ms total";
 }
 
 void Shader::bind()
 {
+	if (!program)
+	{
+		/* Start over on the next bind rather than
+		 * keep a half built program around */
+		try
+		{
+			link();
+		}
+		catch (...)
+		{
+			release();
+			throw;
+		}
+	}
+
 	glState.program.set(program);
 }
 
 void Shader::unbind()
 {
-	gl.ActiveTexture(GL_TEXTURE0);
+	TEX::setActiveUnit(0);
 	glState.program.set(0);
 }
 
@@ -143,14 +200,26 @@ std::string &Shader::commonHeader() {
 }
 #endif
 
+static void getCommonHeader(const GLchar *&src, GLint &size)
+{
+#ifndef MKXPZ_BUILD_XCODE
+	src = (const GLchar*) ___shader_common_h;
+	size = ___shader_common_h_len;
+#else
+    src = (const GLchar*) Shader::commonHeader().c_str();
+    size = Shader::commonHeader().length();
+#endif
+}
+
 static void setupShaderSource(GLuint shader, GLenum type,
-                              const unsigned char *body, int bodySize)
+                              const unsigned char *body, int bodySize,
+                              const char *defines)
 {
 	static const char glesDefine[] = "#define GLSLES\n";
 	static const char fragDefine[] = "#define FRAGMENT_SHADER\n";
 
-	const GLchar *shaderSrc[4];
-	GLint shaderSrcSize[4];
+	const GLchar *shaderSrc[5];
+	GLint shaderSrcSize[5];
 	size_t i = 0;
 
 	if (gl.glsles)
@@ -167,13 +236,14 @@ static void setupShaderSource(GLuint shader, GLenum type,
 		++i;
 	}
 
-#ifndef MKXPZ_BUILD_XCODE
-	shaderSrc[i] = (const GLchar*) ___shader_common_h;
-	shaderSrcSize[i] = ___shader_common_h_len;
-#else
-    shaderSrc[i] = (const GLchar*) Shader::commonHeader().c_str();
-    shaderSrcSize[i] = Shader::commonHeader().length();
-#endif
+	if (defines)
+	{
+		shaderSrc[i] = defines;
+		shaderSrcSize[i] = strlen(defines);
+		++i;
+	}
+
+	getCommonHeader(shaderSrc[i], shaderSrcSize[i]);
 	++i;
 
 	shaderSrc[i] = (const GLchar*) body;
@@ -186,12 +256,52 @@ static void setupShaderSource(GLuint shader, GLenum type,
 void Shader::init(const unsigned char *vert, int vertSize,
                   const unsigned char *frag, int fragSize,
                   const char *vertName, const char *fragName,
-                  const char *programName)
+                  const char *programName, const char *defines)
 {
+	const Uint64 start = SDL_GetPerformanceCounter();
+
+	program = gl.CreateProgram();
+
+	if (!programCacheChecked)
+	{
+		const Config &conf = shState->config();
+
+		if (conf.shaderCache)
+			programCache.open(conf.customDataPath + "shadercache.mkxp");
+
+		programCacheChecked = true;
+	}
+
+	uint64_t cacheKey = 0;
+
+	if (programCache.isOpen())
+	{
+		const GLchar *common;
+		GLint commonSize;
+		getCommonHeader(common, commonSize);
+
+		cacheKey = ShaderCache::hash(&gl.glsles, sizeof(gl.glsles));
+		cacheKey = ShaderCache::hash(common, commonSize, cacheKey);
+		cacheKey = ShaderCache::hash(vert, vertSize, cacheKey);
+		cacheKey = ShaderCache::hash(frag, fragSize, cacheKey);
+
+		if (defines)
+			cacheKey = ShaderCache::hash(defines, strlen(defines), cacheKey);
+
+		if (programCache.load(cacheKey, program))
+		{
+			logLinkTime(programName, start, true);
+			return;
+		}
+	}
+
 	GLint success;
 
+	vertShader = gl.CreateShader(GL_VERTEX_SHADER);
+	fragShader = gl.CreateShader(GL_FRAGMENT_SHADER);
+
 	/* Compile vertex shader */
-	setupShaderSource(vertShader, GL_VERTEX_SHADER, vert, vertSize);
+	setupShaderSource(vertShader, GL_VERTEX_SHADER, vert, vertSize, defines);
 	gl.CompileShader(vertShader);
 
 	gl.GetShaderiv(vertShader, GL_COMPILE_STATUS, &success);
@@ -205,7 +315,7 @@ void Shader::init(const unsigned char *vert, int vertSize,
 	}
 
 	/* Compile fragment shader */
-	setupShaderSource(fragShader, GL_FRAGMENT_SHADER, frag, fragSize);
+	setupShaderSource(fragShader, GL_FRAGMENT_SHADER, frag, fragSize, defines);
 	gl.CompileShader(fragShader);
 
 	gl.GetShaderiv(fragShader, GL_COMPILE_STATUS, &success);
@@ -226,6 +336,9 @@ void Shader::init(const unsigned char *vert, int vertSize,
 	gl.BindAttribLocation(program, TexCoord, "texCoord");
 	gl.BindAttribLocation(program, Color, "color");
 
+	if (programCache.isOpen() && gl.ProgramParameteri)
+		gl.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	gl.LinkProgram(program);
 
 	gl.GetProgramiv(program, GL_LINK_STATUS, &success);
@@ -237,38 +350,122 @@ void Shader::init(const unsigned char *vert, int vertSize,
 	                    "GLSL: An error occured while linking program '%s' (vertex '%s', fragment '%s')",
 	                    programName, vertName, fragName);
 	}
+
+	if (programCache.isOpen())
+		programCache.store(cacheKey, program);
+
+	logLinkTime(programName, start, false);
 }
 
 void Shader::initFromFile(const char *_vertFile, const char *_fragFile,
                           const char *programName)
 {
 	std::string vertContents, fragContents;
-	readFile(_vertFile, vertContents);
-	readFile(_fragFile, fragContents);
+
+	if (_vertFile && !readFile(_vertFile, vertContents))
+		throw Exception(Exception::NoFileError, "%s", _vertFile);
+
+	if (!readFile(_fragFile, fragContents))
+		throw Exception(Exception::NoFileError, "%s", _fragFile);
+
+	if (!_vertFile)
+	{
+#ifndef MKXPZ_BUILD_XCODE
+		vertContents.assign((const char*) ___shader_simple_vert, ___shader_simple_vert_len);
+#else
+		vertContents = mkxp_fs::contentsOfAssetAsString("Shaders/simple", "vert");
+#endif
+		_vertFile = "simple";
+	}
 
 	init((const unsigned char*) vertContents.c_str(), vertContents.size(),
 	     (const unsigned char*) fragContents.c_str(), fragContents.size(),
 	     _vertFile, _fragFile, programName);
 }
 
+bool Shader::uniformChanged(GLint location, const void *data, size_t size)
+{
+	/* Uniform optimized out (or absent from this variant) */
+	if (location < 0)
+		return false;
+
+	assert(size <= sizeof(UniformValue::data));
+
+	if (location >= MAX_SHADOWED_UNIFORMS)
+		return GLShadowStats::check(true);
+
+	if ((size_t) location >= uniformValues.size())
+		uniformValues.resize(location + 1);
+
+	UniformValue &u = uniformValues[location];
+
+	/* The value goes to whichever program is bound, not this
+	 * one, so this program's copy is unknown from here on */
+	if (glState.program.get() != program)
+	{
+		u.size = 0;
+		return true;
+	}
+
+	if (!GLShadowStats::check(u.size != size || memcmp(u.data, data, size)))
+		return false;
+
+	u.size = size;
+	memcpy(u.data, data, size);
+
+	return true;
+}
+
+void Shader::setFloatUniform(GLint location, float value)
+{
+	if (uniformChanged(location, &value, sizeof(value)))
+		gl.Uniform1f(location, value);
+}
+
+void Shader::setFloatArrayUniform(GLint location, int count, const float *values)
+{
+	if (uniformChanged(location, values, sizeof(float) * count))
+		gl.Uniform1fv(location, count, values);
+}
+
+void Shader::setIntUniform(GLint location, int value)
+{
+	if (uniformChanged(location, &value, sizeof(value)))
+		gl.Uniform1i(location, value);
+}
+
+void Shader::setIntArrayUniform(GLint location, int count, const int *values)
+{
+	if (uniformChanged(location, values, sizeof(int) * count))
+		gl.Uniform1iv(location, count, values);
+}
+
 void Shader::setVec2Uniform(GLint location, const Vec2 &vec)
 {
-    gl.Uniform2f(location, vec.x, vec.y);
+	const float v[] = { vec.x, vec.y };
+
+	if (uniformChanged(location, v, sizeof(v)))
+		gl.Uniform2f(location, vec.x, vec.y);
 }
 
 void Shader::setVec4Uniform(GLint location, const Vec4 &vec)
 {
-	gl.Uniform4f(location, vec.x, vec.y, vec.z, vec.w);
+	const float v[] = { vec.x, vec.y, vec.z, vec.w };
+
+	if (uniformChanged(location, v, sizeof(v)))
+		gl.Uniform4f(location, vec.x, vec.y, vec.z, vec.w);
 }
 
-void Shader::setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture)
+void Shader::setMat4Uniform(GLint location, const float value[16])
 {
-	GLenum texUnit = GL_TEXTURE0 + unitIndex;
+	if (uniformChanged(location, value, sizeof(float) * 16))
+		gl.UniformMatrix4fv(location, 1, GL_FALSE, value);
+}
 
-	gl.ActiveTexture(texUnit);
-	gl.BindTexture(GL_TEXTURE_2D, texture.gl);
-	gl.Uniform1i(location, unitIndex);
-	gl.ActiveTexture(GL_TEXTURE0);
+void Shader::setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture)
+{
+	TEX::bindUnit(unitIndex, texture);
+	setIntUniform(location, unitIndex);
 }
 
 void ShaderBase::GLProjMat::apply(const Vec2i &value)
@@ -316,16 +513,16 @@ bool ShaderBase::framebufferScalingAllowed()
 
 void ShaderBase::setTexSize(const Vec2i &value)
 {
-	gl.Uniform2f(u_texSizeInv, 1.f / value.x, 1.f / value.y);
+	setVec2Uniform(u_texSizeInv, Vec2(1.f / value.x, 1.f / value.y));
 }
 
 void ShaderBase::setTranslation(const Vec2i &value)
 {
-	gl.Uniform2f(u_translation, value.x, value.y);
+	setVec2Uniform(u_translation, Vec2(value.x, value.y));
 }
 
 
-FlatColorShader::FlatColorShader()
+void FlatColorShader::link()
 {
 	INIT_SHADER(minimal, flatColor, FlatColorShader);
 
@@ -340,7 +537,7 @@ void FlatColorShader::setColor(const Vec4 &value)
 }
 
 
-SimpleShader::SimpleShader()
+void SimpleShader::link()
 {
 	INIT_SHADER(simple, simple, SimpleShader);
 
@@ -351,11 +548,11 @@ SimpleShader::SimpleShader()
 
 void SimpleShader::setTexOffsetX(int value)
 {
-	gl.Uniform1f(u_texOffsetX, value);
+	setFloatUniform(u_texOffsetX, value);
 }
 
 
-SimpleColorShader::SimpleColorShader()
+void SimpleColorShader::link()
 {
 	INIT_SHADER(simpleColor, simpleColor, SimpleColorShader);
 
@@ -363,7 +560,7 @@ SimpleColorShader::SimpleColorShader()
 }
 
 
-SimpleAlphaShader::SimpleAlphaShader()
+void SimpleAlphaShader::link()
 {
 	INIT_SHADER(simpleColor, simpleAlpha, SimpleAlphaShader);
 
@@ -371,7 +568,7 @@ SimpleAlphaShader::SimpleAlphaShader()
 }
 
 
-SimpleSpriteShader::SimpleSpriteShader()
+void SimpleSpriteShader::link()
 {
 	INIT_SHADER(sprite, simple, SimpleSpriteShader);
 
@@ -382,10 +579,10 @@ SimpleSpriteShader::SimpleSpriteShader()
 
 void SimpleSpriteShader::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
 }
 
-BicubicSpriteShader::BicubicSpriteShader()
+void BicubicSpriteShader::link()
 {
 	INIT_SHADER(sprite, bicubic, BicubicSpriteShader);
 
@@ -398,10 +595,10 @@ BicubicSpriteShader::BicubicSpriteShader()
 
 void BicubicSpriteShader::setSharpness(int sharpness)
 {
-	gl.Uniform2f(u_bc, 1.f - sharpness * 0.01f, sharpness * 0.005f);
+	setVec2Uniform(u_bc, Vec2(1.f - sharpness * 0.01f, sharpness * 0.005f));
 }
 
-Lanczos3SpriteShader::Lanczos3SpriteShader()
+void Lanczos3SpriteShader::link()
 {
 	INIT_SHADER(sprite, lanczos3, Lanczos3SpriteShader);
 
@@ -414,11 +611,11 @@ Lanczos3SpriteShader::Lanczos3SpriteShader()
 void Lanczos3SpriteShader::setTexSize(const Vec2i &value)
 {
 	ShaderBase::setTexSize(value);
-	gl.Uniform2f(u_sourceSize, (float)value.x, (float)value.y);
+	setVec2Uniform(u_sourceSize, Vec2((float)value.x, (float)value.y));
 }
 
 #ifdef MKXPZ_SSL
-XbrzSpriteShader::XbrzSpriteShader()
+void XbrzSpriteShader::link()
 {
 	INIT_SHADER(sprite, xbrz, XbrzSpriteShader);
 
@@ -431,11 +628,11 @@ XbrzSpriteShader::XbrzSpriteShader()
 
 void XbrzSpriteShader::setTargetScale(const Vec2 &value)
 {
-	gl.Uniform2f(u_targetScale, value.x, value.y);
+	setVec2Uniform(u_targetScale, value);
 }
 #endif
 
-AlphaSpriteShader::AlphaSpriteShader()
+void AlphaSpriteShader::link()
 {
 	INIT_SHADER(sprite, simpleAlphaUni, AlphaSpriteShader);
 
@@ -447,16 +644,16 @@ AlphaSpriteShader::AlphaSpriteShader()
 
 void AlphaSpriteShader::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
 }
 
 void AlphaSpriteShader::setAlpha(float value)
 {
-	gl.Uniform1f(u_alpha, value);
+	setFloatUniform(u_alpha, value);
 }
 
 
-TransShader::TransShader()
+void TransShader::link()
 {
 	INIT_SHADER(simple, trans, TransShader);
 
@@ -486,16 +683,34 @@ void TransShader::setTransMap(TEX::ID tex)
 
 void TransShader::setProg(float value)
 {
-	gl.Uniform1f(u_prog, value);
+	setFloatUniform(u_prog, value);
 }
 
 void TransShader::setVague(float value)
 {
-	gl.Uniform1f(u_vague, value);
+	setFloatUniform(u_vague, value);
 }
 
 
-SimpleTransShader::SimpleTransShader()
+CustomTransShader::CustomTransShader(const std::string &fragFile)
+    : fragFile(fragFile)
+{}
+
+void CustomTransShader::link()
+{
+	initFromFile(0, fragFile.c_str(), "CustomTransShader");
+
+	ShaderBase::init();
+
+	GET_U(currentScene);
+	GET_U(frozenScene);
+	GET_U(transMap);
+	GET_U(prog);
+	GET_U(vague);
+}
+
+
+void SimpleTransShader::link()
 {
 	INIT_SHADER(simple, transSimple, SimpleTransShader);
 
@@ -518,13 +733,35 @@ void SimpleTransShader::setFrozenScene(TEX::ID tex)
 
 void SimpleTransShader::setProg(float value)
 {
-	gl.Uniform1f(u_prog, value);
+	setFloatUniform(u_prog, value);
 }
 
 
-SpriteShader::SpriteShader()
+void SpriteShader::link()
 {
-	INIT_SHADER(sprite, sprite, SpriteShader);
+	std::string defines;
+
+	if (variant & Pattern)
+	{
+		defines += "#define SPRITE_PATTERN\n";
+		defines += "#define SPRITE_PATTERN_BLEND ";
+		defines += (char) ('0' + ((variant & (PatternBlend0 | PatternBlend1)) >> 1));
+		defines += "\n";
+	}
+
+	if (variant & Tone)
+		defines += "#define SPRITE_TONE\n";
+
+	if (variant & Color)
+		defines += "#define SPRITE_COLOR\n";
+
+	if (variant & Bush)
+		defines += "#define SPRITE_BUSH\n";
+
+	if (variant & Invert)
+		defines += "#define SPRITE_INVERT\n";
+
+	INIT_SHADER_DEFS(sprite, sprite, SpriteShader, defines.c_str());
 
 	ShaderBase::init();
 
@@ -535,19 +772,29 @@ SpriteShader::SpriteShader()
 	GET_U(bushDepth);
 	GET_U(bushOpacity);
     GET_U(pattern);
-    GET_U(patternBlendType);
     GET_U(patternTile);
-    GET_U(renderPattern);
     GET_U(patternSizeInv);
     GET_U(patternOpacity);
     GET_U(patternScroll);
     GET_U(patternZoom);
-    GET_U(invert);
+}
+
+unsigned SpriteShader::patternBlendVariant(int blendType)
+{
+	switch (blendType)
+	{
+	case BlendAddition:
+		return PatternBlend0;
+	case BlendSubstraction:
+		return PatternBlend1;
+	default:
+		return 0;
+	}
 }
 
 void SpriteShader::setSpriteMat(const float value[16])
 {
-	gl.UniformMatrix4fv(u_spriteMat, 1, GL_FALSE, value);
+	setMat4Uniform(u_spriteMat, value);
 }
 
 void SpriteShader::setTone(const Vec4 &tone)
@@ -562,43 +809,33 @@ void SpriteShader::setColor(const Vec4 &color)
 
 void SpriteShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
 }
 
 void SpriteShader::setBushDepth(float value)
 {
-	gl.Uniform1f(u_bushDepth, value);
+	setFloatUniform(u_bushDepth, value);
 }
 
 void SpriteShader::setBushOpacity(float value)
 {
-	gl.Uniform1f(u_bushOpacity, value);
+	setFloatUniform(u_bushOpacity, value);
 }
 
 void SpriteShader::setPattern(const TEX::ID pattern, const Vec2 &dimensions)
 {
     setTexUniform(u_pattern, 1, pattern);
-    gl.Uniform2f(u_patternSizeInv, 1.f / dimensions.x, 1.f / dimensions.y);
-}
-
-void SpriteShader::setPatternBlendType(int blendType)
-{
-    gl.Uniform1i(u_patternBlendType, blendType);
+    setVec2Uniform(u_patternSizeInv, Vec2(1.f / dimensions.x, 1.f / dimensions.y));
 }
 
 void SpriteShader::setPatternTile(bool value)
 {
-    gl.Uniform1i(u_patternTile, value);
-}
-
-void SpriteShader::setShouldRenderPattern(bool value)
-{
-    gl.Uniform1i(u_renderPattern, value);
+    setIntUniform(u_patternTile, value);
 }
 
 void SpriteShader::setPatternOpacity(float value)
 {
-    gl.Uniform1f(u_patternOpacity, value);
+    setFloatUniform(u_patternOpacity, value);
 }
 
 void SpriteShader::setPatternScroll(const Vec2 &scroll)
@@ -611,13 +848,27 @@ void SpriteShader::setPatternZoom(const Vec2 &zoom)
     setVec2Uniform(u_patternZoom, zoom);
 }
 
-void SpriteShader::setInvert(bool value)
+
+SpriteShaderVariants::SpriteShaderVariants()
 {
-    gl.Uniform1i(u_invert, value);
+	for (unsigned i = 0; i < SpriteShader::VariantCount; ++i)
+		variants[i].variant = i;
+}
+
+SpriteShader &SpriteShaderVariants::get(unsigned variant)
+{
+	/* Blend type is meaningless without a pattern; fold those
+	 * keys together so they don't compile duplicate programs */
+	if (!(variant & SpriteShader::Pattern))
+		variant &= ~(SpriteShader::PatternBlend0 | SpriteShader::PatternBlend1);
+
+	assert(variant < SpriteShader::VariantCount);
+
+	return variants[variant];
 }
 
 
-PlaneShader::PlaneShader()
+void PlaneShader::link()
 {
 	INIT_SHADER(simple, plane, PlaneShader);
 
@@ -646,11 +897,11 @@ void PlaneShader::setFlash(const Vec4 &flash)
 
 void PlaneShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
 }
 
 
-GrayShader::GrayShader()
+void GrayShader::link()
 {
 	INIT_SHADER(simple, gray, GrayShader);
 
@@ -668,11 +919,11 @@ bool GrayShader::framebufferScalingAllowed()
 
 void GrayShader::setGray(float value)
 {
-	gl.Uniform1f(u_gray, value);
+	setFloatUniform(u_gray, value);
 }
 
 
-TilemapShader::TilemapShader()
+void TilemapShader::link()
 {
 	INIT_SHADER(tilemap, tilemap, TilemapShader);
 
@@ -698,22 +949,22 @@ void TilemapShader::setColor(const Vec4 &color)
 
 void TilemapShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
 }
 
 void TilemapShader::setAniIndex(int value)
 {
-	gl.Uniform1i(u_aniIndex, value);
+	setIntUniform(u_aniIndex, value);
 }
 
 void TilemapShader::setATFrames(int values[7])
 {
-	gl.Uniform1iv(u_atFrames, 7, values);
+	setIntArrayUniform(u_atFrames, 7, values);
 }
 
 
 
-FlashMapShader::FlashMapShader()
+void FlashMapShader::link()
 {
 	INIT_SHADER(simpleColor, flashMap, FlashMapShader);
 
@@ -724,11 +975,11 @@ FlashMapShader::FlashMapShader()
 
 void FlashMapShader::setAlpha(float value)
 {
-	gl.Uniform1f(u_alpha, value);
+	setFloatUniform(u_alpha, value);
 }
 
 
-HueShader::HueShader()
+void HueShader::link()
 {
 	INIT_SHADER(simple, hue, HueShader);
 
@@ -739,11 +990,50 @@ HueShader::HueShader()
 
 void HueShader::setHueAdjust(float value)
 {
-	gl.Uniform1f(u_hueAdjust, value);
+	setFloatUniform(u_hueAdjust, value);
+}
+
+void ColorMatrixShader::link()
+{
+	INIT_SHADER(simple, colorMatrix, ColorMatrixShader);
+
+	ShaderBase::init();
+
+	GET_U(colorMat);
+	GET_U(colorOffset);
+}
+
+void ColorMatrixShader::setMatrix(const float value[16])
+{
+	setMat4Uniform(u_colorMat, value);
 }
 
+void ColorMatrixShader::setOffset(const Vec4 &value)
+{
+	setVec4Uniform(u_colorOffset, value);
+}
+
+
+void YUVShader::link()
+{
+	INIT_SHADER(simple, yuv, YUVShader);
+
+	ShaderBase::init();
 
-SimpleMatrixShader::SimpleMatrixShader()
+	GET_U(texY);
+	GET_U(texU);
+	GET_U(texV);
+}
+
+void YUVShader::setPlanes(TEX::ID y, TEX::ID u, TEX::ID v)
+{
+	setTexUniform(u_texY, 1, y);
+	setTexUniform(u_texU, 2, u);
+	setTexUniform(u_texV, 3, v);
+}
+
+
+void SimpleMatrixShader::link()
 {
 	INIT_SHADER(simpleMatrix, simpleAlpha, SimpleMatrixShader);
 
@@ -754,26 +1044,70 @@ SimpleMatrixShader::SimpleMatrixShader()
 
 void SimpleMatrixShader::setMatrix(const float value[16])
 {
-	gl.UniformMatrix4fv(u_matrix, 1, GL_FALSE, value);
+	setMat4Uniform(u_matrix, value);
 }
 
 
-BlurShader::HPass::HPass()
+void BlurShader::HPass::link()
 {
 	INIT_SHADER(blurH, blur, BlurShader::HPass);
 
 	ShaderBase::init();
 }
 
-BlurShader::VPass::VPass()
+void BlurShader::VPass::link()
 {
 	INIT_SHADER(blurV, blur, BlurShader::VPass);
 
 	ShaderBase::init();
 }
 
+void GaussBlurShader::link()
+{
+	INIT_SHADER(simple, gaussBlur, GaussBlurShader);
+
+	ShaderBase::init();
+
+	GET_U(direction);
+	GET_U(weights);
+	GET_U(offsets);
+}
+
+void GaussBlurShader::setDirection(const Vec2 &value)
+{
+	setVec2Uniform(u_direction, value);
+}
+
+void GaussBlurShader::setKernel(const float weights[Taps], const float offsets[Taps])
+{
+	setFloatArrayUniform(u_weights, Taps, weights);
+	setFloatArrayUniform(u_offsets, Taps, offsets);
+}
+
+void RadialBlurShader::link()
+{
+	INIT_SHADER(simple, radialBlur, RadialBlurShader);
+
+	ShaderBase::init();
+
+	GET_U(baseAngle);
+	GET_U(angleStep);
+	GET_U(divisions);
+}
+
+void RadialBlurShader::setAngles(float base, float step)
+{
+	setFloatUniform(u_baseAngle, base);
+	setFloatUniform(u_angleStep, step);
+}
 
-TilemapVXShader::TilemapVXShader()
+void RadialBlurShader::setDivisions(int value)
+{
+	setIntUniform(u_divisions, value);
+}
+
+
+void TilemapVXShader::link()
 {
 	INIT_SHADER(tilemapvx, simple, TilemapVXShader);
 
@@ -784,11 +1118,11 @@ TilemapVXShader::TilemapVXShader()
 
 void TilemapVXShader::setAniOffset(const Vec2 &value)
 {
-	gl.Uniform2f(u_aniOffset, value.x, value.y);
+	setVec2Uniform(u_aniOffset, value);
 }
 
 
-BltShader::BltShader()
+void BltShader::link()
 {
 	INIT_SHADER(simple, bitmapBlit, BltShader);
 
@@ -802,7 +1136,7 @@ BltShader::BltShader()
 
 void BltShader::setSource()
 {
-	gl.Uniform1i(u_source, 0);
+	setIntUniform(u_source, 0);
 }
 
 void BltShader::setDestination(const TEX::ID value)
@@ -812,15 +1146,15 @@ void BltShader::setDestination(const TEX::ID value)
 
 void BltShader::setSubRect(const FloatRect &value)
 {
-	gl.Uniform4f(u_subRect, value.x, value.y, value.w, value.h);
+	setVec4Uniform(u_subRect, Vec4(value.x, value.y, value.w, value.h));
 }
 
 void BltShader::setOpacity(float value)
 {
-	gl.Uniform1f(u_opacity, value);
+	setFloatUniform(u_opacity, value);
 }
 
-BicubicShader::BicubicShader()
+void BicubicShader::link()
 {
 	INIT_SHADER(simple, bicubic, BicubicShader);
 
@@ -833,10 +1167,36 @@ BicubicShader::BicubicShader()
 
 void BicubicShader::setSharpness(int sharpness)
 {
-	gl.Uniform2f(u_bc, 1.f - sharpness * 0.01f, sharpness * 0.005f);
+	setVec2Uniform(u_bc, Vec2(1.f - sharpness * 0.01f, sharpness * 0.005f));
+}
+
+void BltBatchShader::link()
+{
+	INIT_SHADER_DEFS(blitBatch, bitmapBlit, BltBatchShader, "#define BLT_BATCH\n");
+
+	ShaderBase::init();
+
+	GET_U(source);
+	GET_U(destination);
+	GET_U(dstSizeInv);
+}
+
+void BltBatchShader::setSource()
+{
+	setIntUniform(u_source, 0);
+}
+
+void BltBatchShader::setDestination(const TEX::ID value)
+{
+	setTexUniform(u_destination, 1, value);
+}
+
+void BltBatchShader::setDestSize(const Vec2i &value)
+{
+	setVec2Uniform(u_dstSizeInv, Vec2(1.f / value.x, 1.f / value.y));
 }
 
-Lanczos3Shader::Lanczos3Shader()
+void Lanczos3Shader::link()
 {
 	INIT_SHADER(simple, lanczos3, Lanczos3Shader);
 
@@ -849,11 +1209,44 @@ Lanczos3Shader::Lanczos3Shader()
 void Lanczos3Shader::setTexSize(const Vec2i &value)
 {
 	ShaderBase::setTexSize(value);
-	gl.Uniform2f(u_sourceSize, (float)value.x, (float)value.y);
+	setVec2Uniform(u_sourceSize, Vec2((float)value.x, (float)value.y));
+}
+
+void ScalePassShader::setDirection(const Vec2 &value)
+{
+	setVec2Uniform(u_direction, value);
+}
+
+void Lanczos3PassShader::link()
+{
+	INIT_SHADER_DEFS(simple, scalePass, Lanczos3PassShader, "#define SCALE_LANCZOS3\n");
+
+	ShaderBase::init();
+
+	GET_U(texOffsetX);
+	GET_U(sourceSize);
+	GET_U(direction);
+}
+
+void BicubicPassShader::link()
+{
+	INIT_SHADER_DEFS(simple, scalePass, BicubicPassShader, "#define SCALE_BICUBIC\n");
+
+	ShaderBase::init();
+
+	GET_U(texOffsetX);
+	GET_U(sourceSize);
+	GET_U(direction);
+	GET_U(bc);
+}
+
+void BicubicPassShader::setSharpness(int sharpness)
+{
+	setVec2Uniform(u_bc, Vec2(1.f - sharpness * 0.01f, sharpness * 0.005f));
 }
 
 #ifdef MKXPZ_SSL
-XbrzShader::XbrzShader()
+void XbrzShader::link()
 {
 	INIT_SHADER(simple, xbrz, XbrzShader);
 
@@ -866,6 +1259,6 @@ XbrzShader::XbrzShader()
 
 void XbrzShader::setTargetScale(const Vec2 &value)
 {
-	gl.Uniform2f(u_targetScale, value.x, value.y);
+	setVec2Uniform(u_targetScale, value);
 }
 #endif
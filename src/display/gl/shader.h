@@ -26,9 +26,13 @@
 #include "gl-util.h"
 #include "glstate.h"
 
+#include <vector>
+#include <stdint.h>
+
 class Shader
 {
 public:
+	/* Links the program on first use */
 	void bind();
 	static void unbind();
 
@@ -45,21 +49,46 @@ protected:
 	Shader();
 	~Shader();
 
+	/* Compiles the program and looks up its uniforms.
+	 * Called from the first bind(), never earlier */
+	virtual void link() = 0;
+
     void init(const unsigned char *vert, int vertSize,
               const unsigned char *frag, int fragSize,
 	          const char *vertName, const char *fragName,
-	          const char *programName);
+	          const char *programName, const char *defines = 0);
+	/* A null 'vertFile' selects the built-in simple.vert */
 	void initFromFile(const char *vertFile, const char *fragFile,
 	                  const char *programName);
 
-	static void setVec4Uniform(GLint location, const Vec4 &vec);
-    static void setVec2Uniform(GLint location, const Vec2 &vec);
-	static void setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture);
+	/* Uniform setters skip values the program already holds */
+	void setFloatUniform(GLint location, float value);
+	void setFloatArrayUniform(GLint location, int count, const float *values);
+	void setIntUniform(GLint location, int value);
+	void setIntArrayUniform(GLint location, int count, const int *values);
+	void setVec4Uniform(GLint location, const Vec4 &vec);
+	void setVec2Uniform(GLint location, const Vec2 &vec);
+	void setMat4Uniform(GLint location, const float value[16]);
+	void setTexUniform(GLint location, unsigned unitIndex, TEX::ID texture);
 
 	GLuint vertShader, fragShader;
 	GLuint program;
     
 private:
+	void release();
+	bool uniformChanged(GLint location, const void *data, size_t size);
+
+	/* Last value uploaded to each uniform location */
+	struct UniformValue
+	{
+		size_t size;
+		uint8_t data[sizeof(float) * 16];
+
+		UniformValue() : size(0) {}
+	};
+
+	std::vector<UniformValue> uniformValues;
+
 #ifdef MKXPZ_BUILD_XCODE
     static std::string shaderCommon;
 #endif
@@ -73,7 +102,7 @@ public:
 	{
 	private:
 		void apply(const Vec2i &value);
-		GLint u_mat;
+		GLint u_mat = -1;
 
 		friend class ShaderBase;
 	};
@@ -93,98 +122,134 @@ protected:
 	void init();
 	virtual bool framebufferScalingAllowed();
 
-	GLint u_texSizeInv, u_translation;
+	GLint u_texSizeInv = -1, u_translation = -1;
 };
 
 class FlatColorShader : public ShaderBase
 {
 public:
-	FlatColorShader();
-
 	void setColor(const Vec4 &value);
 
+protected:
+	void link();
+
 private:
-	GLint u_color;
+	GLint u_color = -1;
 };
 
 class SimpleShader : public ShaderBase
 {
 public:
-	SimpleShader();
-
 	void setTexOffsetX(int value);
 
 protected:
-	GLint u_texOffsetX;
+	void link();
+
+	GLint u_texOffsetX = -1;
 };
 
 class SimpleColorShader : public ShaderBase
 {
-public:
-	SimpleColorShader();
+protected:
+	void link();
 };
 
 class SimpleAlphaShader : public ShaderBase
 {
-public:
-	SimpleAlphaShader();
+protected:
+	void link();
 };
 
 class SimpleSpriteShader : public ShaderBase
 {
 public:
-	SimpleSpriteShader();
-
 	void setSpriteMat(const float value[16]);
 
 protected:
-	GLint u_spriteMat;
+	void link();
+
+	GLint u_spriteMat = -1;
 };
 
 class AlphaSpriteShader : public ShaderBase
 {
 public:
-	AlphaSpriteShader();
-
 	void setSpriteMat(const float value[16]);
 	void setAlpha(float value);
 
+protected:
+	void link();
+
 private:
-	GLint u_spriteMat, u_alpha;
+	GLint u_spriteMat = -1, u_alpha = -1;
 };
 
 class TransShader : public ShaderBase
 {
 public:
-	TransShader();
-
 	void setCurrentScene(TEX::ID tex);
 	void setFrozenScene(TEX::ID tex);
 	void setTransMap(TEX::ID tex);
 	void setProg(float value);
 	void setVague(float value);
 
+protected:
+	void link();
+
+	GLint u_currentScene = -1, u_frozenScene = -1, u_transMap = -1, u_prog = -1, u_vague = -1;
+};
+
+/* User supplied transition fragment shader, paired with simple.vert.
+ * Contract: sampler2D currentScene, frozenScene, transMap (only bound
+ * when a transition map was given); float prog (0 to 1), float vague
+ * (normalized); varying vec2 v_texCoord. Uniforms a shader doesn't
+ * declare are ignored */
+class CustomTransShader : public TransShader
+{
+public:
+	CustomTransShader(const std::string &fragFile);
+
+protected:
+	void link();
+
 private:
-	GLint u_currentScene, u_frozenScene, u_transMap, u_prog, u_vague;
+	std::string fragFile;
 };
 
 class SimpleTransShader : public ShaderBase
 {
 public:
-	SimpleTransShader();
-
 	void setCurrentScene(TEX::ID tex);
 	void setFrozenScene(TEX::ID tex);
 	void setProg(float value);
 
+protected:
+	void link();
+
 private:
-	GLint u_currentScene, u_frozenScene, u_prog;
+	GLint u_currentScene = -1, u_frozenScene = -1, u_prog = -1;
 };
 
+/* Each effect is compiled in or out of sprite.frag; uniforms of
+ * effects missing from a variant are silently ignored */
 class SpriteShader : public ShaderBase
 {
 public:
-	SpriteShader();
+	enum Variant
+	{
+		Pattern       = 1 << 0,
+		/* Pattern blend type (BlendType), only with Pattern */
+		PatternBlend0 = 1 << 1,
+		PatternBlend1 = 1 << 2,
+		Tone          = 1 << 3,
+		Color         = 1 << 4,
+		Bush          = 1 << 5,
+		Invert        = 1 << 6,
+
+		VariantCount  = 1 << 7
+	};
+
+	static unsigned patternBlendVariant(int blendType);
 
 	void setSpriteMat(const float value[16]);
 	void setTone(const Vec4 &value);
@@ -193,52 +258,65 @@ public:
 	void setBushDepth(float value);
 	void setBushOpacity(float value);
     void setPattern(const TEX::ID pattern, const Vec2 &dimensions);
-    void setPatternBlendType(int blendType);
     void setPatternTile(bool value);
-    void setShouldRenderPattern(bool value);
     void setPatternOpacity(float value);
     void setPatternScroll(const Vec2 &scroll);
     void setPatternZoom(const Vec2 &zoom);
-    void setInvert(bool value);
+
+protected:
+	void link();
 
 private:
-	GLint u_spriteMat, u_tone, u_opacity, u_color, u_bushDepth, u_bushOpacity, u_pattern, u_renderPattern,
-    u_patternBlendType, u_patternSizeInv, u_patternTile, u_patternOpacity, u_patternScroll, u_patternZoom, u_invert;
+	friend class SpriteShaderVariants;
+	unsigned variant;
+
+	GLint u_spriteMat = -1, u_tone = -1, u_opacity = -1, u_color = -1, u_bushDepth = -1, u_bushOpacity = -1, u_pattern = -1,
+    u_patternSizeInv = -1, u_patternTile = -1, u_patternOpacity = -1, u_patternScroll = -1, u_patternZoom = -1;
 };
 
-class PlaneShader : public ShaderBase
+/* All SpriteShader permutations, each one compiled on first use */
+class SpriteShaderVariants
 {
 public:
-	PlaneShader();
+	SpriteShaderVariants();
+
+	SpriteShader &get(unsigned variant);
+
+private:
+	SpriteShader variants[SpriteShader::VariantCount];
+};
 
+class PlaneShader : public ShaderBase
+{
+public:
 	void setTone(const Vec4 &value);
 	void setColor(const Vec4 &value);
 	void setFlash(const Vec4 &value);
 	void setOpacity(float value);
 
+protected:
+	void link();
+
 private:
-	GLint u_tone, u_color, u_flash, u_opacity;
+	GLint u_tone = -1, u_color = -1, u_flash = -1, u_opacity = -1;
 };
 
 class GrayShader : public ShaderBase
 {
 public:
-	GrayShader();
-
 	void setGray(float value);
 
 protected:
+	void link();
 	virtual bool framebufferScalingAllowed();
 
 private:
-	GLint u_gray;
+	GLint u_gray = -1;
 };
 
 class TilemapShader : public ShaderBase
 {
 public:
-	TilemapShader();
-
 	void setAniIndex(int value);
 
 	void setTone(const Vec4 &value);
@@ -247,41 +325,74 @@ public:
 
 	void setATFrames(int values[7]);
 
+protected:
+	void link();
+
 private:
-	GLint u_aniIndex, u_tone, u_color, u_opacity, u_atFrames;
+	GLint u_aniIndex = -1, u_tone = -1, u_color = -1, u_opacity = -1, u_atFrames = -1;
 };
 
 class FlashMapShader : public ShaderBase
 {
 public:
-	FlashMapShader();
-
 	void setAlpha(float value);
 
+protected:
+	void link();
+
 private:
-	GLint u_alpha;
+	GLint u_alpha = -1;
 };
 
 class HueShader : public ShaderBase
 {
 public:
-	HueShader();
-
 	void setHueAdjust(float value);
 
+protected:
+	void link();
+
 private:
-	GLint u_hueAdjust;
+	GLint u_hueAdjust = -1;
 };
 
-class SimpleMatrixShader : public ShaderBase
+class ColorMatrixShader : public ShaderBase
+{
+public:
+	/* Column major */
+	void setMatrix(const float value[16]);
+	void setOffset(const Vec4 &value);
+
+protected:
+	void link();
+
+private:
+	GLint u_colorMat = -1, u_colorOffset = -1;
+};
+
+/* Planar Y'CbCr 4:2:0 -> RGB, used for movie frames */
+class YUVShader : public ShaderBase
 {
 public:
-	SimpleMatrixShader();
+	void setPlanes(TEX::ID y, TEX::ID u, TEX::ID v);
 
+protected:
+	void link();
+
+private:
+	GLint u_texY = -1, u_texU = -1, u_texV = -1;
+};
+
+class SimpleMatrixShader : public ShaderBase
+{
+public:
 	void setMatrix(const float value[16]);
 
+protected:
+	void link();
+
 private:
-	GLint u_matrix;
+	GLint u_matrix = -1;
 };
 
 /* Gaussian blur */
@@ -289,113 +400,192 @@ struct BlurShader
 {
 	class HPass : public ShaderBase
 	{
-	public:
-		HPass();
+	protected:
+		void link();
 	};
 
 	class VPass : public ShaderBase
 	{
-	public:
-		VPass();
+	protected:
+		void link();
 	};
 
 	HPass pass1;
 	VPass pass2;
 };
 
-class TilemapVXShader : public ShaderBase
+/* One axis of Bitmap::blur(radius, passes), see gaussBlur.frag */
+class GaussBlurShader : public ShaderBase
+{
+public:
+	enum { Taps = 8 };
+
+	/* (1, 0) for horizontal, (0, 1) for vertical */
+	void setDirection(const Vec2 &value);
+	void setKernel(const float weights[Taps], const float offsets[Taps]);
+
+protected:
+	void link();
+
+private:
+	GLint u_direction = -1, u_weights = -1, u_offsets = -1;
+};
+
+class RadialBlurShader : public ShaderBase
 {
 public:
-	TilemapVXShader();
+	enum { MaxDivisions = 100 };
+
+	/* In radians */
+	void setAngles(float base, float step);
+	void setDivisions(int value);
 
+protected:
+	void link();
+
+private:
+	GLint u_baseAngle = -1, u_angleStep = -1, u_divisions = -1;
+};
+
+class TilemapVXShader : public ShaderBase
+{
+public:
 	void setAniOffset(const Vec2 &value);
 
+protected:
+	void link();
+
 private:
-	GLint u_aniOffset;
+	GLint u_aniOffset = -1;
 };
 
 /* Bitmap blit */
 class BltShader : public ShaderBase
 {
 public:
-	BltShader();
-
 	void setSource();
 	void setDestination(const TEX::ID value);
 	void setDestCoorF(const Vec2 &value);
 	void setSubRect(const FloatRect &value);
 	void setOpacity(float value);
 
+protected:
+	void link();
+
 private:
-	GLint u_source, u_destination, u_subRect, u_opacity;
+	GLint u_source = -1, u_destination = -1, u_subRect = -1, u_opacity = -1;
 };
 
-class Lanczos3Shader : public SimpleShader
+/* BltShader for Bitmap draw batches; the destination is a
+ * snapshot of the whole target, see Bitmap::beginBatch() */
+class BltBatchShader : public ShaderBase
 {
 public:
-	Lanczos3Shader();
+	void setSource();
+	void setDestination(const TEX::ID value);
+	void setDestSize(const Vec2i &value);
 
+protected:
+	void link();
+
+private:
+	GLint u_source = -1, u_destination = -1, u_dstSizeInv = -1;
+};
+
+class Lanczos3Shader : public SimpleShader
+{
+public:
 	void setTexSize(const Vec2i &value);
 
 protected:
-	GLint u_sourceSize;
+	void link();
+
+	GLint u_sourceSize = -1;
 };
 
 class BicubicShader : public Lanczos3Shader
 {
 public:
-	BicubicShader();
+	void setSharpness(int sharpness);
+
+protected:
+	void link();
+
+	GLint u_bc = -1;
+};
 
+/* Single axis passes of the above, 'direction'
+ * is (1, 0) for horizontal and (0, 1) for vertical */
+class ScalePassShader : public Lanczos3Shader
+{
+public:
+	void setDirection(const Vec2 &value);
+
+protected:
+	GLint u_direction = -1;
+};
+
+class Lanczos3PassShader : public ScalePassShader
+{
+protected:
+	void link();
+};
+
+class BicubicPassShader : public ScalePassShader
+{
+public:
 	void setSharpness(int sharpness);
 
 protected:
-	GLint u_bc;
+	void link();
+
+	GLint u_bc = -1;
 };
 
 #ifdef MKXPZ_SSL
 class XbrzShader : public Lanczos3Shader
 {
 public:
-	XbrzShader();
-
 	void setTargetScale(const Vec2 &value);
 
 protected:
-	GLint u_targetScale;
+	void link();
+
+	GLint u_targetScale = -1;
 };
 #endif
 
 class Lanczos3SpriteShader : public SimpleSpriteShader
 {
 public:
-	Lanczos3SpriteShader();
-
 	void setTexSize(const Vec2i &value);
 
 protected:
-	GLint u_sourceSize;
+	void link();
+
+	GLint u_sourceSize = -1;
 };
 
 class BicubicSpriteShader : public Lanczos3SpriteShader
 {
 public:
-	BicubicSpriteShader();
-
 	void setSharpness(int sharpness);
 
 protected:
-	GLint u_bc;
+	void link();
+
+	GLint u_bc = -1;
 };
 
 class XbrzSpriteShader : public Lanczos3SpriteShader
 {
 public:
-	XbrzSpriteShader();
-
 	void setTargetScale(const Vec2 &value);
 
 protected:
-	GLint u_targetScale;
+	void link();
+
+	GLint u_targetScale = -1;
 };
 
 /* Global object containing all available shaders */
@@ -407,7 +597,7 @@ struct ShaderSet
 	SimpleAlphaShader simpleAlpha;
 	SimpleSpriteShader simpleSprite;
 	AlphaSpriteShader alphaSprite;
-	SpriteShader sprite;
+	SpriteShaderVariants sprite;
 	PlaneShader plane;
 	GrayShader gray;
 	TilemapShader tilemap;
@@ -415,12 +605,19 @@ struct ShaderSet
 	TransShader trans;
 	SimpleTransShader simpleTrans;
 	HueShader hue;
+	YUVShader yuv;
 	BltShader blt;
+	BltBatchShader bltBatch;
 	SimpleMatrixShader simpleMatrix;
 	BlurShader blur;
+	GaussBlurShader gaussBlur;
+	RadialBlurShader radialBlur;
+	ColorMatrixShader colorMatrix;
 	TilemapVXShader tilemapVX;
 	BicubicShader bicubic;
 	Lanczos3Shader lanczos3;
+	BicubicPassShader bicubicPass;
+	Lanczos3PassShader lanczos3Pass;
 #ifdef MKXPZ_SSL
 	XbrzShader xbrz;
 #endif
@@ -0,0 +1,248 @@
+/*
+** shadercache.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shadercache.h"
+#include "debugwriter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* File layout (native endianness, the cache never leaves this machine):
+ *
+ *   char     magic[8]     "MKXPSHC\0"
+ *   uint32_t version
+ *   uint64_t driverHash
+ *
+ * followed by any number of entries:
+ *
+ *   uint64_t key
+ *   uint32_t format
+ *   uint32_t size
+ *   uint8_t  data[size]
+ */
+
+static const char CACHE_MAGIC[8] = { 'M', 'K', 'X', 'P', 'S', 'H', 'C', '\0' };
+static const uint32_t CACHE_VERSION = 1;
+
+/* Sanity limit for a single program binary */
+#define MAX_BINARY_SIZE (16 * 1024 * 1024)
+
+#define READ(ptr, size, n, f) if (fread(ptr, size, n, f) < n) break
+
+static uint64_t driverStringHash()
+{
+	const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+	uint64_t h = ShaderCache::hash(&CACHE_VERSION, sizeof(CACHE_VERSION));
+
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+	{
+		const char *str = (const char*) gl.GetString(names[i]);
+
+		if (str)
+			h = ShaderCache::hash(str, strlen(str) + 1, h);
+	}
+
+	return h;
+}
+
+ShaderCache::ShaderCache()
+    : driverHash(0),
+      rewrite(true),
+      opened(false)
+{}
+
+void ShaderCache::open(const std::string &path)
+{
+	if (opened || !gl.program_binary || path.empty())
+		return;
+
+	this->path = path;
+	driverHash = driverStringHash();
+	opened = true;
+
+	FILE *f = fopen(path.c_str(), "rb");
+
+	if (!f)
+		return;
+
+	char magic[8];
+	uint32_t version;
+	uint64_t fileDriverHash;
+
+	if (fread(magic, sizeof(magic), 1, f) < 1 ||
+	    fread(&version, sizeof(version), 1, f) < 1 ||
+	    fread(&fileDriverHash, sizeof(fileDriverHash), 1, f) < 1 ||
+	    memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+	    version != CACHE_VERSION ||
+	    fileDriverHash != driverHash)
+	{
+		fclose(f);
+		return;
+	}
+
+	bool corrupt = false;
+
+	while (true)
+	{
+		uint64_t key;
+		uint32_t format, size;
+
+		/* Clean end of file */
+		if (fread(&key, sizeof(key), 1, f) < 1)
+			break;
+
+		corrupt = true;
+
+		READ(&format, sizeof(format), 1, f);
+		READ(&size, sizeof(size), 1, f);
+
+		if (size == 0 || size > MAX_BINARY_SIZE)
+			break;
+
+		Entry &e = entries[key];
+		e.format = format;
+		e.data.resize(size);
+
+		READ(&e.data[0], 1, size, f);
+
+		corrupt = false;
+	}
+
+	fclose(f);
+
+	if (corrupt)
+	{
+		Debug() << "Shader cache" << path << "is corrupted, discarding";
+		entries.clear();
+		return;
+	}
+
+	rewrite = false;
+}
+
+bool ShaderCache::isOpen() const
+{
+	return opened;
+}
+
+bool ShaderCache::load(uint64_t key, GLuint program)
+{
+	if (!opened)
+		return false;
+
+	std::unordered_map<uint64_t, Entry>::iterator iter = entries.find(key);
+
+	if (iter == entries.end())
+		return false;
+
+	const Entry &e = iter->second;
+	gl.ProgramBinary(program, e.format, &e.data[0], e.data.size());
+
+	GLint success;
+	gl.GetProgramiv(program, GL_LINK_STATUS, &success);
+
+	if (!success)
+	{
+		/* Rejected by the driver despite matching strings; compile
+		 * from source and make sure the stale entry gets replaced */
+		entries.erase(iter);
+		rewrite = true;
+		return false;
+	}
+
+	return true;
+}
+
+void ShaderCache::store(uint64_t key, GLuint program)
+{
+	if (!opened)
+		return;
+
+	GLint size = 0;
+	gl.GetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+
+	if (size <= 0 || size > MAX_BINARY_SIZE)
+		return;
+
+	Entry &e = entries[key];
+	e.data.resize(size);
+
+	GLsizei length = 0;
+	gl.GetProgramBinary(program, size, &length, &e.format, &e.data[0]);
+
+	if (length <= 0)
+	{
+		entries.erase(key);
+		return;
+	}
+
+	e.data.resize(length);
+
+	/* Appending is enough unless the file has to be
+	 * rebuilt, in which case every entry is written */
+	FILE *f = fopen(path.c_str(), rewrite ? "wb" : "ab");
+
+	if (!f)
+		return;
+
+	bool ok = true;
+
+	if (rewrite)
+	{
+		ok = fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC), 1, f) == 1 &&
+		     fwrite(&CACHE_VERSION, sizeof(CACHE_VERSION), 1, f) == 1 &&
+		     fwrite(&driverHash, sizeof(driverHash), 1, f) == 1;
+	}
+
+	for (std::unordered_map<uint64_t, Entry>::const_iterator iter = entries.begin();
+	     ok && iter != entries.end(); ++iter)
+	{
+		if (!rewrite && iter->first != key)
+			continue;
+
+		const uint32_t format = iter->second.format;
+		const uint32_t entrySize = iter->second.data.size();
+
+		ok = fwrite(&iter->first, sizeof(iter->first), 1, f) == 1 &&
+		     fwrite(&format, sizeof(format), 1, f) == 1 &&
+		     fwrite(&entrySize, sizeof(entrySize), 1, f) == 1 &&
+		     fwrite(&iter->second.data[0], 1, entrySize, f) == entrySize;
+	}
+
+	fclose(f);
+
+	/* A partial write leaves a corrupted tail, which
+	 * the next open() detects and throws away */
+	if (ok)
+		rewrite = false;
+}
+
+uint64_t ShaderCache::hash(const void *data, size_t size, uint64_t seed)
+{
+	const uint8_t *p = (const uint8_t*) data;
+	uint64_t h = seed;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
@@ -0,0 +1,72 @@
+/*
+** shadercache.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include "gl-fun.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* Persistent store of linked program binaries (ARB_get_program_binary).
+ * Entries are keyed by a hash of the full shader sources; the whole
+ * file is tagged with a hash of the driver strings and thrown away
+ * as soon as the driver changes */
+class ShaderCache
+{
+public:
+	ShaderCache();
+
+	/* Reads all entries from 'path'. Does nothing if
+	 * the driver can't hand out program binaries */
+	void open(const std::string &path);
+	bool isOpen() const;
+
+	/* Returns true if 'program' was successfully linked
+	 * from the binary stored under 'key' */
+	bool load(uint64_t key, GLuint program);
+
+	/* Appends the binary of the freshly linked 'program' */
+	void store(uint64_t key, GLuint program);
+
+	/* FNV-1a, chainable through 'seed' */
+	static uint64_t hash(const void *data, size_t size,
+	                     uint64_t seed = 0xcbf29ce484222325ULL);
+
+private:
+	struct Entry
+	{
+		GLenum format;
+		std::vector<uint8_t> data;
+	};
+
+	std::unordered_map<uint64_t, Entry> entries;
+	std::string path;
+	uint64_t driverHash;
+
+	/* Set if the file on disk is missing, corrupted
+	 * or stale and has to be rewritten on first store */
+	bool rewrite;
+	bool opened;
+};
+
+#endif // SHADERCACHE_H
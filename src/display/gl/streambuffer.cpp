@@ -0,0 +1,334 @@
+/*
+** streambuffer.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "streambuffer.h"
+
+#include "sharedstate.h"
+#include "global-ibo.h"
+
+#include <string.h>
+
+#define STREAM_BUFFER_INITIAL_SIZE (4 * 1024 * 1024)
+#define STREAM_BUFFER_MAX_SIZE (64 * 1024 * 1024)
+
+/* Most quads one draw can address from the current attribute
+ * base, bounded by the 16 bit global index buffer */
+#define STREAM_MAX_QUADS (INDEX_T_MAX / 6)
+
+/* Expects 'vao.vbo' to be set up by allocate() */
+static void initVAO(GLMeta::VAO &vao, IBO::ID ibo)
+{
+	vao.ibo = ibo;
+	vao.base = 0;
+
+	GLMeta::vaoInit(vao);
+}
+
+StreamBuffer::StreamBuffer(IBO::ID ibo)
+    : vbo(VBO::ID(0)),
+      capacity(0),
+      persistent(false),
+      mapped(0),
+      writePos(0),
+      resetPos(0),
+      freePos(0),
+      pendingReadPos(UINT64_MAX),
+      overflowed(false)
+{
+	GLMeta::vaoFillInVertexData<SVertex>(simpleVAO);
+	GLMeta::vaoFillInVertexData<CVertex>(colorVAO);
+	GLMeta::vaoFillInVertexData<Vertex>(vertexVAO);
+
+	allocate(STREAM_BUFFER_INITIAL_SIZE);
+
+	initVAO(simpleVAO, ibo);
+	initVAO(colorVAO, ibo);
+	initVAO(vertexVAO, ibo);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	release();
+
+	GLMeta::vaoFini(simpleVAO);
+	GLMeta::vaoFini(colorVAO);
+	GLMeta::vaoFini(vertexVAO);
+}
+
+StreamRange StreamBuffer::upload(const void *data, GLsizeiptr size, GLsizeiptr align)
+{
+	if (size <= 0)
+		return StreamRange();
+
+	if (size > capacity)
+	{
+		GLsizeiptr newCapacity = capacity;
+
+		while (newCapacity < size)
+			newCapacity *= 2;
+
+		allocate(newCapacity);
+	}
+
+	GLintptr offset = writePos % capacity;
+	GLintptr aligned = (offset + align - 1) / align * align;
+	uint64_t pos = writePos + (aligned - offset);
+
+	/* Doesn't fit at the end, skip to the start of the ring */
+	if (aligned + size > capacity)
+	{
+		pos = writePos + (capacity - offset);
+		aligned = 0;
+	}
+
+	if (persistent)
+	{
+		waitFor(size, pos);
+		memcpy(mapped + aligned, data, size);
+	}
+	else
+	{
+		VBO::bind(vbo);
+
+		/* Starting a new lap; give the old storage to the
+		 * driver instead of writing over pending draws */
+		if (aligned == 0 && writePos > resetPos)
+		{
+			VBO::allocEmpty(capacity, GL_STREAM_DRAW);
+			resetPos = pos;
+
+			if (++frameStats.orphans > 1)
+				overflowed = true;
+		}
+
+		VBO::uploadSubData(aligned, size, data);
+		VBO::unbind();
+	}
+
+	writePos = pos + size;
+
+	frameStats.bytes += size;
+	frameStats.uploads++;
+
+	StreamRange range;
+	range.pos = pos;
+	range.offset = aligned;
+	range.size = size;
+
+	return range;
+}
+
+void StreamBuffer::drawQuads(GLMeta::VAO &vao, GLsizeiptr quadBytes,
+                             GLintptr offset, size_t count)
+{
+	if (count == 0)
+		return;
+
+	/* Only re-point the attributes when the quads can't be
+	 * reached through the index buffer from the current base */
+	const GLintptr rel = offset - vao.base;
+	size_t first = rel / quadBytes;
+	bool rebase = false;
+
+	if (vao.base < 0 || rel < 0 || rel % quadBytes != 0
+	    || first + count > STREAM_MAX_QUADS)
+	{
+		first = 0;
+		rebase = true;
+	}
+
+	shState->ensureQuadIBO(first + count);
+
+	if (rebase)
+		GLMeta::vaoRebase(vao, offset);
+	else
+		GLMeta::vaoBind(vao);
+
+	const char *indices = (const char*) 0 + first * 6 * sizeof(index_t);
+	gl.DrawElements(GL_TRIANGLES, count * 6, _GL_INDEX_TYPE, indices);
+
+	GLMeta::vaoUnbind(vao);
+}
+
+void StreamBuffer::endFrame()
+{
+	if (persistent)
+	{
+		const uint64_t fencedPos = fences.empty() ? freePos : fences.back().pos;
+
+		if (writePos > fencedPos || pendingReadPos != UINT64_MAX)
+			pushFence();
+
+		/* Retire whatever the GPU is already done with */
+		while (!fences.empty())
+		{
+			GLenum status = gl.ClientWaitSync(fences.front().sync, 0, 0);
+
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+
+			gl.DeleteSync(fences.front().sync);
+			freePos = fences.front().pos;
+			fences.pop_front();
+		}
+	}
+
+	if (overflowed && capacity < STREAM_BUFFER_MAX_SIZE)
+		allocate(capacity * 2);
+
+	overflowed = false;
+
+	frameStats.capacity = capacity;
+	frameStats.persistent = persistent;
+
+	lastStats = frameStats;
+	frameStats = Stats();
+}
+
+void StreamBuffer::allocate(GLsizeiptr size)
+{
+	release();
+
+	vbo = VBO::gen();
+	VBO::bind(vbo);
+
+	capacity = size;
+	persistent = false;
+	mapped = 0;
+
+	if (gl.buffer_storage)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		gl.BufferStorage(GL_ARRAY_BUFFER, size, 0, flags);
+		mapped = (uint8_t*) gl.MapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+		persistent = (mapped != 0);
+
+		if (!persistent)
+		{
+			/* Immutable storage can't be respecified */
+			VBO::del(vbo);
+			vbo = VBO::gen();
+			VBO::bind(vbo);
+		}
+	}
+
+	if (!persistent)
+		VBO::allocEmpty(size, GL_STREAM_DRAW);
+
+	VBO::unbind();
+
+	/* Nothing of the old storage carries over */
+	resetPos = freePos = writePos;
+	pendingReadPos = UINT64_MAX;
+
+	GLMeta::VAO *vaos[] = { &simpleVAO, &colorVAO, &vertexVAO };
+
+	for (size_t i = 0; i < sizeof(vaos) / sizeof(vaos[0]); ++i)
+	{
+		vaos[i]->vbo = vbo;
+		vaos[i]->base = -1;
+	}
+}
+
+void StreamBuffer::release()
+{
+	for (size_t i = 0; i < fences.size(); ++i)
+		gl.DeleteSync(fences[i].sync);
+
+	fences.clear();
+
+	if (vbo == VBO::ID(0))
+		return;
+
+	if (mapped)
+	{
+		VBO::bind(vbo);
+		gl.UnmapBuffer(GL_ARRAY_BUFFER);
+		VBO::unbind();
+
+		mapped = 0;
+	}
+
+	VBO::del(vbo);
+	vbo = VBO::ID(0);
+}
+
+void StreamBuffer::pushFence()
+{
+	Fence fence = { gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+	                writePos, pendingReadPos };
+	fences.push_back(fence);
+
+	pendingReadPos = UINT64_MAX;
+}
+
+uint64_t StreamBuffer::inUseFrom() const
+{
+	uint64_t pos = freePos < pendingReadPos ? freePos : pendingReadPos;
+
+	for (size_t i = 0; i < fences.size(); ++i)
+		if (fences[i].readPos < pos)
+			pos = fences[i].readPos;
+
+	return pos;
+}
+
+void StreamBuffer::waitFor(GLsizeiptr size, uint64_t pos)
+{
+	/* The bytes being overwritten were last written one lap
+	 * ago; after a skip to the start of the ring, part of that
+	 * lap lies beyond writePos and was never written at all */
+	const uint64_t end = pos + size;
+	uint64_t overwrites = end > (uint64_t) capacity ? end - capacity : 0;
+
+	if (overwrites > writePos)
+		overwrites = writePos;
+
+	while (overwrites > inUseFrom())
+	{
+		if (fences.empty())
+		{
+			/* Wrapping over draws of this very frame */
+			pushFence();
+
+			overflowed = true;
+		}
+
+		waitFence(fences.front());
+		freePos = fences.front().pos;
+		fences.pop_front();
+	}
+}
+
+void StreamBuffer::waitFence(Fence &fence)
+{
+	GLenum status = gl.ClientWaitSync(fence.sync, 0, 0);
+
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		frameStats.waits++;
+
+		do
+			status = gl.ClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+		while (status == GL_TIMEOUT_EXPIRED);
+	}
+
+	gl.DeleteSync(fence.sync);
+}
@@ -0,0 +1,175 @@
+/*
+** streambuffer.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include "gl-fun.h"
+#include "gl-util.h"
+#include "gl-meta.h"
+#include "vertex.h"
+
+#include <stdint.h>
+#include <deque>
+
+/* Where an upload ended up in the stream */
+struct StreamRange
+{
+	/* Absolute stream position, see StreamBuffer::isValid() */
+	uint64_t pos;
+	GLintptr offset;
+	GLsizeiptr size;
+
+	StreamRange()
+	    : pos(0), offset(0), size(0)
+	{}
+};
+
+/* One ring buffer shared by all dynamic quad geometry (Quad,
+ * QuadArray, FlashMap). Uploads are appended behind each other, so
+ * consecutive draws neither switch buffer objects nor write into
+ * storage the GPU may still be reading from.
+ *
+ * Where buffer storage and fences are available, the ring is mapped
+ * persistently and written with memcpy; a fence per frame tells when
+ * a region may be reused. Elsewhere, it is filled with BufferSubData
+ * and orphaned every time it wraps around.
+ *
+ * Data stays in place until the ring wraps over it, so geometry that
+ * didn't change may keep drawing from its old range as long as
+ * isValid() says so. Such re-draws are tracked like fresh uploads:
+ * the ring doesn't wrap over them before a fence after them retired */
+class StreamBuffer
+{
+public:
+	struct Stats
+	{
+		/* Totals of the last finished frame */
+		uint64_t bytes;
+		unsigned uploads;
+		unsigned waits;
+		unsigned orphans;
+
+		GLsizeiptr capacity;
+		bool persistent;
+
+		Stats()
+		    : bytes(0), uploads(0), waits(0), orphans(0),
+		      capacity(0), persistent(false)
+		{}
+	};
+
+	StreamBuffer(IBO::ID ibo);
+	~StreamBuffer();
+
+	template<class VertexType>
+	StreamRange upload(const VertexType *vert, size_t quadCount)
+	{
+		const GLsizeiptr quadBytes = sizeof(VertexType) * 4;
+
+		return upload(vert, quadBytes * quadCount, quadBytes);
+	}
+
+	/* Whether 'range' still holds what was uploaded into it */
+	bool isValid(const StreamRange &range) const
+	{
+		return range.size > 0 && range.pos >= validFrom();
+	}
+
+	/* Draws 'count' quads starting at quad 'first' of 'range' */
+	template<class VertexType>
+	void draw(const StreamRange &range, size_t first, size_t count)
+	{
+		const GLsizeiptr quadBytes = sizeof(VertexType) * 4;
+
+		if (range.pos < pendingReadPos)
+			pendingReadPos = range.pos;
+
+		drawQuads(vaoFor((const VertexType*) 0), quadBytes,
+		          range.offset + first * quadBytes, count);
+	}
+
+	/* Call once per presented frame */
+	void endFrame();
+
+	const Stats &stats() const { return lastStats; }
+
+private:
+	struct Fence
+	{
+		_GLsync sync;
+		/* Write position when the fence was set */
+		uint64_t pos;
+		/* Lowest position drawn from since the previous fence */
+		uint64_t readPos;
+	};
+
+	StreamRange upload(const void *data, GLsizeiptr size, GLsizeiptr align);
+	void drawQuads(GLMeta::VAO &vao, GLsizeiptr quadBytes,
+	               GLintptr offset, size_t count);
+
+	void allocate(GLsizeiptr size);
+	void release();
+
+	void pushFence();
+	uint64_t inUseFrom() const;
+	void waitFor(GLsizeiptr size, uint64_t pos);
+	void waitFence(Fence &fence);
+
+	uint64_t validFrom() const
+	{
+		const uint64_t wrapped = writePos > (uint64_t) capacity
+		                       ? writePos - capacity : 0;
+
+		return wrapped > resetPos ? wrapped : resetPos;
+	}
+
+	GLMeta::VAO &vaoFor(const SVertex*) { return simpleVAO; }
+	GLMeta::VAO &vaoFor(const CVertex*) { return colorVAO; }
+	GLMeta::VAO &vaoFor(const Vertex*)  { return vertexVAO; }
+
+	VBO::ID vbo;
+	GLsizeiptr capacity;
+	bool persistent;
+	uint8_t *mapped;
+
+	/* Absolute positions; the buffer offset is pos % capacity */
+	uint64_t writePos;
+	/* Everything before this is gone (orphaned / reallocated) */
+	uint64_t resetPos;
+	/* Everything before this is no longer read by the GPU,
+	 * except for what later draws picked up again */
+	uint64_t freePos;
+	/* Lowest position drawn from since the last fence */
+	uint64_t pendingReadPos;
+
+	std::deque<Fence> fences;
+
+	/* The ring turned out too small for one frame */
+	bool overflowed;
+
+	GLMeta::VAO simpleVAO;
+	GLMeta::VAO colorVAO;
+	GLMeta::VAO vertexVAO;
+
+	Stats frameStats;
+	Stats lastStats;
+};
+
+#endif // STREAMBUFFER_H
@@ -23,6 +23,7 @@
 
 #include "alstream.h"
 #include "audio.h"
+#include "audioqueue.h"
 #include "binding.h"
 #include "bitmap.h"
 #include "config.h"
@@ -32,17 +33,23 @@
 #include "etc-internal.h"
 #include "eventthread.h"
 #include "filesystem.h"
+#include "font.h"
+#include "framecapture.h"
 #include "gl-fun.h"
 #include "gl-util.h"
 #include "glstate.h"
 #include "intrulist.h"
 #include "quad.h"
+#include "scalerchain.h"
+#include "streambuffer.h"
 #include "scene.h"
 #include "shader.h"
 #include "sharedstate.h"
 #include "texpool.h"
+#include "profiler.h"
 #include "theoraplay/theoraplay.h"
 #include "util.h"
+#include "trace.h"
 #include "input.h"
 #include "sprite.h"
 
@@ -52,6 +59,7 @@
 #include <SDL_video.h>
 #include <SDL_mutex.h>
 #include <SDL_thread.h>
+#include <SDL_ttf.h>
 
 #ifdef MKXPZ_STEAM
 #include "steamshim_child.h"
@@ -64,6 +72,7 @@
 #include <time.h>
 #include <cmath>
 #include <climits>
+#include <map>
 
 
 #define DEF_SCREEN_W (rgssVer == 1 ? 640 : 544)
@@ -73,15 +82,14 @@
 
 #define DEF_MAX_VIDEO_FRAMES 30
 #define VIDEO_DELAY 10
+#define VIDEO_PLANES 3
+#define VIDEO_PBOS 2
+#define VIDEO_SYNC_TOLERANCE 15
 #define MOVIE_AUDIO_BUFFER_SIZE 2048
+#define MOVIE_AUDIO_PACKETS 256
 #define AUDIO_BUFFER_LEN_MS 2000
 
-typedef struct AudioQueue
-{
-    const THEORAPLAY_AudioPacket *audio;
-    int offset;
-    struct AudioQueue *next;
-} AudioQueue;
+typedef AudioQueueItem<THEORAPLAY_AudioPacket> MovieAudioItem;
 
 
 static long readMovie(THEORAPLAY_Io *io, void *buf, long buflen)
@@ -108,18 +116,34 @@ struct Movie
     bool hasAudio;
     bool skippable;
     Bitmap *videoBitmap;
+    TEX::ID videoPlanes[VIDEO_PLANES];
+    PBO::ID videoPBOs[VIDEO_PBOS];
+    int videoPBOIndex;
+    Uint32 baseTicks;
     SDL_RWops srcOps;
     SDL_Thread *audioThread;
     AtomicFlag audioThreadTermReq;
-    volatile AudioQueue *audioQueueHead;
-    volatile AudioQueue *audioQueueTail;
+    // Filled by the video loop, drained by the audio thread
+    SPSCRing<MovieAudioItem, MOVIE_AUDIO_PACKETS> audioQueue;
     ALuint audioSource;
     ALuint alBuffers[STREAM_BUFS];
     ALshort audioBuffer[MOVIE_AUDIO_BUFFER_SIZE];
-    SDL_mutex *audioMutex;
+    
+    /* Audio clock; frame counts are only touched by the audio thread,
+     * the published position is read by the video loop */
+    int audioFreq;
+    Uint32 audioStartMs;
+    Uint64 audioFramesDone;
+    SDL_SpinLock audioClockLock;
+    Uint32 audioClockMs;
+    Uint32 audioClockTicks;
+    bool audioClockValid;
     
     Movie(bool skippable_)
-    : decoder(0), audio(0), video(0), skippable(skippable_), videoBitmap(0), audioThread(0)
+    : decoder(0), audio(0), video(0), skippable(skippable_), videoBitmap(0),
+      videoPBOIndex(0), baseTicks(0), audioThread(0), audioSource(0), audioFreq(0), audioStartMs(0),
+      audioFramesDone(0), audioClockLock(0), audioClockMs(0), audioClockTicks(0),
+      audioClockValid(false)
     {
     }
     bool preparePlayback()
@@ -136,7 +160,8 @@ struct Movie
         io->read = readMovie;
         io->close = closeMovie;
         io->userdata = &srcOps;
-        decoder = THEORAPLAY_startDecode(io, DEF_MAX_VIDEO_FRAMES, THEORAPLAY_VIDFMT_RGBA);
+        // Frames stay planar Y'CbCr, they are converted on the GPU
+        decoder = THEORAPLAY_startDecode(io, DEF_MAX_VIDEO_FRAMES, THEORAPLAY_VIDFMT_IYUV);
         if (!decoder) {
             SDL_RWclose(&srcOps);
             return false;
@@ -182,121 +207,260 @@ struct Movie
         // Create this Bitmap without a hires replacement, because we don't
         // support hires replacement for Movies yet.
         videoBitmap = new Bitmap(video->width, video->height, true);
-        audioQueueHead = NULL;
-        audioQueueTail = NULL;
+        
+        initVideoPlanes(video->width, video->height);
         
         return true;
     }
     
-    void queueAudioPacket(const THEORAPLAY_AudioPacket *audio) {
-        AudioQueue *item = NULL;
+    static Vec2i planeSize(int plane, int width, int height)
+    {
+        return plane == 0 ? Vec2i(width, height) : Vec2i(width / 2, height / 2);
+    }
+    
+    void initVideoPlanes(int width, int height)
+    {
+        for (int i = 0; i < VIDEO_PLANES; ++i)
+        {
+            const Vec2i size = planeSize(i, width, height);
+            
+            videoPlanes[i] = TEX::gen();
+            TEX::bind(videoPlanes[i]);
+            TEX::setRepeat(false);
+            gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            gl.TexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, size.x, size.y, 0,
+                          GL_LUMINANCE, GL_UNSIGNED_BYTE, 0);
+        }
         
-        if (!audio) {
+        TEX::unbind();
+        
+        if (!gl.pixel_buffer)
             return;
+        
+        const Vec2i chroma = planeSize(1, width, height);
+        const GLsizeiptr frameSize = width * height + chroma.x * chroma.y * 2;
+        
+        for (int i = 0; i < VIDEO_PBOS; ++i)
+        {
+            videoPBOs[i] = PBO::gen();
+            PBO::bind(videoPBOs[i]);
+            PBO::allocEmpty(frameSize, GL_STREAM_DRAW);
         }
         
-        item = (AudioQueue *) malloc(sizeof (AudioQueue));
-        if (!item) {
-            THEORAPLAY_freeAudio(audio);
-            return;  // oh well.
+        PBO::unbind();
+    }
+    
+    void finiVideoPlanes()
+    {
+        for (int i = 0; i < VIDEO_PLANES; ++i)
+            if (videoPlanes[i].gl)
+                TEX::del(videoPlanes[i]);
+        
+        for (int i = 0; i < VIDEO_PBOS; ++i)
+            if (videoPBOs[i].gl)
+                PBO::del(videoPBOs[i]);
+    }
+    
+    void uploadVideoFrame(const THEORAPLAY_VideoFrame *frame)
+    {
+        const int w = frame->width;
+        const int h = frame->height;
+        const Vec2i chroma = planeSize(1, w, h);
+        const size_t planeOffsets[VIDEO_PLANES] =
+        {
+            0,
+            (size_t) (w * h),
+            (size_t) (w * h + chroma.x * chroma.y)
+        };
+        const size_t frameSize = planeOffsets[2] + chroma.x * chroma.y;
+        
+        bool usePBO = false;
+        
+        if (gl.pixel_buffer)
+        {
+            /* Alternate between two unpack buffers so the copy into this
+             * frame's buffer doesn't wait on the previous frame's transfer */
+            PBO::bind(videoPBOs[videoPBOIndex]);
+            videoPBOIndex = (videoPBOIndex + 1) % VIDEO_PBOS;
+            
+            void *dst = gl.MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize,
+                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (dst)
+            {
+                memcpy(dst, frame->pixels, frameSize);
+                gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                usePBO = true;
+            }
+            else
+            {
+                PBO::unbind();
+            }
         }
         
-        item->audio = audio;
-        item->offset = 0;
-        item->next = NULL;
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 1);
         
-        SDL_LockMutex(audioMutex);
-        if (audioQueueTail) {
-            audioQueueTail->next = item;
-        } else {
-            audioQueueHead = item;
+        for (int i = 0; i < VIDEO_PLANES; ++i)
+        {
+            const Vec2i size = planeSize(i, w, h);
+            
+            /* With a bound unpack buffer, the data pointer is an offset into it */
+            const GLvoid *data = usePBO ? (const GLvoid*) (uintptr_t) planeOffsets[i]
+                                        : frame->pixels + planeOffsets[i];
+            
+            TEX::bind(videoPlanes[i]);
+            gl.TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
+                             GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
         }
-        audioQueueTail = item;
-        SDL_UnlockMutex(audioMutex);
+        
+        gl.PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        
+        if (usePBO)
+            PBO::unbind();
+        
+        /* Convert into the bitmap the movie sprite displays */
+        TEXFBO &target = videoBitmap->getGLTypes();
+        
+        YUVShader &shader = shState->shaders().yuv;
+        shader.bind();
+        shader.setPlanes(videoPlanes[0], videoPlanes[1], videoPlanes[2]);
+        shader.setTexSize(Vec2i(w, h));
+        shader.setTranslation(Vec2i());
+        
+        Quad &quad = shState->gpQuad();
+        FloatRect rect(0, 0, w, h);
+        quad.setTexPosRect(rect, rect);
+        quad.setColor(Vec4(1, 1, 1, 1));
+        
+        FBO::bind(target.fbo);
+        glState.viewport.pushSet(IntRect(0, 0, w, h));
+        shader.applyViewportProj();
+        glState.blend.pushSet(false);
+        
+        quad.draw();
+        
+        glState.blend.pop();
+        glState.viewport.pop();
+        
+        TEX::unbind();
+        
+        videoBitmap->taintArea(IntRect(0, 0, w, h));
+        videoBitmap->markModified();
     }
     
-    void bufferMovieAudio(THEORAPLAY_Decoder *decoder, const Uint32 now) {
-        const THEORAPLAY_AudioPacket *audio;
-        while ((audio = THEORAPLAY_getAudio(decoder)) != NULL) {
-            queueAudioPacket(audio);
-            if (audio->playms >= now + AUDIO_BUFFER_LEN_MS) {  // don't let this get too far ahead.
+    // Hands decoded packets to the audio thread. A packet that doesn't
+    // fit into the queue stays pending in 'audio' until the next call
+    void bufferMovieAudio(const Uint32 now) {
+        while (!audioQueue.full()) {
+            if (!audio) {
+                audio = THEORAPLAY_getAudio(decoder);
+            }
+            
+            if (!audio) {
+                break;
+            }
+            
+            const MovieAudioItem item = { audio, 0 };
+            const Uint32 playms = audio->playms;
+            audioQueue.push(item);
+            audio = NULL;
+            
+            if (playms >= now + AUDIO_BUFFER_LEN_MS) {  // don't let this get too far ahead.
                 break;
             }
         }
     }
 
+    // Audio thread: convert queued packets into 'audioBuffer',
+    // returns the number of samples written
+    size_t fillAudioBuffer(int &channels, int &sampleRate) {
+        return drainAudioQueue(audioQueue, audioBuffer, MOVIE_AUDIO_BUFFER_SIZE,
+                               channels, sampleRate, THEORAPLAY_freeAudio);
+    }
+
     void streamMovieAudio(){
+        Trace::setThreadName("movieaudio");
+        
+        ALuint freeBufs[STREAM_BUFS];
+        ALint freeCount = STREAM_BUFS;
         ALint state = 0;
-        ALint procBufs = STREAM_BUFS;	    
-        volatile AudioQueue *audioPacketAndOffset;
+        ALint procBufs = 0;
         int channels;
         int sampleRate;
-        float *sourceSamples;
-        ALuint samplesToProcess;
-        ALshort *sampleBuffer;
-        ALuint remainingSamples;
-
-        while(true) {
-            while(procBufs--) {
-                // Quit if audio thread terminate request has been made
-                if (audioThreadTermReq) return;
-
-                remainingSamples = MOVIE_AUDIO_BUFFER_SIZE;
-                sampleBuffer = audioBuffer;
-                SDL_LockMutex(audioMutex);
-
-                while(audioQueueHead && (remainingSamples > 0)) {
-                    audioPacketAndOffset = audioQueueHead;
-                    channels = audioPacketAndOffset->audio->channels;
-                    sampleRate = audioPacketAndOffset->audio->freq;
-                    sourceSamples = audioPacketAndOffset->audio->samples + (audioPacketAndOffset->offset * channels);
-                    samplesToProcess = (audioPacketAndOffset->audio->frames - audioPacketAndOffset->offset) * channels;
-
-                    if (samplesToProcess > remainingSamples) samplesToProcess = remainingSamples;
-
-                    for (ALuint i = 0; i < samplesToProcess; i++) {
-                        const float val = (*(sourceSamples++));
-                        if (val < -1.0f) {
-                            *(sampleBuffer++) = SHRT_MIN;
-                        } else if (val > 1.0f) {
-                            *(sampleBuffer++) = SHRT_MAX;
-                        } else {
-                            *(sampleBuffer++) = (ALshort) (val * SHRT_MAX);
-                        }
-                    }
 
-                    // Necessary to remember position between repeated iterations
-                    audioPacketAndOffset->offset += (samplesToProcess / channels);
-                    remainingSamples -= samplesToProcess;
+        memcpy(freeBufs, alBuffers, sizeof(freeBufs));
 
-                    // The current audio packet has been completed
-                    if ((audioPacketAndOffset->offset) >= audioPacketAndOffset->audio->frames) {
-                        audioQueueHead = audioPacketAndOffset->next;
-                        THEORAPLAY_freeAudio(audioPacketAndOffset->audio);
-                        free((void *) audioPacketAndOffset);
-                    }
-                }
+        // Quit if audio thread terminate request has been made
+        while (!audioThreadTermReq) {
+            // Refill every free buffer there are samples for
+            while (freeCount > 0) {
+                TRACE_SCOPE("movie audio refill");
+                const size_t samples = fillAudioBuffer(channels, sampleRate);
+                if (!samples) break;
 
-                if(!audioQueueHead) audioQueueTail = NULL;
+                ALuint buffer = freeBufs[--freeCount];
+                alBufferData(buffer, channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, audioBuffer,
+                    samples * sizeof(ALshort), sampleRate);
+                alSourceQueueBuffers(audioSource, 1, &buffer);
+            }
 
-                SDL_UnlockMutex(audioMutex);
+            alGetSourcei(audioSource, AL_SOURCE_STATE, &state);
+            if (state != AL_PLAYING && freeCount < STREAM_BUFS) alSourcePlay(audioSource);
 
-                alBufferData(alBuffers[procBufs], channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, audioBuffer,
-                    (MOVIE_AUDIO_BUFFER_SIZE - remainingSamples) * sizeof(ALshort), sampleRate);
-                alSourceQueueBuffers(audioSource, 1, &alBuffers[procBufs]);     
-                alGetSourcei(audioSource, AL_SOURCE_STATE, &state);
-                if(state != AL_PLAYING) alSourcePlay(audioSource);
-            }
+            updateAudioClock();
 
-            // Periodically check the buffers until one is available
-            while(true) {
-                alGetSourcei(audioSource, AL_BUFFERS_PROCESSED, &procBufs);
-                if(procBufs > 0) break;
+            alGetSourcei(audioSource, AL_BUFFERS_PROCESSED, &procBufs);
+            if (procBufs <= 0) {
+                // Nothing to refill yet, check again later
                 SDL_Delay(AUDIO_SLEEP);
+                continue;
             }
-            alSourceUnqueueBuffers(audioSource, procBufs, alBuffers);
+
+            alSourceUnqueueBuffers(audioSource, procBufs, freeBufs + freeCount);
+
+            for (ALint i = 0; i < procBufs; ++i) {
+                ALint size, bits, bufChannels;
+                alGetBufferi(freeBufs[freeCount + i], AL_SIZE, &size);
+                alGetBufferi(freeBufs[freeCount + i], AL_BITS, &bits);
+                alGetBufferi(freeBufs[freeCount + i], AL_CHANNELS, &bufChannels);
+                if (bits > 0 && bufChannels > 0)
+                    audioFramesDone += size / (bufChannels * (bits / 8));
+            }
+            freeCount += procBufs;
         }
     }
+
+    // Audio thread: publish the position the listener is currently hearing
+    void updateAudioClock() {
+        if (!audioFreq) return;
+
+        ALint state = 0, offset = 0;
+        alGetSourcei(audioSource, AL_SOURCE_STATE, &state);
+        alGetSourcei(audioSource, AL_SAMPLE_OFFSET, &offset);
+
+        const Uint32 ms = audioStartMs + (Uint32) ((audioFramesDone + offset) * 1000 / audioFreq);
+
+        SDL_AtomicLock(&audioClockLock);
+        audioClockMs = ms;
+        audioClockTicks = SDL_GetTicks();
+        audioClockValid = (state == AL_PLAYING);
+        SDL_AtomicUnlock(&audioClockLock);
+    }
+
+    // Video thread: re-anchor the playback timer to the audio clock
+    // whenever the two have drifted apart noticeably
+    void syncToAudioClock() {
+        SDL_AtomicLock(&audioClockLock);
+        const bool valid = audioClockValid;
+        const Uint32 clockBase = audioClockTicks - audioClockMs;
+        SDL_AtomicUnlock(&audioClockLock);
+
+        if (!valid) return;
+
+        const Sint32 drift = (Sint32) (clockBase - baseTicks);
+        if (drift > VIDEO_SYNC_TOLERANCE || drift < -VIDEO_SYNC_TOLERANCE)
+            baseTicks = clockBase;
+    }
     
     bool startAudio(float volume)
     {
@@ -305,19 +469,18 @@ struct Movie
         alSourcef(audioSource, AL_GAIN, volume);
 
         audioThreadTermReq.clear();
-        audioMutex = SDL_CreateMutex();
-        queueAudioPacket(audio);
-        audio = NULL;
-        bufferMovieAudio(decoder, 0);
+        audioStartMs = audio->playms;
+        audioFreq = audio->freq;
+        bufferMovieAudio(0);
         audioThread = createSDLThread <Movie, &Movie::streamMovieAudio>(this, "movieaudio");
 
-        return true;
+        return audioThread != 0;
     }
     
     void play(float volume)
     {
         Uint32 frameMs = 0;
-        Uint32 baseTicks = SDL_GetTicks();
+        baseTicks = SDL_GetTicks();
         bool openedAudio = false;
         while (THEORAPLAY_isDecoding(decoder)) {
             // Check for reset/shutdown input
@@ -329,6 +492,10 @@ struct Movie
                 if  (shState->input().isTriggered(Input::Action) || shState->input().isTriggered(Input::Cancel)) break;
             }
             
+            if (openedAudio) {
+                syncToAudioClock();
+            }
+            
             const Uint32 now = SDL_GetTicks() - baseTicks;
             
             if (!video) {
@@ -375,35 +542,31 @@ struct Movie
                 }
 
                 // Got a video frame, now draw it
-                videoBitmap->replaceRaw(video->pixels, video->width * video->height * 4);
+                {
+                    TRACE_SCOPE("movie frame upload");
+                    uploadVideoFrame(video);
+                }
                 shState->graphics().update(false);
                 THEORAPLAY_freeVideo(video);
                 video = NULL;
 
             } else {
-                // Next video frame not yet ready, let the CPU breathe
-                SDL_Delay(VIDEO_DELAY);
+                // Sleep until the next frame is due, but wake up regularly
+                // enough to keep polling input and feeding the audio queue
+                Uint32 wait = VIDEO_DELAY;
+                if (video) wait = std::min<Uint32>(video->playms - now, VIDEO_DELAY);
+                SDL_Delay(std::max<Uint32>(wait, 1));
             }
             
             if (openedAudio) {
-                bufferMovieAudio(decoder, now);
+                bufferMovieAudio(now);
             }
         }
     }
     
     ~Movie()
     {
-        if (hasAudio) {
-            if (audioQueueTail) {
-                THEORAPLAY_freeAudio(audioQueueTail->audio);
-            }
-            audioQueueTail = NULL;
-            
-            if (audioQueueHead) {
-                THEORAPLAY_freeAudio(audioQueueHead->audio);
-            }
-            audioQueueHead = NULL;
-            SDL_DestroyMutex(audioMutex);
+        if (audioSource) {
             audioThreadTermReq.set();
             if(audioThread) {
                 SDL_WaitThread(audioThread, 0);
@@ -413,9 +576,15 @@ struct Movie
             alDeleteSources(1, &audioSource);
             alDeleteBuffers(STREAM_BUFS, alBuffers);
         }
+        // The audio thread is gone, so it's safe to drain from here
+        while (MovieAudioItem *item = audioQueue.front()) {
+            THEORAPLAY_freeAudio(item->audio);
+            audioQueue.pop();
+        }
         if (video) THEORAPLAY_freeVideo(video);
         if (audio) THEORAPLAY_freeAudio(audio);
         if (decoder) THEORAPLAY_stopDecode(decoder);
+        finiVideoPlanes();
         delete videoBitmap;
     }
 };
@@ -492,6 +661,122 @@ private:
     void bind() { FBO::bind(rt[dstInd].fbo); }
 };
 
+/* Profiler report drawn on top of the game screen. The text is
+ * only re-rendered when the profiler publishes new averages */
+struct ProfileOverlay {
+    TEX::ID tex;
+    Vec2i size;
+    Quad quad;
+    unsigned generation;
+    bool visible;
+    
+    ProfileOverlay() : tex(0), generation(0), visible(false) {}
+    
+    ~ProfileOverlay() {
+        if (tex != TEX::ID(0))
+            TEX::del(tex);
+    }
+    
+    void update(const Profiler &profiler) {
+        if (!visible || generation == profiler.generation())
+            return;
+        
+        generation = profiler.generation();
+        
+        static const int lineH = 14;
+        static const int colX[] = { 4, 150, 210, 270 };
+        
+        TTF_Font *font = shState->fontState().getFont("", 12);
+        
+        int lines = 2;
+        for (int i = 0; i < Profiler::SectionCount; ++i)
+            if (profiler.stats(i).calls > 0)
+                ++lines;
+        
+        size = Vec2i(280, lines * lineH + 4);
+        
+        SDL_Surface *surf =
+        SDL_CreateRGBSurfaceWithFormat(0, size.x, size.y, 32, SDL_PIXELFORMAT_ABGR8888);
+        
+        if (!surf)
+            return;
+        
+        SDL_FillRect(surf, 0, SDL_MapRGBA(surf->format, 0, 0, 0, 176));
+        
+        int y = 2;
+        char buf[64];
+        
+        /* Columns are right aligned to their x, except the first */
+        auto put = [&](int col, const char *str) {
+            SDL_Color c = { 255, 255, 255, 255 };
+            SDL_Surface *txt = TTF_RenderUTF8_Blended(font, str, c);
+            
+            if (!txt)
+                return;
+            
+            SDL_Rect dst = { col == 0 ? colX[0] : colX[col] - txt->w, y, 0, 0 };
+            SDL_BlitSurface(txt, 0, surf, &dst);
+            SDL_FreeSurface(txt);
+        };
+        
+        snprintf(buf, sizeof(buf), "frame %.2f ms", profiler.frameMs());
+        put(0, buf);
+        put(1, "calls");
+        put(2, "cpu ms");
+        put(3, profiler.hasGpuTimer() ? "gpu ms" : "gpu n/a");
+        y += lineH;
+        
+        for (int i = 0; i < Profiler::SectionCount; ++i) {
+            const Profiler::Stats &st = profiler.stats(i);
+            
+            if (st.calls <= 0)
+                continue;
+            
+            put(0, Profiler::sectionName(i));
+            snprintf(buf, sizeof(buf), "%.1f", st.calls);
+            put(1, buf);
+            snprintf(buf, sizeof(buf), "%.2f", st.cpuMs);
+            put(2, buf);
+            snprintf(buf, sizeof(buf), "%.2f", st.gpuMs);
+            put(3, buf);
+            y += lineH;
+        }
+        
+        if (tex == TEX::ID(0)) {
+            tex = TEX::gen();
+            TEX::bind(tex);
+            TEX::setRepeat(false);
+            TEX::setSmooth(false);
+        }
+        else {
+            TEX::bind(tex);
+        }
+        
+        TEX::uploadImage(size.x, size.y, surf->pixels, GL_RGBA);
+        SDL_FreeSurface(surf);
+        
+        FloatRect rect(0, 0, size.x, size.y);
+        quad.setTexPosRect(rect, rect);
+    }
+    
+    void draw() {
+        if (!visible || tex == TEX::ID(0))
+            return;
+        
+        SimpleShader &shader = shState->shaders().simple;
+        shader.bind();
+        shader.applyViewportProj();
+        shader.setTranslation(Vec2i());
+        shader.setTexSize(size);
+        
+        TEX::bind(tex);
+        
+        glState.blendMode.pushSet(BlendNormal);
+        quad.draw();
+        glState.blendMode.pop();
+    }
+};
+
 class ScreenScene : public Scene {
 public:
     ScreenScene(int width, int height) : pp(width, height) {
@@ -505,6 +790,9 @@ public:
         const int w = geometry.rect.w;
         const int h = geometry.rect.h;
         
+        /* Before anything looks at bitmap contents */
+        Bitmap::flushPendingBatch();
+        
         shState->prepareDraw();
         
         pp.startRender();
@@ -523,6 +811,8 @@ public:
             
             brightnessQuad.draw();
         }
+        
+        profileOverlay.draw();
     }
     
     void requestViewportRender(const Vec4 &c, const Vec4 &f, const Vec4 &t) {
@@ -651,17 +941,36 @@ public:
     
     PingPong &getPP() { return pp; }
     
+    ProfileOverlay &getProfileOverlay() { return profileOverlay; }
+    
+    /* Describes what the last composite() drew; false if
+     * some visible element can't describe its state */
+    bool addFrameSignature(CacheSignature &sig) const {
+        if (profileOverlay.visible)
+            return false;
+        
+        sig.add(geometry.rect);
+        sig.add(brightEffect);
+        
+        return addElementSignatures(sig);
+    }
+    
 private:
     PingPong pp;
     Quad screenQuad;
     
     Quad brightnessQuad;
     bool brightEffect;
+    
+    ProfileOverlay profileOverlay;
 };
 
 /* Nanoseconds per second */
 #define NS_PER_S 1000000000
 
+/* Transition maps kept around after use */
+#define TRANS_MAP_CACHE_SIZE 4
+
 struct FPSLimiter {
     uint64_t lastTickCount;
     
@@ -679,6 +988,10 @@ struct FPSLimiter {
     
     bool disabled;
     
+    /* Don't sleep at all, only advance the shared
+     * run time by exactly one frame per delay() */
+    bool fixedStep;
+    
     /* Data for frame timing adjustment */
     struct {
         /* Last tick count */
@@ -693,7 +1006,7 @@ struct FPSLimiter {
     FPSLimiter(uint16_t desiredFPS)
     : lastTickCount(SDL_GetPerformanceCounter()),
     tickFreq(SDL_GetPerformanceFrequency()), tickFreqMS(tickFreq / 1000),
-    tickFreqNS((double)tickFreq / NS_PER_S), disabled(false) {
+    tickFreqNS((double)tickFreq / NS_PER_S), disabled(false), fixedStep(false) {
         setDesiredFPS(desiredFPS);
         
         adj.last = SDL_GetPerformanceCounter();
@@ -704,6 +1017,11 @@ struct FPSLimiter {
     void setDesiredFPS(uint16_t value) { tpf = tickFreq / value; }
     
     void delay() {
+        if (fixedStep) {
+            shState->advanceFixedTime((double)tpf / tickFreq);
+            return;
+        }
+        
         if (disabled)
             return;
         
@@ -740,7 +1058,7 @@ struct FPSLimiter {
      * there's no choice but to skip frame(s)
      * to catch up */
     bool frameSkipRequired() const {
-        if (disabled)
+        if (disabled || fixedStep)
             return false;
         
         return adj.idealDiff > tpf;
@@ -829,6 +1147,41 @@ struct GraphicsPrivate {
     SDL_mutex *glResourceLock;
     bool multithreadedMode;
     
+    /* Asynchronous screenshots and frame recording */
+    FrameCapture capture;
+    
+    /* Optional multi-stage replacement for the final scaling blit */
+    ScalerChain scalerChain;
+    
+    /* Signature of the last frame presented through the scaler
+     * chain, used to skip the chain for identical frames */
+    uint64_t chainFrameSignature;
+    bool chainFrameKnown;
+    
+    /* Set while Graphics.play_movie runs its own update loop */
+    bool moviePlaying;
+    
+    /* Loaded transition maps, least recently used first */
+    struct TransMap {
+        std::string filename;
+        TEXFBO buffer;
+    };
+    std::vector<TransMap> transMaps;
+    
+    /* Compiled custom transition shaders by file name */
+    std::map<std::string, CustomTransShader*> transShaders;
+    
+    /* Parameters of the current (or last) transition. A non-blocking
+     * transition advances one step per redrawn frame while 'active' */
+    struct {
+        bool active;
+        int duration;
+        int frame;
+        float vague;
+        TEX::ID map;
+        CustomTransShader *shader;
+    } trans;
+    
     /* Global list of all live Disposables
      * (disposed on reset) */
     IntruList<Disposable> dispList;
@@ -845,7 +1198,14 @@ struct GraphicsPrivate {
     fpsLimiter(frameRate), useFrameSkip(rtData->config.frameSkip), frozen(false),
     last_update(0), last_avg_update(0), backingScaleFactor(1), integerScaleFactor(0, 0),
     integerScaleActive(rtData->config.integerScaling.active),
-    integerLastMileScaling(rtData->config.integerScaling.lastMileScaling) {
+    integerLastMileScaling(rtData->config.integerScaling.lastMileScaling),
+    chainFrameSignature(0), chainFrameKnown(false), moviePlaying(false) {
+        trans.active = false;
+        trans.duration = trans.frame = 0;
+        trans.vague = 1;
+        trans.map = TEX::ID(0);
+        trans.shader = 0;
+        
         avgFPSData = std::vector<double>();
         avgFPSLock = SDL_CreateMutex();
         glResourceLock = SDL_CreateMutex();
@@ -858,6 +1218,8 @@ struct GraphicsPrivate {
         recalculateScreenSize(rtData->config.fixedAspectRatio);
         updateScreenResoRatio(rtData);
         
+        scalerChain.configure(rtData->config.scalerChain);
+        
         TEXFBO::init(frozenScene);
         TEXFBO::allocEmpty(frozenScene, scRes.x, scRes.y);
         TEXFBO::linkFBO(frozenScene);
@@ -869,6 +1231,13 @@ struct GraphicsPrivate {
     }
     
     ~GraphicsPrivate() {
+        for (size_t i = 0; i < transMaps.size(); ++i)
+            TEXFBO::fini(transMaps[i].buffer);
+        
+        for (std::map<std::string, CustomTransShader*>::iterator iter = transShaders.begin();
+             iter != transShaders.end(); ++iter)
+            delete iter->second;
+        
         TEXFBO::fini(frozenScene);
         TEXFBO::fini(integerScaleBuffer);
         SDL_DestroyMutex(avgFPSLock);
@@ -944,6 +1313,12 @@ struct GraphicsPrivate {
     
     void rebuildIntegerScaleBuffer()
     {
+        /* Resizing the window rarely changes the scale */
+        if (integerScaleBuffer.tex != TEX::ID(0) &&
+            integerScaleBuffer.width == scRes.x * integerScaleFactor.x &&
+            integerScaleBuffer.height == scRes.y * integerScaleFactor.y)
+            return;
+        
         TEXFBO::fini(integerScaleBuffer);
         TEXFBO::init(integerScaleBuffer);
         TEXFBO::allocEmpty(integerScaleBuffer, scRes.x * integerScaleFactor.x,
@@ -999,10 +1374,19 @@ struct GraphicsPrivate {
     }
     
     void swapGLBuffer() {
-        fpsLimiter.delay();
-        SDL_GL_SwapWindow(threadData->window);
+        Profiler::Scope profile(shState->profiler(), Profiler::Present);
+        
+        {
+            TRACE_SCOPE("FPSLimiter sleep");
+            fpsLimiter.delay();
+        }
+        {
+            TRACE_SCOPE("swap");
+            SDL_GL_SwapWindow(threadData->window);
+        }
         
         ++frameCount;
+        Trace::instant("frame");
         
         threadData->ethread->notifyFrame();
     }
@@ -1039,8 +1423,74 @@ struct GraphicsPrivate {
                               !forceNearestNeighbor && GLMeta::smoothScalingMethod(scaleIsSpecial) == Bilinear);
     }
     
+    /* Whether the frame just composited looks exactly like the
+     * previous one presented through the scaler chain */
+    bool chainFrameUnchanged() {
+        CacheSignature sig;
+        sig.add(brightness);
+        
+        /* Movie frames change every update anyway */
+        if (trans.active || moviePlaying || !screen.addFrameSignature(sig)) {
+            chainFrameKnown = false;
+            return false;
+        }
+        
+        bool unchanged = chainFrameKnown && sig.hash == chainFrameSignature;
+        
+        chainFrameSignature = sig.hash;
+        chainFrameKnown = true;
+        
+        return unchanged;
+    }
+    
+    void blitScalerChain(TEXFBO &frame, bool unchanged) {
+        TEXFBO &out = scalerChain.process(frame, scRes, scSize, unchanged);
+        
+        GLMeta::blitBeginScreen(winSize, SameScale);
+        GLMeta::blitSource(out, SameScale);
+        
+        FBO::clear();
+        metaBlitBufferFlippedScaled(Vec2i(out.width, out.height), SameScale);
+        
+        GLMeta::blitEnd();
+    }
+    
+    /* For frames that don't come straight from the screen scene */
+    void blitScalerChainUncached(TEXFBO &frame) {
+        chainFrameKnown = false;
+        blitScalerChain(frame, false);
+    }
+    
     void redrawScreen() {
-        screen.composite();
+        Profiler &profiler = shState->profiler();
+        screen.getProfileOverlay().update(profiler);
+        
+        Profiler::Scope profile(profiler, Profiler::Screen);
+        
+        {
+            TRACE_SCOPE("composite");
+            screen.composite();
+        }
+        
+        if (trans.active) {
+            PingPong &pp = screen.getPP();
+            drawTransition(pp.backBuffer(), pp.frontBuffer().tex, stepTransition());
+            pp.swapRender();
+        }
+        
+        capture.onFrame(screen.getPP().frontBuffer(), scRes.x, scRes.y);
+        
+        if (!scalerChain.isEmpty())
+        {
+            TRACE_SCOPE("scaler chain");
+            blitScalerChain(screen.getPP().frontBuffer(), chainFrameUnchanged());
+            
+            profile.close();
+            swapGLBuffer();
+            
+            updateAvgFPS();
+            return;
+        }
         
         // maybe unspaghetti this later
         if (integerScaleStepApplicable() && !integerLastMileScaling)
@@ -1054,6 +1504,7 @@ struct GraphicsPrivate {
             metaBlitBufferFlippedScaled(scRes, scaleIsSpecial, true);
             GLMeta::blitEnd();
             
+            profile.close();
             swapGLBuffer();
             return;
         }
@@ -1104,11 +1555,149 @@ struct GraphicsPrivate {
         
         GLMeta::blitEnd();
         
+        profile.close();
         swapGLBuffer();
         
         updateAvgFPS();
     }
     
+    TEXFBO &getTransMap(const std::string &filename) {
+        for (size_t i = 0; i < transMaps.size(); ++i) {
+            if (transMaps[i].filename != filename)
+                continue;
+            
+            std::rotate(transMaps.begin() + i, transMaps.begin() + i + 1, transMaps.end());
+            
+            return transMaps.back().buffer;
+        }
+        
+        Bitmap *bitmap = new Bitmap(filename.c_str());
+        
+        if (bitmap->hasHires()) {
+            Debug() << "BUG: High-res Graphics transMap not implemented";
+        }
+        
+        /* Keep a plain copy, the Bitmap itself would be
+         * disposed along with the game's on reset */
+        TEXFBO src = bitmap->getGLTypes();
+        src.selfHires = nullptr;
+        
+        TransMap map;
+        map.filename = filename;
+        
+        TEXFBO::init(map.buffer);
+        TEXFBO::allocEmpty(map.buffer, src.width, src.height);
+        TEXFBO::linkFBO(map.buffer);
+        
+        const IntRect rect(0, 0, src.width, src.height);
+        int scaleIsSpecial = GLMeta::blitScaleIsSpecial(map.buffer, false, rect, src, rect);
+        
+        GLMeta::blitBegin(map.buffer, false, scaleIsSpecial);
+        GLMeta::blitSource(src, scaleIsSpecial);
+        GLMeta::blitRectangle(rect, Vec2i());
+        GLMeta::blitEnd();
+        
+        delete bitmap;
+        
+        /* A running non-blocking transition still samples its map,
+         * so that one is skipped (the cache may briefly grow by one) */
+        for (size_t i = 0; i < transMaps.size() && transMaps.size() >= TRANS_MAP_CACHE_SIZE;) {
+            if (trans.active && transMaps[i].buffer.tex == trans.map) {
+                ++i;
+                continue;
+            }
+            
+            TEXFBO::fini(transMaps[i].buffer);
+            transMaps.erase(transMaps.begin() + i);
+        }
+        
+        transMaps.push_back(map);
+        
+        return transMaps.back().buffer;
+    }
+    
+    CustomTransShader &getTransShader(const std::string &filename) {
+        std::map<std::string, CustomTransShader*>::iterator iter = transShaders.find(filename);
+        
+        if (iter != transShaders.end())
+            return *iter->second;
+        
+        /* Compile right away so errors surface at the call site */
+        CustomTransShader *shader = new CustomTransShader(filename);
+        
+        try {
+            shader->bind();
+        } catch (const Exception &) {
+            delete shader;
+            throw;
+        }
+        
+        transShaders[filename] = shader;
+        
+        return *shader;
+    }
+    
+    /* Loads everything a transition needs up front, so that
+     * failing to do so leaves the current state untouched */
+    void setupTransition(const char *filename, int vague, const char *shaderFile) {
+        TEX::ID map = *filename ? getTransMap(filename).tex : TEX::ID(0);
+        CustomTransShader *shader = *shaderFile ? &getTransShader(shaderFile) : 0;
+        
+        trans.active = false;
+        trans.duration = trans.frame = 0;
+        trans.vague = clamp(vague, 1, 256) / 256.0f;
+        trans.map = map;
+        trans.shader = shader;
+    }
+    
+    /* Blends the frozen scene with 'currentScene' into 'target' */
+    void drawTransition(TEXFBO &target, TEX::ID currentScene, float prog) {
+        FBO::bind(target.fbo);
+        
+        /* High-res: the transition has always been drawn in
+         * lores space, texture coordinates included */
+        const Vec2i transSize(scResLores.x, scResLores.y);
+        
+        if (trans.map != TEX::ID(0) || trans.shader) {
+            TransShader &shader = trans.shader ? *trans.shader : shState->shaders().trans;
+            shader.bind();
+            shader.applyViewportProj();
+            shader.setFrozenScene(frozenScene.tex);
+            shader.setCurrentScene(currentScene);
+            if (trans.map != TEX::ID(0))
+                shader.setTransMap(trans.map);
+            shader.setVague(trans.vague);
+            shader.setTexSize(transSize);
+            shader.setProg(prog);
+        } else {
+            SimpleTransShader &shader = shState->shaders().simpleTrans;
+            shader.bind();
+            shader.applyViewportProj();
+            shader.setFrozenScene(frozenScene.tex);
+            shader.setCurrentScene(currentScene);
+            shader.setTexSize(transSize);
+            shader.setProg(prog);
+        }
+        
+        glState.blend.pushSet(false);
+        
+        FBO::clear();
+        screenQuad.draw();
+        
+        glState.blend.pop();
+    }
+    
+    /* Returns the progress of the current non-blocking transition
+     * frame and moves on to the next one */
+    float stepTransition() {
+        const float prog = trans.frame * (1.0f / trans.duration);
+        
+        if (++trans.frame >= trans.duration)
+            trans.active = false;
+        
+        return prog;
+    }
+    
     void checkSyncLock() {
         if (!threadData->syncPoint.mainSyncLocked())
             return;
@@ -1169,6 +1758,12 @@ Graphics::Graphics(RGSSThreadData *data) {
     } else if (data->config.fixedFramerate < 0) {
         p->fpsLimiter.disabled = true;
     }
+    
+    if (data->config.fixedTimestep) {
+        if (data->config.fixedFramerate <= 0)
+            p->fpsLimiter.setDesiredFPS(p->frameRate);
+        p->fpsLimiter.fixedStep = true;
+    }
 }
 
 Graphics::~Graphics() { delete p; }
@@ -1182,6 +1777,9 @@ double Graphics::lastUpdate() {
 }
 
 void Graphics::update(bool checkForShutdown) {
+    TRACE_SCOPE("Graphics.update");
+    shState->profiler().endFrame();
+    
     p->threadData->rqWindowAdjust.wait();
     p->last_update = shState->runTime();
     
@@ -1211,6 +1809,9 @@ void Graphics::update(bool checkForShutdown) {
     if (p->fpsLimiter.frameSkipRequired()) {
         if (p->useFrameSkip) {
             /* Skip frame */
+            if (p->trans.active)
+                p->stepTransition();
+            
             p->fpsLimiter.delay();
             ++p->frameCount;
             p->threadData->ethread->notifyFrame();
@@ -1224,9 +1825,14 @@ void Graphics::update(bool checkForShutdown) {
     
     p->checkResize();
     p->redrawScreen();
+    p->capture.poll();
+    shState->streamBuffer().endFrame();
+    GLShadowStats::endFrame();
 }
 
 void Graphics::freeze() {
+    /* Abandon a running non-blocking transition */
+    p->trans.active = false;
     p->frozen = true;
     
     p->checkShutDownReset();
@@ -1236,14 +1842,14 @@ void Graphics::freeze() {
     p->compositeToBuffer(p->frozenScene);
 }
 
-void Graphics::transition(int duration, const char *filename, int vague) {
+void Graphics::transition(int duration, const char *filename, int vague,
+                          const char *shader) {
     p->checkSyncLock();
     
     if (!p->frozen)
         return;
     
-    vague = clamp(vague, 1, 256);
-    Bitmap *transMap = *filename ? new Bitmap(filename) : 0;
+    p->setupTransition(filename, vague, shader);
     
     setBrightness(255);
     
@@ -1257,72 +1863,25 @@ void Graphics::transition(int duration, const char *filename, int vague) {
     TEXFBO &currentScene = p->screen.getPP().frontBuffer();
     TEXFBO &transBuffer = p->screen.getPP().backBuffer();
     
-    /* If no transition bitmap is provided,
-     * we can use a simplified shader */
-    TransShader &transShader = shState->shaders().trans;
-    SimpleTransShader &simpleShader = shState->shaders().simpleTrans;
-    
-    // Handle high-res.
-    Vec2i transSize(p->scResLores.x, p->scResLores.y);
-
-    if (transMap) {
-        TransShader &shader = transShader;
-        shader.bind();
-        shader.applyViewportProj();
-        shader.setFrozenScene(p->frozenScene.tex);
-        shader.setCurrentScene(currentScene.tex);
-        if (transMap->hasHires()) {
-            Debug() << "BUG: High-res Graphics transMap not implemented";
-        }
-        shader.setTransMap(transMap->getGLTypes().tex);
-        shader.setVague(vague / 256.0f);
-        shader.setTexSize(transSize);
-    } else {
-        SimpleTransShader &shader = simpleShader;
-        shader.bind();
-        shader.applyViewportProj();
-        shader.setFrozenScene(p->frozenScene.tex);
-        shader.setCurrentScene(currentScene.tex);
-        shader.setTexSize(transSize);
-    }
-    
-    glState.blend.pushSet(false);
-    
     for (int i = 0; i < duration; ++i) {
-        /* We need to clean up transMap properly before
-         * a possible longjmp, so we manually test for
-         * shutdown/reset here */
+        /* Transition maps and shaders are cached, so nothing
+         * needs cleaning up before a possible longjmp; but we
+         * still have to test for shutdown/reset manually */
         if (p->threadData->rqTerm) {
-            glState.blend.pop();
-            delete transMap;
             p->shutdown();
             return;
         }
         
         if (p->threadData->rqReset) {
-            glState.blend.pop();
-            delete transMap;
             scriptBinding->reset();
             return;
         }
         
         p->checkSyncLock();
         
-        const float prog = i * (1.0f / duration);
-        
-        if (transMap) {
-            transShader.bind();
-            transShader.setProg(prog);
-        } else {
-            simpleShader.bind();
-            simpleShader.setProg(prog);
-        }
-        
         /* Draw the composed frame to a buffer first
          * (we need this because we're skipping PingPong) */
-        FBO::bind(transBuffer.fbo);
-        FBO::clear();
-        p->screenQuad.draw();
+        p->drawTransition(transBuffer, currentScene.tex, i * (1.0f / duration));
         
         p->checkResize();
         
@@ -1330,25 +1889,55 @@ void Graphics::transition(int duration, const char *filename, int vague) {
         FBO::unbind();
         FBO::clear();
         
-        int scaleIsSpecial = GLMeta::blitScaleIsSpecial(p->integerScaleBuffer, false, IntRect(0, 0, p->scSize.x, p->scSize.y), transBuffer, IntRect(0, 0, p->scRes.x, p->scRes.y));
+        if (!p->scalerChain.isEmpty()) {
+            p->blitScalerChainUncached(transBuffer);
+        } else {
+            int scaleIsSpecial = GLMeta::blitScaleIsSpecial(p->integerScaleBuffer, false, IntRect(0, 0, p->scSize.x, p->scSize.y), transBuffer, IntRect(0, 0, p->scRes.x, p->scRes.y));
 
-        GLMeta::blitBeginScreen(Vec2i(p->winSize), scaleIsSpecial);
-        GLMeta::blitSource(transBuffer, scaleIsSpecial);
-        p->metaBlitBufferFlippedScaled(scaleIsSpecial);
-        GLMeta::blitEnd();
+            GLMeta::blitBeginScreen(Vec2i(p->winSize), scaleIsSpecial);
+            GLMeta::blitSource(transBuffer, scaleIsSpecial);
+            p->metaBlitBufferFlippedScaled(scaleIsSpecial);
+            GLMeta::blitEnd();
+        }
         
         p->swapGLBuffer();
         /* Call this manually, as redrawScreen() is not called during this loop. */
         p->updateAvgFPS();
     }
     
-    glState.blend.pop();
+    p->frozen = false;
+}
+
+void Graphics::startTransition(int duration, const char *filename, int vague,
+                               const char *shader) {
+    p->checkSyncLock();
+    
+    if (!p->frozen)
+        return;
+    
+    p->setupTransition(filename, vague, shader);
     
-    delete transMap;
+    setBrightness(255);
     
+    /* From here on the frozen scene is only read by
+     * redrawScreen() while the transition runs */
+    p->trans.duration = duration;
+    p->trans.active = duration > 0;
     p->frozen = false;
 }
 
+bool Graphics::isTransitioning() const {
+    return p->trans.active;
+}
+
+void Graphics::preloadTransition(const char *filename, const char *shader) {
+    if (*filename)
+        p->getTransMap(filename);
+    
+    if (*shader)
+        p->getTransShader(shader);
+}
+
 void Graphics::frameReset() {p->fpsLimiter.resetFrameAdjust();}
 
 static void guardDisposed() {}
@@ -1370,6 +1959,11 @@ void Graphics::setFrameRate(int value) {
     //shState->input().recalcRepeat((unsigned int)p->frameRate);
 }
 
+void Graphics::glStateStats(unsigned &issued, unsigned &skipped) {
+    issued = GLShadowStats::frameIssued;
+    skipped = GLShadowStats::frameSkipped;
+}
+
 double Graphics::averageFrameRate() {
     return p->averageFPS();
 }
@@ -1391,6 +1985,12 @@ void Graphics::fadeout(int duration) {
         setBrightness(diff + (curr / duration) * i);
         
         if (p->frozen) {
+            if (!p->scalerChain.isEmpty()) {
+                p->blitScalerChainUncached(p->frozenScene);
+                p->swapGLBuffer();
+                continue;
+            }
+            
             int scaleIsSpecial = GLMeta::blitScaleIsSpecial(p->integerScaleBuffer, false, IntRect(0, 0, p->scSize.x, p->scSize.y), p->frozenScene, IntRect(0, 0, p->scRes.x, p->scRes.y));
 
             GLMeta::blitBeginScreen(p->scSize, scaleIsSpecial);
@@ -1418,6 +2018,12 @@ void Graphics::fadein(int duration) {
         setBrightness(curr + (diff / duration) * i);
         
         if (p->frozen) {
+            if (!p->scalerChain.isEmpty()) {
+                p->blitScalerChainUncached(p->frozenScene);
+                p->swapGLBuffer();
+                continue;
+            }
+            
             int scaleIsSpecial = GLMeta::blitScaleIsSpecial(p->integerScaleBuffer, false, IntRect(0, 0, p->scSize.x, p->scSize.y), p->frozenScene, IntRect(0, 0, p->scRes.x, p->scRes.y));
 
             GLMeta::blitBeginScreen(p->scSize, scaleIsSpecial);
@@ -1510,6 +2116,9 @@ void Graphics::resizeScreen(int width, int height) {
     
     TEXFBO::allocEmpty(p->frozenScene, width, height);
     
+    /* The scene being transitioned from is gone */
+    p->trans.active = false;
+    
     FloatRect screenRect(0, 0, width, height);
     p->screenQuad.setTexPosRect(screenRect, screenRect);
     
@@ -1565,20 +2174,61 @@ void Graphics::playMovie(const char *filename, int volume_, bool skippable) {
         letterboxSprite.setZ(4999);
         movieSprite.setZ(5001);
         
-        movie->play(volume);
+        p->moviePlaying = true;
+        
+        try {
+            movie->play(volume);
+        } catch (...) {
+            p->moviePlaying = false;
+            throw;
+        }
+        
+        p->moviePlaying = false;
     }
     
     delete movie;
 }
 
-void Graphics::screenshot(const char *filename) {
+void Graphics::screenshot(const char *filename, bool async) {
     p->threadData->rqWindowAdjust.wait();
+    
+    if (async) {
+        std::string path = shState->fileSystem().normalize(filename, 1, 1);
+        
+        p->screen.composite();
+        p->capture.capture(p->screen.getPP().frontBuffer(), p->scRes.x, p->scRes.y, path);
+        return;
+    }
+    
     Bitmap *ss = snapToBitmap();
     ss->saveToFile(filename);
     ss->dispose();
     delete ss;
 }
 
+void Graphics::startCapture(const char *path, int interval) {
+    std::string normalized = shState->fileSystem().normalize(path, 1, 1);
+    interval = std::max(interval, 1);
+    
+    p->capture.startRecording(normalized, interval, std::max(p->frameRate / interval, 1));
+}
+
+void Graphics::stopCapture() {
+    p->capture.stopRecording();
+}
+
+bool Graphics::isCapturing() const {
+    return p->capture.isRecording();
+}
+
+int Graphics::capturesPending() const {
+    return p->capture.pending();
+}
+
+void Graphics::flushCaptures() {
+    p->capture.flush();
+}
+
 DEF_ATTR_RD_SIMPLE(Graphics, Brightness, int, p->brightness)
 
 void Graphics::setBrightness(int value) {
@@ -1605,6 +2255,7 @@ void Graphics::reset() {
     /* Reset attributes (frame count not included) */
     p->fpsLimiter.resetFrameAdjust();
     p->frozen = false;
+    p->trans.active = false;
     p->screen.getPP().clearBuffers();
     
     setFrameRate(DEF_FRAMERATE);
@@ -1677,6 +2328,17 @@ void Graphics::setIntegerScaling(bool value)
     p->updateScreenResoRatio(p->threadData);
 }
 
+std::vector<std::string> Graphics::getScalerChain() const
+{
+    return p->scalerChain.describe();
+}
+
+void Graphics::setScalerChain(const std::vector<std::string> &value)
+{
+    p->scalerChain.configure(value);
+    p->chainFrameKnown = false;
+}
+
 bool Graphics::getLastMileScaling() const
 {
     return p->integerLastMileScaling;
@@ -1699,6 +2361,36 @@ void Graphics::setThreadsafe(bool value)
     p->multithreadedMode = value;
 }
 
+bool Graphics::getProfiling() const
+{
+    return shState->profiler().isEnabled();
+}
+
+void Graphics::setProfiling(bool value)
+{
+    shState->profiler().setEnabled(value);
+    
+    if (!value)
+        p->screen.getProfileOverlay().visible = false;
+}
+
+bool Graphics::getProfileOverlay() const
+{
+    return p->screen.getProfileOverlay().visible;
+}
+
+void Graphics::setProfileOverlay(bool value)
+{
+    ProfileOverlay &overlay = p->screen.getProfileOverlay();
+    
+    /* Force a redraw with whatever is published right now */
+    overlay.visible = value;
+    overlay.generation--;
+    
+    if (value)
+        shState->profiler().setEnabled(true);
+}
+
 double Graphics::getScale() const {
     p->checkResize();
     return (double)(p->winSize.y / p->backingScaleFactor) / p->scRes.y;
@@ -1729,12 +2421,23 @@ void Graphics::repaintWait(const AtomicFlag &exitCond, bool checkReset) {
         return;
     
     /* Repaint the screen with the last good frame we drew */
-    TEXFBO &lastFrame = p->screen.getPP().frontBuffer();
-
-    int scaleIsSpecial = GLMeta::blitScaleIsSpecial(p->integerScaleBuffer, false, IntRect(0, 0, p->scSize.x, p->scSize.y), lastFrame, IntRect(0, 0, p->scRes.x, p->scRes.y));
+    TEXFBO *lastFrame = &p->screen.getPP().frontBuffer();
+    Vec2i sourceSize = p->scRes;
+    
+    int scaleIsSpecial;
+    
+    if (!p->scalerChain.isEmpty()) {
+        /* Scale once, then only copy the result */
+        p->chainFrameKnown = false;
+        lastFrame = &p->scalerChain.process(*lastFrame, p->scRes, p->scSize, false);
+        sourceSize = Vec2i(lastFrame->width, lastFrame->height);
+        scaleIsSpecial = SameScale;
+    } else {
+        scaleIsSpecial = GLMeta::blitScaleIsSpecial(p->integerScaleBuffer, false, IntRect(0, 0, p->scSize.x, p->scSize.y), *lastFrame, IntRect(0, 0, p->scRes.x, p->scRes.y));
+    }
 
     GLMeta::blitBeginScreen(p->winSize, scaleIsSpecial);
-    GLMeta::blitSource(lastFrame, scaleIsSpecial);
+    GLMeta::blitSource(*lastFrame, scaleIsSpecial);
     
     while (!exitCond) {
         shState->checkShutdown();
@@ -1743,7 +2446,7 @@ void Graphics::repaintWait(const AtomicFlag &exitCond, bool checkReset) {
             shState->checkReset();
         
         FBO::clear();
-        p->metaBlitBufferFlippedScaled(scaleIsSpecial);
+        p->metaBlitBufferFlippedScaled(sourceSize, scaleIsSpecial);
         SDL_GL_SwapWindow(p->threadData->window);
         p->fpsLimiter.delay();
         
@@ -24,6 +24,9 @@
 
 #include "util.h"
 
+#include <string>
+#include <vector>
+
 class Scene;
 class Bitmap;
 class Disposable;
@@ -41,9 +44,24 @@ public:
     
 	void update(bool checkForShutdown = true);
 	void freeze();
+	/* 'shader' optionally names a fragment shader file
+	 * implementing the CustomTransShader contract */
 	void transition(int duration = 8,
 	                const char *filename = "",
-	                int vague = 40);
+	                int vague = 40,
+	                const char *shader = "");
+
+	/* Like transition(), but returns immediately; the game keeps
+	 * running and each following redrawn frame advances the
+	 * transition by one step */
+	void startTransition(int duration = 8,
+	                     const char *filename = "",
+	                     int vague = 40,
+	                     const char *shader = "");
+	bool isTransitioning() const;
+
+	/* Loads and caches a transition map and/or shader ahead of use */
+	void preloadTransition(const char *filename, const char *shader = "");
 	void frameReset();
 
 	DECL_ATTR( FrameRate,  int )
@@ -70,7 +88,19 @@ public:
 	void drawMovieFrame(const THEORAPLAY_VideoFrame* video, Bitmap *videoBitmap);
 	bool updateMovieInput(Movie *movie);
 	void playMovie(const char *filename, int volume, bool skippable);
-	void screenshot(const char *filename);
+	/* With 'async', the screen is read back without a pipeline
+	 * stall and written from a worker thread at full resolution */
+	void screenshot(const char *filename, bool async = false);
+
+	/* Records every 'interval'th presented frame, either as an
+	 * image sequence or, for a .y4m path, as one video file */
+	void startCapture(const char *path, int interval);
+	void stopCapture();
+	bool isCapturing() const;
+
+	/* Captured frames not yet written to disk */
+	int capturesPending() const;
+	void flushCaptures();
 
 	void reset();
     void center();
@@ -84,9 +114,19 @@ public:
     DECL_ATTR( SmoothScaling, int )
     DECL_ATTR( IntegerScaling, bool )
     DECL_ATTR( LastMileScaling, bool )
+    /* Stages as in the "scalerChain" config option,
+     * an empty list restores the plain final blit */
+    std::vector<std::string> getScalerChain() const;
+    void setScalerChain(const std::vector<std::string> &value);
     DECL_ATTR( Threadsafe, bool )
+    DECL_ATTR( Profiling, bool )
+    DECL_ATTR( ProfileOverlay, bool )
     double averageFrameRate();
 
+    /* GL state changes issued to / filtered out before the driver
+     * during the last presented frame */
+    void glStateStats(unsigned &issued, unsigned &skipped);
+
 	/* <internal> */
 	Scene *getScreen() const;
 	/* Repaint screen with static image until exitCond
@@ -0,0 +1,783 @@
+/*
+** pixelkernels.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pixelkernels.h"
+
+#include <SDL_cpuinfo.h>
+#include <SDL_timer.h>
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PIXEL_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+/* AVX2 isn't part of any baseline we build for, so its kernels are
+ * compiled for it separately and only picked when the CPU has it */
+#if defined(PIXEL_KERNELS_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_KERNELS_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define PIXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+/* Exact round(v / 255) for v <= 255 * 255 */
+inline uint32_t div255(uint32_t v)
+{
+	v += 128;
+	return (v + (v >> 8)) >> 8;
+}
+
+inline uint32_t unpremultiplyChannel(uint32_t c, uint32_t a)
+{
+	const uint32_t v = (c * 255 + a / 2) / a;
+
+	return v > 255 ? 255 : v;
+}
+
+void premultiplyScalar(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t p = src[i];
+		const uint32_t a = p >> 24;
+
+		dst[i] = div255((p & 0xFF) * a)
+		       | div255((p >> 8 & 0xFF) * a) << 8
+		       | div255((p >> 16 & 0xFF) * a) << 16
+		       | a << 24;
+	}
+}
+
+void unpremultiplyScalar(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t p = src[i];
+		const uint32_t a = p >> 24;
+
+		if (a == 0)
+		{
+			dst[i] = 0;
+			continue;
+		}
+
+		dst[i] = unpremultiplyChannel(p & 0xFF, a)
+		       | unpremultiplyChannel(p >> 8 & 0xFF, a) << 8
+		       | unpremultiplyChannel(p >> 16 & 0xFF, a) << 16
+		       | a << 24;
+	}
+}
+
+void swizzleScalar(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t p = src[i];
+
+		dst[i] = (p & 0xFF00FF00) | (p >> 16 & 0xFF) | (p & 0xFF) << 16;
+	}
+}
+
+void blendScalar(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t s = src[i];
+		const uint32_t d = dst[i];
+		const uint32_t sa = s >> 24;
+		const uint32_t ia = 255 - sa;
+
+		dst[i] = div255((s & 0xFF) * sa + (d & 0xFF) * ia)
+		       | div255((s >> 8 & 0xFF) * sa + (d >> 8 & 0xFF) * ia) << 8
+		       | div255((s >> 16 & 0xFF) * sa + (d >> 16 & 0xFF) * ia) << 16
+		       | div255(255 * sa + (d >> 24) * ia) << 24;
+	}
+}
+
+void shadowScalar(uint32_t *dst, const uint32_t *src, const uint32_t *shd,
+                  size_t count, uint32_t color)
+{
+	const uint32_t cr = color & 0xFF;
+	const uint32_t cg = color >> 8 & 0xFF;
+	const uint32_t cb = color >> 16 & 0xFF;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t s = src[i];
+		const uint32_t sa = s >> 24;
+		const uint32_t ha = shd[i] >> 24;
+
+		if (sa == 255 || ha == 0)
+		{
+			dst[i] = s;
+			continue;
+		}
+
+		/* Result alpha; the text color is scaled down by how much
+		 * of it comes from the (black) shadow */
+		const uint32_t fa = sa + div255(ha * (255 - sa));
+
+		dst[i] = (cr * sa + fa / 2) / fa
+		       | (cg * sa + fa / 2) / fa << 8
+		       | (cb * sa + fa / 2) / fa << 16
+		       | fa << 24;
+	}
+}
+
+const PixelKernels scalarKernels =
+{
+	"scalar",
+	premultiplyScalar,
+	unpremultiplyScalar,
+	swizzleScalar,
+	blendScalar,
+	shadowScalar
+};
+
+/* The vector kernels divide in float where the scalar ones divide
+ * integers: c * n / d + 0.5 truncated. With c * n exact and
+ * c * n / d <= 255, the one rounding of the division can't move the
+ * quotient across .5, so both round the same */
+
+#ifdef PIXEL_KERNELS_SSE2
+
+/* Two pixels per vector, one channel per 16 bit lane */
+inline __m128i div255x8(__m128i v)
+{
+	v = _mm_add_epi16(v, _mm_set1_epi16(128));
+
+	return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+inline __m128i alphax8(__m128i v)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+
+inline __m128i alphaLanesx8()
+{
+	return _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+}
+
+inline __m128i premultiplyx8(__m128i v)
+{
+	/* Alpha is multiplied by 255, which leaves it as it is */
+	return div255x8(_mm_mullo_epi16(v, _mm_or_si128(alphax8(v), alphaLanesx8())));
+}
+
+inline __m128i blendx8(__m128i s, __m128i d)
+{
+	const __m128i sa = alphax8(s);
+	const __m128i ia = _mm_sub_epi16(_mm_set1_epi16(255), sa);
+
+	/* Source alpha counts as 255 to get sa + da * (1 - sa) */
+	const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(_mm_or_si128(s, alphaLanesx8()), sa),
+	                                  _mm_mullo_epi16(d, ia));
+
+	return div255x8(sum);
+}
+
+/* One pixel per vector, one channel per 32 bit lane */
+inline __m128i unpremultiplyx4(__m128i px)
+{
+	const __m128i alphaLane = _mm_set_epi32(-1, 0, 0, 0);
+
+	/* Colors by alpha, alpha by one */
+	__m128i a = _mm_shuffle_epi32(px, 0xFF);
+	a = _mm_or_si128(_mm_andnot_si128(alphaLane, a),
+	                 _mm_and_si128(alphaLane, _mm_set1_epi32(1)));
+
+	const __m128 num = _mm_mul_ps(_mm_cvtepi32_ps(px), _mm_set_ps(1, 255, 255, 255));
+	const __m128 q = _mm_div_ps(num, _mm_cvtepi32_ps(a));
+
+	/* Zero alpha divides into inf / NaN, which both convert to
+	 * INT_MIN and saturate to 0 when packed */
+	return _mm_cvttps_epi32(_mm_add_ps(q, _mm_set1_ps(0.5f)));
+}
+
+void premultiplySSE2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+		const __m128i lo = premultiplyx8(_mm_unpacklo_epi8(p, zero));
+		const __m128i hi = premultiplyx8(_mm_unpackhi_epi8(p, zero));
+
+		_mm_storeu_si128((__m128i*) (dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	premultiplyScalar(dst + i, src + i, count - i);
+}
+
+void unpremultiplySSE2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+		const __m128i lo = _mm_unpacklo_epi8(p, zero);
+		const __m128i hi = _mm_unpackhi_epi8(p, zero);
+
+		const __m128i p0 = unpremultiplyx4(_mm_unpacklo_epi16(lo, zero));
+		const __m128i p1 = unpremultiplyx4(_mm_unpackhi_epi16(lo, zero));
+		const __m128i p2 = unpremultiplyx4(_mm_unpacklo_epi16(hi, zero));
+		const __m128i p3 = unpremultiplyx4(_mm_unpackhi_epi16(hi, zero));
+
+		_mm_storeu_si128((__m128i*) (dst + i),
+		                 _mm_packus_epi16(_mm_packs_epi32(p0, p1),
+		                                  _mm_packs_epi32(p2, p3)));
+	}
+
+	unpremultiplyScalar(dst + i, src + i, count - i);
+}
+
+void swizzleSSE2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m128i ag = _mm_set1_epi32((int) 0xFF00FF00);
+	const __m128i low = _mm_set1_epi32(0xFF);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i p = _mm_loadu_si128((const __m128i*) (src + i));
+		const __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+		const __m128i b = _mm_slli_epi32(_mm_and_si128(p, low), 16);
+
+		_mm_storeu_si128((__m128i*) (dst + i),
+		                 _mm_or_si128(_mm_and_si128(p, ag), _mm_or_si128(r, b)));
+	}
+
+	swizzleScalar(dst + i, src + i, count - i);
+}
+
+void blendSSE2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+		const __m128i d = _mm_loadu_si128((const __m128i*) (dst + i));
+
+		const __m128i lo = blendx8(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+		const __m128i hi = blendx8(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+
+		_mm_storeu_si128((__m128i*) (dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	blendScalar(dst + i, src + i, count - i);
+}
+
+void shadowSSE2(uint32_t *dst, const uint32_t *src, const uint32_t *shd,
+                size_t count, uint32_t color)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c255 = _mm_set1_epi32(255);
+	const __m128 cr = _mm_set1_ps((float) (color & 0xFF));
+	const __m128 cg = _mm_set1_ps((float) (color >> 8 & 0xFF));
+	const __m128 cb = _mm_set1_ps((float) (color >> 16 & 0xFF));
+	const __m128 half = _mm_set1_ps(0.5f);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i s = _mm_loadu_si128((const __m128i*) (src + i));
+		const __m128i h = _mm_loadu_si128((const __m128i*) (shd + i));
+		const __m128i sa = _mm_srli_epi32(s, 24);
+		const __m128i ha = _mm_srli_epi32(h, 24);
+
+		/* Both factors fit the low 16 bits of each lane */
+		__m128i t = _mm_mullo_epi16(ha, _mm_sub_epi32(c255, sa));
+		t = _mm_add_epi32(t, _mm_set1_epi32(128));
+		t = _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+
+		const __m128i fa = _mm_add_epi32(sa, t);
+		const __m128 fsa = _mm_cvtepi32_ps(sa);
+		const __m128 ffa = _mm_cvtepi32_ps(fa);
+
+		const __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(_mm_mul_ps(cr, fsa), ffa), half));
+		const __m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(_mm_mul_ps(cg, fsa), ffa), half));
+		const __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(_mm_mul_ps(cb, fsa), ffa), half));
+
+		const __m128i out = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+		                                 _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(fa, 24)));
+
+		/* Lanes passing the input through (this includes all with
+		 * a zero result alpha) */
+		const __m128i keep = _mm_or_si128(_mm_cmpeq_epi32(sa, c255), _mm_cmpeq_epi32(ha, zero));
+
+		_mm_storeu_si128((__m128i*) (dst + i),
+		                 _mm_or_si128(_mm_and_si128(keep, s), _mm_andnot_si128(keep, out)));
+	}
+
+	shadowScalar(dst + i, src + i, shd + i, count - i, color);
+}
+
+const PixelKernels sse2Kernels =
+{
+	"sse2",
+	premultiplySSE2,
+	unpremultiplySSE2,
+	swizzleSSE2,
+	blendSSE2,
+	shadowSSE2
+};
+
+#endif // PIXEL_KERNELS_SSE2
+
+#ifdef PIXEL_KERNELS_AVX2
+
+/* Same as the SSE2 versions, on both 128 bit halves at once */
+AVX2_TARGET inline __m256i div255x16(__m256i v)
+{
+	v = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+
+	return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)), 8);
+}
+
+AVX2_TARGET inline __m256i alphax16(__m256i v)
+{
+	return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+
+AVX2_TARGET inline __m256i alphaLanesx16()
+{
+	return _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+	                        255, 0, 0, 0, 255, 0, 0, 0);
+}
+
+AVX2_TARGET void premultiplyAVX2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i p = _mm256_loadu_si256((const __m256i*) (src + i));
+		__m256i lo = _mm256_unpacklo_epi8(p, zero);
+		__m256i hi = _mm256_unpackhi_epi8(p, zero);
+
+		lo = div255x16(_mm256_mullo_epi16(lo, _mm256_or_si256(alphax16(lo), alphaLanesx16())));
+		hi = div255x16(_mm256_mullo_epi16(hi, _mm256_or_si256(alphax16(hi), alphaLanesx16())));
+
+		_mm256_storeu_si256((__m256i*) (dst + i), _mm256_packus_epi16(lo, hi));
+	}
+
+	premultiplySSE2(dst + i, src + i, count - i);
+}
+
+AVX2_TARGET void swizzleAVX2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m256i order = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+	                                       2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i p = _mm256_loadu_si256((const __m256i*) (src + i));
+
+		_mm256_storeu_si256((__m256i*) (dst + i), _mm256_shuffle_epi8(p, order));
+	}
+
+	swizzleSSE2(dst + i, src + i, count - i);
+}
+
+AVX2_TARGET inline __m256i blendx16(__m256i s, __m256i d)
+{
+	const __m256i sa = alphax16(s);
+	const __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(255), sa);
+	const __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_or_si256(s, alphaLanesx16()), sa),
+	                                     _mm256_mullo_epi16(d, ia));
+
+	return div255x16(sum);
+}
+
+AVX2_TARGET void blendAVX2(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i s = _mm256_loadu_si256((const __m256i*) (src + i));
+		const __m256i d = _mm256_loadu_si256((const __m256i*) (dst + i));
+
+		const __m256i lo = blendx16(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+		const __m256i hi = blendx16(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+
+		_mm256_storeu_si256((__m256i*) (dst + i), _mm256_packus_epi16(lo, hi));
+	}
+
+	blendSSE2(dst + i, src + i, count - i);
+}
+
+/* Unpremultiply and shadow are bound by their divisions, which
+ * don't get any wider here */
+const PixelKernels avx2Kernels =
+{
+	"avx2",
+	premultiplyAVX2,
+	unpremultiplySSE2,
+	swizzleAVX2,
+	blendAVX2,
+	shadowSSE2
+};
+
+#endif // PIXEL_KERNELS_AVX2
+
+#ifdef PIXEL_KERNELS_NEON
+
+/* Sixteen pixels per iteration, deinterleaved into one vector
+ * per channel */
+inline uint8x8_t div255x8(uint16x8_t v)
+{
+	v = vaddq_u16(v, vdupq_n_u16(128));
+
+	return vshrn_n_u16(vaddq_u16(v, vshrq_n_u16(v, 8)), 8);
+}
+
+inline uint8x16_t mulDiv255(uint8x16_t c, uint8x16_t a)
+{
+	return vcombine_u8(div255x8(vmull_u8(vget_low_u8(c), vget_low_u8(a))),
+	                   div255x8(vmull_high_u8(c, a)));
+}
+
+inline uint8x16_t blendChannel(uint8x16_t s, uint8x16_t d, uint8x16_t sa, uint8x16_t ia)
+{
+	const uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(s), vget_low_u8(sa)),
+	                               vget_low_u8(d), vget_low_u8(ia));
+	const uint16x8_t hi = vmlal_high_u8(vmull_high_u8(s, sa), d, ia);
+
+	return vcombine_u8(div255x8(lo), div255x8(hi));
+}
+
+void premultiplyNEON(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t p = vld4q_u8((const uint8_t*) (src + i));
+
+		p.val[0] = mulDiv255(p.val[0], p.val[3]);
+		p.val[1] = mulDiv255(p.val[1], p.val[3]);
+		p.val[2] = mulDiv255(p.val[2], p.val[3]);
+
+		vst4q_u8((uint8_t*) (dst + i), p);
+	}
+
+	premultiplyScalar(dst + i, src + i, count - i);
+}
+
+void swizzleNEON(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	static const uint8_t orderData[] =
+		{ 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 };
+
+	const uint8x16_t order = vld1q_u8(orderData);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint8x16_t p = vld1q_u8((const uint8_t*) (src + i));
+
+		vst1q_u8((uint8_t*) (dst + i), vqtbl1q_u8(p, order));
+	}
+
+	swizzleScalar(dst + i, src + i, count - i);
+}
+
+void blendNEON(uint32_t *dst, const uint32_t *src, size_t count)
+{
+	const uint8x16_t full = vdupq_n_u8(255);
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16x4_t s = vld4q_u8((const uint8_t*) (src + i));
+		uint8x16x4_t d = vld4q_u8((const uint8_t*) (dst + i));
+
+		const uint8x16_t sa = s.val[3];
+		const uint8x16_t ia = vmvnq_u8(sa);
+
+		d.val[0] = blendChannel(s.val[0], d.val[0], sa, ia);
+		d.val[1] = blendChannel(s.val[1], d.val[1], sa, ia);
+		d.val[2] = blendChannel(s.val[2], d.val[2], sa, ia);
+		d.val[3] = blendChannel(full, d.val[3], sa, ia);
+
+		vst4q_u8((uint8_t*) (dst + i), d);
+	}
+
+	blendScalar(dst + i, src + i, count - i);
+}
+
+const PixelKernels neonKernels =
+{
+	"neon",
+	premultiplyNEON,
+	unpremultiplyScalar,
+	swizzleNEON,
+	blendNEON,
+	shadowScalar
+};
+
+#endif // PIXEL_KERNELS_NEON
+
+const PixelKernels &selectKernels()
+{
+#ifdef PIXEL_KERNELS_AVX2
+	if (SDL_HasAVX2())
+		return avx2Kernels;
+#endif
+#if defined(PIXEL_KERNELS_SSE2)
+	return sse2Kernels;
+#elif defined(PIXEL_KERNELS_NEON)
+	return neonKernels;
+#else
+	return scalarKernels;
+#endif
+}
+
+inline uint32_t *rowOf(void *data, int pitch, int y)
+{
+	return (uint32_t*) ((uint8_t*) data + (ptrdiff_t) y * pitch);
+}
+
+inline const uint32_t *rowOf(const void *data, int pitch, int y)
+{
+	return (const uint32_t*) ((const uint8_t*) data + (ptrdiff_t) y * pitch);
+}
+
+template<typename Kernel>
+void forEachRow(Kernel kernel, void *dst, int dstPitch,
+                const void *src, int srcPitch, int w, int h)
+{
+	if (w <= 0)
+		return;
+
+	for (int y = 0; y < h; ++y)
+		kernel(rowOf(dst, dstPitch, y), rowOf(src, srcPitch, y), w);
+}
+
+} // anonymous namespace
+
+const PixelKernels &pixelKernels()
+{
+	static const PixelKernels &kernels = selectKernels();
+
+	return kernels;
+}
+
+std::vector<const PixelKernels*> pixelKernelPaths()
+{
+	std::vector<const PixelKernels*> paths;
+	paths.push_back(&scalarKernels);
+
+#ifdef PIXEL_KERNELS_SSE2
+	paths.push_back(&sse2Kernels);
+#endif
+#ifdef PIXEL_KERNELS_AVX2
+	if (SDL_HasAVX2())
+		paths.push_back(&avx2Kernels);
+#endif
+#ifdef PIXEL_KERNELS_NEON
+	paths.push_back(&neonKernels);
+#endif
+
+	return paths;
+}
+
+void pixelCopyRect(void *dst, int dstPitch,
+                   const void *src, int srcPitch, int w, int h)
+{
+	if (w <= 0 || h <= 0)
+		return;
+
+	const size_t rowBytes = (size_t) w * 4;
+
+	if (dstPitch == srcPitch && (size_t) dstPitch == rowBytes)
+	{
+		memcpy(dst, src, rowBytes * h);
+		return;
+	}
+
+	for (int y = 0; y < h; ++y)
+		memcpy(rowOf(dst, dstPitch, y), rowOf(src, srcPitch, y), rowBytes);
+}
+
+void pixelSwizzleRect(void *dst, int dstPitch,
+                      const void *src, int srcPitch, int w, int h)
+{
+	forEachRow(pixelKernels().swizzle, dst, dstPitch, src, srcPitch, w, h);
+}
+
+void pixelBlendRect(void *dst, int dstPitch,
+                    const void *src, int srcPitch, int w, int h)
+{
+	forEachRow(pixelKernels().blend, dst, dstPitch, src, srcPitch, w, h);
+}
+
+namespace
+{
+
+enum BenchKernel
+{
+	BenchPremultiply,
+	BenchUnpremultiply,
+	BenchSwizzle,
+	BenchBlend,
+	BenchShadow,
+
+	BenchKernelCount
+};
+
+const char *benchKernelNames[] =
+{
+	"premultiply", "unpremultiply", "swizzle", "blend", "shadow"
+};
+
+struct BenchData
+{
+	std::vector<uint32_t> src;
+	std::vector<uint32_t> shd;
+	std::vector<uint32_t> back;
+};
+
+/* Blend works on 'out' in place, so it is expected to hold the
+ * backdrop on the first run */
+void runKernel(const PixelKernels &k, int kernel, std::vector<uint32_t> &out,
+               const BenchData &data)
+{
+	const size_t count = out.size();
+
+	switch (kernel)
+	{
+	case BenchPremultiply:
+		k.premultiply(&out[0], &data.src[0], count);
+		break;
+	case BenchUnpremultiply:
+		k.unpremultiply(&out[0], &data.src[0], count);
+		break;
+	case BenchSwizzle:
+		k.swizzle(&out[0], &data.src[0], count);
+		break;
+	case BenchBlend:
+		k.blend(&out[0], &data.src[0], count);
+		break;
+	case BenchShadow:
+		k.shadow(&out[0], &data.src[0], &data.shd[0], count, 0x0080A0C0);
+		break;
+	}
+}
+
+} // anonymous namespace
+
+std::vector<PixelKernelResult> pixelKernelsBenchmark(size_t pixels, int rounds)
+{
+	/* All color/alpha pairs, and an odd count so every path also
+	 * runs its remainder loop */
+	pixels = std::max<size_t>(pixels, 256 * 256) | 1;
+	rounds = std::max(rounds, 1);
+
+	BenchData data;
+	data.src.resize(pixels);
+	data.shd.resize(pixels);
+	data.back.resize(pixels);
+
+	uint32_t seed = 0x9E3779B9;
+
+	for (size_t i = 0; i < pixels; ++i)
+	{
+		uint32_t rnd[3];
+
+		for (int j = 0; j < 3; ++j)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			rnd[j] = seed;
+		}
+
+		if (i < 256 * 256)
+		{
+			const uint32_t c = i & 0xFF;
+			const uint32_t a = i >> 8;
+
+			data.src[i] = c | (255 - c) << 8 | (c * 7 & 0xFF) << 16 | a << 24;
+		}
+		else
+		{
+			data.src[i] = rnd[0];
+		}
+
+		data.shd[i] = rnd[1];
+		data.back[i] = rnd[2];
+	}
+
+	const std::vector<const PixelKernels*> paths = pixelKernelPaths();
+	const double freq = (double) SDL_GetPerformanceFrequency();
+
+	std::vector<PixelKernelResult> results;
+	std::vector<uint32_t> expected, out;
+
+	for (int kernel = 0; kernel < BenchKernelCount; ++kernel)
+	{
+		expected = data.back;
+		runKernel(scalarKernels, kernel, expected, data);
+
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			out = data.back;
+			runKernel(*paths[i], kernel, out, data);
+
+			PixelKernelResult result;
+			result.path = paths[i]->name;
+			result.kernel = benchKernelNames[kernel];
+			result.exact = (out == expected);
+
+			const uint64_t start = SDL_GetPerformanceCounter();
+
+			for (int r = 0; r < rounds; ++r)
+				runKernel(*paths[i], kernel, out, data);
+
+			const double secs = (SDL_GetPerformanceCounter() - start) / freq;
+
+			result.mpixPerSec = secs > 0 ? (double) pixels * rounds / secs / 1e6 : 0;
+			results.push_back(result);
+		}
+	}
+
+	return results;
+}
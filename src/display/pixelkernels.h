@@ -0,0 +1,90 @@
+/*
+** pixelkernels.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIXELKERNELS_H
+#define PIXELKERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/* CPU side pixel loops for Bitmap surfaces (mega surfaces, readbacks,
+ * text rendering). Pixels are 32 bit values with red in the lowest
+ * and alpha in the highest byte (SDL_PIXELFORMAT_ABGR8888), the format
+ * Bitmaps keep their surfaces in.
+ *
+ * Every path computes exactly the same result as the scalar one;
+ * where a path has no version of a kernel, it uses the next narrower
+ * one. 'dst' may be the same as 'src' in all kernels */
+struct PixelKernels
+{
+	const char *name;
+
+	/* c = c * a / 255 */
+	void (*premultiply)(uint32_t *dst, const uint32_t *src, size_t count);
+
+	/* c = c * 255 / a, 0 where a is 0 */
+	void (*unpremultiply)(uint32_t *dst, const uint32_t *src, size_t count);
+
+	/* Swaps red and blue (ABGR8888 <-> ARGB8888) */
+	void (*swizzle)(uint32_t *dst, const uint32_t *src, size_t count);
+
+	/* Non premultiplied 'src' over 'dst', like SDL_BLENDMODE_BLEND */
+	void (*blend)(uint32_t *dst, const uint32_t *src, size_t count);
+
+	/* Text pixels 'src' (drawn in 'color') over a black shadow of
+	 * the alpha of 'shd' */
+	void (*shadow)(uint32_t *dst, const uint32_t *src, const uint32_t *shd,
+	               size_t count, uint32_t color);
+};
+
+/* The fastest path this machine supports */
+const PixelKernels &pixelKernels();
+
+/* All paths this build and machine support, scalar first */
+std::vector<const PixelKernels*> pixelKernelPaths();
+
+/* Rectangle versions; pitches are in bytes */
+void pixelCopyRect(void *dst, int dstPitch,
+                   const void *src, int srcPitch, int w, int h);
+
+void pixelSwizzleRect(void *dst, int dstPitch,
+                      const void *src, int srcPitch, int w, int h);
+
+void pixelBlendRect(void *dst, int dstPitch,
+                    const void *src, int srcPitch, int w, int h);
+
+struct PixelKernelResult
+{
+	std::string path;
+	std::string kernel;
+
+	/* Output identical to the scalar path */
+	bool exact;
+	double mpixPerSec;
+};
+
+/* Runs every kernel of every path over 'pixels' pixels (at least all
+ * color/alpha combinations) 'rounds' times, checking the results
+ * against the scalar path */
+std::vector<PixelKernelResult> pixelKernelsBenchmark(size_t pixels, int rounds);
+
+#endif // PIXELKERNELS_H
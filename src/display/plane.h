@@ -23,6 +23,7 @@
 #define PLANE_H
 
 #include "disposable.h"
+#include "bindingslots.h"
 #include "viewport.h"
 
 class Bitmap;
@@ -31,7 +32,7 @@ struct Tone;
 
 struct PlanePrivate;
 
-class Plane : public ViewportElement, public Disposable
+class Plane : public ViewportElement, public Disposable, public BindingSlots
 {
 public:
 	Plane(Viewport *viewport = 0);
@@ -54,6 +55,7 @@ private:
 
 	void draw();
 	void onGeometryChange(const Scene::Geometry &);
+	Profiler::Section profileSection() const { return Profiler::Plane; }
 
 	void releaseResources();
 	const char *klassName() const { return "plane"; }
@@ -0,0 +1,300 @@
+/*
+** scalerchain.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scalerchain.h"
+
+#include "sharedstate.h"
+#include "config.h"
+#include "glstate.h"
+#include "shader.h"
+#include "texpool.h"
+#include "etc.h"
+#include "util.h"
+#include "debugwriter.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
+
+/* Largest accepted per stage factor */
+#define SCALER_MAX_FACTOR 8
+
+namespace
+{
+
+struct MethodName
+{
+	const char *name;
+	int method;
+};
+
+const MethodName methodNames[] =
+{
+	{ "nearest",  NearestNeighbor },
+	{ "bilinear", Bilinear        },
+	{ "bicubic",  Bicubic         },
+	{ "lanczos3", Lanczos3        },
+#ifdef MKXPZ_SSL
+	{ "xbrz",     xBRZ            },
+#endif
+};
+
+const size_t methodCount = sizeof(methodNames) / sizeof(methodNames[0]);
+
+int findMethod(const std::string &name)
+{
+	for (size_t i = 0; i < methodCount; ++i)
+		if (name == methodNames[i].name)
+			return methodNames[i].method;
+
+	return -1;
+}
+
+const char *methodName(int method)
+{
+	for (size_t i = 0; i < methodCount; ++i)
+		if (method == methodNames[i].method)
+			return methodNames[i].name;
+
+	return "nearest";
+}
+
+} // anonymous namespace
+
+ScalerChain::ScalerChain()
+    : valid(false),
+      output(0)
+{}
+
+ScalerChain::~ScalerChain()
+{
+	/* The TexPool may already be gone at this point */
+	for (size_t i = 0; i < targets.size(); ++i)
+		TEXFBO::fini(targets[i].buffer);
+}
+
+void ScalerChain::configure(const std::vector<std::string> &desc)
+{
+	stages.clear();
+	releaseTargets();
+
+	for (size_t i = 0; i < desc.size(); ++i)
+	{
+		std::string entry = desc[i];
+		std::transform(entry.begin(), entry.end(), entry.begin(),
+		               [](unsigned char c) { return tolower(c); });
+
+		std::string name = entry;
+		int factor = 2;
+
+		size_t sep = entry.find(':');
+
+		if (sep != std::string::npos)
+		{
+			name = entry.substr(0, sep);
+			factor = atoi(entry.c_str() + sep + 1);
+		}
+
+		Stage stage;
+		stage.method = findMethod(name);
+		stage.factor = clamp(factor, 1, SCALER_MAX_FACTOR);
+
+		if (stage.method < 0)
+		{
+			Debug() << "Unknown scaler stage:" << desc[i];
+			continue;
+		}
+
+		stages.push_back(stage);
+	}
+}
+
+std::vector<std::string> ScalerChain::describe() const
+{
+	std::vector<std::string> result;
+
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		std::string entry = methodName(stages[i].method);
+
+		/* The last stage always scales to the output */
+		if (i < stages.size() - 1)
+			entry += ":" + std::to_string(stages[i].factor);
+
+		result.push_back(entry);
+	}
+
+	return result;
+}
+
+TEXFBO &ScalerChain::process(TEXFBO &source, const Vec2i &srcSize,
+                             const Vec2i &outSize, bool unchanged)
+{
+	if (unchanged && valid && srcSize == lastSrcSize && outSize == lastOutSize)
+		return *output;
+
+	const int maxSize = glState.caps.maxTexSize;
+
+	/* Sized up front, as stages hold references into it */
+	if (targets.size() < stages.size() * 2)
+		targets.resize(stages.size() * 2);
+
+	TEXFBO *src = &source;
+	Vec2i size = srcSize;
+
+	for (size_t i = 0; i < stages.size(); ++i)
+	{
+		Vec2i dstSize = outSize;
+
+		if (i < stages.size() - 1)
+			dstSize = Vec2i(size.x * stages[i].factor, size.y * stages[i].factor);
+
+		dstSize.x = clamp(dstSize.x, 1, maxSize);
+		dstSize.y = clamp(dstSize.y, 1, maxSize);
+
+		runStage(stages[i], i, *src, size, dstSize);
+
+		src = &targets[i*2+1].buffer;
+		size = dstSize;
+	}
+
+	output = src;
+	lastSrcSize = srcSize;
+	lastOutSize = outSize;
+	valid = true;
+
+	return *output;
+}
+
+void ScalerChain::releaseTargets()
+{
+	for (size_t i = 0; i < targets.size(); ++i)
+		shState->texPool().release(targets[i].buffer);
+
+	targets.clear();
+	output = 0;
+	valid = false;
+}
+
+TEXFBO &ScalerChain::target(size_t index, const Vec2i &size)
+{
+	Target &t = targets[index];
+
+	if (t.buffer.tex == TEX::ID(0) || !(t.size == size))
+	{
+		shState->texPool().release(t.buffer);
+		t.buffer = shState->texPool().request(size.x, size.y);
+		t.size = size;
+	}
+
+	return t.buffer;
+}
+
+void ScalerChain::runStage(const Stage &stage, size_t index, TEXFBO &src,
+                           const Vec2i &srcSize, const Vec2i &dstSize)
+{
+	const Vec2i srcTexSize(src.width, src.height);
+
+	switch (stage.method)
+	{
+	case Bicubic:
+	case Lanczos3:
+	{
+		ShaderSet &shaders = shState->shaders();
+		ScalePassShader *shader;
+
+		if (stage.method == Bicubic)
+		{
+			shaders.bicubicPass.bind();
+			shaders.bicubicPass.setSharpness(shState->config().bicubicSharpness);
+			shader = &shaders.bicubicPass;
+		}
+		else
+		{
+			shaders.lanczos3Pass.bind();
+			shader = &shaders.lanczos3Pass;
+		}
+
+		/* Horizontal pass at source height, then vertical */
+		const Vec2i midSize(dstSize.x, srcSize.y);
+		TEXFBO &mid = target(index*2, midSize);
+
+		shader->setDirection(Vec2(1, 0));
+		shader->setTexSize(srcTexSize);
+		drawPass(*shader, src, srcSize, mid, midSize);
+
+		shader->setDirection(Vec2(0, 1));
+		shader->setTexSize(Vec2i(mid.width, mid.height));
+		drawPass(*shader, mid, midSize, target(index*2+1, dstSize), dstSize);
+
+		break;
+	}
+#ifdef MKXPZ_SSL
+	case xBRZ:
+	{
+		XbrzShader &shader = shState->shaders().xbrz;
+		shader.bind();
+		shader.setTexSize(srcTexSize);
+		shader.setTargetScale(Vec2((float) dstSize.x / srcSize.x,
+		                           (float) dstSize.y / srcSize.y));
+
+		drawPass(shader, src, srcSize, target(index*2+1, dstSize), dstSize);
+
+		break;
+	}
+#endif
+	default:
+	{
+		SimpleShader &shader = shState->shaders().simple;
+		shader.bind();
+		shader.setTexSize(srcTexSize);
+
+		drawPass(shader, src, srcSize, target(index*2+1, dstSize), dstSize,
+		         stage.method == Bilinear);
+	}
+	}
+}
+
+void ScalerChain::drawPass(ShaderBase &shader, TEXFBO &src, const Vec2i &srcSize,
+                           TEXFBO &dst, const Vec2i &dstSize, bool smooth)
+{
+	FBO::bind(dst.fbo);
+	glState.viewport.pushSet(IntRect(0, 0, dstSize.x, dstSize.y));
+
+	shader.applyViewportProj();
+	shader.setTranslation(Vec2i());
+
+	TEX::bind(src.tex);
+
+	if (smooth)
+		TEX::setSmooth(true);
+
+	glState.blend.pushSet(false);
+
+	quad.setTexPosRect(FloatRect(0, 0, srcSize.x, srcSize.y),
+	                   FloatRect(0, 0, dstSize.x, dstSize.y));
+	quad.draw();
+
+	glState.blend.pop();
+
+	if (smooth)
+		TEX::setSmooth(false);
+
+	glState.viewport.pop();
+}
@@ -0,0 +1,96 @@
+/*
+** scalerchain.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCALERCHAIN_H
+#define SCALERCHAIN_H
+
+#include "gl-util.h"
+#include "etc-internal.h"
+#include "quad.h"
+
+#include <string>
+#include <vector>
+
+/* Upscales the finished game screen through a sequence of filters,
+ * eg. "xbrz:2" -> "lanczos3", instead of the single smoothScaling
+ * pass. Every stage but the last multiplies the size by its factor,
+ * the last one scales to the final output size. Lanczos3 and Bicubic
+ * run as two separable passes. All intermediate targets come from
+ * the TexPool and are kept while their size stays the same */
+class ScalerChain
+{
+public:
+	ScalerChain();
+	~ScalerChain();
+
+	/* Entries are "method" or "method:factor", with method one of
+	 * nearest, bilinear, bicubic, lanczos3 or xbrz. Unknown entries
+	 * are skipped with a warning. An empty list disables the chain */
+	void configure(const std::vector<std::string> &desc);
+	std::vector<std::string> describe() const;
+
+	bool isEmpty() const { return stages.empty(); }
+
+	/* Runs 'source' (using its top left 'srcSize' pixels) through
+	 * all stages and returns the result, of size 'outSize'. If the
+	 * source is known to be unchanged since the last call, the
+	 * previous result is returned as is */
+	TEXFBO &process(TEXFBO &source, const Vec2i &srcSize,
+	                const Vec2i &outSize, bool unchanged);
+
+	/* Forces the next process() to run all stages */
+	void invalidate() { valid = false; }
+
+	/* Gives all intermediate targets back to the TexPool */
+	void releaseTargets();
+
+private:
+	struct Stage
+	{
+		int method;
+		int factor;
+	};
+
+	struct Target
+	{
+		TEXFBO buffer;
+		Vec2i size;
+	};
+
+	TEXFBO &target(size_t index, const Vec2i &size);
+
+	void runStage(const Stage &stage, size_t index, TEXFBO &src,
+	              const Vec2i &srcSize, const Vec2i &dstSize);
+	void drawPass(ShaderBase &shader, TEXFBO &src, const Vec2i &srcSize,
+	              TEXFBO &dst, const Vec2i &dstSize, bool smooth = false);
+
+	std::vector<Stage> stages;
+
+	/* Two per stage, for the separable passes */
+	std::vector<Target> targets;
+
+	bool valid;
+	Vec2i lastSrcSize;
+	Vec2i lastOutSize;
+	TEXFBO *output;
+
+	Quad quad;
+};
+
+#endif // SCALERCHAIN_H
@@ -133,6 +133,7 @@ struct SpritePrivate
         wave.length = 180;
         wave.speed = 360;
         wave.phase = 0.0f;
+        wave.active = false;
         wave.dirty = false;
     }
     
@@ -607,6 +608,62 @@ void Sprite::update()
     p->wave.dirty = true;
 }
 
+bool Sprite::hitTest(int x, int y, int alphaThreshold)
+{
+    guardDisposed();
+    
+    if (!visible || !p->opacity || nullOrDisposed(p->bitmap))
+        return false;
+    
+    /* setBitmap() already refuses mega bitmaps, but a mega one has no
+     * texture to draw or take an alpha mask from, and hitAlpha() would
+     * throw halfway through a Viewport#pick. It can't be hit */
+    if (p->bitmap->isMega())
+        return false;
+    
+    Viewport *viewport = getViewport();
+    
+    if (!nullOrDisposed(viewport))
+    {
+        if (!viewport->getVisible())
+            return false;
+        
+        /* Children are clipped to the viewport rect */
+        const IntRect rect = viewport->getRect().toIntRect();
+        
+        if (x < rect.x || y < rect.y || x >= rect.x + rect.w || y >= rect.y + rect.h)
+            return false;
+    }
+    
+    /* Undo the sprite transform for the pixel center */
+    const float *m = p->trans.getMatrix();
+    const float det = m[0] * m[5] - m[4] * m[1];
+    
+    if (det == 0)
+        return false;
+    
+    const float dx = x + 0.5f - m[12];
+    const float dy = y + 0.5f - m[13];
+    const float lx = (m[5] * dx - m[4] * dy) / det;
+    const float ly = (m[0] * dy - m[1] * dx) / det;
+    
+    /* Same clamping as onSrcRectChange() */
+    IntRect src = p->srcRect->toIntRect();
+    src.w = clamp<int>(src.w, 0, p->bitmap->width() - src.x);
+    src.h = clamp<int>(src.h, 0, p->bitmap->height() - src.y);
+    
+    if (lx < 0 || ly < 0 || lx >= src.w || ly >= src.h)
+        return false;
+    
+    if (alphaThreshold <= 0)
+        return true;
+    
+    const int bx = p->mirrored ? src.x + src.w - 1 - (int) lx : src.x + (int) lx;
+    const int by = src.y + (int) ly;
+    
+    return p->bitmap->hitAlpha(bx, by) >= alphaThreshold;
+}
+
 /* SceneElement */
 void Sprite::draw()
 {
@@ -672,42 +729,56 @@ void Sprite::draw()
             scalingMethod = NearestNeighbor;
         }
 
-        SpriteShader &shader = shState->shaders().sprite;
+        /* When both flashing and effective color are set,
+         * the one with higher alpha will be blended */
+        const Vec4 *blend = (flashing && flashColor.w > p->color->norm.w) ?
+        &flashColor : &p->color->norm;
+        
+        const bool renderPattern = p->pattern && p->patternOpacity > 0;
+        
+        /* Only compile in the effects this sprite actually uses */
+        unsigned variant = 0;
+        
+        if (renderPattern)
+            variant |= SpriteShader::Pattern | SpriteShader::patternBlendVariant(p->patternBlendType);
+        if (p->tone->hasEffect())
+            variant |= SpriteShader::Tone;
+        if (blend->w != 0)
+            variant |= SpriteShader::Color;
+        if (p->bushDepth != 0)
+            variant |= SpriteShader::Bush;
+        if (p->invert)
+            variant |= SpriteShader::Invert;
+        
+        SpriteShader &shader = shState->shaders().sprite.get(variant);
         
         shader.bind();
         shader.applyViewportProj();
         shader.setSpriteMat(p->trans.getMatrix());
-        
-        shader.setTone(p->tone->norm);
         shader.setOpacity(p->opacity.norm);
-        shader.setBushDepth(p->efBushDepth);
-        shader.setBushOpacity(p->bushOpacity.norm);
         
-        if (p->pattern && p->patternOpacity > 0) {
+        if (variant & SpriteShader::Tone)
+            shader.setTone(p->tone->norm);
+        
+        if (variant & SpriteShader::Bush) {
+            shader.setBushDepth(p->efBushDepth);
+            shader.setBushOpacity(p->bushOpacity.norm);
+        }
+        
+        if (renderPattern) {
             if (p->pattern->hasHires()) {
                 Debug() << "BUG: High-res Sprite pattern not implemented";
             }
 
             shader.setPattern(p->pattern->getGLTypes().tex, Vec2(p->pattern->width(), p->pattern->height()));
-            shader.setPatternBlendType(p->patternBlendType);
             shader.setPatternTile(p->patternTile);
             shader.setPatternZoom(p->patternZoom);
             shader.setPatternOpacity(p->patternOpacity.norm);
             shader.setPatternScroll(p->patternScroll);
-            shader.setShouldRenderPattern(true);
-        }
-        else {
-            shader.setShouldRenderPattern(false);
         }
         
-        shader.setInvert(p->invert);
-        
-        /* When both flashing and effective color are set,
-         * the one with higher alpha will be blended */
-        const Vec4 *blend = (flashing && flashColor.w > p->color->norm.w) ?
-        &flashColor : &p->color->norm;
-        
-        shader.setColor(*blend);
+        if (variant & SpriteShader::Color)
+            shader.setColor(*blend);
         
         base = &shader;
     }
@@ -784,14 +855,6 @@ void Sprite::draw()
     
     p->bitmap->bindTex(*base, false);
 
-#ifdef MKXPZ_SSL
-    if (scalingMethod == xBRZ)
-    {
-        XbrzShader &shader = shState->shaders().xbrz;
-        shader.setTargetScale(Vec2((float)(shState->config().xbrzScalingFactor), (float)(shState->config().xbrzScalingFactor)));
-    }
-#endif
-    
     TEX::setSmooth(scalingMethod == Bilinear);
 
     if (p->wave.active)
@@ -804,6 +867,61 @@ void Sprite::draw()
     glState.blendMode.pop();
 }
 
+bool Sprite::addCacheSignature(CacheSignature &sig) const
+{
+    /* Other blend types depend on what's already on screen */
+    if (p->blendType != BlendNormal)
+        return false;
+    
+    sig.add(p->isVisible);
+    sig.add(emptyFlashFlag);
+    
+    if (!p->isVisible || emptyFlashFlag)
+        return true;
+    
+    sig.add(p->bitmap->contentStamp());
+    sig.add(p->bitmap->animationFrame());
+    
+    sig.add(p->trans.getPosition());
+    sig.add(p->trans.getOrigin());
+    sig.add(p->trans.getScale());
+    sig.add(p->trans.getRotation());
+    sig.add(p->srcRect->toIntRect());
+    sig.add(p->mirrored);
+    
+    sig.add(p->opacity.unNorm);
+    sig.add(p->bushDepth);
+    sig.add(p->bushOpacity.unNorm);
+    sig.add(p->color->norm);
+    sig.add(p->tone->norm);
+    sig.add(p->invert);
+    
+    sig.add(flashing);
+    sig.add(flashColor);
+    
+    if (p->pattern && !p->pattern->isDisposed())
+    {
+        sig.add(p->pattern->contentStamp());
+        sig.add(p->pattern->animationFrame());
+        sig.add(p->patternBlendType);
+        sig.add(p->patternTile);
+        sig.add(p->patternOpacity.unNorm);
+        sig.add(p->patternScroll);
+        sig.add(p->patternZoom);
+    }
+    
+    sig.add(p->wave.active);
+    
+    if (p->wave.active)
+    {
+        sig.add(p->wave.amp);
+        sig.add(p->wave.length);
+        sig.add(p->wave.phase);
+    }
+    
+    return true;
+}
+
 void Sprite::onGeometryChange(const Scene::Geometry &geo)
 {
     /* Offset at which the sprite will be drawn
@@ -25,6 +25,7 @@
 #include "scene.h"
 #include "flashable.h"
 #include "disposable.h"
+#include "bindingslots.h"
 #include "viewport.h"
 #include "util.h"
 
@@ -35,7 +36,8 @@ struct Rect;
 
 struct SpritePrivate;
 
-class Sprite : public ViewportElement, public Flashable, public Disposable
+class Sprite : public ViewportElement, public Flashable, public Disposable,
+               public BindingSlots
 {
 public:
 	Sprite(Viewport *viewport = 0);
@@ -46,6 +48,12 @@ public:
 
 	void update();
 
+	/* Whether the screen pixel (x, y) lies on a pixel of this sprite
+	 * with at least 'alphaThreshold' alpha (0 only tests the bounds).
+	 * Takes position, origin, zoom, angle, mirror, src_rect and the
+	 * viewport into account, but not wave or bush depth */
+	bool hitTest(int x, int y, int alphaThreshold = 1);
+
 	DECL_ATTR( Bitmap,      Bitmap* )
 	DECL_ATTR( SrcRect,     Rect&   )
 	DECL_ATTR( X,           int     )
@@ -83,6 +91,8 @@ private:
 
 	void draw();
 	void onGeometryChange(const Scene::Geometry &);
+	Profiler::Section profileSection() const { return Profiler::Sprite; }
+	bool addCacheSignature(CacheSignature &sig) const;
 
 	void releaseResources();
 	const char *klassName() const { return "sprite"; }
@@ -27,6 +27,7 @@
 #include "gl-meta.h"
 #include "sharedstate.h"
 #include "global-ibo.h"
+#include "streambuffer.h"
 #include "glstate.h"
 #include "shader.h"
 #include "vertex.h"
@@ -115,19 +116,11 @@ struct FlashMap
 	FlashMap()
 		: dirty(false),
 	      data(0),
-	      allocQuads(0)
-	{
-		vao.vbo = VBO::gen();
-		vao.ibo = shState->globalIBO().ibo;
-		GLMeta::vaoFillInVertexData<CVertex>(vao);
-
-		GLMeta::vaoInit(vao);
-	}
+	      rangeDirty(true)
+	{}
 
 	~FlashMap()
 	{
-		GLMeta::vaoFini(vao);
-		VBO::del(vao.vbo);
 		dataCon.disconnect();
 	}
 
@@ -175,7 +168,14 @@ struct FlashMap
 		if (count == 0)
 			return;
 
-		GLMeta::vaoBind(vao);
+		StreamBuffer &stream = shState->streamBuffer();
+
+		if (rangeDirty || !stream.isValid(range))
+		{
+			range = stream.upload(dataPtr(vertices), count);
+			rangeDirty = false;
+		}
+
 		glState.blendMode.pushSet(BlendAddition);
 
 		FlashMapShader &shader = shState->shaders().flashMap;
@@ -184,11 +184,9 @@ struct FlashMap
 		shader.setAlpha(alpha);
 		shader.setTranslation(trans);
 
-		gl.DrawElements(GL_TRIANGLES, count * 6, _GL_INDEX_TYPE, 0);
+		stream.draw<CVertex>(range, 0, count);
 
 		glState.blendMode.pop();
-
-		GLMeta::vaoUnbind(vao);
 	}
 
 private:
@@ -245,23 +243,8 @@ private:
 					vertices.push_back(v[i]);
 			}
 
-		if (vertices.size() == 0)
-			return;
-
-		VBO::bind(vao.vbo);
-
-		if (quadCount() > allocQuads)
-		{
-			allocQuads = quadCount();
-			VBO::allocEmpty(sizeof(CVertex) * vertices.size());
-		}
-
-		VBO::uploadSubData(0, sizeof(CVertex) * vertices.size(), dataPtr(vertices));
-
-		VBO::unbind();
-
-		/* Ensure global IBO size */
-		shState->ensureQuadIBO(quadCount());
+		/* Streamed on the next draw */
+		rangeDirty = true;
 	}
 
 	bool dirty;
@@ -271,8 +254,8 @@ private:
 
 	IntRect viewp;
 
-	GLMeta::VAO vao;
-	size_t allocQuads;
+	StreamRange range;
+	bool rangeDirty;
 	std::vector<CVertex> vertices;
 };
 
@@ -199,6 +199,8 @@ struct GroundLayer : public ViewportElement
 
 	void onGeometryChange(const Scene::Geometry &geo);
 
+	Profiler::Section profileSection() const { return Profiler::Tilemap; }
+
 	ABOUT_TO_ACCESS_NOOP
 };
 
@@ -229,6 +231,8 @@ struct ZLayer : public ViewportElement
 	void initUpdateZ();
 	void finiUpdateZ(ZLayer *prev);
 
+	Profiler::Section profileSection() const { return Profiler::Tilemap; }
+
 	ABOUT_TO_ACCESS_NOOP
 };
 
@@ -23,6 +23,7 @@
 #define TILEMAP_H
 
 #include "disposable.h"
+#include "bindingslots.h"
 
 #include "util.h"
 
@@ -35,7 +36,7 @@ struct Tone;
 
 struct TilemapPrivate;
 
-class Tilemap : public Disposable
+class Tilemap : public Disposable, public BindingSlots
 {
 public:
 	class Autotiles
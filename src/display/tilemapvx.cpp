@@ -113,6 +113,8 @@ struct TilemapVXPrivate : public ViewportElement, TileAtlasVX::Reader
 			p->drawFlashLayer();
 		}
 
+		Profiler::Section profileSection() const { return Profiler::TilemapVX; }
+
 		ABOUT_TO_ACCESS_NOOP
 	};
 
@@ -323,6 +325,8 @@ struct TilemapVXPrivate : public ViewportElement, TileAtlasVX::Reader
 		drawFlashLayer();
 	}
 
+	Profiler::Section profileSection() const { return Profiler::TilemapVX; }
+
 	void drawGround()
 	{
 		if (groundQuads == 0)
@@ -23,6 +23,7 @@
 #define TILEMAPVX_H
 
 #include "disposable.h"
+#include "bindingslots.h"
 #include "util.h"
 
 class Viewport;
@@ -31,7 +32,7 @@ class Table;
 
 struct TilemapVXPrivate;
 
-class TilemapVX : public Disposable
+class TilemapVX : public Disposable, public BindingSlots
 {
 public:
 	class BitmapArray
@@ -21,17 +21,26 @@
 
 #include "viewport.h"
 
+#include "sprite.h"
 #include "sharedstate.h"
 #include "etc.h"
 #include "util.h"
 #include "quad.h"
 #include "glstate.h"
 #include "graphics.h"
+#include "gl-util.h"
+#include "texpool.h"
+#include "shader.h"
+#include "config.h"
 
 #include <SDL_rect.h>
 
 #include "sigslot/signal.hpp"
 
+/* Consecutive frames without a cache hit after
+ * which the cache texture is given back */
+#define VIEWPORT_CACHE_RELEASE_FRAMES 60
+
 struct ViewportPrivate
 {
 	/* Needed for geometry changes */
@@ -48,6 +57,26 @@ struct ViewportPrivate
 
 	EtcTemps tmp;
 
+	struct Cache
+	{
+		bool enabled;
+
+		/* Holds the composited children, premultiplied */
+		TEXFBO buffer;
+		bool valid;
+
+		/* Signature of the buffer contents, and of
+		 * what was drawn in the previous frame */
+		uint64_t signature;
+		uint64_t lastSignature;
+
+		int missStreak;
+		unsigned int hits;
+		unsigned int misses;
+
+		Quad quad;
+	} cache;
+
 	ViewportPrivate(int x, int y, int width, int height, Viewport *self)
 	    : self(self),
 	      rect(&tmp.rect),
@@ -57,11 +86,27 @@ struct ViewportPrivate
 	{
 		rect->set(x, y, width, height);
 		updateRectCon();
+
+		cache.enabled = shState->config().viewportCache;
+		cache.valid = false;
+		cache.signature = cache.lastSignature = 0;
+		cache.missStreak = 0;
+		cache.hits = cache.misses = 0;
 	}
 
 	~ViewportPrivate()
 	{
 		rectCon.disconnect();
+
+		releaseCache();
+	}
+
+	void releaseCache()
+	{
+		shState->texPool().release(cache.buffer);
+
+		cache.buffer = TEXFBO();
+		cache.valid = false;
 	}
 
 	void onRectChange()
@@ -197,7 +242,8 @@ void Viewport::composite()
 	glState.scissorTest.pushSet(true);
 	glState.scissorBox.pushSet(p->rect->toIntRect());
 
-	Scene::composite();
+	if (!p->cache.enabled || !compositeCached())
+		Scene::composite();
 
 	/* If any effects are visible, request parent Scene to
 	 * render them. */
@@ -209,6 +255,195 @@ void Viewport::composite()
 	glState.scissorTest.pop();
 }
 
+bool Viewport::compositeCached()
+{
+	ViewportPrivate::Cache &cache = p->cache;
+	const IntRect rect = p->rect->toIntRect();
+
+	/* The buffer is kept at native resolution */
+	if (shState->config().enableHires ||
+	    rect.w <= 0 || rect.h <= 0 ||
+	    rect.w > glState.caps.maxTexSize ||
+	    rect.h > glState.caps.maxTexSize)
+	{
+		p->releaseCache();
+		++cache.misses;
+
+		return false;
+	}
+
+	CacheSignature sig;
+	sig.add(rect.size());
+	sig.add(geometry.orig);
+
+	if (!addElementSignatures(sig))
+	{
+		cache.lastSignature = 0;
+		++cache.misses;
+
+		if (++cache.missStreak >= VIEWPORT_CACHE_RELEASE_FRAMES)
+			p->releaseCache();
+
+		return false;
+	}
+
+	const bool hit = cache.valid && sig.hash == cache.signature;
+	const bool stable = sig.hash == cache.lastSignature;
+	cache.lastSignature = sig.hash;
+
+	if (hit)
+	{
+		++cache.hits;
+		cache.missStreak = 0;
+	}
+	else
+	{
+		++cache.misses;
+
+		/* Only pay for rendering into the buffer once the
+		 * contents stayed the same for two frames in a row */
+		if (!stable)
+		{
+			if (++cache.missStreak >= VIEWPORT_CACHE_RELEASE_FRAMES)
+				p->releaseCache();
+
+			return false;
+		}
+
+		renderCache(rect.size());
+		cache.signature = sig.hash;
+	}
+
+	SimpleShader &shader = shState->shaders().simple;
+	shader.bind();
+	shader.applyViewportProj();
+	shader.setTranslation(Vec2i());
+	shader.setTexSize(Vec2i(cache.buffer.width, cache.buffer.height));
+
+	TEX::bind(cache.buffer.tex);
+
+	cache.quad.setTexPosRect(IntRect(0, 0, rect.w, rect.h), rect);
+
+	/* The buffer holds premultiplied color */
+	glState.blendMode.pushSet(BlendNormal);
+	gl.BlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+	                     GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	cache.quad.draw();
+
+	glState.blendMode.pop();
+	glState.blendMode.refresh();
+
+	return true;
+}
+
+void Viewport::renderCache(const Vec2i &size)
+{
+	ViewportPrivate::Cache &cache = p->cache;
+
+	if (cache.buffer.width != size.x || cache.buffer.height != size.y)
+	{
+		p->releaseCache();
+		cache.buffer = shState->texPool().request(size.x, size.y);
+	}
+
+	const FBO::ID prevFBO = FBO::boundFramebufferID;
+
+	FBO::bind(cache.buffer.fbo);
+	glState.viewport.pushSet(IntRect(0, 0, size.x, size.y));
+	glState.scissorBox.pushSet(IntRect(0, 0, size.x, size.y));
+	glState.clearColor.pushSet(Vec4());
+
+	FBO::clear();
+
+	/* Let the children draw relative to the buffer origin */
+	const IntRect rect = geometry.rect;
+	geometry.rect = IntRect(Vec2i(), size);
+	notifyGeometryChange();
+
+	Scene::composite();
+
+	geometry.rect = rect;
+	notifyGeometryChange();
+
+	glState.clearColor.pop();
+	glState.scissorBox.pop();
+	glState.viewport.pop();
+	FBO::bind(prevFBO);
+
+	cache.valid = true;
+}
+
+bool Viewport::addCacheSignature(CacheSignature &sig) const
+{
+	sig.add(p->rect->toIntRect());
+	sig.add(geometry.orig);
+	sig.add(p->color->norm);
+	sig.add(p->tone->norm);
+	sig.add(flashing);
+	sig.add(flashColor);
+	sig.add(emptyFlashFlag);
+
+	return addElementSignatures(sig);
+}
+
+void Viewport::setCache(bool value)
+{
+	guardDisposed();
+
+	if (p->cache.enabled == value)
+		return;
+
+	p->cache.enabled = value;
+	p->cache.lastSignature = 0;
+	p->cache.missStreak = 0;
+
+	if (!value)
+		p->releaseCache();
+}
+
+bool Viewport::getCache() const
+{
+	guardDisposed();
+
+	return p->cache.enabled;
+}
+
+void Viewport::getCacheStats(unsigned int &hits, unsigned int &misses) const
+{
+	guardDisposed();
+
+	hits = p->cache.hits;
+	misses = p->cache.misses;
+}
+
+Sprite *Viewport::pick(int x, int y, int alphaThreshold)
+{
+	guardDisposed();
+
+	const IntRect rect = p->rect->toIntRect();
+
+	if (!visible || x < rect.x || y < rect.y ||
+	    x >= rect.x + rect.w || y >= rect.y + rect.h)
+		return 0;
+
+	/* Draw order is only settled once a reorder batch ends */
+	if (reorderPending)
+		sortElements();
+
+	/* Later elements are drawn on top */
+	for (IntruListLink<SceneElement> *iter = elements.end()->prev;
+	     iter != elements.end(); iter = iter->prev)
+	{
+		Sprite *sprite = dynamic_cast<Sprite*>(iter->data);
+
+		if (sprite && sprite->hitTest(x, y, alphaThreshold))
+			return sprite;
+	}
+
+	return 0;
+}
+
 /* SceneElement */
 void Viewport::draw()
 {
@@ -25,11 +25,14 @@
 #include "scene.h"
 #include "flashable.h"
 #include "disposable.h"
+#include "bindingslots.h"
 #include "util.h"
 
+class Sprite;
 struct ViewportPrivate;
 
-class Viewport : public Scene, public SceneElement, public Flashable, public Disposable
+class Viewport : public Scene, public SceneElement, public Flashable, public Disposable,
+                 public BindingSlots
 {
 public:
 	Viewport(int x, int y, int width, int height);
@@ -47,13 +50,26 @@ public:
 
 	void initDynAttribs();
 
+	/* Render the children into a texture and reuse it
+	 * for as long as none of them change */
+	DECL_ATTR( Cache, bool )
+	void getCacheStats(unsigned int &hits, unsigned int &misses) const;
+
+	/* The topmost sprite of this viewport whose hit test succeeds
+	 * at screen pixel (x, y), or null */
+	Sprite *pick(int x, int y, int alphaThreshold = 1);
+
 private:
 	void initViewport(int x, int y, int width, int height);
 	void geometryChanged();
 
 	void composite();
+	bool compositeCached();
+	void renderCache(const Vec2i &size);
 	void draw();
 	void onGeometryChange(const Geometry &);
+	Profiler::Section profileSection() const { return Profiler::Viewport; }
+	bool addCacheSignature(CacheSignature &sig) const;
 	bool isEffectiveViewport(Rect *&, Color *&, Tone *&) const;
 
 	void releaseResources();
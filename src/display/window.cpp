@@ -223,6 +223,15 @@ struct WindowPrivate
 			p->drawControls();
 		}
 
+		Profiler::Section profileSection() const { return Profiler::Window; }
+
+		bool addCacheSignature(CacheSignature &sig) const
+		{
+			p->addControlsSignature(sig);
+
+			return true;
+		}
+
 		void release()
 		{
 			unlink();
@@ -682,6 +691,53 @@ struct WindowPrivate
 			controlsQuadArray.commit();
 	}
 
+	static void addBitmapSignature(CacheSignature &sig, Bitmap *bitmap)
+	{
+		if (nullOrDisposed(bitmap))
+		{
+			sig.add((uint64_t) 0);
+			return;
+		}
+
+		sig.add(bitmap->contentStamp());
+		sig.add(bitmap->animationFrame());
+	}
+
+	void addBaseSignature(CacheSignature &sig) const
+	{
+		addBitmapSignature(sig, windowskin);
+
+		sig.add(position);
+		sig.add(size);
+		sig.add(bgStretch);
+		sig.add(opacity.unNorm);
+		sig.add(backOpacity.unNorm);
+	}
+
+	void addControlsSignature(CacheSignature &sig) const
+	{
+		addBitmapSignature(sig, windowskin);
+		addBitmapSignature(sig, contents);
+
+		sig.add(position);
+		sig.add(size);
+		sig.add(contentsOffset);
+		sig.add(contentsOpacity.unNorm);
+		sig.add(cursorRect->toIntRect());
+		sig.add(active);
+		sig.add(pause);
+
+		/* Animation steps only matter while they're shown */
+		if (active && !cursorRect->isEmpty())
+			sig.add(cursorAniAlphaIdx);
+
+		if (pause)
+		{
+			sig.add(pauseAniAlphaIdx);
+			sig.add(pauseAniQuadIdx);
+		}
+	}
+
 	void stepAnimations()
 	{
 		if (++cursorAniAlphaIdx == cursorAniAlphaN)
@@ -900,6 +956,13 @@ void Window::draw()
 	p->drawBase();
 }
 
+bool Window::addCacheSignature(CacheSignature &sig) const
+{
+	p->addBaseSignature(sig);
+
+	return true;
+}
+
 void Window::onGeometryChange(const Scene::Geometry &geo)
 {
 	p->sceneOffset = geo.offset();
@@ -24,6 +24,7 @@
 
 #include "viewport.h"
 #include "disposable.h"
+#include "bindingslots.h"
 
 #include "util.h"
 
@@ -32,7 +33,7 @@ struct Rect;
 
 struct WindowPrivate;
 
-class Window : public ViewportElement, public Disposable
+class Window : public ViewportElement, public Disposable, public BindingSlots
 {
 public:
 	Window(Viewport *viewport = 0);
@@ -63,6 +64,8 @@ private:
 
 	void draw();
 	void onGeometryChange(const Scene::Geometry &);
+	Profiler::Section profileSection() const { return Profiler::Window; }
+	bool addCacheSignature(CacheSignature &sig) const;
 	void setZ(int value);
 	void setVisible(bool value);
 
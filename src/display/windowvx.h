@@ -24,6 +24,7 @@
 
 #include "viewport.h"
 #include "disposable.h"
+#include "bindingslots.h"
 
 #include "util.h"
 
@@ -33,7 +34,7 @@ struct Tone;
 
 struct WindowVXPrivate;
 
-class WindowVX : public ViewportElement, public Disposable
+class WindowVX : public ViewportElement, public Disposable, public BindingSlots
 {
 public:
 	WindowVX(Viewport *viewport = 0);
@@ -73,6 +74,7 @@ private:
 
 	void draw();
 	void onGeometryChange(const Scene::Geometry &);
+	Profiler::Section profileSection() const { return Profiler::WindowVX; }
 
 	void releaseResources();
 	const char *klassName() const { return "window"; }
@@ -47,6 +47,7 @@
 
 #include "al-util.h"
 #include "debugwriter.h"
+#include "trace.h"
 
 #ifndef __APPLE__
 #include "util/string-util.h"
@@ -401,6 +402,18 @@ void EventThread::process(RGSSThreadData &rtData)
                     break;
                 }
                 
+                if (event.key.keysym.scancode == SDL_SCANCODE_F3 && Trace::isRecording())
+                {
+                    std::string path = rtData.config.customDataPath + "trace.json";
+                    
+                    if (Trace::dump(path.c_str()))
+                        Debug() << "Trace written to" << path;
+                    else
+                        Debug() << "Failed to write trace to" << path;
+                    
+                    break;
+                }
+                
                 if (event.key.keysym.scancode == SDL_SCANCODE_F12)
                 {
                     if (!rtData.config.enableReset)
@@ -415,6 +428,8 @@ void EventThread::process(RGSSThreadData &rtData)
                     break;
                 }
                 
+                if (!keyStates[event.key.keysym.scancode])
+                    pushInputEvent(InputEvent::Key, event.key.keysym.scancode, true);
                 keyStates[event.key.keysym.scancode] = true;
                 break;
                 
@@ -429,14 +444,17 @@ void EventThread::process(RGSSThreadData &rtData)
                     break;
                 }
                 
+                pushInputEvent(InputEvent::Key, event.key.keysym.scancode, false);
                 keyStates[event.key.keysym.scancode] = false;
                 break;
                 
             case SDL_CONTROLLERBUTTONDOWN:
+                pushInputEvent(InputEvent::ControllerButton, event.cbutton.button, true);
                 controllerState.buttons[event.cbutton.button] = true;
                 break;
                 
             case SDL_CONTROLLERBUTTONUP:
+                pushInputEvent(InputEvent::ControllerButton, event.cbutton.button, false);
                 controllerState.buttons[event.cbutton.button] = false;
                 break;
                 
@@ -457,10 +475,12 @@ void EventThread::process(RGSSThreadData &rtData)
                 break;
                 
             case SDL_MOUSEBUTTONDOWN :
+                pushInputEvent(InputEvent::MouseButton, event.button.button, true);
                 mouseState.buttons[event.button.button] = true;
                 break;
                 
             case SDL_MOUSEBUTTONUP :
+                pushInputEvent(InputEvent::MouseButton, event.button.button, false);
                 mouseState.buttons[event.button.button] = false;
                 break;
                 
@@ -694,6 +714,20 @@ void EventThread::resetInputStates()
     memset(&controllerState, 0, sizeof(controllerState));
     memset(&mouseState.buttons, 0, sizeof(mouseState.buttons));
     memset(&touchState, 0, sizeof(touchState));
+    
+    inputResync.set();
+}
+
+void EventThread::pushInputEvent(InputEvent::Source source, int index, bool down)
+{
+    InputEvent e;
+    e.source = source;
+    e.down = down;
+    e.index = index;
+    e.time = SDL_GetPerformanceCounter();
+    
+    if (!inputEvents.push(e))
+        inputResync.set();
 }
 
 void EventThread::setFullscreen(SDL_Window *win, bool mode)
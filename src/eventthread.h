@@ -43,6 +43,25 @@ struct SDL_Window;
 union SDL_Event;
 
 #define MAX_FINGERS 4
+#define INPUT_EVENT_QUEUE_SIZE 1024
+
+/* A single button transition, as seen by the event thread */
+struct InputEvent
+{
+	enum Source
+	{
+		Key,
+		ControllerButton,
+		MouseButton
+	};
+
+	uint8_t source;
+	uint8_t down;
+	uint16_t index;
+
+	/* SDL_GetPerformanceCounter() at the time of the event */
+	uint64_t time;
+};
 
 class EventThread
 {
@@ -80,6 +99,12 @@ public:
     std::string textInputBuffer;
     void lockText(bool lock);
     
+    /* Every button transition in order, consumed by Input.update.
+     * If the queue overflows or the states are reset, 'inputResync'
+     * is set and Input falls back to the static state arrays */
+    SPSCRing<InputEvent, INPUT_EVENT_QUEUE_SIZE> inputEvents;
+    AtomicFlag inputResync;
+    
 
 	static bool allocUserEvents();
 
@@ -121,6 +146,7 @@ private:
 	static int eventFilter(void *, SDL_Event*);
 
 	void resetInputStates();
+	void pushInputEvent(InputEvent::Source source, int index, bool down);
 	void setFullscreen(SDL_Window *, bool mode);
 	void updateCursorState(bool inWindow,
 	                       const SDL_Rect &screen);
@@ -25,6 +25,7 @@
 #include "util/debugwriter.h"
 #include "util/exception.h"
 #include "util/util.h"
+#include "util/trace.h"
 #include "display/font.h"
 #include "crypto/rgssad.h"
 
@@ -612,6 +613,8 @@ openReadEnumCB(void *d, const char *dirpath, const char *filename) {
 }
 
 void FileSystem::openRead(OpenHandler &handler, const char *filename) {
+  TRACE_SCOPE("openRead", filename);
+
   std::string filename_nm = normalize(filename, false, false);
   char buffer[512];
   size_t len = strcpySafe(buffer, filename_nm.c_str(), sizeof(buffer), -1);
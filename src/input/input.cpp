@@ -24,6 +24,9 @@
 #include "sharedstate.h"
 #include "eventthread.h"
 #include "input/keybindings.h"
+#include "input/inputlog.h"
+#include "graphics.h"
+#include "debugwriter.h"
 #include "util/exception.h"
 #include "util/util.h"
 
@@ -31,6 +34,7 @@
 #include <SDL_keyboard.h>
 #include <SDL_mouse.h>
 #include <SDL_clipboard.h>
+#include <SDL_timer.h>
 
 #include <vector>
 #include <cmath>
@@ -475,14 +479,27 @@ struct ButtonState
     bool repeated;
     bool released;
     
+    /* Performance counter value of the press that
+     * triggered this button, 0 if unknown */
+    uint64_t pressTime;
+    
     ButtonState()
     : pressed(false),
     triggered(false),
     repeated(false),
-    released(false)
+    released(false),
+    pressTime(0)
     {}
 };
 
+/* Keys, controller buttons and mouse buttons share one flat
+ * index space for event timestamps (INPUT_MOUSE_BUTTONS
+ * comes from inputlog.h) */
+#define INPUT_SOURCE_KEY(i) (i)
+#define INPUT_SOURCE_BUTTON(i) (SDL_NUM_SCANCODES + (i))
+#define INPUT_SOURCE_MOUSE(i) (SDL_NUM_SCANCODES + SDL_CONTROLLER_BUTTON_MAX + (i))
+#define INPUT_SOURCE_COUNT INPUT_SOURCE_MOUSE(INPUT_MOUSE_BUTTONS)
+
 struct KbBindingData
 {
     SDL_Scancode source;
@@ -495,9 +512,13 @@ struct Binding
     : target(target)
     {}
     
-    virtual bool sourceActive() const = 0;
+    virtual bool sourceActive(const InputSnapshot &s) const = 0;
     virtual bool sourceRepeatable() const = 0;
     
+    /* Index into the flat input source table (see InputPrivate),
+     * or -1 for sources that don't produce timestamped events */
+    virtual int sourceId() const { return -1; }
+    
     Input::ButtonCode target;
 };
 
@@ -511,18 +532,23 @@ struct KbBinding : public Binding
     source(data.source)
     {}
     
-    bool sourceActive() const
+    bool sourceActive(const InputSnapshot &s) const
     {
         /* Special case aliases */
         if (source == SDL_SCANCODE_LSHIFT)
-            return EventThread::keyStates[source]
-            || EventThread::keyStates[SDL_SCANCODE_RSHIFT];
+            return s.keys[source]
+            || s.keys[SDL_SCANCODE_RSHIFT];
         
         if (source == SDL_SCANCODE_RETURN)
-            return EventThread::keyStates[source]
-            || EventThread::keyStates[SDL_SCANCODE_KP_ENTER];
+            return s.keys[source]
+            || s.keys[SDL_SCANCODE_KP_ENTER];
         
-        return EventThread::keyStates[source];
+        return s.keys[source];
+    }
+    
+    int sourceId() const
+    {
+        return INPUT_SOURCE_KEY(source);
     }
     
     bool sourceRepeatable() const
@@ -542,9 +568,14 @@ struct CtrlButtonBinding : public Binding
 {
     CtrlButtonBinding() {}
     
-    bool sourceActive() const
+    bool sourceActive(const InputSnapshot &s) const
+    {
+        return s.buttons[source];
+    }
+    
+    int sourceId() const
     {
-        return EventThread::controllerState.buttons[source];
+        return INPUT_SOURCE_BUTTON(source);
     }
     
     bool sourceRepeatable() const
@@ -562,9 +593,9 @@ struct CtrlAxisBinding : public Binding
     CtrlAxisBinding(uint8_t source, AxisDir dir, Input::ButtonCode target)
     : Binding(target), source(source), dir(dir) {}
     
-    bool sourceActive() const
+    bool sourceActive(const InputSnapshot &s) const
     {
-        float val = EventThread::controllerState.axes[source];
+        float val = s.axes[source];
         
         if (dir == Negative)
             return val < -JAXIS_THRESHOLD;
@@ -591,9 +622,14 @@ struct MsBinding : public Binding
     index(buttonIndex)
     {}
     
-    bool sourceActive() const
+    bool sourceActive(const InputSnapshot &s) const
     {
-        return EventThread::mouseState.buttons[index];
+        return s.mouseButtons[index];
+    }
+    
+    int sourceId() const
+    {
+        return INPUT_SOURCE_MOUSE(index);
     }
     
     bool sourceRepeatable() const
@@ -718,6 +754,28 @@ struct InputPrivate
 
     bool triedExit;
     
+    /* Raw state all bindings are polled from; captured from the
+     * event thread or fed back from a recording once per frame */
+    InputSnapshot snapshot;
+    InputRecorder recorder;
+    InputReplayer replayer;
+    bool replayDesynced;
+    
+    /* Timestamped transitions drained from the event thread.
+     * A source that goes down and back up between two updates is
+     * latched as pressed for one frame; its release (and anything
+     * after it) is carried over to the next update so taps shorter
+     * than a frame are never lost */
+    std::vector<InputEvent> carriedEvents;
+    std::vector<InputEvent> nextCarriedEvents;
+    uint8_t sourcePressed[INPUT_SOURCE_COUNT];
+    uint8_t sourceDeferred[INPUT_SOURCE_COUNT];
+    uint64_t sourcePressTime[INPUT_SOURCE_COUNT];
+    
+    /* Performance counter at the previous and current update */
+    uint64_t frameStart;
+    uint64_t frameUpdate;
+    
     struct
     {
         int active;
@@ -786,8 +844,195 @@ struct InputPrivate
         vScrollDistance = 0;
 
         triedExit = false;
+        
+        replayDesynced = false;
+        
+        memset(sourcePressTime, 0, sizeof(sourcePressTime));
+        frameStart = frameUpdate = SDL_GetPerformanceCounter();
+        
+        const Config &conf = rtData.config;
+        
+        if (!conf.inputReplay.empty()) {
+            if (replayer.open(conf.inputReplay.c_str()))
+                Debug() << "Replaying input from" << conf.inputReplay;
+            else
+                Debug() << "Failed to open input recording" << conf.inputReplay;
+        }
+        
+        if (!conf.inputRecord.empty()) {
+            if (recorder.open(conf.inputRecord.c_str()))
+                Debug() << "Recording input to" << conf.inputRecord;
+            else
+                Debug() << "Failed to create input recording" << conf.inputRecord;
+        }
+    }
+    
+    /* Text typed into the snapshot is owned by Input while recording
+     * or replaying, so both runs see exactly the same strings */
+    bool ownsText() const
+    {
+        return recorder.isOpen() || replayer.isOpen();
     }
     
+    static int eventSourceId(const InputEvent &e)
+    {
+        switch (e.source)
+        {
+        case InputEvent::Key:
+            if (e.index < SDL_NUM_SCANCODES)
+                return INPUT_SOURCE_KEY(e.index);
+            break;
+        case InputEvent::ControllerButton:
+            if (e.index < SDL_CONTROLLER_BUTTON_MAX)
+                return INPUT_SOURCE_BUTTON(e.index);
+            break;
+        case InputEvent::MouseButton:
+            if (e.index < INPUT_MOUSE_BUTTONS)
+                return INPUT_SOURCE_MOUSE(e.index);
+            break;
+        }
+        
+        return -1;
+    }
+    
+    void applyEvent(const InputEvent &e)
+    {
+        const int id = eventSourceId(e);
+        
+        if (id < 0)
+            return;
+        
+        if (sourceDeferred[id] || (!e.down && sourcePressed[id])) {
+            /* Keep per-source ordering: once one transition is
+             * deferred, every later one for that source is too */
+            sourceDeferred[id] = 1;
+            nextCarriedEvents.push_back(e);
+            return;
+        }
+        
+        switch (e.source)
+        {
+        case InputEvent::Key:
+            snapshot.keys[e.index] = e.down;
+            break;
+        case InputEvent::ControllerButton:
+            snapshot.buttons[e.index] = e.down;
+            break;
+        case InputEvent::MouseButton:
+            snapshot.mouseButtons[e.index] = e.down;
+            break;
+        }
+        
+        if (e.down) {
+            sourcePressed[id] = 1;
+            sourcePressTime[id] = e.time;
+        }
+    }
+    
+    void drainEvents(bool apply)
+    {
+        EventThread &et = shState->eThread();
+        
+        if (!apply || et.inputResync) {
+            /* States were reset behind our back or the queue overflowed;
+             * fall back to the event thread's current view */
+            et.inputResync.clear();
+            
+            while (et.inputEvents.front())
+                et.inputEvents.pop();
+            
+            carriedEvents.clear();
+            memset(sourcePressTime, 0, sizeof(sourcePressTime));
+            
+            if (!apply)
+                return;
+            
+            memcpy(snapshot.keys, EventThread::keyStates, sizeof(snapshot.keys));
+            
+            for (int i = 0; i < SDL_CONTROLLER_BUTTON_MAX; i++)
+                snapshot.buttons[i] = EventThread::controllerState.buttons[i];
+            
+            memcpy(snapshot.mouseButtons, EventThread::mouseState.buttons, sizeof(snapshot.mouseButtons));
+            
+            return;
+        }
+        
+        memset(sourcePressed, 0, sizeof(sourcePressed));
+        memset(sourceDeferred, 0, sizeof(sourceDeferred));
+        nextCarriedEvents.clear();
+        
+        for (const InputEvent &e : carriedEvents)
+            applyEvent(e);
+        
+        while (const InputEvent *e = et.inputEvents.front()) {
+            applyEvent(*e);
+            et.inputEvents.pop();
+        }
+        
+        carriedEvents.swap(nextCarriedEvents);
+    }
+    
+    void captureSnapshot()
+    {
+        EventThread &et = shState->eThread();
+        
+        drainEvents(true);
+        
+        for (int i = 0; i < SDL_CONTROLLER_AXIS_MAX; i++)
+            snapshot.axes[i] = EventThread::controllerState.axes[i];
+        
+        snapshot.mouseX = EventThread::mouseState.x;
+        snapshot.mouseY = EventThread::mouseState.y;
+        snapshot.mouseInWindow = EventThread::mouseState.inWindow;
+        
+        /* Fetch new cumulative scroll distance and reset counter */
+        snapshot.scroll = SDL_AtomicSet(&EventThread::verticalScrollDistance, 0);
+        
+        snapshot.text.clear();
+        
+        if (recorder.isOpen()) {
+            et.lockText(true);
+            snapshot.text.swap(et.textInputBuffer);
+            et.lockText(false);
+        }
+    }
+    
+    void updateSnapshot()
+    {
+        const int frameCount = shState->graphics().getFrameCount();
+        
+        if (replayer.isOpen()) {
+            int recordedFrame;
+            
+            if (replayer.readFrame(recordedFrame, snapshot)) {
+                if (recordedFrame != frameCount && !replayDesynced) {
+                    Debug() << "Input replay desynced: frame" << frameCount << "was recorded as" << recordedFrame;
+                    replayDesynced = true;
+                }
+                
+                /* Live events are meaningless while replaying,
+                 * but must not pile up in the queue */
+                drainEvents(false);
+            } else {
+                Debug() << "Input replay finished at frame" << frameCount;
+                shState->eThread().inputResync.set();
+                captureSnapshot();
+            }
+        } else {
+            captureSnapshot();
+        }
+        
+        recorder.writeFrame(frameCount, snapshot);
+        
+        if (ownsText()) {
+            textBuffer += snapshot.text;
+            if (textBuffer.size() > 512)
+                textBuffer.resize(512);
+        }
+    }
+    
+    std::string textBuffer;
+    
     inline ButtonState &getStateCheck(int code)
     {
         int index;
@@ -1002,7 +1247,7 @@ struct InputPrivate
     {
         for (Binding *bind : bindings) {
             // Get all binding states
-            pollBindingPriv(*bind, repeatCand);
+            pollBindingPriv(*bind, snapshot, repeatCand);
         }
         
         for (Binding *bind : bindings) {
@@ -1019,9 +1264,10 @@ struct InputPrivate
     }
     
     void pollBindingPriv(const Binding &b,
+                         const InputSnapshot &s,
                          Input::ButtonCode &repeatCand)
     {
-        if (!b.sourceActive())
+        if (!b.sourceActive(s))
             return;
         
         if (b.target == Input::None)
@@ -1033,8 +1279,13 @@ struct InputPrivate
         state.pressed = true;
         
         /* Must have been released before to trigger */
-        if (!oldState.pressed)
+        if (!oldState.pressed) {
             state.triggered = true;
+            
+            const int id = b.sourceId();
+            if (id >= 0 && sourcePressTime[id] > state.pressTime)
+                state.pressTime = sourcePressTime[id];
+        }
         
         /* Unbound keys don't create/break repeat */
         if (repeatCand != Input::None)
@@ -1054,7 +1305,7 @@ struct InputPrivate
     void updateRaw()
     {
         
-        memcpy(rawStates, shState->eThread().keyStates, SDL_NUM_SCANCODES);
+        memcpy(rawStates, snapshot.keys, SDL_NUM_SCANCODES);
         
         for (int i = 0; i < SDL_NUM_SCANCODES; i++)
         {
@@ -1082,9 +1333,9 @@ struct InputPrivate
     void updateControllerRaw()
     {
         for (int i = 0; i < SDL_CONTROLLER_AXIS_MAX; i++)
-            axisStateArray[i] = shState->eThread().controllerState.axes[i];
+            axisStateArray[i] = snapshot.axes[i];
         
-        memcpy(rawButtonStates, shState->eThread().controllerState.buttons, SDL_CONTROLLER_BUTTON_MAX);
+        memcpy(rawButtonStates, snapshot.buttons, SDL_CONTROLLER_BUTTON_MAX);
         
         for (int i = 0; i < SDL_CONTROLLER_BUTTON_MAX; i++)
         {
@@ -1210,6 +1461,12 @@ void Input::update()
     p->swapBuffers();
     p->clearBuffer();
     
+    p->frameStart = p->frameUpdate;
+    p->frameUpdate = SDL_GetPerformanceCounter();
+    
+    p->updateSnapshot();
+    p->vScrollDistance = p->snapshot.scroll;
+    
     ButtonCode repeatCand = None;
     
     /* Poll all bindings */
@@ -1220,9 +1477,9 @@ void Input::update()
     p->updateControllerRaw();
     
     // Record mouse positions
-    p->mousePos[0] = shState->eThread().mouseState.x;
-    p->mousePos[1] = shState->eThread().mouseState.y;
-    p->mouseInWindow = shState->eThread().mouseState.inWindow;
+    p->mousePos[0] = p->snapshot.mouseX;
+    p->mousePos[1] = p->snapshot.mouseY;
+    p->mouseInWindow = p->snapshot.mouseInWindow;
     
     
     /* Check for new repeating key */
@@ -1257,9 +1514,6 @@ void Input::update()
     }
     
     p->repeating = None;
-    
-    /* Fetch new cumulative scroll distance and reset counter */
-    p->vScrollDistance = SDL_AtomicSet(&EventThread::verticalScrollDistance, 0);
 
     RGSSThreadData &rtData = shState->rtData();
 	p->triedExit = rtData.triedExit;
@@ -1321,6 +1575,28 @@ double Input::repeatTime(int button) {
     return shState->runTime() - p->repeatTime;
 }
 
+bool Input::pressTime(int button, double &out)
+{
+    const ButtonState &state = p->getStateCheck(button);
+    
+    if (!state.triggered || !state.pressTime)
+        return false;
+    
+    out = ((double)(int64_t)(state.pressTime - p->frameStart)) / SDL_GetPerformanceFrequency();
+    return true;
+}
+
+bool Input::pressLatency(int button, double &out)
+{
+    const ButtonState &state = p->getStateCheck(button);
+    
+    if (!state.triggered || !state.pressTime)
+        return false;
+    
+    out = ((double)(int64_t)(p->frameUpdate - state.pressTime)) / SDL_GetPerformanceFrequency();
+    return true;
+}
+
 bool Input::isPressedEx(int code, bool isVKey)
 {
     return p->getStateRaw(code, isVKey).pressed;
@@ -1497,14 +1773,28 @@ void Input::setTextInputMode(bool mode)
 
 const char *Input::getText()
 {
+    if (p->ownsText())
+        return p->textBuffer.c_str();
+    
     return shState->eThread().textInputBuffer.c_str();
 }
 
 void Input::clearText()
 {
+    p->textBuffer.clear();
     shState->eThread().textInputBuffer.clear();
 }
 
+bool Input::isRecording()
+{
+    return p->recorder.isOpen();
+}
+
+bool Input::isReplaying()
+{
+    return p->replayer.isOpen();
+}
+
 char *Input::getClipboardText()
 {
     char *tx = SDL_GetClipboardText();
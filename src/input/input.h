@@ -70,6 +70,14 @@ public:
     unsigned int count(int button);
     double repeatTime(int button);
     
+    /* When the press that triggered 'button' this frame happened, in
+     * seconds relative to the previous update (negative if it was held
+     * over from an earlier frame), and how long before this update it
+     * happened. Return false if the button wasn't triggered or the
+     * press has no timestamp (eg. during replay) */
+    bool pressTime(int button, double &out);
+    bool pressLatency(int button, double &out);
+    
     bool isPressedEx(int code, bool isVKey);
     bool isTriggeredEx(int code, bool isVKey);
     bool isRepeatedEx(int code, bool isVKey);
@@ -117,6 +125,10 @@ public:
     const char *getButtonName(SDL_GameControllerButton button);
 
     bool hasQuit();
+    
+    /* Input recording / replay (see "inputRecord", "inputReplay") */
+    bool isRecording();
+    bool isReplaying();
 
 private:
 	Input(const RGSSThreadData &rtData);
@@ -0,0 +1,379 @@
+/*
+** inputlog.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "inputlog.h"
+
+#include "sdl-util.h"
+
+#include <SDL_endian.h>
+#include <string.h>
+#include <algorithm>
+
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+#error "Non little endian systems not supported"
+#endif
+
+static const char logMagic[] = "MKXPINP";
+static const uint8_t logVersion = 1;
+
+enum
+{
+	SectionKeys    = 1 << 0,
+	SectionButtons = 1 << 1,
+	SectionAxes    = 1 << 2,
+	SectionMouse   = 1 << 3,
+	SectionScroll  = 1 << 4,
+	SectionText    = 1 << 5
+};
+
+InputSnapshot::InputSnapshot()
+    : mouseX(0), mouseY(0),
+      mouseInWindow(false),
+      scroll(0)
+{
+	memset(keys, 0, sizeof(keys));
+	memset(buttons, 0, sizeof(buttons));
+	memset(axes, 0, sizeof(axes));
+	memset(mouseButtons, 0, sizeof(mouseButtons));
+}
+
+template<typename T>
+static void put(std::vector<uint8_t> &buf, T value)
+{
+	const uint8_t *p = (const uint8_t*) &value;
+	buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+static bool get(const std::string &data, size_t &pos, T &value)
+{
+	if (data.size() - pos < sizeof(T))
+		return false;
+
+	memcpy(&value, &data[pos], sizeof(T));
+	pos += sizeof(T);
+
+	return true;
+}
+
+static uint32_t mouseButtonBits(const InputSnapshot &snap)
+{
+	uint32_t bits = 0;
+
+	for (int i = 0; i < INPUT_MOUSE_BUTTONS; ++i)
+		if (snap.mouseButtons[i])
+			bits |= (1u << i);
+
+	return bits;
+}
+
+InputRecorder::InputRecorder()
+    : ops(0)
+{}
+
+InputRecorder::~InputRecorder()
+{
+	close();
+}
+
+bool InputRecorder::open(const char *filename)
+{
+	close();
+
+	ops = RWFromFile(filename, "wb");
+
+	if (!ops)
+		return false;
+
+	SDL_RWwrite(ops, logMagic, 1, sizeof(logMagic));
+	SDL_RWwrite(ops, &logVersion, 1, 1);
+
+	last = InputSnapshot();
+
+	return true;
+}
+
+void InputRecorder::close()
+{
+	if (!ops)
+		return;
+
+	SDL_RWclose(ops);
+	ops = 0;
+}
+
+void InputRecorder::writeFrame(int frameCount, const InputSnapshot &snap)
+{
+	if (!ops)
+		return;
+
+	buf.clear();
+	put<uint32_t>(buf, frameCount);
+	put<uint8_t>(buf, 0);
+
+	uint8_t mask = 0;
+
+	/* Keys */
+	size_t countPos = buf.size();
+	uint16_t count = 0;
+	put<uint16_t>(buf, 0);
+
+	for (int i = 0; i < SDL_NUM_SCANCODES; ++i)
+	{
+		if (snap.keys[i] == last.keys[i])
+			continue;
+
+		put<uint16_t>(buf, i);
+		put<uint8_t>(buf, snap.keys[i]);
+		++count;
+	}
+
+	if (count)
+	{
+		memcpy(&buf[countPos], &count, sizeof(count));
+		mask |= SectionKeys;
+	}
+	else
+	{
+		buf.resize(countPos);
+	}
+
+	/* Controller buttons */
+	countPos = buf.size();
+	uint8_t smallCount = 0;
+	put<uint8_t>(buf, 0);
+
+	for (int i = 0; i < SDL_CONTROLLER_BUTTON_MAX; ++i)
+	{
+		if (snap.buttons[i] == last.buttons[i])
+			continue;
+
+		put<uint8_t>(buf, i);
+		put<uint8_t>(buf, snap.buttons[i]);
+		++smallCount;
+	}
+
+	if (smallCount)
+	{
+		buf[countPos] = smallCount;
+		mask |= SectionButtons;
+	}
+	else
+	{
+		buf.resize(countPos);
+	}
+
+	/* Controller axes */
+	countPos = buf.size();
+	smallCount = 0;
+	put<uint8_t>(buf, 0);
+
+	for (int i = 0; i < SDL_CONTROLLER_AXIS_MAX; ++i)
+	{
+		if (snap.axes[i] == last.axes[i])
+			continue;
+
+		put<uint8_t>(buf, i);
+		put<int16_t>(buf, snap.axes[i]);
+		++smallCount;
+	}
+
+	if (smallCount)
+	{
+		buf[countPos] = smallCount;
+		mask |= SectionAxes;
+	}
+	else
+	{
+		buf.resize(countPos);
+	}
+
+	/* Mouse */
+	const uint32_t mouseBits = mouseButtonBits(snap);
+
+	if (snap.mouseX != last.mouseX || snap.mouseY != last.mouseY ||
+	    snap.mouseInWindow != last.mouseInWindow || mouseBits != mouseButtonBits(last))
+	{
+		put<int32_t>(buf, snap.mouseX);
+		put<int32_t>(buf, snap.mouseY);
+		put<uint8_t>(buf, snap.mouseInWindow);
+		put<uint32_t>(buf, mouseBits);
+		mask |= SectionMouse;
+	}
+
+	/* Scroll and text are per-frame deltas */
+	if (snap.scroll)
+	{
+		put<int32_t>(buf, snap.scroll);
+		mask |= SectionScroll;
+	}
+
+	if (!snap.text.empty())
+	{
+		const uint16_t len = std::min<size_t>(snap.text.size(), UINT16_MAX);
+		put<uint16_t>(buf, len);
+		buf.insert(buf.end(), snap.text.begin(), snap.text.begin() + len);
+		mask |= SectionText;
+	}
+
+	buf[sizeof(uint32_t)] = mask;
+
+	SDL_RWwrite(ops, &buf[0], 1, buf.size());
+
+	memcpy(last.keys, snap.keys, sizeof(last.keys));
+	memcpy(last.buttons, snap.buttons, sizeof(last.buttons));
+	memcpy(last.axes, snap.axes, sizeof(last.axes));
+	memcpy(last.mouseButtons, snap.mouseButtons, sizeof(last.mouseButtons));
+	last.mouseX = snap.mouseX;
+	last.mouseY = snap.mouseY;
+	last.mouseInWindow = snap.mouseInWindow;
+}
+
+InputReplayer::InputReplayer()
+    : pos(0)
+{}
+
+bool InputReplayer::open(const char *filename)
+{
+	data.clear();
+	pos = 0;
+
+	if (!readFileSDL(filename, data))
+		return false;
+
+	const size_t headerSize = sizeof(logMagic) + 1;
+
+	if (data.size() < headerSize || memcmp(&data[0], logMagic, sizeof(logMagic))
+	    || (uint8_t) data[sizeof(logMagic)] != logVersion)
+	{
+		data.clear();
+		return false;
+	}
+
+	pos = headerSize;
+
+	return true;
+}
+
+bool InputReplayer::readFrame(int &frameCount, InputSnapshot &snap)
+{
+	uint32_t frame;
+	uint8_t mask;
+
+	if (!get(data, pos, frame) || !get(data, pos, mask))
+		goto corrupt;
+
+	frameCount = frame;
+	snap.scroll = 0;
+	snap.text.clear();
+
+	if (mask & SectionKeys)
+	{
+		uint16_t count;
+		if (!get(data, pos, count))
+			goto corrupt;
+
+		for (uint16_t i = 0; i < count; ++i)
+		{
+			uint16_t key;
+			uint8_t state;
+			if (!get(data, pos, key) || !get(data, pos, state) || key >= SDL_NUM_SCANCODES)
+				goto corrupt;
+
+			snap.keys[key] = state;
+		}
+	}
+
+	if (mask & SectionButtons)
+	{
+		uint8_t count;
+		if (!get(data, pos, count))
+			goto corrupt;
+
+		for (uint8_t i = 0; i < count; ++i)
+		{
+			uint8_t button, state;
+			if (!get(data, pos, button) || !get(data, pos, state) || button >= SDL_CONTROLLER_BUTTON_MAX)
+				goto corrupt;
+
+			snap.buttons[button] = state;
+		}
+	}
+
+	if (mask & SectionAxes)
+	{
+		uint8_t count;
+		if (!get(data, pos, count))
+			goto corrupt;
+
+		for (uint8_t i = 0; i < count; ++i)
+		{
+			uint8_t axis;
+			int16_t value;
+			if (!get(data, pos, axis) || !get(data, pos, value) || axis >= SDL_CONTROLLER_AXIS_MAX)
+				goto corrupt;
+
+			snap.axes[axis] = value;
+		}
+	}
+
+	if (mask & SectionMouse)
+	{
+		int32_t x, y;
+		uint8_t inWindow;
+		uint32_t bits;
+		if (!get(data, pos, x) || !get(data, pos, y) || !get(data, pos, inWindow) || !get(data, pos, bits))
+			goto corrupt;
+
+		snap.mouseX = x;
+		snap.mouseY = y;
+		snap.mouseInWindow = inWindow;
+
+		for (int i = 0; i < INPUT_MOUSE_BUTTONS; ++i)
+			snap.mouseButtons[i] = (bits >> i) & 1;
+	}
+
+	if (mask & SectionScroll)
+	{
+		int32_t scroll;
+		if (!get(data, pos, scroll))
+			goto corrupt;
+
+		snap.scroll = scroll;
+	}
+
+	if (mask & SectionText)
+	{
+		uint16_t len;
+		if (!get(data, pos, len) || data.size() - pos < len)
+			goto corrupt;
+
+		snap.text.assign(&data[pos], len);
+		pos += len;
+	}
+
+	return true;
+
+corrupt:
+	/* Treat a truncated record like the end of the recording */
+	data.clear();
+	pos = 0;
+
+	return false;
+}
@@ -0,0 +1,99 @@
+/*
+** inputlog.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <SDL_scancode.h>
+#include <SDL_gamecontroller.h>
+#include <SDL_rwops.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define INPUT_MOUSE_BUTTONS 32
+
+/* Raw input state as seen by one Input.update call */
+struct InputSnapshot
+{
+	uint8_t keys[SDL_NUM_SCANCODES];
+	uint8_t buttons[SDL_CONTROLLER_BUTTON_MAX];
+	int16_t axes[SDL_CONTROLLER_AXIS_MAX];
+
+	int mouseX, mouseY;
+	bool mouseInWindow;
+	bool mouseButtons[INPUT_MOUSE_BUTTONS];
+
+	/* Scroll distance accumulated since the previous frame */
+	int scroll;
+
+	/* Text typed since the previous frame */
+	std::string text;
+
+	InputSnapshot();
+};
+
+/* Writes one delta-encoded record per frame:
+ *
+ *   u32 frame count, u8 section mask, then for each set bit:
+ *   keys     u16 n, n * (u16 scancode, u8 state)
+ *   buttons  u8 n,  n * (u8 button, u8 state)
+ *   axes     u8 n,  n * (u8 axis, i16 value)
+ *   mouse    i32 x, i32 y, u8 in window, u32 button bits
+ *   scroll   i32 distance
+ *   text     u16 length, bytes */
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool open(const char *filename);
+	void close();
+
+	bool isOpen() const { return ops != 0; }
+
+	void writeFrame(int frameCount, const InputSnapshot &snap);
+
+private:
+	SDL_RWops *ops;
+	InputSnapshot last;
+	std::vector<uint8_t> buf;
+};
+
+class InputReplayer
+{
+public:
+	InputReplayer();
+
+	bool open(const char *filename);
+
+	bool isOpen() const { return pos < data.size(); }
+
+	/* Applies the next recorded frame on top of 'snap', which must
+	 * hold the state left by the previous call. Returns false once
+	 * the recording is exhausted (or corrupt) */
+	bool readFrame(int &frameCount, InputSnapshot &snap);
+
+private:
+	std::string data;
+	size_t pos;
+};
+
+#endif // INPUTLOG_H
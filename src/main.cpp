@@ -41,6 +41,7 @@
 #include "eventthread.h"
 #include "util/debugwriter.h"
 #include "util/exception.h"
+#include "util/trace.h"
 #include "display/gl/gl-debug.h"
 #include "display/gl/gl-fun.h"
 
@@ -119,6 +120,8 @@ static SDL_GLContext initGL(SDL_Window *win, Config &conf,
 int rgssThreadFun(void *userdata) {
   RGSSThreadData *threadData = static_cast<RGSSThreadData *>(userdata);
 
+  Trace::setThreadName("rgss");
+
 #ifdef MKXPZ_INIT_GL_LATER
   threadData->glContext =
       initGL(threadData->window, threadData->config, threadData);
@@ -440,6 +443,9 @@ int main(int argc, char *argv[]) {
     initTouchBar(win, conf);
 #endif
 
+    Trace::setThreadName("event");
+    Trace::setRecording(conf.enableTracing);
+
     /* Start RGSS thread */
     SDL_Thread *rgssThread = SDL_CreateThread(rgssThreadFun, "rgss", &rtData);
 
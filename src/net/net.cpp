@@ -17,6 +17,11 @@
 #include "LUrlParser.h"
 #include "net.h"
 
+#include <deque>
+#include <thread>
+#include <vector>
+#include <string.h>
+
 const char* httpErrorNames[] = {
     "Success",
     "Unknown",
@@ -112,34 +117,134 @@ StringMap &HTTPRequest::headers() {
     return _headers;
 }
 
-HTTPResponse HTTPRequest::get() {
-    HTTPResponse ret;
-    auto target = readURL(destination.c_str());
+namespace {
+
+// Idle clients kept per scheme/host/port
+#define HTTP_POOL_MAX_IDLE 4
+
+// Background threads serving the async requests
+#define HTTP_ASYNC_WORKERS 4
+
+// Keeps finished clients (and so their keep-alive connections)
+// around for the next request to the same host
+struct ClientPool {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<httplib::Client*>> idle;
     
-    httplib::Client *client = nullptr;
-    try {
-        client = new httplib::Client(getHost(target).c_str());
+    httplib::Client *acquire(const std::string &host) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &clients = idle[host];
+            
+            if (!clients.empty()) {
+                httplib::Client *client = clients.back();
+                clients.pop_back();
+                return client;
+            }
+        }
+        
+        httplib::Client *client = nullptr;
+        try {
+            client = new httplib::Client(host.c_str());
+        }
+        catch (std::exception &e) {
+            delete client;
+            throw Exception(Exception::MKXPError, "Failed to create HTTP client (%s)", e.what());
+        }
+        
+        // Seems to need to be disabled for now, at least on macOS
+#ifdef MKXPZ_SSL
+        client->enable_server_certificate_verification(false);
+#endif
+        client->set_keep_alive(true);
+        
+        return client;
     }
-    catch (std::exception &e) {
+    
+    void release(const std::string &host, httplib::Client *client) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &clients = idle[host];
+            
+            if (clients.size() < HTTP_POOL_MAX_IDLE) {
+                clients.push_back(client);
+                return;
+            }
+        }
+        
         delete client;
-        throw Exception(Exception::MKXPError, "Failed to create HTTP client (%s)", e.what());
     }
+};
+
+struct TaskQueue {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<HTTPTaskPtr> tasks;
+    int workers = 0;
+    int idleWorkers = 0;
+    
+    void push(HTTPTaskPtr task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(task);
+        
+        if (idleWorkers == 0 && workers < HTTP_ASYNC_WORKERS) {
+            workers++;
+            std::thread(&TaskQueue::work, this).detach();
+        }
+        
+        cond.notify_one();
+    }
+    
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        
+        for (;;) {
+            idleWorkers++;
+            cond.wait(lock, [this] { return !tasks.empty(); });
+            idleWorkers--;
+            
+            HTTPTaskPtr task = tasks.front();
+            tasks.pop_front();
+            
+            lock.unlock();
+            task->run();
+            lock.lock();
+        }
+    }
+};
+
+// Both are never destroyed, as detached workers may
+// still be using them while the program exits
+ClientPool &clientPool() {
+    static ClientPool *pool = new ClientPool;
+    return *pool;
+}
+
+TaskQueue &taskQueue() {
+    static TaskQueue *queue = new TaskQueue;
+    return *queue;
+}
+
+}
+
+template<typename Perform>
+HTTPResponse HTTPRequest::perform(const char *method, Perform fn) {
+    HTTPResponse ret;
+    auto target = readURL(destination.c_str());
+    std::string host = getHost(target);
     
+    httplib::Client *client = clientPool().acquire(host);
     httplib::Headers head;
     
-    // Seems to need to be disabled for now, at least on macOS
-#ifdef MKXPZ_SSL
-    client->enable_server_certificate_verification(false);
-#endif
     client->set_follow_location(follow_location);
     
     for (auto const &h : _headers)
         head.emplace(h.first, h.second);
-        
-    if (auto result = client->Get(getPath(target).c_str(), head)) {
-        auto response = result.value();
+    
+    if (auto result = fn(*client, getPath(target), head)) {
+        auto &response = result.value();
         ret._status = response.status;
-        ret._body = response.body;
+        ret._body = std::move(response.body);
         
         for (auto const &h : response.headers)
             ret._headers.emplace(h.first, h.second);
@@ -147,98 +252,183 @@ HTTPResponse HTTPRequest::get() {
     else {
         auto err = result.error();
         std::string errname = httplib::to_string(err);
+        
+        // The connection is in an unknown state, don't reuse it
         delete client;
-        throw Exception(Exception::MKXPError, "Failed to GET %s (%i: %s)", destination.c_str(), err, errname.c_str());
+        throw Exception(Exception::MKXPError, "Failed to %s %s (%i: %s)", method, destination.c_str(), err, errname.c_str());
     }
     
-    delete client;
+    clientPool().release(host, client);
     return ret;
 }
 
+HTTPResponse HTTPRequest::get() {
+    return perform("GET", [](httplib::Client &client, const std::string &path,
+                             const httplib::Headers &head) {
+        return client.Get(path, head);
+    });
+}
+
 HTTPResponse HTTPRequest::post(StringMap &postData) {
+    httplib::Params params;
+    
+    for (auto const &p : postData)
+        params.emplace(p.first, p.second);
+    
+    return perform("POST", [&](httplib::Client &client, const std::string &path,
+                               const httplib::Headers &head) {
+        return client.Post(path, head, params);
+    });
+}
+
+HTTPResponse HTTPRequest::post(const char *body, const char *content_type) {
+    return perform("POST", [&](httplib::Client &client, const std::string &path,
+                               const httplib::Headers &head) {
+        return client.Post(path, head, body, strlen(body), content_type);
+    });
+}
+
+HTTPResponse HTTPRequest::download(const char *path) {
+    std::string partPath = std::string(path) + ".part";
+    FILE *file = nullptr;
+    int status = 0;
+    
     HTTPResponse ret;
-    auto target = readURL(destination.c_str());
+    std::string errorBody;
     
-    httplib::Client *client = nullptr;
     try {
-        client = new httplib::Client(getHost(target).c_str());
+        ret = perform("GET", [&](httplib::Client &client, const std::string &urlPath,
+                                 const httplib::Headers &head) {
+            return client.Get(urlPath, head,
+                              [&](const httplib::Response &response) {
+                                  status = response.status;
+                                  return true;
+                              },
+                              [&](const char *data, size_t length) {
+                                  // Keep error pages in memory, like any other response
+                                  if (status < 200 || status >= 300) {
+                                      errorBody.append(data, length);
+                                      return true;
+                                  }
+                                  
+                                  if (!file)
+                                      file = fopen(partPath.c_str(), "wb");
+                                  
+                                  return file && fwrite(data, 1, length, file) == length;
+                              });
+        });
     }
-    catch (std::exception &e) {
-        delete client;
-        throw Exception(Exception::MKXPError, "Failed to create HTTP client (%s)", e.what());
+    catch (const Exception &) {
+        if (file) {
+            fclose(file);
+            remove(partPath.c_str());
+        }
+        throw;
     }
     
-    httplib::Headers head;
-    httplib::Params params;
-    
-    // Seems to need to be disabled for now, at least on macOS
-#ifdef MKXPZ_SSL
-    client->enable_server_certificate_verification(false);
-#endif
-    client->set_follow_location(follow_location);
+    ret._body = errorBody;
     
-    for (auto const &h : _headers)
-        head.emplace(h.first, h.second);
+    if (status < 200 || status >= 300)
+        return ret;
     
-    for (auto const &p : postData)
-        params.emplace(p.first, p.second);
+    // Empty bodies never opened the file
+    if (!file)
+        file = fopen(partPath.c_str(), "wb");
     
-    if (auto result = client->Post(getPath(target).c_str(), head, params)) {
-        auto response = result.value();
-        ret._status = response.status;
-        ret._body = response.body;
-        
-        for (auto h : response.headers)
-            ret._headers.emplace(h.first, h.second);
+    if (!file || fclose(file) != 0) {
+        remove(partPath.c_str());
+        throw Exception(Exception::MKXPError, "Failed to write %s", path);
     }
-    else {
-        auto err = result.error();
-        std::string errname = httplib::to_string(err);
-        delete client;
-        throw Exception(Exception::MKXPError, "Failed to POST %s (%i: %s)", destination.c_str(), err, errname.c_str());
+    
+    remove(path);
+    if (rename(partPath.c_str(), path) != 0) {
+        remove(partPath.c_str());
+        throw Exception(Exception::MKXPError, "Failed to write %s", path);
     }
-    delete client;
+    
     return ret;
 }
 
-HTTPResponse HTTPRequest::post(const char *body, const char *content_type) {
-    HTTPResponse ret;
-    auto target = readURL(destination.c_str());
+HTTPTaskPtr HTTPRequest::getAsync() {
+    HTTPRequest req(*this);
+    HTTPTaskPtr task(new HTTPTask([req]() mutable { return req.get(); }));
     
-    httplib::Client *client = nullptr;
-    try {
-        client = new httplib::Client(getHost(target).c_str());
-    }
-    catch (std::exception &e) {
-        delete client;
-        throw Exception(Exception::MKXPError, "Failed to create HTTP client (%s)", e.what());
-    }
+    taskQueue().push(task);
+    return task;
+}
+
+HTTPTaskPtr HTTPRequest::postAsync(const StringMap &postData) {
+    HTTPRequest req(*this);
+    StringMap data(postData);
+    HTTPTaskPtr task(new HTTPTask([req, data]() mutable { return req.post(data); }));
     
-    httplib::Headers head;
+    taskQueue().push(task);
+    return task;
+}
+
+HTTPTaskPtr HTTPRequest::postAsync(const std::string &body, const std::string &content_type) {
+    HTTPRequest req(*this);
+    HTTPTaskPtr task(new HTTPTask([req, body, content_type]() mutable {
+        return req.post(body.c_str(), content_type.c_str());
+    }));
     
-    // Seems to need to be disabled for now, at least on macOS
-#ifdef MKXPZ_SSL
-    client->enable_server_certificate_verification(false);
-#endif
-    client->set_follow_location(true);
+    taskQueue().push(task);
+    return task;
+}
+
+HTTPTaskPtr HTTPRequest::downloadAsync(const std::string &path) {
+    HTTPRequest req(*this);
+    HTTPTaskPtr task(new HTTPTask([req, path]() mutable { return req.download(path.c_str()); }));
     
-    for (auto const &h : _headers)
-        head.emplace(h.first, h.second);
+    taskQueue().push(task);
+    return task;
+}
 
-    if (auto result = client->Post(getPath(target).c_str(), head, body, content_type)) {
-        auto response = result.value();
-        ret._status = response.status;
-        ret._body = response.body;
-        
-        for (auto const &h : response.headers)
-            ret._headers.emplace(h.first, h.second);
+HTTPTask::HTTPTask(std::function<HTTPResponse()> job) :
+    job(job),
+    done(false),
+    failed(false),
+    error(Exception::MKXPError, "")
+{}
+
+void HTTPTask::run() {
+    HTTPResponse res;
+    bool fail = false;
+    Exception exc(Exception::MKXPError, "");
+    
+    try {
+        res = job();
     }
-    else {
-        auto err = result.error();
-        std::string errname = httplib::to_string(err);
-        delete client;
-        throw Exception(Exception::MKXPError, "Failed to POST %s (%i: %s)", destination.c_str(), err, errname.c_str());
+    catch (const Exception &e) {
+        exc = e;
+        fail = true;
     }
-    delete client;
-    return ret;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    result = std::move(res);
+    failed = fail;
+    error = exc;
+    done = true;
+    job = nullptr;
+    
+    finished.notify_all();
+}
+
+bool HTTPTask::isDone() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return done;
+}
+
+void HTTPTask::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return done; });
+}
+
+HTTPResponse &HTTPTask::response() {
+    wait();
+    
+    if (failed)
+        throw error;
+    
+    return result;
 }
@@ -10,6 +10,12 @@
 
 #include <unordered_map>
 #include <string>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+#include "util/exception.h"
 
 namespace mkxp_net {
 
@@ -17,6 +23,7 @@ typedef std::unordered_map<std::string, std::string> StringMap;
 
 class HTTPResponse {
 public:
+    HTTPResponse();
     int status();
     std::string &body();
     StringMap &headers();
@@ -26,11 +33,42 @@ private:
     int _status;
     std::string _body;
     StringMap _headers;
-    HTTPResponse();
     
     friend class HTTPRequest;
 };
 
+// A request running on one of the background HTTP workers
+class HTTPTask {
+public:
+    bool isDone();
+    
+    // Blocks until the request has finished
+    void wait();
+    
+    // Only valid once done. Throws if the request failed
+    HTTPResponse &response();
+    
+    // Called by the worker thread
+    void run();
+    
+private:
+    HTTPTask(std::function<HTTPResponse()> job);
+    
+    std::function<HTTPResponse()> job;
+    
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done;
+    
+    HTTPResponse result;
+    bool failed;
+    Exception error;
+    
+    friend class HTTPRequest;
+};
+
+typedef std::shared_ptr<HTTPTask> HTTPTaskPtr;
+
 class HTTPRequest {
 public:
     HTTPRequest(const char *dest, bool follow_redirects = true);
@@ -43,7 +81,23 @@ public:
     HTTPResponse get();
     HTTPResponse post(StringMap &postData);
     HTTPResponse post(const char *body, const char *content_type);
+    
+    // Writes the body of a successful (2xx) response to 'path' as it
+    // arrives, leaving the returned body empty. Other responses are
+    // returned as usual and leave the file untouched
+    HTTPResponse download(const char *path);
+    
+    // Same as above, but run on a background worker. The request is
+    // copied, so this object may go away in the meantime
+    HTTPTaskPtr getAsync();
+    HTTPTaskPtr postAsync(const StringMap &postData);
+    HTTPTaskPtr postAsync(const std::string &body, const std::string &content_type);
+    HTTPTaskPtr downloadAsync(const std::string &path);
+    
 private:
+    template<typename Perform>
+    HTTPResponse perform(const char *method, Perform fn);
+    
     StringMap _headers;
     bool follow_location;
 };
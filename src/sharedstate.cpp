@@ -29,10 +29,12 @@
 #include "glstate.h"
 #include "shader.h"
 #include "texpool.h"
+#include "profiler.h"
 #include "font.h"
 #include "eventthread.h"
 #include "gl-util.h"
 #include "global-ibo.h"
+#include "streambuffer.h"
 #include "quad.h"
 #include "binding.h"
 #include "exception.h"
@@ -48,6 +50,7 @@
 SharedState *SharedState::instance = 0;
 int SharedState::rgssVersion = 0;
 static GlobalIBO *_globalIBO = 0;
+static StreamBuffer *_streamBuffer = 0;
 
 static const char *gameArchExt()
 {
@@ -88,6 +91,8 @@ struct SharedStatePrivate
 
 	TexPool texPool;
 
+	Profiler profiler;
+
 	SharedFontState fontState;
 	Font *defaultFont;
 
@@ -104,6 +109,7 @@ struct SharedStatePrivate
 	unsigned int stampCounter;
     
     std::chrono::time_point<std::chrono::steady_clock> startupTime;
+    double fixedTime;
 
 	SharedStatePrivate(RGSSThreadData *threadData)
 	    : bindingData(0),
@@ -119,7 +125,8 @@ struct SharedStatePrivate
 				oneshot(*threadData),
 	      _glState(threadData->config),
 	      fontState(threadData->config),
-	      stampCounter(0)
+	      stampCounter(0),
+	      fixedTime(0)
 	{}
 	
 	void init(RGSSThreadData *threadData)
@@ -127,10 +134,6 @@ struct SharedStatePrivate
         
         startupTime = std::chrono::steady_clock::now();
         
-		/* Shaders have been compiled in ShaderSet's constructor */
-		if (gl.ReleaseShaderCompiler)
-			gl.ReleaseShaderCompiler();
-
 		std::string archPath = config.execName + gameArchExt();
 
 		for (size_t i = 0; i < config.patches.size(); ++i)
@@ -194,6 +197,8 @@ void SharedState::initInstance(RGSSThreadData *threadData)
 	_globalIBO = new GlobalIBO();
 	_globalIBO->ensureSize(1);
 
+	_streamBuffer = new StreamBuffer(_globalIBO->ibo);
+
 	SharedState::instance = 0;
 	Font *defaultFont = 0;
 
@@ -205,6 +210,7 @@ void SharedState::initInstance(RGSSThreadData *threadData)
 	}
 	catch (const Exception &exc)
 	{
+		delete _streamBuffer;
 		delete _globalIBO;
 		delete SharedState::instance;
 		delete defaultFont;
@@ -221,6 +227,7 @@ void SharedState::finiInstance()
 
 	delete SharedState::instance;
 
+	delete _streamBuffer;
 	delete _globalIBO;
 }
 
@@ -249,6 +256,7 @@ GSATT(Oneshot&, oneshot);
 GSATT(GLState&, _glState)
 GSATT(ShaderSet&, shaders)
 GSATT(TexPool&, texPool)
+GSATT(Profiler&, profiler)
 GSATT(Quad&, gpQuad)
 GSATT(SharedFontState&, fontState)
 GSATT(SharedMidiState&, midiState)
@@ -268,6 +276,11 @@ GlobalIBO &SharedState::globalIBO()
 	return *_globalIBO;
 }
 
+StreamBuffer &SharedState::streamBuffer()
+{
+	return *_streamBuffer;
+}
+
 void SharedState::bindTex()
 {
 	TEX::bind(p->globalTex);
@@ -377,10 +390,15 @@ Font &SharedState::defaultFont() const
 
 double SharedState::runTime() {
     if (!p) return 0;
+    if (p->config.fixedTimestep) return p->fixedTime;
     const auto now = std::chrono::steady_clock::now();
     return std::chrono::duration_cast<std::chrono::microseconds>(now - p->startupTime).count() / 1000.0 / 1000.0;
 }
 
+void SharedState::advanceFixedTime(double seconds) {
+    p->fixedTime += seconds;
+}
+
 unsigned int SharedState::genTimeStamp()
 {
 	return p->stampCounter++;
@@ -32,6 +32,7 @@
 struct SharedStatePrivate;
 struct RGSSThreadData;
 struct GlobalIBO;
+class StreamBuffer;
 struct SDL_Window;
 struct TEXFBO;
 struct Quad;
@@ -45,6 +46,7 @@ class Input;
 class Audio;
 class GLState;
 class TexPool;
+class Profiler;
 class Font;
 class SharedFontState;
 struct GlobalIBO;
@@ -81,6 +83,8 @@ struct SharedState
 
 	TexPool &texPool() const;
 
+	Profiler &profiler() const;
+
 	SharedFontState &fontState() const;
 	Font &defaultFont() const;
 	SharedMidiState &midiState() const;
@@ -91,12 +95,18 @@ struct SharedState
     
     // Returns time since SharedState was constructed in microseconds
     double runTime();
+    
+    /* Advances runTime() when "fixedTimestep" is enabled */
+    void advanceFixedTime(double seconds);
 
 	/* Returns global quad IBO, and ensures it has indices
 	 * for at least minSize quads */
 	void ensureQuadIBO(size_t minSize);
 	GlobalIBO &globalIBO();
 
+	/* Ring buffer all dynamic quad geometry is streamed into */
+	StreamBuffer &streamBuffer();
+
 	/* Global general purpose texture */
 	void bindTex();
 	void ensureTexSize(int minW, int minH, Vec2i &currentSizeOut);
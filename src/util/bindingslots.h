@@ -0,0 +1,70 @@
+/*
+** bindingslots.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BINDINGSLOTS_H
+#define BINDINGSLOTS_H
+
+#include <stdint.h>
+
+/* Fixed storage the binding keeps the script side wrappers of an
+ * object's properties in (eg. a Sprite's Bitmap and Color objects),
+ * so accessors don't have to look them up by name. The values are
+ * opaque here; the binding is responsible for keeping them alive.
+ * Slots belong to one wrapper and are never copied along */
+class BindingSlots
+{
+public:
+	enum { SlotCount = 8 };
+
+	BindingSlots()
+	{
+		clearSlots();
+	}
+
+	BindingSlots(const BindingSlots &)
+	{
+		clearSlots();
+	}
+
+	BindingSlots &operator=(const BindingSlots &)
+	{
+		return *this;
+	}
+
+	uintptr_t getSlot(int index) const
+	{
+		return bindingSlots[index];
+	}
+
+	void setSlot(int index, uintptr_t value)
+	{
+		bindingSlots[index] = value;
+	}
+
+private:
+	void clearSlots()
+	{
+		for (int i = 0; i < SlotCount; ++i)
+			bindingSlots[i] = 0;
+	}
+
+	uintptr_t bindingSlots[SlotCount];
+};
+
+#endif // BINDINGSLOTS_H
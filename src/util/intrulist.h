@@ -133,6 +133,16 @@ public:
 		return &root;
 	}
 
+	const IntruListLink<T> *begin() const
+	{
+		return root.next;
+	}
+
+	const IntruListLink<T> *end() const
+	{
+		return &root;
+	}
+
 	bool isEmpty() const
 	{
 		return root.next == &root;
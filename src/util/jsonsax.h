@@ -0,0 +1,612 @@
+/*
+** jsonsax.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JSONSAX_H
+#define JSONSAX_H
+
+#include <stdexcept>
+#include <string>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Event based JSON5 parser: instead of building a document, it
+ * reports every value to a handler as soon as it is read, so the
+ * handler can construct its own representation directly.
+ * Accepts everything JSON5 allows (comments, trailing commas,
+ * single quoted strings, unquoted keys, hex numbers, NaN and
+ * Infinity...). The handler has to provide:
+ *
+ *   void null();
+ *   void boolean(bool value);
+ *   void number(double value);
+ *   void string(const char *str, size_t len);
+ *   void key(const char *str, size_t len);
+ *   void startArray();   void endArray();
+ *   void startObject();  void endObject();
+ *
+ * Strings are passed in UTF-8 and are only valid during the call */
+
+struct JSONSaxError : std::runtime_error
+{
+	JSONSaxError(const std::string &msg)
+	    : std::runtime_error(msg)
+	{}
+};
+
+template<class Handler>
+class JSONSaxParser
+{
+public:
+	/* Nesting deeper than this is rejected
+	 * instead of overflowing the stack */
+	enum { MaxDepth = 512 };
+
+	JSONSaxParser(const char *data, size_t len, Handler &handler)
+	    : begin(data),
+	      p(data),
+	      end(data + len),
+	      handler(handler)
+	{}
+
+	void parse()
+	{
+		/* UTF-8 byte order mark */
+		if (end - p >= 3 && !memcmp(p, "\xEF\xBB\xBF", 3))
+			p += 3;
+
+		skipSpace();
+		parseValue(0);
+		skipSpace();
+
+		if (p != end)
+			fail("Unexpected trailing data");
+	}
+
+private:
+	const char *begin;
+	const char *p;
+	const char *end;
+	Handler &handler;
+
+	/* Scratch space for strings with escapes */
+	std::string buffer;
+
+	void fail(const char *what)
+	{
+		int line = 1, column = 1;
+
+		for (const char *c = begin; c < p && c < end; ++c)
+		{
+			if (*c == '\n')
+			{
+				++line;
+				column = 1;
+			}
+			else
+			{
+				++column;
+			}
+		}
+
+		char msg[128];
+		snprintf(msg, sizeof(msg), "%s at line %d, column %d", what, line, column);
+
+		throw JSONSaxError(msg);
+	}
+
+	bool atEnd() const { return p >= end; }
+
+	bool matchWord(const char *word)
+	{
+		size_t len = strlen(word);
+
+		if ((size_t) (end - p) < len || memcmp(p, word, len))
+			return false;
+
+		/* Don't match prefixes of identifiers */
+		if ((size_t) (end - p) > len && isIdentChar((unsigned char) p[len]))
+			return false;
+
+		p += len;
+
+		return true;
+	}
+
+	static bool isIdentStart(unsigned char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+		    || c == '_' || c == '$' || c >= 0x80;
+	}
+
+	static bool isIdentChar(unsigned char c)
+	{
+		return isIdentStart(c) || (c >= '0' && c <= '9');
+	}
+
+	void skipSpace()
+	{
+		while (p < end)
+		{
+			unsigned char c = *p;
+
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f')
+			{
+				++p;
+			}
+			else if (c == '/' && p + 1 < end && p[1] == '/')
+			{
+				while (p < end && *p != '\n')
+					++p;
+			}
+			else if (c == '/' && p + 1 < end && p[1] == '*')
+			{
+				p += 2;
+
+				while (p + 1 < end && !(p[0] == '*' && p[1] == '/'))
+					++p;
+
+				if (p + 1 >= end)
+					fail("Unterminated comment");
+
+				p += 2;
+			}
+			/* Non breaking space, line/paragraph separators, BOM */
+			else if (c == 0xC2 && p + 1 < end && (unsigned char) p[1] == 0xA0)
+			{
+				p += 2;
+			}
+			else if (c == 0xE2 && end - p >= 3 && (unsigned char) p[1] == 0x80
+			         && ((unsigned char) p[2] == 0xA8 || (unsigned char) p[2] == 0xA9))
+			{
+				p += 3;
+			}
+			else if (c == 0xEF && end - p >= 3 && !memcmp(p, "\xEF\xBB\xBF", 3))
+			{
+				p += 3;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	void parseValue(int depth)
+	{
+		if (atEnd())
+			fail("Unexpected end of input");
+
+		switch (*p)
+		{
+		case '{':
+			parseObject(depth + 1);
+			return;
+
+		case '[':
+			parseArray(depth + 1);
+			return;
+
+		case '"':
+		case '\'':
+		{
+			size_t len;
+			const char *str = parseString(len);
+			handler.string(str, len);
+			return;
+		}
+
+		case 'n':
+			if (matchWord("null"))
+			{
+				handler.null();
+				return;
+			}
+			break;
+
+		case 't':
+			if (matchWord("true"))
+			{
+				handler.boolean(true);
+				return;
+			}
+			break;
+
+		case 'f':
+			if (matchWord("false"))
+			{
+				handler.boolean(false);
+				return;
+			}
+			break;
+
+		default:
+			handler.number(parseNumber());
+			return;
+		}
+
+		fail("Unexpected token");
+	}
+
+	void parseArray(int depth)
+	{
+		if (depth > MaxDepth)
+			fail("Nesting too deep");
+
+		++p;
+		handler.startArray();
+
+		for (;;)
+		{
+			skipSpace();
+
+			if (atEnd())
+				fail("Unterminated array");
+
+			if (*p == ']')
+				break;
+
+			parseValue(depth);
+			skipSpace();
+
+			if (atEnd())
+				fail("Unterminated array");
+
+			if (*p == ',')
+				++p;
+			else if (*p != ']')
+				fail("Expected ',' or ']'");
+		}
+
+		++p;
+		handler.endArray();
+	}
+
+	void parseObject(int depth)
+	{
+		if (depth > MaxDepth)
+			fail("Nesting too deep");
+
+		++p;
+		handler.startObject();
+
+		for (;;)
+		{
+			skipSpace();
+
+			if (atEnd())
+				fail("Unterminated object");
+
+			if (*p == '}')
+				break;
+
+			parseKey();
+			skipSpace();
+
+			if (atEnd() || *p != ':')
+				fail("Expected ':'");
+
+			++p;
+			skipSpace();
+			parseValue(depth);
+			skipSpace();
+
+			if (atEnd())
+				fail("Unterminated object");
+
+			if (*p == ',')
+				++p;
+			else if (*p != '}')
+				fail("Expected ',' or '}'");
+		}
+
+		++p;
+		handler.endObject();
+	}
+
+	void parseKey()
+	{
+		if (*p == '"' || *p == '\'')
+		{
+			size_t len;
+			const char *str = parseString(len);
+			handler.key(str, len);
+			return;
+		}
+
+		if (!isIdentStart((unsigned char) *p))
+			fail("Expected object key");
+
+		const char *start = p;
+
+		while (p < end && isIdentChar((unsigned char) *p))
+			++p;
+
+		handler.key(start, p - start);
+	}
+
+	static int hexValue(char c)
+	{
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+
+		return -1;
+	}
+
+	unsigned readHex(int digits)
+	{
+		if (end - p < digits)
+			fail("Invalid escape");
+
+		unsigned value = 0;
+
+		for (int i = 0; i < digits; ++i)
+		{
+			int h = hexValue(p[i]);
+
+			if (h < 0)
+				fail("Invalid escape");
+
+			value = value * 16 + h;
+		}
+
+		p += digits;
+
+		return value;
+	}
+
+	void appendUTF8(uint32_t cp)
+	{
+		if (cp < 0x80)
+		{
+			buffer += (char) cp;
+		}
+		else if (cp < 0x800)
+		{
+			buffer += (char) (0xC0 | (cp >> 6));
+			buffer += (char) (0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000)
+		{
+			buffer += (char) (0xE0 | (cp >> 12));
+			buffer += (char) (0x80 | ((cp >> 6) & 0x3F));
+			buffer += (char) (0x80 | (cp & 0x3F));
+		}
+		else
+		{
+			buffer += (char) (0xF0 | (cp >> 18));
+			buffer += (char) (0x80 | ((cp >> 12) & 0x3F));
+			buffer += (char) (0x80 | ((cp >> 6) & 0x3F));
+			buffer += (char) (0x80 | (cp & 0x3F));
+		}
+	}
+
+	/* Returns a pointer either into the input (no escapes)
+	 * or into 'buffer' */
+	const char *parseString(size_t &len)
+	{
+		const char quote = *p++;
+		const char *start = p;
+
+		/* Fast path: plain run up to the closing quote */
+		while (p < end && *p != quote && *p != '\\' && *p != '\n' && *p != '\r')
+			++p;
+
+		if (p < end && *p == quote)
+		{
+			len = p - start;
+			++p;
+
+			return start;
+		}
+
+		buffer.assign(start, p - start);
+
+		for (;;)
+		{
+			if (atEnd())
+				fail("Unterminated string");
+
+			char c = *p++;
+
+			if (c == quote)
+				break;
+
+			if (c == '\n' || c == '\r')
+				fail("Unescaped line break in string");
+
+			if (c != '\\')
+			{
+				buffer += c;
+				continue;
+			}
+
+			if (atEnd())
+				fail("Unterminated string");
+
+			c = *p++;
+
+			switch (c)
+			{
+			case 'b': buffer += '\b'; break;
+			case 'f': buffer += '\f'; break;
+			case 'n': buffer += '\n'; break;
+			case 'r': buffer += '\r'; break;
+			case 't': buffer += '\t'; break;
+			case 'v': buffer += '\v'; break;
+			case '0':
+				if (p < end && *p >= '0' && *p <= '9')
+					fail("Invalid escape");
+				buffer += '\0';
+				break;
+			case 'x':
+				appendUTF8(readHex(2));
+				break;
+			case 'u':
+			{
+				uint32_t cp = readHex(4);
+
+				/* Surrogate pair */
+				if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6
+				    && p[0] == '\\' && p[1] == 'u')
+				{
+					const char *save = p;
+					p += 2;
+					uint32_t low = readHex(4);
+
+					if (low >= 0xDC00 && low <= 0xDFFF)
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+					else
+						p = save;
+				}
+
+				appendUTF8(cp);
+				break;
+			}
+			/* Line continuation */
+			case '\r':
+				if (p < end && *p == '\n')
+					++p;
+				break;
+			case '\n':
+				break;
+			default:
+				if (c >= '1' && c <= '9')
+					fail("Invalid escape");
+
+				buffer += c;
+			}
+		}
+
+		len = buffer.size();
+
+		return buffer.data();
+	}
+
+	double parseNumber()
+	{
+		const char *start = p;
+		bool negative = false;
+
+		if (*p == '+' || *p == '-')
+		{
+			negative = (*p == '-');
+			++p;
+		}
+
+		if (matchWord("Infinity"))
+			return negative ? -INFINITY : INFINITY;
+
+		if (matchWord("NaN"))
+			return NAN;
+
+		if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+		{
+			p += 2;
+
+			double value = 0;
+			const char *digits = p;
+
+			while (p < end && hexValue(*p) >= 0)
+				value = value * 16 + hexValue(*p++);
+
+			if (p == digits)
+				fail("Invalid number");
+
+			return negative ? -value : value;
+		}
+
+		const char *digits = p;
+
+		while (p < end && *p >= '0' && *p <= '9')
+			++p;
+
+		bool hasDigits = (p != digits);
+
+		if (p < end && *p == '.')
+		{
+			++p;
+
+			while (p < end && *p >= '0' && *p <= '9')
+			{
+				++p;
+				hasDigits = true;
+			}
+		}
+
+		if (!hasDigits)
+		{
+			p = start;
+			fail("Unexpected token");
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			++p;
+
+			if (p < end && (*p == '+' || *p == '-'))
+				++p;
+
+			const char *expDigits = p;
+
+			while (p < end && *p >= '0' && *p <= '9')
+				++p;
+
+			if (p == expDigits)
+				fail("Invalid number");
+		}
+
+		/* strtod needs a terminated copy; most numbers are short */
+		char local[64];
+		std::string large;
+		const size_t len = p - start;
+		const char *text;
+
+		if (len < sizeof(local))
+		{
+			memcpy(local, start, len);
+			local[len] = '\0';
+			text = local;
+		}
+		else
+		{
+			large.assign(start, len);
+			text = large.c_str();
+		}
+
+		return strtod(text, 0);
+	}
+};
+
+/* Parses 'len' bytes of 'data', feeding every value to 'handler'.
+ * Throws JSONSaxError on malformed input */
+template<class Handler>
+inline void jsonSaxParse(const char *data, size_t len, Handler &handler)
+{
+	JSONSaxParser<Handler> parser(data, len, handler);
+	parser.parse();
+}
+
+#endif // JSONSAX_H
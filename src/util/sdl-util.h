@@ -46,6 +46,68 @@ private:
 	mutable SDL_atomic_t atom;
 };
 
+/* Bounded single-producer / single-consumer queue over a
+ * preallocated slot array. 'push' may only be called from one
+ * thread and 'front'/'pop' from one other; neither side ever
+ * blocks or takes a lock. 'capacity' must be a power of two */
+template<typename T, unsigned capacity>
+class SPSCRing
+{
+public:
+	SPSCRing()
+	{
+		SDL_AtomicSet(&head, 0);
+		SDL_AtomicSet(&tail, 0);
+	}
+
+	/* Producer side. Returns false if the ring is full */
+	bool push(const T &value)
+	{
+		const unsigned t = SDL_AtomicGet(&tail);
+
+		if (t - (unsigned) SDL_AtomicGet(&head) == capacity)
+			return false;
+
+		slots[t & (capacity-1)] = value;
+		SDL_AtomicSet(&tail, t + 1);
+
+		return true;
+	}
+
+	bool full() const
+	{
+		return size() == capacity;
+	}
+
+	/* Consumer side. Returns null if the ring is empty. The slot
+	 * stays owned by the consumer until it is popped */
+	T *front()
+	{
+		const unsigned h = SDL_AtomicGet(&head);
+
+		if (h == (unsigned) SDL_AtomicGet(&tail))
+			return 0;
+
+		return &slots[h & (capacity-1)];
+	}
+
+	void pop()
+	{
+		SDL_AtomicAdd(&head, 1);
+	}
+
+	unsigned size() const
+	{
+		return (unsigned) SDL_AtomicGet(&tail) - (unsigned) SDL_AtomicGet(&head);
+	}
+
+private:
+	static_assert((capacity & (capacity-1)) == 0, "SPSCRing capacity must be a power of two");
+
+	T slots[capacity];
+	mutable SDL_atomic_t head, tail;
+};
+
 template<class C, void (C::*func)()>
 int __sdlThreadFun(void *obj)
 {
@@ -0,0 +1,301 @@
+/*
+** trace.cpp
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+
+#include <SDL_atomic.h>
+#include <SDL_thread.h>
+#include <SDL_timer.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/* Events kept per thread; must be a power of two */
+#define TRACE_RING_SIZE 8192
+
+/* Buffers of finished threads are recycled once this many exist */
+#define TRACE_MAX_THREADS 64
+
+/* Slots right behind the write head that a concurrent dump skips,
+ * as the writer may be about to overwrite them */
+#define TRACE_DUMP_MARGIN 64
+
+namespace Trace
+{
+
+std::atomic<bool> recording(false);
+
+namespace
+{
+
+struct Event
+{
+	uint64_t start;
+	uint64_t end;
+	const char *name;
+	char detail[40];
+};
+
+struct ThreadBuffer
+{
+	char name[32];
+	unsigned long tid;
+
+	/* Total number of events ever written */
+	std::atomic<uint32_t> written;
+
+	/* The owning thread has exited */
+	std::atomic<bool> retired;
+
+	Event events[TRACE_RING_SIZE];
+};
+
+std::vector<ThreadBuffer*> buffers;
+SDL_SpinLock buffersLock = 0;
+
+uint64_t timeBase = 0;
+
+/* Retires the thread's buffer on thread exit */
+struct ThreadHandle
+{
+	ThreadBuffer *buf;
+	char name[32];
+
+	ThreadHandle() : buf(0) { name[0] = '\0'; }
+
+	~ThreadHandle()
+	{
+		if (buf)
+			buf->retired.store(true);
+	}
+};
+
+thread_local ThreadHandle handle;
+
+void copyString(char *dst, size_t size, const char *src)
+{
+	strncpy(dst, src, size - 1);
+	dst[size - 1] = '\0';
+}
+
+ThreadBuffer *acquireBuffer()
+{
+	ThreadBuffer *buf = 0;
+
+	SDL_AtomicLock(&buffersLock);
+
+	if (buffers.size() >= TRACE_MAX_THREADS)
+	{
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			if (buffers[i]->retired.load())
+			{
+				buf = buffers[i];
+				break;
+			}
+		}
+	}
+
+	if (!buf && buffers.size() < TRACE_MAX_THREADS)
+	{
+		buf = new ThreadBuffer;
+		buffers.push_back(buf);
+	}
+
+	if (buf)
+	{
+		buf->tid = SDL_ThreadID();
+		buf->written.store(0);
+		buf->retired.store(false);
+
+		if (handle.name[0])
+			copyString(buf->name, sizeof(buf->name), handle.name);
+		else
+			snprintf(buf->name, sizeof(buf->name), "thread %lu", buf->tid);
+	}
+
+	SDL_AtomicUnlock(&buffersLock);
+
+	return buf;
+}
+
+void record(const char *name, uint64_t start, uint64_t end, const char *detail)
+{
+	if (!handle.buf)
+	{
+		handle.buf = acquireBuffer();
+
+		/* Too many live threads; drop the event */
+		if (!handle.buf)
+			return;
+	}
+
+	ThreadBuffer &buf = *handle.buf;
+	uint32_t index = buf.written.load(std::memory_order_relaxed);
+
+	/* The slot may still hold event 'index - TRACE_RING_SIZE'. Keep
+	 * the count from the last call ahead of the writes below, so a
+	 * dump that sees part of them also sees that the slot moved on */
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Event &e = buf.events[index & (TRACE_RING_SIZE-1)];
+	e.start = start;
+	e.end = end;
+	e.name = name;
+
+	if (detail)
+		copyString(e.detail, sizeof(e.detail), detail);
+	else
+		e.detail[0] = '\0';
+
+	buf.written.store(index + 1, std::memory_order_release);
+}
+
+void writeEscaped(FILE *f, const char *str)
+{
+	for (; *str; ++str)
+	{
+		unsigned char c = *str;
+
+		if (c == '"' || c == '\\')
+			fprintf(f, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+}
+
+} // anonymous namespace
+
+void setRecording(bool value)
+{
+	if (value && !isRecording())
+		timeBase = SDL_GetPerformanceCounter();
+
+	recording.store(value);
+}
+
+void setThreadName(const char *name)
+{
+	copyString(handle.name, sizeof(handle.name), name);
+
+	if (handle.buf)
+		copyString(handle.buf->name, sizeof(handle.buf->name), name);
+}
+
+uint64_t now()
+{
+	return SDL_GetPerformanceCounter();
+}
+
+void complete(const char *name, uint64_t start, const char *detail)
+{
+	record(name, start, now(), detail);
+}
+
+void instant(const char *name, const char *detail)
+{
+	if (!isRecording())
+		return;
+
+	uint64_t t = now();
+	record(name, t, t, detail);
+}
+
+bool dump(const char *path)
+{
+	FILE *f = fopen(path, "wb");
+
+	if (!f)
+		return false;
+
+	const double usPerTick = 1000000.0 / SDL_GetPerformanceFrequency();
+	bool first = true;
+
+	fputs("{\"traceEvents\":[\n", f);
+
+	/* Buffers are never freed, so the pointers stay valid
+	 * after the lock is dropped */
+	SDL_AtomicLock(&buffersLock);
+	std::vector<ThreadBuffer*> snapshot(buffers);
+	SDL_AtomicUnlock(&buffersLock);
+
+	for (size_t i = 0; i < snapshot.size(); ++i)
+	{
+		ThreadBuffer &buf = *snapshot[i];
+
+		fprintf(f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"",
+		        first ? "" : ",\n", buf.tid);
+		writeEscaped(f, buf.name);
+		fputs("\"}}", f);
+		first = false;
+
+		uint32_t written = buf.written.load(std::memory_order_acquire);
+		uint32_t begin = 0;
+
+		if (written > TRACE_RING_SIZE - TRACE_DUMP_MARGIN)
+			begin = written - (TRACE_RING_SIZE - TRACE_DUMP_MARGIN);
+
+		for (uint32_t j = begin; j < written; ++j)
+		{
+			/* The owning thread may be writing the slot right now.
+			 * Copy it, then check that it wasn't reused meanwhile */
+			Event e;
+			memcpy(&e, &buf.events[j & (TRACE_RING_SIZE-1)], sizeof(e));
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (buf.written.load(std::memory_order_relaxed) - j >= TRACE_RING_SIZE)
+				continue;
+
+			/* Torn copies are skipped above, this is just
+			 * so a bad one can never run past the buffer */
+			e.detail[sizeof(e.detail) - 1] = '\0';
+
+			/* Recorded before the current session started */
+			if (e.start < timeBase)
+				continue;
+
+			double ts = (e.start - timeBase) * usPerTick;
+
+			if (e.end == e.start)
+				fprintf(f, ",\n{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f",
+				        e.name, buf.tid, ts);
+			else
+				fprintf(f, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f",
+				        e.name, buf.tid, ts, (e.end - e.start) * usPerTick);
+
+			if (e.detail[0])
+			{
+				fputs(",\"args\":{\"detail\":\"", f);
+				writeEscaped(f, e.detail);
+				fputs("\"}", f);
+			}
+
+			fputc('}', f);
+		}
+	}
+
+	fputs("\n]}\n", f);
+
+	return fclose(f) == 0;
+}
+
+} // namespace Trace
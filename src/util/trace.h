@@ -0,0 +1,88 @@
+/*
+** trace.h
+**
+** This file is part of mkxp.
+**
+** mkxp is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 of the License, or
+** (at your option) any later version.
+**
+** mkxp is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with mkxp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <stdint.h>
+
+/* Cross-thread event recorder producing Chrome trace-event JSON
+ * (chrome://tracing, ui.perfetto.dev). Every thread writes into its
+ * own fixed-size ring, so recording never takes a lock; once a ring
+ * is full its oldest events are overwritten. While recording is off,
+ * a scope costs one relaxed atomic load.
+ *
+ * Event names must be string literals (only the pointer is stored);
+ * the optional detail string is copied and truncated */
+namespace Trace
+{
+	extern std::atomic<bool> recording;
+
+	inline bool isRecording()
+	{
+		return recording.load(std::memory_order_relaxed);
+	}
+
+	void setRecording(bool value);
+
+	/* Names the calling thread in the exported trace */
+	void setThreadName(const char *name);
+
+	uint64_t now();
+
+	/* Records a span that started at 'start' (from now())
+	 * and ends at the moment of the call */
+	void complete(const char *name, uint64_t start, const char *detail = 0);
+
+	void instant(const char *name, const char *detail = 0);
+
+	/* Writes all buffered events to 'path'. Safe to call from
+	 * any thread while others keep recording; events overwritten
+	 * while the dump reads them are left out. Returns false on
+	 * IO error */
+	bool dump(const char *path);
+
+	struct Scope
+	{
+		Scope(const char *name, const char *detail = 0)
+		    : name(name), detail(detail),
+		      start(isRecording() ? now() : 0)
+		{}
+
+		~Scope()
+		{
+			if (start && isRecording())
+				complete(name, start, detail);
+		}
+
+	private:
+		const char *name;
+		const char *detail;
+		uint64_t start;
+	};
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(...) \
+	Trace::Scope TRACE_CONCAT(_traceScope, __LINE__)(__VA_ARGS__)
+
+#endif // TRACE_H
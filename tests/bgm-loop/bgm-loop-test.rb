@@ -0,0 +1,68 @@
+# Test script for mkxp-z BGM loop points and crossfading.
+# Run via the "customScript" field in mkxp.json.
+#
+# Renders a short WAV with a 'smpl' loop chunk, plays it and checks that
+# the reported playback position wraps exactly at the loop seam, then
+# crossfades into a second track.
+
+RATE = 22050
+LOOP_START = RATE / 2       # 0.5 s
+LOOP_END = RATE * 3 / 2     # 1.5 s, exclusive
+TOTAL = RATE * 2            # 2.0 s, the tail must never be heard
+
+def write_wav(path, frames, freq, loop = nil)
+	data = (0...frames).map { |i| (Math.sin(2 * Math::PI * freq * i / RATE) * 12000).round }.pack("s<*")
+
+	smpl = ""
+	if loop
+		# Header, followed by one forward loop; the end sample is inclusive
+		smpl = [0, 0, 1_000_000_000 / RATE, 60, 0, 0, 0, 1, 0].pack("V*")
+		smpl += [0, 0, loop[0], loop[1] - 1, 0, 0].pack("V*")
+		smpl = "smpl" + [smpl.bytesize].pack("V") + smpl
+	end
+
+	fmt = "fmt " + [16, 1, 1, RATE, RATE * 2, 2, 16].pack("VvvVVvv")
+	body = "WAVE" + fmt + smpl + "data" + [data.bytesize].pack("V") + data
+
+	File.open(path, "wb") { |f| f.write("RIFF" + [body.bytesize].pack("V") + body) }
+end
+
+Dir.mkdir("Audio") unless Dir.exist?("Audio")
+Dir.mkdir("Audio/BGM") unless Dir.exist?("Audio/BGM")
+write_wav("Audio/BGM/loop-a.wav", TOTAL, 440, [LOOP_START, LOOP_END])
+write_wav("Audio/BGM/loop-b.wav", TOTAL, 660)
+
+failures = 0
+check = lambda do |cond, desc|
+	System::puts((cond ? "PASS " : "FAIL ") + desc)
+	failures += 1 unless cond
+end
+
+# Loop seam
+Audio.bgm_play("Audio/BGM/loop-a")
+wrapped = false
+last = 0.0
+(4 * Graphics.frame_rate).times do
+	Graphics.update
+	pos = Audio.bgm_pos
+	wrapped = true if pos < last
+	check.call(pos < LOOP_END.to_f / RATE + 0.05, "position #{pos} stays before the loop end") if wrapped
+	last = pos
+end
+check.call(wrapped, "position wrapped around")
+check.call(last >= LOOP_START.to_f / RATE - 0.05, "position #{last} restarted at the loop start")
+
+# Preloaded switch and crossfade
+Audio.bgm_preload("Audio/BGM/loop-b")
+Audio.bgm_crossfade("Audio/BGM/loop-b", 1000)
+Graphics.wait(Graphics.frame_rate / 2)
+check.call(Audio.bgm_pos < 1.0, "crossfaded track plays from the start")
+Graphics.wait(Graphics.frame_rate)
+
+Audio.bgm_crossfade("Audio/BGM/loop-a", 500)
+Graphics.wait(Graphics.frame_rate)
+Audio.bgm_stop
+
+System::puts(failures == 0 ? "All BGM loop tests passed" : "#{failures} BGM loop tests failed")
+
+exit
@@ -0,0 +1,54 @@
+# Test script for mkxp-z's property accessor bindings.
+# Run via the "customScript" field in mkxp.json.
+#
+# Calls the most common object property getters and setters in a tight
+# loop and prints how many calls per second each manages. Object
+# properties (bitmap, color, tone, contents, font...) are served from
+# fixed slots and should come out close to plain integer ones like x.
+# Also checks that the wrappers stay identical between calls and
+# survive a full GC.
+
+ITERATIONS = 200_000
+
+bitmap = Bitmap.new(32, 32)
+sprite = Sprite.new
+sprite.bitmap = bitmap
+window = Window.new
+window.contents = bitmap
+font = bitmap.font
+
+def bench(label)
+  t = Time.now
+  ITERATIONS.times { yield }
+  elapsed = Time.now - t
+  puts format("%-22s %12.0f calls/s", label, ITERATIONS / elapsed)
+end
+
+bench("sprite.x")          { sprite.x }
+bench("sprite.x=")         { sprite.x = 1 }
+bench("sprite.bitmap")     { sprite.bitmap }
+bench("sprite.bitmap=")    { sprite.bitmap = bitmap }
+bench("sprite.color")      { sprite.color }
+bench("sprite.tone")       { sprite.tone }
+bench("sprite.src_rect")   { sprite.src_rect }
+bench("sprite.viewport")   { sprite.viewport }
+bench("window.contents")   { window.contents }
+bench("window.cursor_rect"){ window.cursor_rect }
+bench("bitmap.font")       { bitmap.font }
+bench("bitmap.font.color") { bitmap.font.color }
+bench("font.name")         { font.name }
+
+color = sprite.color
+GC.start
+raise "Sprite#color changed identity" unless sprite.color.equal?(color)
+raise "Sprite#bitmap lost" unless sprite.bitmap.equal?(bitmap)
+raise "Window#contents lost" unless window.contents.equal?(bitmap)
+raise "Font#color lost" unless bitmap.font.color.is_a?(Color)
+
+copy = font.dup
+raise "Font#dup lost the name" unless copy.name == font.name
+raise "Font#dup shares Color" if copy.color.equal?(font.color)
+
+puts "OK"
+
+exit
@@ -0,0 +1,72 @@
+# Test script for Bitmap#blur(radius, passes) and Bitmap#radial_blur.
+# Run via the "customScript" field in mkxp.json.
+#
+# Checks that blurring keeps flat areas flat and spreads a dot evenly
+# in all directions, then prints timings at 640x480 and 1920x1080,
+# next to what calling the fixed Bitmap#blur in a loop costs.
+
+def check(cond, what)
+  raise "failed: #{what}" unless cond
+end
+
+def close(a, b, tolerance = 2)
+  [a.red - b.red, a.green - b.green, a.blue - b.blue, a.alpha - b.alpha].all? { |d| d.abs <= tolerance }
+end
+
+# Flat areas stay flat
+flat = Bitmap.new(200, 150)
+color = Color.new(90, 160, 220)
+flat.fill_rect(flat.rect, color)
+[2, 10, 40].each do |r|
+  flat.blur(r, 2)
+  check(close(flat.get_pixel(100, 75), color), "flat, radius #{r}")
+end
+
+# A dot spreads the same way along both axes
+[3, 12, 50].each do |r|
+  dot = Bitmap.new(256, 256)
+  dot.fill_rect(dot.rect, Color.new(0, 0, 0))
+  dot.fill_rect(126, 126, 4, 4, Color.new(255, 255, 255))
+  dot.blur(r)
+  check(dot.get_pixel(128, 128).red < 255, "dot dimmed, radius #{r}")
+  left = dot.get_pixel(128 - r / 2, 128).red
+  up = dot.get_pixel(128, 128 - r / 2).red
+  check((left - up).abs <= 2, "dot symmetric, radius #{r}")
+  check(dot.get_pixel(128 - r * 2 - 4, 128).red <= 1, "dot reach, radius #{r}")
+  dot.dispose
+end
+
+# A flat picture stays flat under rotation in the middle
+radial = Bitmap.new(160, 120)
+radial.fill_rect(radial.rect, color)
+radial.radial_blur(30, 12)
+check(close(radial.get_pixel(80, 60), color), "radial_blur, flat")
+
+def time(label, rounds, bitmap)
+  yield
+  bitmap.get_pixel(0, 0)
+  t = Time.now
+  rounds.times { yield }
+  # Reading a pixel waits for the GPU
+  bitmap.get_pixel(0, 0)
+  puts format("%-34s %8.2f ms", label, (Time.now - t) * 1000 / rounds)
+end
+
+[[640, 480], [1920, 1080]].each do |w, h|
+  puts "#{w}x#{h}:"
+  bmp = Bitmap.new(w, h)
+  bmp.fill_rect(0, 0, w / 2, h, Color.new(255, 128, 0))
+
+  time("  blur x 8 (fixed kernel)", 10, bmp) { 8.times { bmp.blur } }
+  [4, 16, 64].each do |r|
+    time("  blur(#{r})", 10, bmp) { bmp.blur(r) }
+  end
+  time("  blur(16, 4)", 10, bmp) { bmp.blur(16, 4) }
+  time("  radial_blur(20, 20)", 10, bmp) { bmp.radial_blur(20, 20) }
+  time("  radial_blur(90, 100)", 5, bmp) { bmp.radial_blur(90, 100) }
+
+  bmp.dispose
+end
+
+puts "OK"
+exit
@@ -0,0 +1,96 @@
+# Test script for Bitmap#color_matrix! and Bitmap.color_matrix.
+# Run via the "customScript" field in mkxp.json.
+#
+# Checks each adjustment on a known color, that chained adjustments
+# in one call match separate calls, and that hue_change still works
+# now that it runs in place. Then times one chained pass against
+# separate passes at 1920x1080.
+
+def check(cond, what)
+  raise "failed: #{what}" unless cond
+end
+
+def close(c, r, g, b, a = 255)
+  [c.red - r, c.green - g, c.blue - b, c.alpha - a].all? { |d| d.abs <= 1 }
+end
+
+# Separate passes round to 8 bits in between
+def same(a, b, tolerance = 2)
+  [a.red - b.red, a.green - b.green, a.blue - b.blue, a.alpha - b.alpha].all? { |d| d.abs <= tolerance }
+end
+
+def sample(color, *mats)
+  bmp = Bitmap.new(4, 4)
+  bmp.fill_rect(bmp.rect, color)
+  bmp.color_matrix!(*mats)
+  bmp.get_pixel(1, 1)
+end
+
+base = Color.new(200, 100, 50)
+
+check(close(sample(base, invert: true), 55, 155, 205), "invert")
+check(close(sample(base, brightness: 0.5), 100, 50, 25), "brightness")
+check(close(sample(base, saturation: 1.0), 200, 100, 50), "saturation 1")
+
+luma = (200 * 0.299 + 100 * 0.587 + 50 * 0.114).round
+check(close(sample(base, grayscale: 1.0), luma, luma, luma), "grayscale")
+check(close(sample(base, saturation: 0.0), luma, luma, luma), "saturation 0")
+
+check(close(sample(base, tint: Color.new(0, 0, 255, 255)), 0, 0, 255), "full tint")
+check(close(sample(base, tint: Color.new(0, 0, 0, 0)), 200, 100, 50), "empty tint")
+
+gray = Color.new(128, 128, 128)
+check(close(sample(gray, hue: 120), 128, 128, 128), "hue keeps gray")
+
+# Alpha is left alone unless asked for
+translucent = Color.new(200, 100, 50, 100)
+check(close(sample(translucent, invert: true), 55, 155, 205, 100), "invert keeps alpha")
+fade = [1, 0, 0, 0, 0,  0, 1, 0, 0, 0,  0, 0, 1, 0, 0,  0, 0, 0, 0.5, 0]
+check(close(sample(base, fade), 200, 100, 50, 128), "alpha row")
+
+# Arrays round trip, offsets are in 0..255
+inv = Bitmap.color_matrix(invert: true)
+check(inv.size == 20 && inv[0] == -1 && inv[4] == 255 && inv[18] == 1, "color_matrix array")
+check(close(sample(base, inv), 55, 155, 205), "array argument")
+
+# One pass with everything equals separate passes
+chain = { saturation: 0.5, brightness: 1.2, tint: Color.new(0, 128, 255, 64), invert: true }
+one = sample(base, chain)
+bmp = Bitmap.new(4, 4)
+bmp.fill_rect(bmp.rect, base)
+chain.each { |k, v| bmp.color_matrix!(k => v) }
+check(same(one, bmp.get_pixel(1, 1)), "chained == separate")
+check(same(sample(base, { saturation: 0.5 }, { invert: true }),
+           sample(base, saturation: 0.5, invert: true), 0), "several arguments")
+
+begin
+  sample(base, blur: 3)
+  raise "unknown key accepted"
+rescue ArgumentError
+end
+
+# hue_change works in place: sprites showing the bitmap see the result
+red = Bitmap.new(8, 8)
+red.fill_rect(red.rect, Color.new(255, 0, 0))
+sprite = Sprite.new
+sprite.bitmap = red
+red.hue_change(180)
+check(close(red.get_pixel(2, 2), 0, 255, 255), "hue_change")
+check(sprite.bitmap.equal?(red), "sprite keeps bitmap")
+
+def time(label, bitmap)
+  bitmap.get_pixel(0, 0)
+  t = Time.now
+  10.times { yield }
+  bitmap.get_pixel(0, 0)
+  puts format("%-24s %8.2f ms", label, (Time.now - t) * 100)
+end
+
+big = Bitmap.new(1920, 1080)
+big.fill_rect(0, 0, 960, 1080, base)
+time("4 adjustments, 1 pass", big) { big.color_matrix!(chain) }
+time("4 adjustments, 4 passes", big) { chain.each { |k, v| big.color_matrix!(k => v) } }
+time("hue_change", big) { big.hue_change(30) }
+
+puts "OK"
+exit
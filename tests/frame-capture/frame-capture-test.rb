@@ -0,0 +1,39 @@
+# Test script for mkxp-z asynchronous frame capture.
+# Run via the "customScript" field in mkxp.json.
+#
+# Takes a synchronous and an asynchronous screenshot of the same frame,
+# then records a short PNG sequence and a Y4M clip next to the save data.
+# The two screenshots should look identical, the sequence should count up
+# from capture_00000.png, and the clip should play back in ffplay/mpv.
+
+dir = System.data_directory
+
+sprite = Sprite.new
+sprite.bitmap = Bitmap.new(320, 240)
+sprite.bitmap.fill_rect(0, 0, 320, 240, Color.new(40, 80, 160))
+
+def draw(sprite, i)
+	sprite.bitmap.clear
+	sprite.bitmap.fill_rect(i * 4 % 320, 100, 32, 32, Color.new(255, 255, 255))
+	sprite.bitmap.draw_text(0, 0, 320, 32, "frame #{i}")
+end
+
+draw(sprite, 0)
+Graphics.update
+
+Graphics.screenshot(dir + "capture-sync.png")
+Graphics.screenshot(dir + "capture-async.png", true)
+
+Graphics.start_capture(dir + "capture_%05d.png", 10)
+60.times { |i| draw(sprite, i); Graphics.update }
+Graphics.stop_capture
+
+Graphics.start_capture(dir + "capture.y4m", 2)
+120.times { |i| draw(sprite, i); Graphics.update }
+Graphics.stop_capture
+
+System::puts("Pending before flush: #{Graphics.capture_pending}")
+Graphics.flush_captures
+System::puts("Pending after flush: #{Graphics.capture_pending}")
+
+exit
@@ -0,0 +1,47 @@
+# Test script for mkxp-z non-blocking and custom shader transitions.
+# Run via the "customScript" field in mkxp.json.
+#
+# The sprite should keep moving during both transitions. The second one
+# uses the wipe shader written next to this script, which sweeps the
+# new scene in from the left.
+
+File.write("wipe.frag", <<~GLSL)
+  uniform sampler2D currentScene;
+  uniform sampler2D frozenScene;
+  uniform float prog;
+
+  varying vec2 v_texCoord;
+
+  void main()
+  {
+      float edge = step(v_texCoord.x, prog);
+      gl_FragColor = mix(texture2D(frozenScene, v_texCoord),
+                         texture2D(currentScene, v_texCoord), edge);
+  }
+GLSL
+
+sprite = Sprite.new
+sprite.bitmap = Bitmap.new(64, 64)
+sprite.bitmap.fill_rect(sprite.bitmap.rect, Color.new(255, 128, 0))
+sprite.y = 200
+
+Graphics.preload_transition("", "wipe.frag")
+
+["", "wipe.frag"].each do |shader|
+  Graphics.freeze
+  sprite.bitmap.hue_change(90)
+  Graphics.start_transition(60, "", 40, shader)
+
+  frames = 0
+  while Graphics.transitioning?
+    sprite.x = (sprite.x + 4) % 640
+    Graphics.update
+    frames += 1
+  end
+
+  puts "Transition with '#{shader}' took #{frames} frames (expected 60)"
+end
+
+Graphics.wait(30)
+
+exit
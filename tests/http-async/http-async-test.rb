@@ -0,0 +1,72 @@
+# Test script for the HTTPLite connection pool, async requests
+# and downloads.
+# Run via the "customScript" field in mkxp.json, with the local
+# stand-in server (see stand-in-server.cpp) running.
+
+BASE = "http://127.0.0.1:8089"
+
+def check(cond, what)
+  raise "FAILED: #{what}" unless cond
+  System::puts "ok: #{what}"
+end
+
+# Keep-alive: sequential requests to one host share a connection
+a = HTTPLite.get("#{BASE}/connection")[:body]
+b = HTTPLite.get("#{BASE}/connection")[:body]
+check(a == b, "connection reused (#{a} / #{b})")
+
+# Async requests don't block, and their blocks run on Graphics.update
+results = []
+started = Time.now
+3.times do
+  HTTPLite.get_async("#{BASE}/slow") { |res, err| results << (err || res[:body]) }
+end
+check(Time.now - started < 0.25, "get_async returns immediately")
+
+frames = 0
+while results.size < 3
+  Graphics.update
+  frames += 1
+end
+check(results == ["slow"] * 3, "async blocks called with responses")
+check(frames > 1, "game loop kept running (#{frames} frames)")
+
+# Pollable handles without a block
+req = HTTPLite.get_async("#{BASE}/json")
+check(req.wait[:status] == 200, "Request#wait")
+check(req.done? && req.response[:body].include?("mkxp"), "Request#response")
+
+req = HTTPLite.post_async("#{BASE}/echo", { "key1" => "value1" })
+check(req.wait[:body] == "value1", "post_async")
+
+req = HTTPLite.post_body_async("#{BASE}/echo", "raw", "text/plain")
+check(req.wait[:body] == "raw", "post_body_async")
+
+# Errors go to the block instead of raising
+error = nil
+HTTPLite.get_async("http://127.0.0.1:1/") { |res, err| error = err }
+Graphics.update until error
+check(error.is_a?(String), "async error reported (#{error})")
+
+# Streaming downloads
+path = "http-async-download.bin"
+res = HTTPLite.download("#{BASE}/large", path)
+check(res[:status] == 200 && res[:body].empty?, "download keeps body out of memory")
+check(File.size(path) == 8 * 1024 * 1024, "download wrote the whole file")
+data = File.binread(path, 512)
+check(data.bytes.each_with_index.all? { |byte, i| byte == (i & 0xFF) }, "download content")
+File.delete(path)
+
+res = HTTPLite.download("#{BASE}/missing", path)
+check(res[:status] == 404 && res[:body] == "not here", "error page kept in memory")
+check(!File.exist?(path), "no file for failed download")
+
+done = false
+HTTPLite.download_async("#{BASE}/large", path) { |res, err| done = true }
+Graphics.update until done
+check(File.size(path) == 8 * 1024 * 1024, "download_async")
+File.delete(path)
+
+System::puts "OK"
+
+exit
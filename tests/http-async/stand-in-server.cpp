@@ -0,0 +1,67 @@
+// Local stand-in server for the HTTPLite async tests.
+// Uses the same bundled httplib as the engine; build and start it
+// from the repository root with
+//
+//   c++ -std=c++14 -Isrc/net tests/http-async/stand-in-server.cpp \
+//       -o http-stand-in -pthread && ./http-stand-in
+//
+// and then run http-async-test.rb. Listens on 127.0.0.1:8089.
+
+#include "httplib.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+int main() {
+    httplib::Server server;
+    
+    server.Get("/json", [](const httplib::Request &, httplib::Response &res) {
+        res.set_content("{\"name\": \"mkxp\", \"values\": [1, 2, 3]}", "application/json");
+    });
+    
+    // Replies with the client's port, so the test can tell
+    // whether a connection was reused
+    server.Get("/connection", [](const httplib::Request &req, httplib::Response &res) {
+        res.set_content(std::to_string(req.remote_port), "text/plain");
+    });
+    
+    server.Get("/slow", [](const httplib::Request &, httplib::Response &res) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        res.set_content("slow", "text/plain");
+    });
+    
+    // 8 MiB body, sent in chunks
+    server.Get("/large", [](const httplib::Request &, httplib::Response &res) {
+        const size_t total = 8 * 1024 * 1024;
+        
+        res.set_content_provider(total, "application/octet-stream",
+            [](size_t offset, size_t length, httplib::DataSink &sink) {
+                std::string chunk(std::min<size_t>(length, 64 * 1024), '\0');
+                
+                for (size_t i = 0; i < chunk.size(); ++i)
+                    chunk[i] = (char)((offset + i) & 0xFF);
+                
+                return sink.write(chunk.data(), chunk.size());
+            });
+    });
+    
+    server.Get("/missing", [](const httplib::Request &, httplib::Response &res) {
+        res.status = 404;
+        res.set_content("not here", "text/plain");
+    });
+    
+    server.Post("/echo", [](const httplib::Request &req, httplib::Response &res) {
+        std::string body;
+        
+        if (req.has_param("key1"))
+            body = req.get_param_value("key1");
+        else
+            body = req.body;
+        
+        res.set_content(body, "text/plain");
+    });
+    
+    server.listen("127.0.0.1", 8089);
+    return 0;
+}
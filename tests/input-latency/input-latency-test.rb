@@ -0,0 +1,57 @@
+# Test script for mkxp-z input latency measurement.
+# Run via the "customScript" field in mkxp.json.
+#
+# Flashes the screen whenever C (or a mouse click) triggers and reports when
+# within the frame the press happened and how long it waited before the
+# Input.update that saw it. Tap as fast as possible; taps shorter than a
+# frame should still be counted once each. Press B to print a summary.
+
+flash = Sprite.new
+flash.bitmap = Bitmap.new(Graphics.width, Graphics.height)
+flash.bitmap.fill_rect(flash.bitmap.rect, Color.new(255, 255, 255))
+flash.opacity = 0
+
+latencies = []
+taps = 0
+
+report = lambda do
+	if latencies.empty?
+		System::puts("No timestamped presses recorded")
+		next
+	end
+
+	sorted = latencies.sort
+	avg = sorted.inject(:+) / sorted.size
+	pct = lambda { |p| sorted[[(sorted.size * p).floor, sorted.size - 1].min] }
+
+	System::puts(format("taps: %d  latency avg %.2f ms  p50 %.2f ms  p95 %.2f ms  max %.2f ms",
+		taps, avg * 1000, pct.call(0.5) * 1000, pct.call(0.95) * 1000, sorted.last * 1000))
+end
+
+System::puts("Tap C or click; press B for a summary, close the window to quit")
+
+loop do
+	Graphics.update
+	Input.update
+
+	[Input::C, Input::MOUSELEFT].each do |button|
+		next unless Input.trigger?(button)
+
+		taps += 1
+		flash.opacity = 255
+
+		latency = Input.latency(button)
+		if latency.nil?
+			System::puts("press without timestamp (replay?)")
+			next
+		end
+
+		latencies << latency
+		System::puts(format("press at %+.2f ms into the frame, seen %.2f ms later",
+			Input.press_time(button) * 1000, latency * 1000))
+	end
+
+	report.call if Input.trigger?(Input::B)
+
+	flash.opacity = [flash.opacity - 64, 0].max
+end
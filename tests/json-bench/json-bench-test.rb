@@ -0,0 +1,70 @@
+# Test script for HTTPLite::JSON.
+# Run via the "customScript" field in mkxp.json.
+#
+# Builds save-file-like documents of about 1 MB and 10 MB, then times
+# stringify and parse on them and prints the throughput. Run it once
+# on a build from before the native parser and once after to compare.
+# The correctness checks at the end only pass on the new one.
+
+def make_doc(target_bytes)
+  entries = []
+  size = 0
+  i = 0
+  while size < target_bytes
+    entry = {
+      "id" => i,
+      "name" => "Actor #{i}",
+      "level" => (i % 99) + 1,
+      "hp" => 1000.5 + i,
+      "alive" => i.even?,
+      "items" => [1, 2, 3, i],
+      "note" => "Line one\nLine \"two\"",
+      "parent" => nil
+    }
+    entries << entry
+    size += 170
+    i += 1
+  end
+  { "version" => 3, "entries" => entries }
+end
+
+def bench(label, bytes)
+  t = Time.now
+  result = yield
+  elapsed = Time.now - t
+  puts format("%-20s %8.1f ms  %8.1f MB/s", label, elapsed * 1000,
+              bytes / 1048576.0 / elapsed)
+  result
+end
+
+[1, 10].each do |mb|
+  doc = make_doc(mb * 1024 * 1024)
+  json = bench("stringify #{mb} MB", mb * 1048576) { HTTPLite::JSON.stringify(doc) }
+  bench("parse #{mb} MB", json.bytesize) { HTTPLite::JSON.parse(json) }
+end
+
+# Correctness
+doc = { "a" => [1, 2.5, "x\ny", true, false, nil], "b" => { "c" => "é" } }
+back = HTTPLite::JSON.parse(HTTPLite::JSON.stringify(doc))
+raise "round trip" unless back["a"][1] == 2.5 && back["a"][2] == "x\ny" && back["b"]["c"] == "é"
+raise "numbers come back as Float" unless back["a"][0] == 1.0 && back["a"][0].is_a?(Float)
+
+raise "large integers" unless HTTPLite::JSON.stringify([1234567], false) == "[1234567]"
+raise "compact output" unless HTTPLite::JSON.stringify({ "k" => [] }, pretty: false) == '{"k":[]}'
+
+sym = HTTPLite::JSON.parse('{"key": {"inner": 1}}', symbolize_names: true)
+raise "symbolize_names" unless sym[:key][:inner] == 1.0
+
+json5 = HTTPLite::JSON.parse("{unquoted: 'single', trailing: [1, 2,], /* comment */ hex: 0x10,}")
+raise "JSON5 input" unless json5["unquoted"] == "single" && json5["trailing"].size == 2 && json5["hex"] == 16.0
+
+begin
+  HTTPLite::JSON.parse("[1, 2")
+  raise "accepted broken JSON"
+rescue MKXPError => e
+  puts "error: #{e.message}"
+end
+
+puts "OK"
+
+exit
@@ -0,0 +1,43 @@
+# Test script for MiniFFI call overhead.
+# Run via the "customScript" field in mkxp.json.
+#
+# Calls a trivial foreign function in a loop, once with the default
+# blocking call (which releases the GVL) and once created with
+# blocking: false, and prints the calls per second of each. The
+# non-blocking one should be noticeably faster, and both must return
+# the same results.
+
+ITERATIONS = 200_000
+
+if System.is_windows?
+  lib, func, imports, exports, arg = "user32", "GetAsyncKeyState", "i", "i", 0x41
+elsif System.is_mac?
+  lib, func, imports, exports, arg = "libSystem.dylib", "abs", "i", "i", -42
+else
+  lib, func, imports, exports, arg = "libc.so.6", "abs", "i", "i", -42
+end
+
+blocking = MiniFFI.new(lib, func, imports, exports)
+fast = MiniFFI.new(lib, func, imports, exports, blocking: false)
+
+raise "blocking flag" unless blocking.blocking && !fast.blocking
+raise "results differ" unless blocking.call(arg) == fast.call(arg)
+
+def bench(label, ffi, arg)
+  t = Time.now
+  ITERATIONS.times { ffi.call(arg) }
+  puts format("%-12s %12.0f calls/s", label, ITERATIONS / (Time.now - t))
+end
+
+bench("blocking", blocking, arg)
+bench("non-blocking", fast, arg)
+
+begin
+  fast.call
+  raise "accepted a wrong argument count"
+rescue RuntimeError
+end
+
+puts "OK"
+
+exit
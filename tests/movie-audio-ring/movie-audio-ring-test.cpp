@@ -0,0 +1,291 @@
+// Standalone test for the movie audio path: SPSCRing (sdl-util.h),
+// drainAudioQueue (audioqueue.h) and convertF32ToS16 (al-util.h).
+// All are header only. It's built and run by meson with
+// -Dbuild_tests=true, or by hand from the repository root with
+//
+//   c++ -std=c++14 -O2 -Isrc/util -Isrc/audio $(sdl2-config --cflags) \
+//       $(pkg-config --cflags openal) \
+//       tests/movie-audio-ring/movie-audio-ring-test.cpp \
+//       -o movie-audio-ring-test $(sdl2-config --libs) -pthread \
+//       && ./movie-audio-ring-test
+//
+// One thread produces synthetic packets the way the movie decoder
+// loop does, another drains them with the same function the movie
+// audio thread uses. Every sample encodes its position in the
+// stream, so a dropped, repeated or reordered sample fails the run,
+// and so does a buffer mixing two formats. The SIMD conversion is
+// then checked against the scalar tail.
+
+#include "sdl-util.h"
+#include "al-util.h"
+#include "audioqueue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const unsigned PACKET_COUNT = 20000;
+const size_t BUFFER_SIZE = 4096;
+
+struct Packet
+{
+    unsigned seq;
+    int channels;
+    int freq;
+    int frames;
+    size_t first;
+    float *samples;
+};
+
+typedef AudioQueueItem<Packet> QueueItem;
+
+SPSCRing<QueueItem, 256> queue;
+AtomicFlag producerDone;
+int failures = 0;
+
+void fail(const char *what, size_t where)
+{
+    if (failures++ < 10)
+        std::printf("failed: %s at %zu\n", what, where);
+}
+
+// The sample at stream position 'index', covering the whole
+// [-1, 1] range and a bit beyond so clamping is exercised too
+float streamSample(size_t index)
+{
+    return ((float) (index % 70001) - 35000.0f) / 32767.0f;
+}
+
+// Same as the scalar tail of convertF32ToS16
+int16_t scalarS16(float val)
+{
+    if (!(val >= -1.0f))
+        val = -1.0f;
+    else if (val > 1.0f)
+        val = 1.0f;
+
+    return (int16_t) (val * 32767.0f);
+}
+
+// Where each packet starts in the stream and what format it has.
+// When 'formatChanges' is set, runs of packets switch between
+// stereo 44.1kHz and mono 22.05kHz, the way a chained stream
+// would; every so often a packet is empty
+struct PacketInfo
+{
+    int channels;
+    int freq;
+    int frames;
+    size_t first;
+};
+
+std::vector<PacketInfo> plan;
+
+void makePlan(bool formatChanges)
+{
+    size_t position = 0;
+
+    plan.resize(PACKET_COUNT);
+
+    for (unsigned seq = 0; seq < PACKET_COUNT; ++seq)
+    {
+        PacketInfo &info = plan[seq];
+        const bool mono = formatChanges && (seq / 37) % 2;
+
+        info.channels = mono ? 1 : 2;
+        info.freq = mono ? 22050 : 44100;
+        info.frames = (formatChanges && seq % 101 == 0) ? 0 : 1 + (seq * 7919) % 1500;
+        info.first = position;
+
+        position += (size_t) info.frames * info.channels;
+    }
+}
+
+void produce()
+{
+    for (unsigned seq = 0; seq < PACKET_COUNT; ++seq)
+    {
+        const PacketInfo &info = plan[seq];
+        const size_t count = (size_t) info.frames * info.channels;
+
+        Packet *packet = new Packet;
+        packet->seq = seq;
+        packet->channels = info.channels;
+        packet->freq = info.freq;
+        packet->frames = info.frames;
+        packet->first = info.first;
+        packet->samples = new float[count];
+
+        for (size_t i = 0; i < count; ++i)
+            packet->samples[i] = streamSample(info.first + i);
+
+        const QueueItem item = { packet, 0 };
+
+        // Like the decoder loop, hold on to the packet until there
+        // is room instead of dropping it
+        while (!queue.push(item))
+            std::this_thread::yield();
+    }
+
+    producerDone.set();
+}
+
+unsigned nextFreed = 0;
+
+void freePacket(const Packet *packet)
+{
+    if (packet->seq != nextFreed)
+        fail("packet sequence", packet->seq);
+    nextFreed = packet->seq + 1;
+
+    delete[] packet->samples;
+    delete packet;
+}
+
+void consume(size_t &consumed)
+{
+    int16_t buffer[BUFFER_SIZE];
+    size_t packetIdx = 0;
+    consumed = 0;
+
+    while (true)
+    {
+        int channels, sampleRate;
+        const size_t filled = drainAudioQueue(queue, buffer, BUFFER_SIZE,
+                                              channels, sampleRate, freePacket);
+
+        for (size_t i = 0; i < filled; ++i)
+            if (buffer[i] != scalarS16(streamSample(consumed + i)))
+                fail("sample value", consumed + i);
+
+        if (filled % std::max(channels, 1))
+            fail("partial frame", consumed);
+
+        // Every sample in the buffer has to come from a packet
+        // of the format the buffer was reported with
+        while (filled && packetIdx < plan.size() && consumed + filled > plan[packetIdx].first)
+        {
+            const PacketInfo &info = plan[packetIdx];
+
+            if (info.frames && (info.channels != channels || info.freq != sampleRate))
+                fail("mixed formats", consumed);
+
+            if (info.first + (size_t) info.frames * info.channels > consumed + filled)
+                break;
+
+            ++packetIdx;
+        }
+
+        consumed += filled;
+
+        if (!filled)
+        {
+            if (producerDone && !queue.front())
+                break;
+
+            std::this_thread::yield();
+        }
+    }
+
+    if (nextFreed != PACKET_COUNT)
+        fail("packet count", nextFreed);
+}
+
+void testRing(bool formatChanges)
+{
+    makePlan(formatChanges);
+    nextFreed = 0;
+
+    const PacketInfo &last = plan.back();
+    const size_t produced = last.first + (size_t) last.frames * last.channels;
+
+    size_t consumed = 0;
+    std::thread consumer(consume, std::ref(consumed));
+    std::thread producer(produce);
+
+    producer.join();
+    consumer.join();
+
+    if (consumed != produced)
+        fail("total samples", consumed);
+
+    producerDone.clear();
+
+    std::printf("ring%s: %u packets, %zu samples\n",
+                formatChanges ? " (format changes)" : "", PACKET_COUNT, consumed);
+}
+
+void testConversion()
+{
+    const float inf = std::numeric_limits<float>::infinity();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float denorm = std::numeric_limits<float>::denorm_min();
+
+    // In range, the exact ends, just past them, far out, and the odd ones
+    const float classes[] = {
+        0.0f, -0.0f, 0.5f, -0.5f, 0.25f, 1.0f / 32767.0f, -1.0f / 32767.0f,
+        0.999999f, -0.999999f, 1.0f, -1.0f,
+        1.0000001f, -1.0000001f, 1.5f, -1.5f, 1e9f, -1e9f,
+        inf, -inf, nan, -nan, denorm, -denorm
+    };
+    const size_t classCount = sizeof(classes) / sizeof(classes[0]);
+
+    std::vector<float> src(classCount * 8 + 64);
+    std::vector<int16_t> dst(src.size() + 1);
+
+    // Every class in every lane, at lengths that leave a tail
+    // and at unaligned starts
+    for (size_t c = 0; c < classCount; ++c)
+    {
+        for (size_t lane = 0; lane < 8; ++lane)
+        {
+            for (size_t i = 0; i < src.size(); ++i)
+                src[i] = streamSample(i * 13 + c);
+            for (size_t i = lane; i < src.size(); i += 8)
+                src[i] = classes[c];
+
+            for (size_t start = 0; start < 4; ++start)
+            {
+                for (size_t count = 0; count + start <= src.size(); count += 5)
+                {
+                    std::memset(dst.data(), 0x55, dst.size() * sizeof(int16_t));
+                    convertF32ToS16(dst.data(), src.data() + start, count);
+
+                    for (size_t i = 0; i < count; ++i)
+                        if (dst[i] != scalarS16(src[start + i]))
+                            fail("conversion", c);
+
+                    if (dst[count] != 0x5555)
+                        fail("conversion overrun", c);
+                }
+            }
+        }
+    }
+
+    std::printf("conversion: %zu input classes\n", classCount);
+}
+
+}
+
+int main()
+{
+    testConversion();
+    testRing(false);
+    testRing(true);
+
+    if (failures)
+    {
+        std::printf("%d failures\n", failures);
+        return EXIT_FAILURE;
+    }
+
+    std::puts("OK");
+    return EXIT_SUCCESS;
+}
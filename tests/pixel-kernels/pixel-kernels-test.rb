@@ -0,0 +1,59 @@
+# Test script for mkxp-z's CPU pixel kernels.
+# Run via the "customScript" field in mkxp.json.
+#
+# Runs every kernel of every SIMD path this machine supports over the
+# same pixels as the scalar path, fails if any result differs, and
+# prints the throughput of each. Then exercises the bitmap paths that
+# use them: raw data on a mega surface and shadowed/outlined text.
+
+results = Bitmap.benchmark_pixel_kernels(4 * 1024 * 1024, 16)
+
+puts "Active path: #{Bitmap.pixel_kernels}"
+results.group_by { |r| r[:kernel] }.each do |kernel, rows|
+  line = rows.map { |r| format("%s %7.0f", r[:path], r[:mpix_per_sec]) }.join("  ")
+  puts format("%-14s %s Mpix/s", kernel, line)
+end
+
+inexact = results.reject { |r| r[:exact] }
+unless inexact.empty?
+  raise "Not bit-exact: " + inexact.map { |r| "#{r[:path]} #{r[:kernel]}" }.join(", ")
+end
+
+# Raw data on a mega surface (loaded from a BMP too wide for a texture)
+def write_bmp(path, w, h)
+  stride = (w * 3 + 3) & ~3
+  data = "".b
+  h.times do |y|
+    row = (0...w).map { |x| [x & 0xFF, y * 40, (x >> 8) & 0xFF].pack("C3") }.join
+    data << row << "\0" * (stride - w * 3)
+  end
+  header = ["BM", 54 + data.bytesize, 0, 0, 54].pack("a2Vv2V")
+  info = [40, w, -h, 1, 24, 0, data.bytesize, 2835, 2835, 0, 0].pack("Vl<l<v2V6")
+  File.binwrite(path, header + info + data)
+end
+
+w = Bitmap.max_size + 1
+write_bmp("pixel-kernels-mega.bmp", w, 4)
+mega = Bitmap.new("pixel-kernels-mega.bmp")
+raise "not a mega surface" unless mega.mega?
+
+expected = (0...4).map { |y|
+  (0...w).map { |x| [(x >> 8) & 0xFF, y * 40, x & 0xFF, 255].pack("C4") }.join
+}.join
+raise "mega raw_data" unless mega.raw_data == expected
+
+replaced = Array.new(w * 4 * 4) { |i| (i * 7) & 0xFF }.pack("C*")
+mega.raw_data = replaced
+raise "mega raw_data=" unless mega.raw_data == replaced
+mega.dispose
+File.delete("pixel-kernels-mega.bmp")
+
+# Text with shadow and outline goes through swizzle, shadow and blend
+text = Bitmap.new(200, 48)
+text.font.shadow = true
+text.font.outline = true
+text.draw_text(text.rect, "Kernels", 1)
+raise "text not drawn" unless text.raw_data.unpack("C*").each_slice(4).any? { |px| px[3] > 0 }
+
+puts "OK"
+exit
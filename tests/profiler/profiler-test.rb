@@ -0,0 +1,58 @@
+# Test script for mkxp-z frame profiler.
+# Run via the "customScript" field in mkxp.json.
+#
+# Builds a small scene (sprites, a plane, a window and a viewport) plus
+# some per-frame Bitmap work, shows the profiler overlay for a few
+# seconds and then prints Graphics.profile_report to the console.
+
+FRAMES = 300
+
+bg = Bitmap.new(64, 64)
+bg.gradient_fill_rect(bg.rect, Color.new(40, 40, 80), Color.new(80, 40, 40))
+plane = Plane.new
+plane.bitmap = bg
+
+viewport = Viewport.new(0, 0, Graphics.width, Graphics.height / 2)
+viewport.tone = Tone.new(0, 0, 0, 128)
+
+ball = Bitmap.new(32, 32)
+ball.fill_rect(8, 8, 16, 16, Color.new(255, 255, 255))
+sprites = (0...64).map do |i|
+	s = Sprite.new(i.even? ? viewport : nil)
+	s.bitmap = ball
+	s.x = (i * 37) % Graphics.width
+	s.y = (i * 53) % Graphics.height
+	s
+end
+
+window = Window.new(16, Graphics.height - 96, 200, 80)
+
+canvas = Bitmap.new(200, 48)
+text = Sprite.new
+text.bitmap = canvas
+text.z = 500
+
+Graphics.profile_overlay = true
+
+FRAMES.times do |f|
+	plane.ox += 1
+	sprites.each { |s| s.x = (s.x + 1) % Graphics.width }
+
+	canvas.clear
+	canvas.draw_text(canvas.rect, "frame #{f}")
+	canvas.blt(0, 0, ball, ball.rect) if f % 10 == 0
+
+	Graphics.update
+end
+
+report = Graphics.profile_report
+System::puts("frame: %.2f ms" % report.delete(:frame))
+report.each do |name, s|
+	next if s[:calls] == 0
+	gpu = s[:gpu] ? "%.3f" % s[:gpu] : "n/a"
+	System::puts("%-20s calls %6.1f  cpu %.3f ms  gpu %s ms" % [name, s[:calls], s[:cpu], gpu])
+end
+
+Graphics.profiling = false
+
+exit
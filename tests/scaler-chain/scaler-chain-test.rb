@@ -0,0 +1,47 @@
+# Test script for mkxp-z's screen scaler chain.
+# Run via the "customScript" field in mkxp.json, ideally with a window
+# (or fullscreen) size several times larger than the game resolution.
+#
+# Cycles through a few chains, showing each one for a few seconds and
+# printing the average frame rate. Press C to switch early. The last
+# half of every run leaves the screen static, which should let the
+# chain reuse its previous output.
+
+CHAINS = [
+  [],
+  ["lanczos3"],
+  ["bicubic"],
+  ["nearest:2", "bilinear"],
+  ["xbrz:2", "lanczos3"],
+  ["bogus:3", "nearest"],
+]
+
+bitmap = Bitmap.new(Graphics.width, Graphics.height)
+(0...Graphics.height).step(8) do |y|
+  bitmap.fill_rect(0, y, Graphics.width, 4, Color.new(y % 256, 96, 255 - y % 256))
+end
+bitmap.draw_text(bitmap.rect, "Scaler chain", 1)
+
+background = Sprite.new
+background.bitmap = bitmap
+
+mover = Sprite.new
+mover.bitmap = Bitmap.new(32, 32)
+mover.bitmap.fill_rect(mover.bitmap.rect, Color.new(255, 255, 255))
+
+CHAINS.each do |chain|
+  Graphics.scaler_chain = chain
+  puts "Requested #{chain.inspect}, active #{Graphics.scaler_chain.inspect}"
+
+  240.times do |i|
+    mover.x = (i * 3) % Graphics.width if i < 120
+    Graphics.update
+    Input.update
+    break if Input.trigger?(Input::C)
+  end
+
+  puts "  average frame rate: #{Graphics.average_frame_rate.round(1)}"
+end
+
+Graphics.scaler_chain = nil
+exit
@@ -0,0 +1,85 @@
+# Test script for Sprite#set and Sprite.batch_update.
+# Run via the "customScript" field in mkxp.json.
+#
+# Moves 2000 sprites around for a number of frames three times: with
+# one setter call per attribute, with Sprite#set, and with a single
+# Sprite.batch_update per frame, and prints the time spent updating in
+# each run. All three runs should look the same, and the batched one
+# should be clearly faster. Also checks that Y based draw ordering and
+# the packed layout are applied correctly.
+
+COUNT = 2000
+FRAMES = 120
+
+bitmap = Bitmap.new(8, 8)
+bitmap.fill_rect(bitmap.rect, Color.new(255, 255, 255))
+
+sprites = COUNT.times.map do |i|
+  s = Sprite.new
+  s.bitmap = bitmap
+  s
+end
+
+def pos(i, f)
+  [(i * 7 + f * 2) % Graphics.width, (i * 13 + f) % Graphics.height]
+end
+
+def run(label)
+  spent = 0.0
+  FRAMES.times do |f|
+    t = Time.now
+    yield f
+    spent += Time.now - t
+    Graphics.update
+  end
+  puts format("%-14s %8.2f ms/frame", label, spent * 1000 / FRAMES)
+end
+
+run("per attribute") do |f|
+  sprites.each_with_index do |s, i|
+    x, y = pos(i, f)
+    s.x = x
+    s.y = y
+    s.ox = 4
+    s.oy = 4
+    s.zoom_x = 1.5
+    s.angle = f
+    s.opacity = 200
+  end
+end
+
+run("Sprite#set") do |f|
+  sprites.each_with_index do |s, i|
+    x, y = pos(i, f)
+    s.set(x: x, y: y, ox: 4, oy: 4, zoom_x: 1.5, angle: f, opacity: 200)
+  end
+end
+
+layout = [:x, :y, :ox, :oy, :zoom_x, :angle, :opacity]
+run("batch_update") do |f|
+  values = []
+  COUNT.times do |i|
+    x, y = pos(i, f)
+    values.push(x, y, 4, 4, 1.5, f, 200)
+  end
+  Sprite.batch_update(sprites, values.pack("f*"), layout)
+end
+
+s = sprites[0]
+Sprite.batch_update([s], [12, 34, 0.5, 0].pack("f*"), [:x, :y, :zoom_x, :visible])
+raise "batch_update x/y" unless s.x == 12 && s.y == 34
+raise "batch_update zoom_x" unless s.zoom_x == 0.5
+raise "batch_update visible" if s.visible
+
+s.set(visible: true, z: 5)
+raise "set visible/z" unless s.visible && s.z == 5
+
+begin
+  s.set(foo: 1)
+  raise "set accepted an unknown property"
+rescue ArgumentError
+end
+
+puts "OK"
+
+exit
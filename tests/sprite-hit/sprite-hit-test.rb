@@ -0,0 +1,102 @@
+# Test script for Sprite#hit? and Viewport#pick.
+# Run via the "customScript" field in mkxp.json.
+#
+# Checks hit testing against the bitmap's alpha under the sprite
+# transforms (zoom, angle, mirror, src_rect, viewport), that the
+# alpha masks follow bitmap changes, and times repeated queries.
+
+def check(cond, what)
+  raise "failed: #{what}" unless cond
+end
+
+# Opaque left half, transparent right half
+bmp = Bitmap.new(32, 16)
+bmp.fill_rect(0, 0, 16, 16, Color.new(255, 255, 255))
+
+s = Sprite.new
+s.bitmap = bmp
+s.x = 100
+s.y = 50
+
+check(s.hit?(100, 50), "plain, opaque")
+check(!s.hit?(120, 50), "plain, transparent")
+check(s.hit?(120, 50, 0), "plain, bounds only")
+check(!s.hit?(99, 50, 0), "plain, outside")
+
+s.mirror = true
+check(!s.hit?(100, 50), "mirror, transparent")
+check(s.hit?(120, 50), "mirror, opaque")
+s.mirror = false
+
+s.zoom_x = 2.0
+check(s.hit?(130, 50), "zoom, opaque")
+check(!s.hit?(135, 50), "zoom, transparent")
+check(s.hit?(160, 50, 0), "zoom, bounds")
+s.zoom_x = 1.0
+
+# Rotated 90 degrees counterclockwise around the origin:
+# the bitmap's x axis now points up on screen
+s.angle = 90
+check(s.hit?(105, 45), "angle, opaque")
+check(!s.hit?(105, 25), "angle, transparent")
+check(!s.hit?(105, 55), "angle, outside")
+s.angle = 0
+
+s.src_rect.set(16, 0, 16, 16)
+check(!s.hit?(100, 50), "src_rect, transparent")
+check(!s.hit?(116, 50, 0), "src_rect, outside")
+s.src_rect.set(0, 0, 32, 16)
+
+s.ox = 16
+check(!s.hit?(100, 50), "ox, transparent")
+check(s.hit?(90, 50), "ox, opaque")
+s.ox = 0
+
+s.visible = false
+check(!s.hit?(100, 50), "invisible")
+s.visible = true
+
+# Masks are rebuilt after changes
+bmp.fill_rect(20, 0, 4, 16, Color.new(0, 0, 255))
+check(s.hit?(121, 50), "after change, opaque")
+bmp.clear_rect(0, 0, 8, 16)
+check(!s.hit?(100, 50), "after change, cleared")
+
+# Viewports clip and pick the topmost sprite
+vp = Viewport.new(50, 40, 100, 40)
+vp.ox = 10
+
+a = Sprite.new(vp)
+a.bitmap = Bitmap.new(40, 40)
+a.bitmap.fill_rect(a.bitmap.rect, Color.new(255, 0, 0))
+a.z = 1
+
+b = Sprite.new(vp)
+b.bitmap = Bitmap.new(40, 40)
+b.bitmap.fill_rect(0, 0, 20, 40, Color.new(0, 255, 0))
+b.x = 10
+b.z = 2
+
+check(vp.pick(55, 45).equal?(b), "pick top")
+check(vp.pick(75, 45).equal?(a), "pick through transparent")
+check(vp.pick(85, 45).nil?, "pick empty")
+check(vp.pick(45, 45).nil?, "pick outside viewport")
+check(vp.pick(75, 45, 0).equal?(b), "pick bounds only")
+
+b.z = 0
+check(vp.pick(55, 45).equal?(a), "pick after reorder")
+
+# A large bitmap gets a coarse mask
+big = Bitmap.new(1024, 1024)
+big.fill_rect(0, 0, 512, 1024, Color.new(255, 255, 255))
+s.bitmap = big
+s.x = s.y = 0
+check(s.hit?(511, 10), "big, opaque")
+check(!s.hit?(520, 10), "big, transparent")
+
+t = Time.now
+10_000.times { |i| s.hit?(i % 1024, i % 768) }
+puts format("10000 hit tests: %.2f ms", (Time.now - t) * 1000)
+
+puts "OK"
+exit
@@ -0,0 +1,61 @@
+# Test script for mkxp-z sprite shader variants.
+# Run via the "customScript" field in mkxp.json.
+#
+# Fill-rate benchmark: draws a stack of screen-sized sprites with different
+# effect combinations and reports the frame time of each. Set
+# "enableHires": true and a high "framebufferScalingFactor" (eg. 4) and
+# turn "vsync" off to make the fragment cost dominate.
+
+LAYERS = 24
+FRAMES = 120
+
+bitmap = Bitmap.new(Graphics.width, Graphics.height)
+bitmap.gradient_fill_rect(bitmap.rect, Color.new(255, 0, 0), Color.new(0, 0, 255))
+
+pattern = Bitmap.new(32, 32)
+pattern.fill_rect(0, 0, 16, 16, Color.new(255, 255, 255, 128))
+
+sprites = (0...LAYERS).map do |i|
+	s = Sprite.new
+	s.bitmap = bitmap
+	s.z = i
+	s
+end
+
+cases = {
+	"plain"             => lambda { |s| },
+	"opacity"           => lambda { |s| s.opacity = 200 },
+	"tone"              => lambda { |s| s.tone.set(-34, 0, 34, 170) },
+	"color"             => lambda { |s| s.color.set(255, 255, 0, 96) },
+	"bush"              => lambda { |s| s.bush_depth = Graphics.height / 2 },
+	"invert"            => lambda { |s| s.invert = true },
+	"pattern (add)"     => lambda { |s| s.pattern = pattern; s.pattern_blend_type = 1 },
+	"tone+color+bush"   => lambda { |s| s.tone.set(-34, 0, 34, 170); s.color.set(255, 255, 0, 96); s.bush_depth = Graphics.height / 2 },
+}
+
+reset = lambda do |s|
+	s.opacity = 255
+	s.tone.set(0, 0, 0, 0)
+	s.color.set(0, 0, 0, 0)
+	s.bush_depth = 0
+	s.invert = false
+	s.pattern = nil
+	s.pattern_blend_type = 0
+end
+
+System::puts(format("%d layers of %dx%d", LAYERS, Graphics.width, Graphics.height))
+
+cases.each do |name, setup|
+	sprites.each { |s| reset.call(s); setup.call(s) }
+
+	# Let the variant compile before measuring
+	Graphics.update
+
+	start = Time.now
+	FRAMES.times { Graphics.update }
+	elapsed = Time.now - start
+
+	System::puts(format("%-18s %7.3f ms/frame", name, elapsed * 1000 / FRAMES))
+end
+
+exit
@@ -0,0 +1,29 @@
+# Test script for mkxp-z trace export.
+# Run via the "customScript" field in mkxp.json.
+#
+# Records a couple of seconds of frames, Bitmap work and GC runs, then
+# writes the trace next to the save data. Load the resulting file in
+# chrome://tracing or ui.perfetto.dev and check that the rgss, event and
+# audio threads all show up with their events.
+
+path = System.data_directory + "trace-test.json"
+
+System.tracing = true
+
+sprite = Sprite.new
+sprite.bitmap = Bitmap.new(320, 240)
+
+120.times do |i|
+	sprite.bitmap.clear
+	sprite.bitmap.draw_text(0, 0, 320, 32, "frame #{i}")
+	Array.new(20000) { |n| n.to_s } if i % 30 == 0
+	GC.start if i % 60 == 0
+	Graphics.update
+end
+
+System.dump_trace(path)
+System.tracing = false
+
+System::puts("Trace written to #{path} (#{File.size(path)} bytes)")
+
+exit
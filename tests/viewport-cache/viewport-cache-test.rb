@@ -0,0 +1,53 @@
+# Test script for mkxp-z Viewport render caching.
+# Run via the "customScript" field in mkxp.json.
+#
+# Both viewports should look identical. The left one is cached, so its
+# hit count should climb while nothing changes, then drop back to misses
+# for the frames in which the sprites are moved or redrawn.
+
+def make_panel(x)
+  vp = Viewport.new(x, 40, 280, 400)
+  sprites = 8.times.map do |i|
+    s = Sprite.new(vp)
+    s.bitmap = Bitmap.new(48, 48)
+    s.bitmap.fill_rect(s.bitmap.rect, Color.new(40 * i, 255 - 30 * i, 128, 200))
+    s.bitmap.draw_text(s.bitmap.rect, i.to_s, 1)
+    s.x = (i % 4) * 64 + 8
+    s.y = (i / 4) * 64 + 8
+    s
+  end
+  window = Window.new(vp)
+  window.windowskin = Bitmap.new(128, 128)
+  window.windowskin.fill_rect(0, 0, 64, 64, Color.new(0, 0, 96))
+  window.contents = Bitmap.new(232, 120)
+  window.contents.draw_text(0, 0, 232, 32, "Status")
+  window.y = 160
+  window.width = 264
+  window.height = 152
+  [vp, sprites, window]
+end
+
+cached, cached_sprites, cached_window = make_panel(20)
+plain, plain_sprites, plain_window = make_panel(340)
+cached.cache = true
+
+step = lambda do |sprites, window, frame|
+  sprites[0].x = 8 + frame % 32 if frame.between?(60, 90)
+  window.contents.draw_text(0, 40, 232, 32, "Frame #{frame}") if frame == 120
+end
+
+180.times do |frame|
+  step.call(cached_sprites, cached_window, frame)
+  step.call(plain_sprites, plain_window, frame)
+  Graphics.update
+
+  if frame % 30 == 29
+    hits, misses = cached.cache_stats
+    puts "Frame #{frame + 1}: #{hits} hits, #{misses} misses"
+  end
+end
+
+cached.cache = false
+Graphics.wait(30)
+
+exit